@@ -0,0 +1,217 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "test_bootmodel.h"
+#include "../testdatalocation.h"
+#include <QAbstractItemModelTester>
+#include <QSet>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryFile>
+#include <QTest>
+#include <QThread>
+#include <bootmodel.h>
+#include <journaldexportreader.h>
+#include <journaldhelper.h>
+#include <localjournal.h>
+#include <memoryjournal.h>
+#include <systemdjournalremote.h>
+#include <algorithm>
+
+namespace
+{
+/**
+ * export with @p boots consecutive boots of one hour, each with @p entries entries, starting at boot
+ * @p firstBoot and entry @p firstEntry
+ */
+QByteArray syntheticExport(int boots, int entries, int firstBoot = 1, int firstEntry = 0)
+{
+    constexpr quint64 sStartUsec{1600000000000000};
+    constexpr quint64 sHourUsec{3600000000};
+    QByteArray data;
+    for (int boot = firstBoot; boot < firstBoot + boots; ++boot) {
+        const QByteArray bootId = QByteArray::number(boot, 16).rightJustified(32, '0');
+        for (int entry = firstEntry; entry < firstEntry + entries; ++entry) {
+            const quint64 monotonic = 1000000 + entry * 1000000;
+            data += "__REALTIME_TIMESTAMP=" + QByteArray::number(sStartUsec + boot * sHourUsec + monotonic) + '\n';
+            data += "__MONOTONIC_TIMESTAMP=" + QByteArray::number(monotonic) + '\n';
+            data += "_BOOT_ID=" + bootId + '\n';
+            data += "_HOSTNAME=synthetic\n";
+            data += "PRIORITY=6\n";
+            data += "MESSAGE=entry " + QByteArray::number(entry) + " of boot " + QByteArray::number(boot) + "\n\n";
+        }
+    }
+    return data;
+}
+
+bool equalBoots(const QVector<JournaldHelper::BootInfo> &lhs, const QVector<JournaldHelper::BootInfo> &rhs)
+{
+    return std::equal(lhs.cbegin(), lhs.cend(), rhs.cbegin(), rhs.cend(), [](const JournaldHelper::BootInfo &left, const JournaldHelper::BootInfo &right) {
+        return left.mBootId == right.mBootId && left.mSince == right.mSince && left.mUntil == right.mUntil;
+    });
+}
+}
+
+void TestBootModel::initTestCase()
+{
+    // the boot model fills the default metadata cache
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void TestBootModel::parallelEnumeration()
+{
+    LocalJournal journal(JOURNAL_LOCATION);
+    QVERIFY(journal.isValid());
+    const QVector<JournaldHelper::BootInfo> serialBoots = JournaldHelper::queryOrderedBootIds(journal, 1);
+    QCOMPARE(serialBoots.size(), 3);
+    QVERIFY(equalBoots(JournaldHelper::queryOrderedBootIds(journal, 4), serialBoots));
+
+    const QByteArray data = syntheticExport(100, 5);
+    JournaldExportReader reader{QByteArrayView(data)};
+    MemoryJournal memoryJournal(reader);
+    const QVector<JournaldHelper::BootInfo> boots = JournaldHelper::queryOrderedBootIds(memoryJournal, 1);
+    QCOMPARE(boots.size(), 100);
+    for (int i = 1; i < boots.size(); ++i) {
+        QVERIFY(boots.at(i - 1).mSince < boots.at(i).mSince);
+    }
+    QCOMPARE(boots.first().mBootId, QLatin1String("00000000000000000000000000000001"));
+    QCOMPARE(boots.first().mUntil.toMSecsSinceEpoch() - boots.first().mSince.toMSecsSinceEpoch(), 4000);
+    QVERIFY(equalBoots(JournaldHelper::queryOrderedBootIds(memoryJournal, 8), boots));
+}
+
+void TestBootModel::asynchronousLoading()
+{
+    BootModel model(JOURNAL_LOCATION);
+    QSignalSpy loadingSpy(&model, &BootModel::loadingChanged);
+    QVERIFY(model.isLoading());
+    QCOMPARE(model.rowCount(), 0);
+
+    QTRY_COMPARE(model.rowCount(), 3);
+    QVERIFY(!model.isLoading());
+    QCOMPARE(loadingSpy.count(), 1);
+    // latest boot first
+    for (int row = 1; row < model.rowCount(); ++row) {
+        QVERIFY(model.data(model.index(row - 1, 0), BootModel::SINCE).toDateTime() > model.data(model.index(row, 0), BootModel::SINCE).toDateTime());
+    }
+
+    QVERIFY(model.setJournaldPath(JOURNAL_LOCATION));
+    QCOMPARE(model.rowCount(), 0);
+    QVERIFY(model.isLoading());
+    QTRY_COMPARE(model.rowCount(), 3);
+}
+
+void TestBootModel::resetWhileLoading()
+{
+    const QByteArray data = syntheticExport(500, 2);
+    JournaldExportReader reader{QByteArrayView(data)};
+    BootModel model(std::make_unique<MemoryJournal>(reader));
+    QVERIFY(model.isLoading());
+
+    // result of the replaced journal must not show up
+    QVERIFY(!model.setJournaldPath(QLatin1String("/does/not/exist")));
+    QCOMPARE(model.rowCount(), 0);
+    QVERIFY(model.setJournaldPath(JOURNAL_LOCATION));
+    QTRY_VERIFY(!model.isLoading());
+    QCOMPARE(model.rowCount(), 3);
+}
+
+void TestBootModel::liveUpdates()
+{
+    const QByteArray data = syntheticExport(3, 5);
+    JournaldExportReader reader{QByteArrayView(data)};
+    auto journal = std::make_unique<MemoryJournal>(reader);
+    MemoryJournal *memoryJournal = journal.get();
+    BootModel model(std::move(journal));
+    QTRY_COMPARE(model.rowCount(), 3);
+    const QDateTime until = model.data(model.index(0, 0), BootModel::UNTIL).toDateTime();
+    QSignalSpy dataChangedSpy(&model, &QAbstractItemModel::dataChanged);
+    QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+
+    // new entries of the latest boot only extend it
+    const QByteArray continuation = syntheticExport(1, 3, 3, 5);
+    JournaldExportReader continuationReader{QByteArrayView(continuation)};
+    QCOMPARE(memoryJournal->append(continuationReader), qint64(3));
+    QTRY_COMPARE(dataChangedSpy.count(), 1);
+    QCOMPARE(dataChangedSpy.first().at(0).value<QModelIndex>().row(), 0);
+    QCOMPARE(model.data(model.index(0, 0), BootModel::UNTIL).toDateTime().toMSecsSinceEpoch() - until.toMSecsSinceEpoch(), 3000);
+    QCOMPARE(insertedSpy.count(), 0);
+
+    // new boot is inserted as latest boot
+    const QByteArray nextBoot = syntheticExport(1, 2, 4);
+    JournaldExportReader nextBootReader{QByteArrayView(nextBoot)};
+    QCOMPARE(memoryJournal->append(nextBootReader), qint64(2));
+    QTRY_COMPARE(model.rowCount(), 4);
+    QCOMPARE(insertedSpy.count(), 1);
+    QCOMPARE(insertedSpy.first().at(1).toInt(), 0);
+    QCOMPARE(model.data(model.index(0, 0), BootModel::BOOT_ID).toString(), QLatin1String("00000000000000000000000000000004"));
+    QCOMPARE(model.data(model.index(0, 0), BootModel::UNTIL).toDateTime().toMSecsSinceEpoch()
+                 - model.data(model.index(0, 0), BootModel::SINCE).toDateTime().toMSecsSinceEpoch(),
+             1000);
+    QCOMPARE(model.data(model.index(1, 0), BootModel::BOOT_ID).toString(), QLatin1String("00000000000000000000000000000003"));
+    QCOMPARE(resetSpy.count(), 0);
+}
+
+void TestBootModel::updatesWhileLoading()
+{
+    const QByteArray data = syntheticExport(300, 5);
+    JournaldExportReader reader{QByteArrayView(data)};
+    auto journal = std::make_unique<MemoryJournal>(reader);
+    MemoryJournal *memoryJournal = journal.get();
+    BootModel model(std::move(journal));
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::Fatal);
+    QVERIFY(model.isLoading());
+
+    // continuation of the latest boot and a new boot
+    const QByteArray continuation = syntheticExport(1, 3, 300, 5);
+    JournaldExportReader continuationReader{QByteArrayView(continuation)};
+    QCOMPARE(memoryJournal->append(continuationReader), qint64(3));
+    const QByteArray nextBoot = syntheticExport(1, 2, 301);
+    JournaldExportReader nextBootReader{QByteArrayView(nextBoot)};
+    QCOMPARE(memoryJournal->append(nextBootReader), qint64(2));
+
+    QTRY_COMPARE(model.rowCount(), 301);
+    QVERIFY(!model.isLoading());
+    QSet<QString> bootIds;
+    for (int row = 0; row < model.rowCount(); ++row) {
+        bootIds.insert(model.data(model.index(row, 0), BootModel::BOOT_ID).toString());
+    }
+    QCOMPARE(bootIds.size(), 301);
+    QCOMPARE(model.data(model.index(0, 0), BootModel::BOOT_ID).toString(), QString::number(301, 16).rightJustified(32, QLatin1Char('0')));
+    QCOMPARE(model.data(model.index(1, 0), BootModel::UNTIL).toDateTime().toMSecsSinceEpoch()
+                 - model.data(model.index(1, 0), BootModel::SINCE).toDateTime().toMSecsSinceEpoch(),
+             7000);
+}
+
+void TestBootModel::enumerationBenchmark_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::newRow("1 journal object") << 1;
+    QTest::newRow("parallel") << QThread::idealThreadCount();
+}
+
+void TestBootModel::enumerationBenchmark()
+{
+    QFETCH(int, threads);
+    constexpr int sBootCount{300};
+
+    // journal files are created by systemd-journal-remote from a synthetic export
+    QTemporaryFile exportFile;
+    QVERIFY(exportFile.open());
+    exportFile.write(syntheticExport(sBootCount, 20));
+    exportFile.close();
+    SystemdJournalRemote journal(exportFile.fileName());
+    QSignalSpy finishedSpy(&journal, &SystemdJournalRemote::importFinished);
+    QVERIFY(finishedSpy.wait(30000));
+    QCOMPARE(finishedSpy.first().at(0).toBool(), true);
+
+    QVector<JournaldHelper::BootInfo> boots;
+    QBENCHMARK {
+        boots = JournaldHelper::queryOrderedBootIds(journal, threads);
+    }
+    QCOMPARE(boots.size(), sBootCount);
+}
+
+QTEST_GUILESS_MAIN(TestBootModel);
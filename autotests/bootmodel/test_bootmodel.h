@@ -0,0 +1,40 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef TEST_BOOTMODEL_H
+#define TEST_BOOTMODEL_H
+
+#include <QObject>
+
+class TestBootModel : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    /**
+     * Boots are read through the metadata cache, which is redirected to the test locations
+     */
+    void initTestCase();
+    /**
+     * Parallel enumeration provides the same boots as enumeration with a single journal object
+     */
+    void parallelEnumeration();
+    void asynchronousLoading();
+    void resetWhileLoading();
+    /**
+     * New entries extend the current boot or add new boots without enumerating all boots again
+     */
+    void liveUpdates();
+    /**
+     * Journal updates during the enumeration are applied after its result, without duplicating boots
+     */
+    void updatesWhileLoading();
+    /**
+     * Enumeration of a journal file with many boots, with one and with several journal objects
+     */
+    void enumerationBenchmark_data();
+    void enumerationBenchmark();
+};
+#endif
@@ -0,0 +1,263 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "test_exportreader.h"
+#include "../testdatalocation.h"
+#include <KCompressionDevice>
+#include <QBuffer>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+#include <QTest>
+#include <QThread>
+#include <journaldexportreader.h>
+
+namespace
+{
+QByteArray readFixture(const char *path)
+{
+    QFile file(QString::fromLocal8Bit(path));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+QVector<QVector<std::pair<QByteArray, QByteArray>>> readAll(JournaldExportReader &reader)
+{
+    QVector<QVector<std::pair<QByteArray, QByteArray>>> entries;
+    while (reader.readNext()) {
+        QVector<std::pair<QByteArray, QByteArray>> entry;
+        for (const auto &field : reader.fields()) {
+            entry.append({field.mName.toByteArray(), field.mValue.toByteArray()});
+        }
+        entries.append(entry);
+    }
+    return entries;
+}
+}
+
+void TestExportReader::fieldAccess()
+{
+    JournaldExportReader reader(QString::fromLocal8Bit(JOURNAL_EXPORT_FORMAT_EXAMPLE));
+    QVERIFY(!reader.atEnd());
+
+    QVERIFY(reader.readNext());
+    QCOMPARE(reader.fields().size(), qsizetype(24));
+    QCOMPARE(reader.fields().first().mName, QByteArrayView("__CURSOR"));
+    QCOMPARE(reader.fieldValue("_HOSTNAME").value_or(QByteArrayView()), QByteArrayView("epsilon"));
+    QCOMPARE(reader.fieldValue("SYSLOG_PID").value_or(QByteArrayView()), QByteArrayView("587"));
+    QVERIFY(!reader.fieldValue("UNKNOWN_FIELD"));
+    QCOMPARE(reader.entry().value(QLatin1String("_COMM")), QLatin1String("gdm-session-wor"));
+
+    QVERIFY(reader.readNext());
+    QCOMPARE(reader.fieldValue("MESSAGE").value_or(QByteArrayView()), QByteArrayView("(root) CMD (run-parts /etc/cron.hourly)"));
+
+    QVERIFY(reader.atEnd());
+    QVERIFY(!reader.readNext());
+    QVERIFY(!reader.hasError());
+    QCOMPARE(reader.position(), QFileInfo(QString::fromLocal8Bit(JOURNAL_EXPORT_FORMAT_EXAMPLE)).size());
+}
+
+void TestExportReader::binaryFieldAccess()
+{
+    // devices that are no files are read completely
+    QByteArray data = readFixture(JOURNAL_EXPORT_FORMAT_BINARY_EXAMPLE);
+    QBuffer buffer(&data);
+    JournaldExportReader reader(&buffer);
+
+    QVERIFY(reader.readNext());
+    QCOMPARE(reader.fieldValue("_SELINUX_CONTEXT").value_or(QByteArrayView()), QByteArrayView("unconfined\n"));
+    QCOMPARE(reader.fieldValue("MESSAGE").value_or(QByteArrayView()), QByteArrayView("foo\nbar"));
+    // field after the binary fields is found, i.e. the empty line within binary data is no entry separator
+    QCOMPARE(reader.fieldValue("_AUDIT_LOGINUID").value_or(QByteArrayView()), QByteArrayView("1000"));
+    QCOMPARE(reader.entry().value(QLatin1String("MESSAGE")), QLatin1String("foo\nbar"));
+    QVERIFY(reader.atEnd());
+}
+
+void TestExportReader::truncatedInput()
+{
+    const QByteArray data = readFixture(JOURNAL_EXPORT_FORMAT_BINARY_EXAMPLE);
+    const qsizetype binaryField = data.indexOf("unconfined");
+    QVERIFY(binaryField > 0);
+
+    // size of binary field exceeds the data
+    JournaldExportReader reader(QByteArrayView(data).first(binaryField + 4));
+    QVERIFY(!reader.readNext());
+    QVERIFY(reader.hasError());
+    QVERIFY(reader.atEnd());
+
+    // size of binary field is incomplete
+    JournaldExportReader sizeReader(QByteArrayView(data).first(binaryField - 4));
+    QVERIFY(!sizeReader.readNext());
+    QVERIFY(sizeReader.hasError());
+}
+
+void TestExportReader::incrementalInput()
+{
+    // without the final blank line, the last entry can only be recognized as complete at the end of the input
+    const QByteArray data = (readFixture(JOURNAL_EXPORT_FORMAT_EXAMPLE) + readFixture(JOURNAL_EXPORT_FORMAT_BINARY_EXAMPLE)).chopped(1);
+    JournaldExportReader sequentialReader{QByteArrayView(data)};
+    const auto expectedEntries = readAll(sequentialReader);
+    QCOMPARE(expectedEntries.size(), qsizetype(3));
+
+    // small chunks split lines, binary field sizes and binary data
+    JournaldExportReader reader;
+    QVERIFY(!reader.readNext());
+    QVERIFY(!reader.atEnd());
+    QVERIFY(!reader.hasError());
+    QVector<QVector<std::pair<QByteArray, QByteArray>>> entries;
+    for (qsizetype position = 0; position < data.size(); position += 7) {
+        reader.addData(QByteArrayView(data).sliced(position, std::min<qsizetype>(7, data.size() - position)));
+        entries.append(readAll(reader));
+        QVERIFY(!reader.hasError());
+    }
+    QCOMPARE(entries.size(), qsizetype(2));
+    reader.closeInput();
+    entries.append(readAll(reader));
+    QCOMPARE(entries, expectedEntries);
+    QVERIFY(reader.atEnd());
+    QVERIFY(!reader.hasError());
+    QCOMPARE(reader.position(), qint64(data.size()));
+
+    // truncated entry is reported once the input is complete
+    JournaldExportReader truncatedReader;
+    truncatedReader.addData(QByteArrayView(data).first(data.lastIndexOf("foo\nbar") + 3));
+    QCOMPARE(readAll(truncatedReader).size(), qsizetype(2));
+    QVERIFY(!truncatedReader.hasError());
+    truncatedReader.closeInput();
+    QVERIFY(!truncatedReader.readNext());
+    QVERIFY(truncatedReader.hasError());
+}
+
+void TestExportReader::parallelParsing_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::addColumn<qint64>("segmentSize");
+    QTest::newRow("tiny segments") << 4 << qint64(1);
+    QTest::newRow("small segments") << 3 << qint64(100);
+    QTest::newRow("medium segments") << 2 << qint64(1000);
+    QTest::newRow("single segment") << 4 << qint64(1024 * 1024);
+}
+
+void TestExportReader::parallelParsing()
+{
+    QFETCH(int, threads);
+    QFETCH(qint64, segmentSize);
+
+    // the binary fixture contains a blank line followed by a field within binary data
+    QByteArray data;
+    for (int i = 0; i < 50; ++i) {
+        data += readFixture(JOURNAL_EXPORT_FORMAT_EXAMPLE) + readFixture(JOURNAL_EXPORT_FORMAT_BINARY_EXAMPLE);
+    }
+    JournaldExportReader sequentialReader{QByteArrayView(data)};
+    const auto expectedEntries = readAll(sequentialReader);
+    QCOMPARE(expectedEntries.size(), qsizetype(150));
+
+    JournaldExportReader reader{QByteArrayView(data)};
+    reader.setParallelParsing(threads, segmentSize);
+    QCOMPARE(readAll(reader), expectedEntries);
+    QVERIFY(reader.atEnd());
+    QVERIFY(!reader.hasError());
+    QCOMPARE(reader.position(), qint64(data.size()));
+
+    // truncated binary field is reported after all complete entries
+    JournaldExportReader truncatedReader{QByteArrayView(data).first(data.lastIndexOf("foo\nbar") + 3)};
+    truncatedReader.setParallelParsing(threads, segmentSize);
+    QCOMPARE(readAll(truncatedReader).size(), qsizetype(149));
+    QVERIFY(truncatedReader.hasError());
+}
+
+void TestExportReader::compressedInput_data()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<int>("type");
+    QTest::newRow("gzip") << QStringLiteral("journal.export.gz") << int(KCompressionDevice::GZip);
+    QTest::newRow("xz") << QStringLiteral("journal.export.xz") << int(KCompressionDevice::Xz);
+    QTest::newRow("zstd") << QStringLiteral("journal.export.zst") << int(KCompressionDevice::Zstd);
+}
+
+void TestExportReader::compressedInput()
+{
+    QFETCH(QString, fileName);
+    QFETCH(int, type);
+
+    // large enough for several decompressed blocks
+    QByteArray data;
+    while (data.size() < 5 * 1024 * 1024) {
+        data += readFixture(JOURNAL_EXPORT_FORMAT_EXAMPLE) + readFixture(JOURNAL_EXPORT_FORMAT_BINARY_EXAMPLE);
+    }
+    QTemporaryDir directory;
+    const QString path = directory.filePath(fileName);
+    {
+        KCompressionDevice device(path, static_cast<KCompressionDevice::CompressionType>(type));
+        if (!device.open(QIODevice::WriteOnly)) {
+            QSKIP("Compression format is not supported by KArchive");
+        }
+        QCOMPARE(device.write(data), qint64(data.size()));
+    }
+
+    JournaldExportReader sequentialReader{QByteArrayView(data)};
+    const auto expectedEntries = readAll(sequentialReader);
+    JournaldExportReader reader(path);
+    QCOMPARE(readAll(reader), expectedEntries);
+    QVERIFY(reader.atEnd());
+    QVERIFY(!reader.hasError());
+    QCOMPARE(reader.position(), qint64(data.size()));
+
+    // truncated compressed data ends parsing early
+    QFile file(path);
+    QVERIFY(file.resize(file.size() / 2));
+    JournaldExportReader truncatedReader(path);
+    QVERIFY(readAll(truncatedReader).size() < expectedEntries.size());
+}
+
+void TestExportReader::parseBenchmark_data()
+{
+    QTest::addColumn<int>("megabytes");
+    QTest::addColumn<int>("threads");
+    QTest::newRow("1 MiB") << 1 << 1;
+    QTest::newRow("16 MiB") << 16 << 1;
+    QTest::newRow("16 MiB parallel") << 16 << QThread::idealThreadCount();
+}
+
+void TestExportReader::parseBenchmark()
+{
+    QFETCH(int, megabytes);
+    QFETCH(int, threads);
+
+    const QByteArray fixtures = readFixture(JOURNAL_EXPORT_FORMAT_EXAMPLE) + readFixture(JOURNAL_EXPORT_FORMAT_BINARY_EXAMPLE);
+    QVERIFY(!fixtures.isEmpty());
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    const int repetitions = megabytes * 1024 * 1024 / fixtures.size();
+    for (int i = 0; i < repetitions; ++i) {
+        file.write(fixtures);
+    }
+    file.close();
+
+    int entries{0};
+    qint64 elapsed{0};
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+        JournaldExportReader reader(file.fileName());
+        reader.setParallelParsing(threads);
+        entries = 0;
+        while (reader.readNext()) {
+            if (reader.fieldValue("MESSAGE")) {
+                ++entries;
+            }
+        }
+        elapsed = timer.nsecsElapsed();
+    }
+    QCOMPARE(entries, 3 * repetitions);
+    qDebug() << "parsed" << entries << "entries with" << (file.size() / 1024. / 1024.) / (elapsed / 1e9) << "MiB/s";
+}
+
+QTEST_GUILESS_MAIN(TestExportReader);
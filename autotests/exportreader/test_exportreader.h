@@ -0,0 +1,42 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef TEST_EXPORTREADER_H
+#define TEST_EXPORTREADER_H
+
+#include <QObject>
+
+class TestExportReader : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void fieldAccess();
+    /**
+     * Binary fields may contain line breaks and empty lines
+     */
+    void binaryFieldAccess();
+    void truncatedInput();
+    /**
+     * Entries of incrementally added input are provided as soon as they are complete
+     */
+    void incrementalInput();
+    /**
+     * Parallel parsing provides the same entries as sequential parsing, also if split points are found within binary data
+     */
+    void parallelParsing_data();
+    void parallelParsing();
+    /**
+     * Compressed export files are decompressed while parsing
+     */
+    void compressedInput_data();
+    void compressedInput();
+    /**
+     * Parse throughput for scaled up fixtures, the throughput is reported in debug output
+     */
+    void parseBenchmark_data();
+    void parseBenchmark();
+};
+#endif
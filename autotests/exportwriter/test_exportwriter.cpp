@@ -0,0 +1,224 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "test_exportwriter.h"
+#include "../testdatalocation.h"
+#include <QBuffer>
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSemaphore>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+#include <journaldexportreader.h>
+#include <journaldexportwriter.h>
+#include <journaldviewmodel.h>
+#include <localjournal.h>
+#include <memoryjournal.h>
+#include <systemd/sd-journal.h>
+
+namespace
+{
+const QString sBootId{QLatin1String("68f2e61d061247d8a8ba0b8d53a97a52")};
+
+int countEntries(const QString &bootId)
+{
+    LocalJournal journal(JOURNAL_LOCATION);
+    const QByteArray match = QByteArray("_BOOT_ID=") + bootId.toLatin1();
+    sd_journal_add_match(journal.sdJournal(), match.constData(), 0);
+    int count{0};
+    SD_JOURNAL_FOREACH(journal.sdJournal())
+    {
+        ++count;
+    }
+    return count;
+}
+
+/**
+ * journal that blocks the export's worker thread when it prepares the query until @p resume is released
+ */
+class BlockingJournal : public LocalJournal
+{
+public:
+    BlockingJournal(QSemaphore &started, QSemaphore &resume)
+        : LocalJournal(JOURNAL_LOCATION)
+        , mStarted(started)
+        , mResume(resume)
+    {
+    }
+
+    void prepareQuery(const FilterExpression &expression) override
+    {
+        mStarted.release();
+        mResume.acquire();
+        LocalJournal::prepareQuery(expression);
+    }
+
+private:
+    QSemaphore &mStarted;
+    QSemaphore &mResume;
+};
+
+QByteArray exportBoot(const QString &bootId, JournaldExportWriter::Format format)
+{
+    QBuffer buffer;
+    JournaldExportWriter writer;
+    QSignalSpy spy(&writer, &JournaldExportWriter::finished);
+    if (!writer.start(std::make_unique<LocalJournal>(JOURNAL_LOCATION), FilterExpression::match(QLatin1String("_BOOT_ID"), bootId), &buffer, format)) {
+        return QByteArray();
+    }
+    writer.waitForFinished();
+    if (spy.count() != 1 || !spy.first().at(0).toBool()) {
+        return QByteArray();
+    }
+    return buffer.data();
+}
+}
+
+void TestExportWriter::exportFormat()
+{
+    const int expectedEntries = countEntries(sBootId);
+    QVERIFY(expectedEntries > 0);
+    QByteArray data = exportBoot(sBootId, JournaldExportWriter::Format::EXPORT);
+    QVERIFY(!data.isEmpty());
+
+    QBuffer buffer(&data);
+    JournaldExportReader reader(&buffer);
+    int entries{0};
+    while (reader.readNext()) {
+        const JournaldExportReader::LogEntry entry = reader.entry();
+        if (entry.isEmpty()) {
+            continue;
+        }
+        ++entries;
+        QCOMPARE(entry.value(QLatin1String("_BOOT_ID")), sBootId);
+        QVERIFY(entry.contains(QLatin1String("__CURSOR")));
+        QVERIFY(entry.contains(QLatin1String("__REALTIME_TIMESTAMP")));
+        QVERIFY(entry.contains(QLatin1String("MESSAGE")));
+    }
+    QCOMPARE(entries, expectedEntries);
+}
+
+void TestExportWriter::jsonLines()
+{
+    const QByteArray data = exportBoot(sBootId, JournaldExportWriter::Format::JSON);
+    const QList<QByteArray> lines = data.trimmed().split('\n');
+    QCOMPARE(lines.size(), static_cast<qsizetype>(countEntries(sBootId)));
+    for (const QByteArray &line : lines) {
+        QJsonParseError error;
+        const QJsonDocument document = QJsonDocument::fromJson(line, &error);
+        QCOMPARE(error.error, QJsonParseError::NoError);
+        QCOMPARE(document.object().value(QLatin1String("_BOOT_ID")).toString(), sBootId);
+        QVERIFY(document.object().contains(QLatin1String("__CURSOR")));
+    }
+}
+
+void TestExportWriter::plainText()
+{
+    const QByteArray data = exportBoot(sBootId, JournaldExportWriter::Format::TEXT);
+    // messages might contain line breaks, thus only lines that start with a date are entries
+    static const QRegularExpression entryStart(QLatin1String("^\\d{4}-\\d{2}-\\d{2} \\d{2}:\\d{2}:\\d{2}\\.\\d{3} UTC "));
+    int entries{0};
+    for (const QByteArray &line : data.split('\n')) {
+        if (entryStart.match(QString::fromUtf8(line)).hasMatch()) {
+            ++entries;
+        }
+    }
+    QCOMPARE(entries, countEntries(sBootId));
+}
+
+void TestExportWriter::cancellation()
+{
+    QBuffer buffer;
+    JournaldExportWriter writer;
+    QSignalSpy spy(&writer, &JournaldExportWriter::finished);
+    QSemaphore started;
+    QSemaphore resume;
+    QVERIFY(writer.start(std::make_unique<BlockingJournal>(started, resume), FilterExpression(), &buffer, JournaldExportWriter::Format::JSON));
+    QVERIFY(writer.isRunning());
+    // the worker is blocked before reading the first entry, such that the export cannot finish before it is canceled
+    started.acquire();
+    // a second export cannot be started while running
+    QBuffer otherBuffer;
+    QVERIFY(!writer.start(std::make_unique<LocalJournal>(JOURNAL_LOCATION), FilterExpression(), &otherBuffer, JournaldExportWriter::Format::JSON));
+    writer.cancel();
+    resume.release();
+    writer.waitForFinished();
+    QVERIFY(!writer.isRunning());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().at(0).toBool(), false);
+    QVERIFY(writer.progress() < 1.);
+}
+
+void TestExportWriter::exportModel()
+{
+    JournaldViewModel model;
+    model.setFetchMoreChunkSize(10);
+    QVERIFY(model.setJournaldPath(JOURNAL_LOCATION));
+    model.setBootFilter({sBootId});
+
+    QTemporaryDir directory;
+    const QString path = directory.filePath(QLatin1String("export.json"));
+    JournaldExportWriter writer;
+    QSignalSpy spy(&writer, &JournaldExportWriter::finished);
+    QVERIFY(writer.exportModel(&model, path, JournaldExportWriter::Format::JSON));
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().at(0).toBool(), true);
+    QCOMPARE(spy.first().at(1).toLongLong(), static_cast<qint64>(countEntries(sBootId)));
+    QCOMPARE(writer.progress(), 1.);
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll().trimmed().split('\n').size(), static_cast<qsizetype>(countEntries(sBootId)));
+}
+
+void TestExportWriter::exportMemoryJournal()
+{
+    // the binary example contains fields that must be serialized in binary form
+    for (const char *location : {JOURNAL_EXPORT_FORMAT_EXAMPLE, JOURNAL_EXPORT_FORMAT_BINARY_EXAMPLE}) {
+        const QString path = QString::fromLocal8Bit(location);
+        QBuffer exported;
+        JournaldExportWriter writer;
+        QSignalSpy spy(&writer, &JournaldExportWriter::finished);
+        QVERIFY(writer.start(std::make_unique<MemoryJournal>(path), FilterExpression(), &exported, JournaldExportWriter::Format::EXPORT));
+        writer.waitForFinished();
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(spy.first().at(0).toBool(), true);
+
+        JournaldExportReader originalReader(path);
+        JournaldExportReader exportedReader(QByteArrayView(exported.data()));
+        int entries{0};
+        while (originalReader.readNext()) {
+            if (originalReader.entry().isEmpty()) {
+                continue;
+            }
+            do {
+                QVERIFY(exportedReader.readNext());
+            } while (exportedReader.entry().isEmpty());
+            QCOMPARE(exportedReader.entry(), originalReader.entry());
+            ++entries;
+        }
+        QVERIFY(entries > 0);
+        QCOMPARE(spy.first().at(1).toLongLong(), static_cast<qint64>(entries));
+    }
+
+    // the residual part of the filter is evaluated for entries of the memory journal as well
+    QBuffer buffer;
+    JournaldExportWriter writer;
+    QSignalSpy spy(&writer, &JournaldExportWriter::finished);
+    QVERIFY(writer.start(std::make_unique<MemoryJournal>(QString::fromLocal8Bit(JOURNAL_EXPORT_FORMAT_BINARY_EXAMPLE)),
+                         FilterExpression::contains(QLatin1String("MESSAGE"), QLatin1String("no such message")),
+                         &buffer,
+                         JournaldExportWriter::Format::JSON));
+    writer.waitForFinished();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().at(1).toLongLong(), qint64(0));
+    QVERIFY(buffer.data().isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestExportWriter);
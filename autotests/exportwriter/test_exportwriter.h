@@ -0,0 +1,32 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef TEST_EXPORTWRITER_H
+#define TEST_EXPORTWRITER_H
+
+#include <QObject>
+
+class TestExportWriter : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    /**
+     * Exported entries can be read again with JournaldExportReader
+     */
+    void exportFormat();
+    void jsonLines();
+    void plainText();
+    void cancellation();
+    /**
+     * Complete result set of a model is written, not only the loaded window
+     */
+    void exportModel();
+    /**
+     * Entries of a journal without sd_journal object are exported like those of journal files
+     */
+    void exportMemoryJournal();
+};
+#endif
@@ -10,6 +10,8 @@
 #include <QAbstractItemModelTester>
 #include <QDebug>
 #include <QDir>
+#include <QSignalSpy>
+#include <QStandardPaths>
 #include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QTest>
@@ -19,6 +21,12 @@
 //       you can check them by using "journalctl -D journal" and requesting the values
 //       that are checked here
 
+void TestFilterCriteriaModel::initTestCase()
+{
+    // unique values are read through the default metadata cache
+    QStandardPaths::setTestModeEnabled(true);
+}
+
 void TestFilterCriteriaModel::basicTreeModelStructure()
 {
     FilterCriteriaModel model;
@@ -47,7 +55,8 @@ void TestFilterCriteriaModel::standaloneTestSystemdUnitSelectionOptions()
     // use extracted journal
     QCOMPARE(model.setJournaldPath(JOURNAL_LOCATION), true);
     QVERIFY(model.rowCount() > 0);
-    QVERIFY(model.entries(FilterCriteriaModel::Category::SYSTEMD_UNIT).count() > 0);
+    // values are read in the background
+    QTRY_VERIFY(model.entries(FilterCriteriaModel::Category::SYSTEMD_UNIT).count() > 0);
 
     {
         const auto container = model.entries(FilterCriteriaModel::Category::SYSTEMD_UNIT);
@@ -79,7 +88,8 @@ void TestFilterCriteriaModel::standaloneTestExeSelectionOptions()
     // use extracted journal
     QCOMPARE(model.setJournaldPath(JOURNAL_LOCATION), true);
     QVERIFY(model.rowCount() > 0);
-    QVERIFY(model.entries(FilterCriteriaModel::Category::EXE).count() > 0);
+    // values are read in the background
+    QTRY_VERIFY(model.entries(FilterCriteriaModel::Category::EXE).count() > 0);
 
     {
         const auto container = model.entries(FilterCriteriaModel::Category::EXE);
@@ -170,4 +180,42 @@ void TestFilterCriteriaModel::standaloneTestPrioritySelectionOptions()
     }
 }
 
+void TestFilterCriteriaModel::asynchronousLoading()
+{
+    FilterCriteriaModel model(JOURNAL_LOCATION);
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::Fatal);
+    QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+
+    // categories are available before their values
+    QCOMPARE(model.rowCount(), 4);
+    QCOMPARE(model.rowCount(model.index(FilterCriteriaModel::Category::PRIORITY, 0)), 9);
+    QCOMPARE(model.rowCount(model.index(FilterCriteriaModel::Category::SYSTEMD_UNIT, 0)), 0);
+
+    QTRY_VERIFY(!model.isLoading());
+    // one insert per category and no further reset
+    QCOMPARE(insertedSpy.count(), 2);
+    QCOMPARE(insertedSpy.at(0).at(0).value<QModelIndex>(), model.index(FilterCriteriaModel::Category::SYSTEMD_UNIT, 0));
+    QCOMPARE(insertedSpy.at(1).at(0).value<QModelIndex>(), model.index(FilterCriteriaModel::Category::EXE, 0));
+    QCOMPARE(resetSpy.count(), 0);
+    QVERIFY(model.rowCount(model.index(FilterCriteriaModel::Category::SYSTEMD_UNIT, 0)) > 0);
+    QVERIFY(model.rowCount(model.index(FilterCriteriaModel::Category::EXE, 0)) > 0);
+}
+
+void TestFilterCriteriaModel::resetWhileLoading()
+{
+    FilterCriteriaModel reference(JOURNAL_LOCATION);
+    QTRY_VERIFY(!reference.isLoading());
+
+    FilterCriteriaModel model(JOURNAL_LOCATION);
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::Fatal);
+    // values of the replaced journal must not show up
+    QTemporaryFile invalidJournal;
+    QCOMPARE(model.setJournaldPath(invalidJournal.fileName()), false);
+    QCOMPARE(model.setJournaldPath(JOURNAL_LOCATION), true);
+    QTRY_VERIFY(!model.isLoading());
+    QCOMPARE(model.entries(FilterCriteriaModel::Category::SYSTEMD_UNIT), reference.entries(FilterCriteriaModel::Category::SYSTEMD_UNIT));
+    QCOMPARE(model.entries(FilterCriteriaModel::Category::EXE), reference.entries(FilterCriteriaModel::Category::EXE));
+}
+
 QTEST_GUILESS_MAIN(TestFilterCriteriaModel);
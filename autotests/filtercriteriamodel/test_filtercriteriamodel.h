@@ -13,6 +13,10 @@ class TestFilterCriteriaModel : public QObject
     Q_OBJECT
 
 private Q_SLOTS:
+    /**
+     * Unit and executable values are cached in the test locations, not in the user's cache
+     */
+    void initTestCase();
     /**
      * @brief Test basic assumptions about this model when loading a journal
      */
@@ -23,6 +27,12 @@ private Q_SLOTS:
     void standaloneTestExeSelectionOptions();
     void standaloneTestPrioritySelectionOptions();
 
+    /**
+     * @brief Categories are available immediately, their values are inserted once they are read
+     */
+    void asynchronousLoading();
+    void resetWhileLoading();
+
 private:
     const QStringList mBoots{"68f2e61d061247d8a8ba0b8d53a97a52", "27acae2fe35a40ac93f9c7732c0b8e59", "2dbe99dd855049af8f2865c5da2b8fda"};
 };
@@ -0,0 +1,262 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "test_filterexpression.h"
+#include "../testdatalocation.h"
+#include "filterexpression.h"
+#include "journaldviewmodel.h"
+#include "residualfilter.h"
+#include <QAbstractItemModelTester>
+#include <QDebug>
+#include <QTest>
+
+void TestFilterExpression::emptyExpressions()
+{
+    FilterExpression empty;
+    QVERIFY(empty.isEmpty());
+    QVERIFY(empty.normalize().mSatisfiable);
+    QCOMPARE(empty.normalize().mConjunction.size(), 0);
+
+    QVERIFY(FilterExpression::allOf({}).isEmpty());
+    QVERIFY(FilterExpression::anyOf({FilterExpression(), FilterExpression()}).isEmpty());
+    QVERIFY(FilterExpression::matchAny("_PID", {}).isEmpty());
+
+    // single remaining operand replaces the operation
+    const FilterExpression pid = FilterExpression::match("_PID", "1");
+    QVERIFY(FilterExpression::anyOf({FilterExpression(), pid}) == pid);
+    QVERIFY(FilterExpression::allOf({pid, FilterExpression()}) == pid);
+}
+
+void TestFilterExpression::normalization()
+{
+    // (_PID=1 OR _PID=42) AND SYSLOG_IDENTIFIER=sddm AND (_COMM=sddm OR _SYSTEMD_USER_UNIT=init.scope)
+    const FilterExpression expression = FilterExpression::allOf({
+        FilterExpression::matchAny("_PID", {"1", "42"}),
+        FilterExpression::match("SYSLOG_IDENTIFIER", "sddm"),
+        FilterExpression::anyOf({FilterExpression::match("_COMM", "sddm"), FilterExpression::match("_SYSTEMD_USER_UNIT", "init.scope")}),
+    });
+
+    const FilterExpression::NormalizedForm form = expression.normalize();
+    QVERIFY(form.mSatisfiable);
+    QCOMPARE(form.mConjunction.size(), 3);
+
+    // same field within a disjunction is joined into one term
+    QCOMPARE(form.mConjunction.at(0).size(), 1);
+    QCOMPARE(form.mConjunction.at(0).at(0).mMatches.value("_PID"), QStringList({"1", "42"}));
+
+    QCOMPARE(form.mConjunction.at(1).size(), 1);
+    QCOMPARE(form.mConjunction.at(1).at(0).mMatches.value("SYSLOG_IDENTIFIER"), QStringList({"sddm"}));
+
+    // different fields stay separate terms of the disjunction
+    QCOMPARE(form.mConjunction.at(2).size(), 2);
+
+    QCOMPARE(expression.explain(), "(_PID=1 OR _PID=42) AND (SYSLOG_IDENTIFIER=sddm) AND (_COMM=sddm OR _SYSTEMD_USER_UNIT=init.scope)");
+}
+
+void TestFilterExpression::distribution()
+{
+    // ((_PID=1 OR _PID=2) AND _COMM=systemd) OR SYSLOG_IDENTIFIER=sddm
+    {
+        const FilterExpression expression = FilterExpression::anyOf({
+            FilterExpression::allOf({FilterExpression::matchAny("_PID", {"1", "2"}), FilterExpression::match("_COMM", "systemd")}),
+            FilterExpression::match("SYSLOG_IDENTIFIER", "sddm"),
+        });
+        const FilterExpression::NormalizedForm form = expression.normalize();
+        QCOMPARE(form.mConjunction.size(), 1);
+        QCOMPARE(form.mConjunction.at(0).size(), 2);
+        QCOMPARE(form.mConjunction.at(0).at(0).mMatches.value("_PID"), QStringList({"1", "2"}));
+        QCOMPARE(form.mConjunction.at(0).at(0).mMatches.value("_COMM"), QStringList({"systemd"}));
+        QCOMPARE(form.mConjunction.at(0).at(1).mMatches.value("SYSLOG_IDENTIFIER"), QStringList({"sddm"}));
+        QCOMPARE(expression.explain(), "((_COMM=systemd AND (_PID=1 OR _PID=2)) OR SYSLOG_IDENTIFIER=sddm)");
+    }
+
+    // ((_PID=1 OR _PID=2) AND _PID=2) OR SYSLOG_IDENTIFIER=sddm, matches of same field are intersected
+    {
+        const FilterExpression expression = FilterExpression::anyOf({
+            FilterExpression::allOf({FilterExpression::matchAny("_PID", {"1", "2"}), FilterExpression::match("_PID", "2")}),
+            FilterExpression::match("SYSLOG_IDENTIFIER", "sddm"),
+        });
+        QCOMPARE(expression.explain(), "(_PID=2 OR SYSLOG_IDENTIFIER=sddm)");
+    }
+
+    // (_PID=1 AND _PID=2) OR SYSLOG_IDENTIFIER=sddm, unsatisfiable term is dropped
+    {
+        const FilterExpression expression = FilterExpression::anyOf({
+            FilterExpression::allOf({FilterExpression::match("_PID", "1"), FilterExpression::match("_PID", "2")}),
+            FilterExpression::match("SYSLOG_IDENTIFIER", "sddm"),
+        });
+        QCOMPARE(expression.explain(), "(SYSLOG_IDENTIFIER=sddm)");
+    }
+}
+
+void TestFilterExpression::unsatisfiableExpression()
+{
+    const FilterExpression expression = FilterExpression::anyOf({
+        FilterExpression::allOf({FilterExpression::match("_PID", "1"), FilterExpression::match("_PID", "2")}),
+        FilterExpression::allOf({FilterExpression::match("_COMM", "sddm"), FilterExpression::match("_COMM", "systemd")}),
+    });
+    QCOMPARE(expression.normalize().mSatisfiable, false);
+    QCOMPARE(expression.explain(), "<match none>");
+}
+
+void TestFilterExpression::residualSplit()
+{
+    const FilterExpression pid = FilterExpression::match("_PID", "1");
+    const FilterExpression notSddm = FilterExpression::noneOf({FilterExpression::match("SYSLOG_IDENTIFIER", "sddm")});
+    const FilterExpression socket = FilterExpression::contains("MESSAGE", "Socket");
+    QVERIFY(pid.isIndexable());
+    QVERIFY(!notSddm.isIndexable());
+    QVERIFY(!socket.isIndexable());
+
+    const FilterExpression expression = FilterExpression::allOf({pid, notSddm, socket});
+    QVERIFY(!expression.isIndexable());
+    QVERIFY(expression.indexablePart() == pid);
+    QVERIFY(expression.residualPart() == FilterExpression::allOf({notSddm, socket}));
+    QCOMPARE(expression.explain(), "(_PID=1) RESIDUAL (NOT (SYSLOG_IDENTIFIER=sddm) AND MESSAGE CONTAINS \"Socket\")");
+
+    // a disjunction with a non-indexable operand cannot be split
+    const FilterExpression disjunction = FilterExpression::anyOf({pid, socket});
+    QVERIFY(disjunction.indexablePart().isEmpty());
+    QVERIFY(disjunction.residualPart() == disjunction);
+}
+
+void TestFilterExpression::residualFilter()
+{
+    const QMap<QByteArray, QByteArray> entry{{"_PID", "1"}, {"PRIORITY", "4"}, {"MESSAGE", "Listening on D-Bus System Message Bus Socket."}};
+    const ResidualFilter::FieldAccessor accessor = [&entry](const QByteArray &field) -> std::optional<QByteArrayView> {
+        const auto it = entry.constFind(field);
+        if (it == entry.constEnd()) {
+            return std::nullopt;
+        }
+        return QByteArrayView(it.value());
+    };
+
+    QVERIFY(ResidualFilter().matches(accessor));
+    QVERIFY(ResidualFilter(FilterExpression::contains("MESSAGE", "Bus Socket")).matches(accessor));
+    QVERIFY(!ResidualFilter(FilterExpression::contains("MESSAGE", "socket")).matches(accessor));
+    QVERIFY(ResidualFilter(FilterExpression::inRange("PRIORITY", 0, 4)).matches(accessor));
+    QVERIFY(!ResidualFilter(FilterExpression::inRange("PRIORITY", 5)).matches(accessor));
+    QVERIFY(ResidualFilter(FilterExpression::matchRegularExpression("MESSAGE", "^Listening on .*\\.$")).matches(accessor));
+    QVERIFY(ResidualFilter(FilterExpression::noneOf({FilterExpression::match("_PID", "2")})).matches(accessor));
+    QVERIFY(!ResidualFilter(FilterExpression::noneOf({FilterExpression::match("_PID", "1")})).matches(accessor));
+
+    // absent fields never match a leaf
+    QVERIFY(!ResidualFilter(FilterExpression::contains("_COMM", "")).matches(accessor));
+    QVERIFY(ResidualFilter(FilterExpression::noneOf({FilterExpression::contains("_COMM", "")})).matches(accessor));
+}
+
+namespace
+{
+QStringList requiredMachineIds(const FilterExpression &expression)
+{
+    return expression.requiredValues(QLatin1String("_MACHINE_ID")).value_or(QStringList({"<unconstrained>"}));
+}
+}
+
+void TestFilterExpression::requiredValues()
+{
+    const FilterExpression machineA = FilterExpression::match("_MACHINE_ID", "a");
+    const FilterExpression machineB = FilterExpression::match("_MACHINE_ID", "b");
+    const FilterExpression pid = FilterExpression::match("_PID", "1");
+
+    QCOMPARE(requiredMachineIds(FilterExpression()), QStringList({"<unconstrained>"}));
+    QCOMPARE(requiredMachineIds(pid), QStringList({"<unconstrained>"}));
+    QCOMPARE(requiredMachineIds(FilterExpression::allOf({machineA, pid})), QStringList({"a"}));
+    QCOMPARE(requiredMachineIds(FilterExpression::anyOf({machineB, machineA})), QStringList({"a", "b"}));
+
+    // a term without the field does not constrain its conjunct
+    QCOMPARE(requiredMachineIds(FilterExpression::anyOf({machineA, pid})), QStringList({"<unconstrained>"}));
+
+    // bounds of conjuncts are intersected
+    const FilterExpression intersected = FilterExpression::allOf({FilterExpression::anyOf({machineA, machineB}), FilterExpression::anyOf({machineB, pid})});
+    QCOMPARE(requiredMachineIds(intersected), QStringList({"a", "b"}));
+    QCOMPARE(requiredMachineIds(FilterExpression::allOf({machineA, machineB})), QStringList());
+
+    // non-indexable parts are ignored
+    const FilterExpression residual = FilterExpression::allOf({machineA, FilterExpression::noneOf({machineB})});
+    QCOMPARE(requiredMachineIds(residual), QStringList({"a"}));
+}
+
+void TestFilterExpression::requiredRange()
+{
+    const FilterExpression window = FilterExpression::inRealtimeRange(QDateTime::fromMSecsSinceEpoch(1000), QDateTime::fromMSecsSinceEpoch(5000));
+    QVERIFY(window.requiredRange("__REALTIME_TIMESTAMP") == std::make_pair(qint64(1000000), qint64(5000999)));
+    QVERIFY(!window.isIndexable());
+
+    const FilterExpression intersected = FilterExpression::allOf({window, FilterExpression::match("_PID", "1"), FilterExpression::inRange("__REALTIME_TIMESTAMP", 2000000)});
+    QVERIFY(intersected.requiredRange("__REALTIME_TIMESTAMP") == std::make_pair(qint64(2000000), qint64(5000999)));
+
+    // ranges inside of disjunctions do not bound all entries
+    QVERIFY(!FilterExpression::anyOf({window, FilterExpression::match("_PID", "1")}).requiredRange("__REALTIME_TIMESTAMP").has_value());
+}
+
+void TestFilterExpression::viewModelFilterExpression()
+{
+    JournaldViewModel model;
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::Fatal);
+    QCOMPARE(model.setJournaldPath(JOURNAL_LOCATION), true);
+
+    const QStringList units{"systemd-networkd.service", "dbus.service"};
+    model.setFilterExpression(FilterExpression::anyOf({
+        FilterExpression::matchAny("_SYSTEMD_UNIT", units),
+        FilterExpression::match("SYSLOG_IDENTIFIER", "no-such-identifier"),
+    }));
+    while (model.canFetchMore(QModelIndex())) {
+        model.fetchMore(QModelIndex());
+    }
+    QVERIFY(model.rowCount() > 0);
+    for (int i = 0; i < model.rowCount(); ++i) {
+        QVERIFY(units.contains(model.data(model.index(i, 0), JournaldViewModel::SYSTEMD_UNIT).toString()));
+    }
+
+    // resetting expression restores unfiltered journal
+    const int filteredRows = model.rowCount();
+    model.setFilterExpression(FilterExpression());
+    while (model.canFetchMore(QModelIndex())) {
+        model.fetchMore(QModelIndex());
+    }
+    QVERIFY(model.rowCount() > filteredRows);
+}
+
+void TestFilterExpression::viewModelUnsatisfiableFilterExpression()
+{
+    JournaldViewModel model;
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::Fatal);
+    QCOMPARE(model.setJournaldPath(JOURNAL_LOCATION), true);
+    QVERIFY(model.rowCount() > 0);
+
+    model.setFilterExpression(FilterExpression::anyOf({
+        FilterExpression::allOf({FilterExpression::match("_SYSTEMD_UNIT", "dbus.service"), FilterExpression::match("_SYSTEMD_UNIT", "init.scope")}),
+        FilterExpression::allOf({FilterExpression::match("_PID", "1"), FilterExpression::match("_PID", "2")}),
+    }));
+    QCOMPARE(model.rowCount(), 0);
+}
+
+void TestFilterExpression::viewModelResidualFilterExpression()
+{
+    JournaldViewModel model;
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::Fatal);
+    QCOMPARE(model.setJournaldPath(JOURNAL_LOCATION), true);
+
+    model.setFilterExpression(FilterExpression::noneOf({FilterExpression::match("_SYSTEMD_UNIT", "dbus.service")}));
+    while (model.canFetchMore(QModelIndex())) {
+        model.fetchMore(QModelIndex());
+    }
+    QVERIFY(model.rowCount() > 0);
+    for (int i = 0; i < model.rowCount(); ++i) {
+        QVERIFY(model.data(model.index(i, 0), JournaldViewModel::SYSTEMD_UNIT).toString() != QLatin1String("dbus.service"));
+    }
+
+    model.setFilterExpression(FilterExpression::contains("MESSAGE", "Socket"));
+    while (model.canFetchMore(QModelIndex())) {
+        model.fetchMore(QModelIndex());
+    }
+    QVERIFY(model.rowCount() > 0);
+    for (int i = 0; i < model.rowCount(); ++i) {
+        QVERIFY(model.data(model.index(i, 0), JournaldViewModel::MESSAGE).toString().contains(QLatin1String("Socket")));
+    }
+}
+
+QTEST_GUILESS_MAIN(TestFilterExpression);
@@ -0,0 +1,46 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef TEST_FILTEREXPRESSION_H
+#define TEST_FILTEREXPRESSION_H
+
+#include <QObject>
+
+class TestFilterExpression : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    /**
+     * Empty operands must not add any constraint
+     */
+    void emptyExpressions();
+    /**
+     * Nested AND/OR operations are brought into journald's four level form
+     */
+    void normalization();
+    /**
+     * AND operations inside of OR operations are distributed and matches of same field intersected
+     */
+    void distribution();
+    void unsatisfiableExpression();
+    /**
+     * Non-indexable operands of the top-level conjunction are split into the residual part
+     */
+    void residualSplit();
+    void residualFilter();
+    /**
+     * Values of a field that are required by all terms of a conjunct bound the matching entries
+     */
+    void requiredValues();
+    void requiredRange();
+
+    // check that filters are pushed down into journal
+    void viewModelFilterExpression();
+    void viewModelUnsatisfiableFilterExpression();
+    void viewModelResidualFilterExpression();
+};
+
+#endif
@@ -0,0 +1,206 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "test_gatewayjournal.h"
+#include "../testdatalocation.h"
+#include <QFile>
+#include <QPointer>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTest>
+#include <gatewayjournal.h>
+#include <journaldviewmodel.h>
+
+namespace
+{
+/**
+ * Minimal stand-in for systemd-journal-gatewayd on loopback that answers every request with a fixed response
+ */
+class GatewayStub
+{
+public:
+    GatewayStub(const QByteArray &status, const QByteArray &body, bool keepOpen = false)
+        : mStatus(status)
+        , mBody(body)
+        , mKeepOpen(keepOpen)
+    {
+        mServer.listen(QHostAddress::LocalHost);
+        QObject::connect(&mServer, &QTcpServer::newConnection, &mServer, [this]() {
+            mSocket = mServer.nextPendingConnection();
+            mRequest.clear();
+            QObject::connect(mSocket, &QTcpSocket::readyRead, mSocket, [this]() {
+                const bool complete = mRequest.contains("\r\n\r\n");
+                mRequest += mSocket->readAll();
+                if (!complete && mRequest.contains("\r\n\r\n")) {
+                    respond();
+                }
+            });
+        });
+    }
+
+    QUrl url() const
+    {
+        return QUrl(QLatin1String("http://127.0.0.1:") + QString::number(mServer.serverPort()));
+    }
+
+    void send(const QByteArray &data)
+    {
+        mSocket->write(data);
+    }
+
+    void close()
+    {
+        mSocket->disconnectFromHost();
+    }
+
+    QByteArray mRequest; //!< request of the last connection
+
+private:
+    void respond()
+    {
+        // without content length, the response ends when the connection is closed, like for follow requests
+        mSocket->write(QByteArray("HTTP/1.1 ") + mStatus + "\r\nContent-Type: application/vnd.fdo.journal\r\nConnection: close\r\n\r\n");
+        mSocket->write(mBody);
+        if (!mKeepOpen) {
+            close();
+        }
+    }
+
+    QTcpServer mServer;
+    QPointer<QTcpSocket> mSocket;
+    QByteArray mStatus;
+    QByteArray mBody;
+    bool mKeepOpen{false};
+};
+
+QByteArray readFixture()
+{
+    QFile file(QString::fromLocal8Bit(JOURNAL_EXPORT_FORMAT_EXAMPLE));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+}
+
+void TestGatewayJournal::receiveEntries()
+{
+    const QByteArray data = readFixture();
+    GatewayStub gateway("200 OK", data);
+    GatewayJournal journal(gateway.url());
+    QVERIFY(journal.isValid());
+    QVERIFY(!journal.isReceiving());
+
+    journal.start();
+    QVERIFY(journal.isReceiving());
+    QTRY_VERIFY_WITH_TIMEOUT(!journal.isReceiving(), 5000);
+    QVERIFY(gateway.mRequest.startsWith("GET /entries HTTP/1.1\r\n"));
+    QVERIFY(gateway.mRequest.contains("Accept: application/vnd.fdo.journal\r\n"));
+    QVERIFY(!gateway.mRequest.contains("Range:"));
+
+    QCOMPARE(journal.bytesReceived(), qint64(data.size()));
+    QCOMPARE(journal.entryCount(), qint64(2));
+    QVERIFY(journal.seekHead());
+    QCOMPARE(journal.next(), 1);
+    QCOMPARE(journal.fieldValue("_HOSTNAME").value_or(QByteArrayView()).toByteArray(), QByteArray("epsilon"));
+    QCOMPARE(journal.realtimeUsec(), quint64(1342540861416409));
+}
+
+void TestGatewayJournal::rangeHeader_data()
+{
+    QTest::addColumn<QString>("cursor");
+    QTest::addColumn<qint64>("skip");
+    QTest::addColumn<qint64>("count");
+    QTest::addColumn<QByteArray>("header");
+    QTest::newRow("tail") << QString() << qint64(-100) << qint64(100) << QByteArray("Range: entries=:-100:100\r\n");
+    QTest::newRow("head") << QString() << qint64(0) << qint64(50) << QByteArray("Range: entries=:0:50\r\n");
+    QTest::newRow("after cursor") << QLatin1String("s=1;i=2") << qint64(1) << qint64(-1) << QByteArray("Range: entries=s=1;i=2:1:\r\n");
+    QTest::newRow("cursor") << QLatin1String("s=1;i=2") << qint64(0) << qint64(-1) << QByteArray("Range: entries=s=1;i=2\r\n");
+}
+
+void TestGatewayJournal::rangeHeader()
+{
+    QFETCH(QString, cursor);
+    QFETCH(qint64, skip);
+    QFETCH(qint64, count);
+    QFETCH(QByteArray, header);
+
+    GatewayStub gateway("200 OK", QByteArray());
+    GatewayJournal journal(gateway.url());
+    journal.setRange(cursor, skip, count);
+    journal.start();
+    QTRY_VERIFY_WITH_TIMEOUT(!journal.isReceiving(), 5000);
+    QVERIFY(gateway.mRequest.contains(header));
+    QCOMPARE(journal.entryCount(), qint64(0));
+}
+
+void TestGatewayJournal::followMode()
+{
+    const QByteArray data = readFixture();
+    const qsizetype secondEntry = data.indexOf("\n\n") + 2;
+    GatewayStub gateway("200 OK", data.first(secondEntry), true);
+
+    auto journal = std::make_unique<GatewayJournal>(gateway.url());
+    GatewayJournal *gatewayJournal = journal.get();
+    gatewayJournal->setFollow(true);
+    QVERIFY(gatewayJournal->follow());
+    JournaldViewModel model;
+    QVERIFY(model.setJournal(std::move(journal)));
+    QCOMPARE(model.rowCount(), 0);
+
+    gatewayJournal->start();
+    QTRY_COMPARE_WITH_TIMEOUT(model.rowCount(), 1, 5000);
+    QVERIFY(gateway.mRequest.startsWith("GET /entries?follow HTTP/1.1\r\n"));
+
+    // entries become visible once they are complete
+    gateway.send(data.sliced(secondEntry, 100));
+    QTest::qWait(100);
+    QCOMPARE(model.rowCount(), 1);
+    gateway.send(data.sliced(secondEntry + 100));
+    QTRY_COMPARE_WITH_TIMEOUT(model.rowCount(), 2, 5000);
+    QCOMPARE(model.data(model.index(1, 0), JournaldViewModel::Roles::MESSAGE).toString(), QLatin1String("(root) CMD (run-parts /etc/cron.hourly)"));
+    QVERIFY(gatewayJournal->isReceiving());
+
+    gatewayJournal->stop();
+    QVERIFY(!gatewayJournal->isReceiving());
+    QCOMPARE(gatewayJournal->entryCount(), qint64(2));
+}
+
+void TestGatewayJournal::followClones()
+{
+    const QByteArray data = readFixture();
+    const qsizetype secondEntry = data.indexOf("\n\n") + 2;
+    GatewayStub gateway("200 OK", data.first(secondEntry), true);
+
+    GatewayJournal journal(gateway.url());
+    journal.setFollow(true);
+    journal.start();
+    QTRY_COMPARE_WITH_TIMEOUT(journal.entryCount(), qint64(1), 5000);
+
+    JournaldViewModel model;
+    QVERIFY(model.setJournal(journal.clone()));
+    QCOMPARE(model.rowCount(), 1);
+
+    gateway.send(data.sliced(secondEntry));
+    QTRY_COMPARE_WITH_TIMEOUT(model.rowCount(), 2, 5000);
+    QCOMPARE(model.data(model.index(1, 0), JournaldViewModel::Roles::MESSAGE).toString(), QLatin1String("(root) CMD (run-parts /etc/cron.hourly)"));
+    QCOMPARE(journal.entryCount(), qint64(2));
+    journal.stop();
+}
+
+void TestGatewayJournal::errorResponse()
+{
+    GatewayStub gateway("404 Not Found", "Not found");
+    GatewayJournal journal(gateway.url());
+    QSignalSpy errorSpy(&journal, &GatewayJournal::errorOccurred);
+    journal.start();
+    QTRY_VERIFY_WITH_TIMEOUT(!journal.isReceiving(), 5000);
+    QCOMPARE(errorSpy.count(), 1);
+    QCOMPARE(journal.entryCount(), qint64(0));
+    QVERIFY(journal.isValid());
+}
+
+QTEST_GUILESS_MAIN(TestGatewayJournal);
@@ -0,0 +1,32 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef TEST_GATEWAYJOURNAL_H
+#define TEST_GATEWAYJOURNAL_H
+
+#include <QObject>
+
+class TestGatewayJournal : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void receiveEntries();
+    /**
+     * The requested window is passed as "Range" header
+     */
+    void rangeHeader_data();
+    void rangeHeader();
+    /**
+     * In follow mode, entries are appended while the response is received and shown by the view model
+     */
+    void followMode();
+    /**
+     * Clones receive the entries that arrive after they were created
+     */
+    void followClones();
+    void errorResponse();
+};
+#endif
@@ -0,0 +1,135 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "test_importcache.h"
+#include "../testdatalocation.h"
+#include "journalimportcache.h"
+#include "systemdjournalremote.h"
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace
+{
+QString createFile(const QString &path, qint64 size)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return QString();
+    }
+    file.write(QByteArray(size, 'x'));
+    return path;
+}
+
+void setLastUse(const QString &path, const QDateTime &time)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.setFileTime(time, QFileDevice::FileModificationTime));
+}
+}
+
+void TestImportCache::key()
+{
+    QTemporaryDir directory;
+    const QString exportFile = directory.filePath(QLatin1String("journal.export"));
+    QVERIFY(QFile::copy(JOURNAL_EXPORT_FORMAT_EXAMPLE, exportFile));
+
+    const QString key = JournalImportCache::key(exportFile);
+    QVERIFY(!key.isEmpty());
+    QCOMPARE(JournalImportCache::key(exportFile), key);
+    QCOMPARE(JournalImportCache::key(directory.filePath(QLatin1String("missing.export"))), QString());
+
+    // same size and modification time, but different content
+    const QDateTime modified = QFileInfo(exportFile).lastModified();
+    {
+        QFile file(exportFile);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.seek(10));
+        file.write("X");
+        QVERIFY(file.setFileTime(modified, QFileDevice::FileModificationTime));
+    }
+    QVERIFY(JournalImportCache::key(exportFile) != key);
+}
+
+void TestImportCache::insertAndLookup()
+{
+    QTemporaryDir directory;
+    JournalImportCache cache(directory.filePath(QLatin1String("cache")));
+    QCOMPARE(cache.directory(), directory.filePath(QLatin1String("cache")));
+    QVERIFY(QFileInfo(cache.directory()).isDir());
+
+    const QString file = createFile(directory.filePath(QLatin1String("remote.journal")), 100);
+    QVERIFY(!file.isEmpty());
+    QCOMPARE(cache.lookup(QLatin1String("a")), QString());
+    QVERIFY(cache.insert(QLatin1String("a"), file));
+    QVERIFY(!QFile::exists(file));
+    QCOMPARE(cache.lookup(QLatin1String("a")), cache.journalFile(QLatin1String("a")));
+    QCOMPARE(QFileInfo(cache.lookup(QLatin1String("a"))).size(), 100);
+    QCOMPARE(cache.lookup(QLatin1String("b")), QString());
+
+    // entries of other caches are found as well
+    JournalImportCache otherCache(cache.directory());
+    QCOMPARE(otherCache.lookup(QLatin1String("a")), cache.journalFile(QLatin1String("a")));
+}
+
+void TestImportCache::leastRecentlyUsedEviction()
+{
+    QTemporaryDir directory;
+    JournalImportCache cache(directory.filePath(QLatin1String("cache")), 250);
+    QCOMPARE(cache.maxSize(), 250);
+
+    QVERIFY(cache.insert(QLatin1String("a"), createFile(directory.filePath(QLatin1String("a.journal")), 100)));
+    QVERIFY(cache.insert(QLatin1String("b"), createFile(directory.filePath(QLatin1String("b.journal")), 100)));
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    setLastUse(cache.journalFile(QLatin1String("a")), now.addSecs(-7200));
+    setLastUse(cache.journalFile(QLatin1String("b")), now.addSecs(-3600));
+
+    // use of "a" makes "b" the least recently used entry
+    QVERIFY(!cache.lookup(QLatin1String("a")).isEmpty());
+    QVERIFY(cache.insert(QLatin1String("c"), createFile(directory.filePath(QLatin1String("c.journal")), 100)));
+    QVERIFY(QFile::exists(cache.journalFile(QLatin1String("a"))));
+    QVERIFY(!QFile::exists(cache.journalFile(QLatin1String("b"))));
+    QVERIFY(QFile::exists(cache.journalFile(QLatin1String("c"))));
+
+    // the inserted entry is kept even if it exceeds the cache size alone
+    QVERIFY(cache.insert(QLatin1String("d"), createFile(directory.filePath(QLatin1String("d.journal")), 300)));
+    QVERIFY(!QFile::exists(cache.journalFile(QLatin1String("a"))));
+    QVERIFY(!QFile::exists(cache.journalFile(QLatin1String("c"))));
+    QVERIFY(QFile::exists(cache.journalFile(QLatin1String("d"))));
+}
+
+void TestImportCache::remoteJournalFromCache()
+{
+    QTemporaryDir directory;
+    JournalImportCache cache(directory.path());
+    const QString key = JournalImportCache::key(JOURNAL_EXPORT_FORMAT_EXAMPLE);
+
+    {
+        SystemdJournalRemote journal(JOURNAL_EXPORT_FORMAT_EXAMPLE, cache);
+        QSignalSpy finishedSpy(&journal, &SystemdJournalRemote::importFinished);
+        QVERIFY(journal.isImporting());
+        QVERIFY(finishedSpy.wait(5000));
+        QCOMPARE(finishedSpy.first().at(0).toBool(), true);
+        QCOMPARE(journal.journalFile(), cache.journalFile(key));
+        QCOMPARE(journal.entryCount(), 2);
+    }
+    // the cached journal file outlives the journal object
+    QVERIFY(QFile::exists(cache.journalFile(key)));
+
+    SystemdJournalRemote journal(JOURNAL_EXPORT_FORMAT_EXAMPLE, cache);
+    QSignalSpy finishedSpy(&journal, &SystemdJournalRemote::importFinished);
+    QVERIFY(journal.isValid());
+    QVERIFY(!journal.isImporting());
+    QCOMPARE(journal.journalFile(), cache.journalFile(key));
+    QCOMPARE(journal.entryCount(), 2);
+    QVERIFY(finishedSpy.wait(1000));
+    QCOMPARE(finishedSpy.first().at(0).toBool(), true);
+}
+
+QTEST_GUILESS_MAIN(TestImportCache);
@@ -0,0 +1,21 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef TEST_IMPORTCACHE_H
+#define TEST_IMPORTCACHE_H
+
+#include <QObject>
+
+class TestImportCache : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void key();
+    void insertAndLookup();
+    void leastRecentlyUsedEviction();
+    void remoteJournalFromCache();
+};
+#endif
@@ -0,0 +1,265 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "test_ingestserver.h"
+#include "../testdatalocation.h"
+#include <QFile>
+#include <QSignalSpy>
+#include <QTcpSocket>
+#include <QTest>
+#include <ingestserver.h>
+#include <journaldviewmodel.h>
+#include <memoryjournal.h>
+#include <mergedjournaldviewmodel.h>
+
+namespace
+{
+const QByteArray sMachineId{"a91663387a90b89f185d4e860000001a"};
+
+QByteArray machineId(int index)
+{
+    return QByteArray::number(index).rightJustified(sMachineId.size(), '0');
+}
+
+QByteArray readFixture(const QByteArray &hostname = QByteArray("epsilon"), const QByteArray &machineId = sMachineId)
+{
+    QFile file(QString::fromLocal8Bit(JOURNAL_EXPORT_FORMAT_EXAMPLE));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll().replace("_HOSTNAME=epsilon", "_HOSTNAME=" + hostname).replace("_MACHINE_ID=" + sMachineId, "_MACHINE_ID=" + machineId);
+}
+
+QByteArray uploadHeader(qint64 contentLength = -1)
+{
+    QByteArray header("POST /upload HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/vnd.fdo.journal\r\n");
+    if (contentLength >= 0) {
+        header += "Content-Length: " + QByteArray::number(contentLength) + "\r\n";
+    } else {
+        header += "Transfer-Encoding: chunked\r\nExpect: 100-continue\r\n";
+    }
+    return header + "\r\n";
+}
+
+QByteArray chunk(const QByteArray &data)
+{
+    return QByteArray::number(data.size(), 16) + "\r\n" + data + "\r\n";
+}
+
+qint64 entryCount(const std::unique_ptr<IJournal> &journal)
+{
+    auto memoryJournal = qobject_cast<MemoryJournal *>(journal.get());
+    return memoryJournal ? memoryJournal->entryCount() : -1;
+}
+
+bool fetchAll(MergedJournaldViewModel &model)
+{
+    for (int i = 0; i < 1000 && model.canFetchMore(QModelIndex()); ++i) {
+        model.fetchMore(QModelIndex());
+        QTest::qWait(1);
+    }
+    return !model.canFetchMore(QModelIndex());
+}
+}
+
+void TestIngestServer::httpUpload()
+{
+    IngestServer server;
+    QSignalSpy sourcesSpy(&server, &IngestServer::sourcesChanged);
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+    QVERIFY(server.isListening());
+    QVERIFY(server.serverPort() > 0);
+
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress::LocalHost, server.serverPort());
+    QVERIFY(socket.waitForConnected(5000));
+    socket.write(uploadHeader());
+    QTRY_VERIFY_WITH_TIMEOUT(socket.bytesAvailable() > 0, 5000);
+    QCOMPARE(socket.readAll(), QByteArray("HTTP/1.1 100 Continue\r\n\r\n"));
+
+    // chunk boundaries do not need to align with entries
+    const QByteArray data = readFixture();
+    socket.write(chunk(data.first(1000)));
+    socket.write(chunk(data.sliced(1000)) + "0\r\n\r\n");
+    QTRY_VERIFY_WITH_TIMEOUT(socket.bytesAvailable() > 0, 5000);
+    QVERIFY(socket.readAll().startsWith("HTTP/1.1 202 Accepted\r\n"));
+
+    QTRY_COMPARE_WITH_TIMEOUT(server.sources(), QStringList{QLatin1String("epsilon")}, 5000);
+    QCOMPARE(sourcesSpy.count(), 1);
+    QTRY_COMPARE_WITH_TIMEOUT(server.statistics(QLatin1String("epsilon")).mEntries, qint64(2), 5000);
+    const IngestServer::SourceStatistics statistics = server.statistics(QLatin1String("epsilon"));
+    QCOMPARE(statistics.mConnections, 1);
+    QVERIFY(statistics.mBytes > data.size());
+    QCOMPARE(statistics.mAddress, QHostAddress(QHostAddress::LocalHost).toString());
+
+    std::unique_ptr<IJournal> journal = server.journal(QLatin1String("epsilon"));
+    QVERIFY(journal);
+    QCOMPARE(entryCount(journal), qint64(2));
+    QVERIFY(journal->seekHead());
+    QCOMPARE(journal->next(), 1);
+    QCOMPARE(journal->fieldValue("_HOSTNAME").value_or(QByteArrayView()).toByteArray(), QByteArray("epsilon"));
+    QVERIFY(!server.journal(QLatin1String("unknown")));
+
+    socket.disconnectFromHost();
+    QTRY_COMPARE_WITH_TIMEOUT(server.statistics(QLatin1String("epsilon")).mConnections, 0, 5000);
+}
+
+void TestIngestServer::rawStream()
+{
+    IngestServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+
+    const QByteArray data = readFixture().chopped(1);
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress::LocalHost, server.serverPort());
+    QVERIFY(socket.waitForConnected(5000));
+    socket.write(data);
+    // the last entry is complete when the stream ends
+    QTRY_COMPARE_WITH_TIMEOUT(server.statistics(QLatin1String("epsilon")).mEntries, qint64(1), 5000);
+    socket.disconnectFromHost();
+    QTRY_COMPARE_WITH_TIMEOUT(server.statistics(QLatin1String("epsilon")).mEntries, qint64(2), 5000);
+    QCOMPARE(server.statistics(QLatin1String("epsilon")).mBytes, data.size());
+}
+
+void TestIngestServer::concurrentSources()
+{
+    IngestServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+
+    constexpr int sourceCount{24};
+    std::vector<std::unique_ptr<QTcpSocket>> sockets;
+    QStringList expectedSources;
+    for (int i = 0; i < sourceCount; ++i) {
+        const QByteArray hostname = "device-" + QByteArray::number(i);
+        expectedSources.append(QString::fromUtf8(hostname));
+        auto socket = std::make_unique<QTcpSocket>();
+        socket->connectToHost(QHostAddress::LocalHost, server.serverPort());
+        QVERIFY(socket->waitForConnected(5000));
+        const QByteArray data = readFixture(hostname, machineId(i));
+        socket->write(uploadHeader(data.size()));
+        // interleaved partial writes of all systems
+        socket->write(data.first(500));
+        sockets.push_back(std::move(socket));
+    }
+    for (int i = 0; i < sourceCount; ++i) {
+        sockets.at(i)->write(readFixture("device-" + QByteArray::number(i), machineId(i)).sliced(500));
+    }
+    for (const auto &socket : sockets) {
+        QTRY_VERIFY_WITH_TIMEOUT(socket->readAll().startsWith("HTTP/1.1 202 Accepted"), 5000);
+        socket->disconnectFromHost();
+    }
+
+    QTRY_COMPARE_WITH_TIMEOUT(server.sources().size(), qsizetype(sourceCount), 5000);
+    QStringList sources = server.sources();
+    sources.sort();
+    expectedSources.sort();
+    QCOMPARE(sources, expectedSources);
+    for (const QString &source : std::as_const(expectedSources)) {
+        QTRY_COMPARE_WITH_TIMEOUT(server.statistics(source).mEntries, qint64(2), 5000);
+        QTRY_COMPARE_WITH_TIMEOUT(server.statistics(source).mConnections, 0, 5000);
+        std::unique_ptr<IJournal> journal = server.journal(source);
+        QCOMPARE(entryCount(journal), qint64(2));
+        QVERIFY(journal->seekHead());
+        QCOMPARE(journal->next(), 1);
+        QCOMPARE(journal->fieldValue("_HOSTNAME").value_or(QByteArrayView()).toByteArray(), source.toUtf8());
+    }
+}
+
+void TestIngestServer::liveJournals()
+{
+    IngestServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+
+    auto upload = [&server](const QByteArray &hostname, const QByteArray &machineId) {
+        QTcpSocket socket;
+        socket.connectToHost(QHostAddress::LocalHost, server.serverPort());
+        QVERIFY(socket.waitForConnected(5000));
+        const QByteArray data = readFixture(hostname, machineId);
+        socket.write(uploadHeader(data.size()) + data);
+        QTRY_VERIFY_WITH_TIMEOUT(socket.readAll().startsWith("HTTP/1.1 202 Accepted"), 5000);
+    };
+    upload("alpha", machineId(1));
+    upload("beta", machineId(2));
+    QTRY_COMPARE_WITH_TIMEOUT(server.statistics(QLatin1String("beta")).mEntries, qint64(2), 5000);
+
+    JournaldViewModel model;
+    QVERIFY(model.setJournal(server.journal(QLatin1String("alpha"))));
+    QCOMPARE(model.rowCount(), 2);
+    MergedJournaldViewModel mergedModel(server.journals());
+    QCOMPARE(mergedModel.sourceCount(), 2);
+    QVERIFY(fetchAll(mergedModel));
+    QCOMPARE(mergedModel.rowCount(), 4);
+
+    // reconnect of a system continues its source
+    upload("alpha", machineId(1));
+    QTRY_COMPARE_WITH_TIMEOUT(model.rowCount(), 4, 5000);
+    QCOMPARE(server.sources(), (QStringList{QLatin1String("alpha"), QLatin1String("beta")}));
+    // merged journals are read by worker threads and receive the new entries there
+    QTRY_VERIFY_WITH_TIMEOUT(fetchAll(mergedModel) && mergedModel.rowCount() == 6, 5000);
+}
+
+void TestIngestServer::sourceIdentity()
+{
+    IngestServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+
+    auto upload = [&server](const QByteArray &data) {
+        QTcpSocket socket;
+        socket.connectToHost(QHostAddress::LocalHost, server.serverPort());
+        QVERIFY(socket.waitForConnected(5000));
+        socket.write(uploadHeader(data.size()) + data);
+        QTRY_VERIFY_WITH_TIMEOUT(socket.readAll().startsWith("HTTP/1.1 202 Accepted"), 5000);
+    };
+    upload(readFixture("epsilon", machineId(1)));
+    QTRY_COMPARE_WITH_TIMEOUT(server.statistics(QLatin1String("epsilon")).mEntries, qint64(2), 5000);
+
+    // another system with the same hostname
+    upload(readFixture("epsilon", machineId(2)));
+    const QString secondName = QLatin1String("epsilon-") + QString::fromLatin1(machineId(2));
+    QTRY_COMPARE_WITH_TIMEOUT(server.statistics(secondName).mEntries, qint64(2), 5000);
+    QCOMPARE(server.sources(), (QStringList{QLatin1String("epsilon"), secondName}));
+
+    // renamed system continues its source
+    upload(readFixture("zeta", machineId(1)));
+    QTRY_COMPARE_WITH_TIMEOUT(server.statistics(QLatin1String("epsilon")).mEntries, qint64(4), 5000);
+    QCOMPARE(server.sources().size(), qsizetype(2));
+
+    // entries without machine ID are assigned by peer address
+    QByteArray data = readFixture("eta");
+    data.replace("_MACHINE_ID=" + sMachineId + "\n", QByteArray());
+    upload(data);
+    const QString address = QHostAddress(QHostAddress::LocalHost).toString();
+    QTRY_COMPARE_WITH_TIMEOUT(server.statistics(QLatin1String("eta")).mEntries, qint64(2), 5000);
+    QCOMPARE(server.statistics(QLatin1String("eta")).mAddress, address);
+    QCOMPARE(server.sources().size(), qsizetype(3));
+}
+
+void TestIngestServer::rejectedRequests()
+{
+    IngestServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+
+    {
+        QTcpSocket socket;
+        socket.connectToHost(QHostAddress::LocalHost, server.serverPort());
+        QVERIFY(socket.waitForConnected(5000));
+        socket.write("POST /entries HTTP/1.1\r\nContent-Type: application/vnd.fdo.journal\r\nContent-Length: 0\r\n\r\n");
+        QTRY_VERIFY_WITH_TIMEOUT(socket.readAll().startsWith("HTTP/1.1 404 Not Found"), 5000);
+        QTRY_COMPARE_WITH_TIMEOUT(socket.state(), QAbstractSocket::UnconnectedState, 5000);
+    }
+    {
+        QTcpSocket socket;
+        socket.connectToHost(QHostAddress::LocalHost, server.serverPort());
+        QVERIFY(socket.waitForConnected(5000));
+        socket.write("POST /upload HTTP/1.1\r\nContent-Type: application/json\r\nContent-Length: 2\r\n\r\n{}");
+        QTRY_VERIFY_WITH_TIMEOUT(socket.readAll().startsWith("HTTP/1.1 415 Unsupported Media Type"), 5000);
+    }
+    QVERIFY(server.sources().isEmpty());
+
+    server.close();
+    QVERIFY(!server.isListening());
+}
+
+QTEST_GUILESS_MAIN(TestIngestServer);
@@ -0,0 +1,35 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef TEST_INGESTSERVER_H
+#define TEST_INGESTSERVER_H
+
+#include <QObject>
+
+class TestIngestServer : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    /**
+     * Upload like systemd-journal-upload: chunked HTTP request with "Expect: 100-continue"
+     */
+    void httpUpload();
+    void rawStream();
+    /**
+     * Many systems upload at the same time, each becomes its own source
+     */
+    void concurrentSources();
+    /**
+     * Handed out journals show entries that are received later, also when merged
+     */
+    void liveJournals();
+    /**
+     * Sources are identified by machine ID, such that renamed systems and systems with the same hostname are told apart
+     */
+    void sourceIdentity();
+    void rejectedRequests();
+};
+#endif
@@ -0,0 +1,227 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "test_jsonreader.h"
+#include "../testdatalocation.h"
+#include <KCompressionDevice>
+#include <QBuffer>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+#include <QTest>
+#include <journaldexportreader.h>
+#include <journaldjsonreader.h>
+#include <memoryjournal.h>
+
+namespace
+{
+QByteArray readFixture(const char *path)
+{
+    QFile file(QString::fromLocal8Bit(path));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+template<typename Reader>
+QVector<QVector<std::pair<QByteArray, QByteArray>>> readAll(Reader &reader)
+{
+    QVector<QVector<std::pair<QByteArray, QByteArray>>> entries;
+    while (reader.readNext()) {
+        QVector<std::pair<QByteArray, QByteArray>> entry;
+        for (const auto &field : reader.fields()) {
+            entry.append({field.mName.toByteArray(), field.mValue.toByteArray()});
+        }
+        entries.append(entry);
+    }
+    return entries;
+}
+}
+
+void TestJsonReader::sameAsExportFormat()
+{
+    const QByteArray exportData = readFixture(JOURNAL_EXPORT_FORMAT_EXAMPLE) + readFixture(JOURNAL_EXPORT_FORMAT_BINARY_EXAMPLE);
+    JournaldExportReader exportReader{QByteArrayView(exportData)};
+    const auto expectedEntries = readAll(exportReader);
+    QCOMPARE(expectedEntries.size(), qsizetype(3));
+
+    JournaldJsonReader reader(QString::fromLocal8Bit(JOURNAL_JSON_FORMAT_EXAMPLE));
+    QVERIFY(!reader.atEnd());
+    QCOMPARE(readAll(reader), expectedEntries);
+    QVERIFY(reader.atEnd());
+    QVERIFY(!reader.hasError());
+    QCOMPARE(reader.position(), QFileInfo(QString::fromLocal8Bit(JOURNAL_JSON_FORMAT_EXAMPLE)).size());
+
+    // binary field that is encoded as array of bytes
+    JournaldJsonReader binaryReader(QString::fromLocal8Bit(JOURNAL_JSON_FORMAT_EXAMPLE));
+    for (int i = 0; i < 3; ++i) {
+        QVERIFY(binaryReader.readNext());
+    }
+    QCOMPARE(binaryReader.fieldValue("_SELINUX_CONTEXT").value_or(QByteArrayView()), QByteArrayView("unconfined\n"));
+    QCOMPARE(binaryReader.fieldValue("MESSAGE").value_or(QByteArrayView()), QByteArrayView("foo\nbar"));
+    QCOMPARE(binaryReader.entry().value(QLatin1String("_CMDLINE")), QLatin1String("python3 -c from systemd import journal; journal.send(\"foo\\nbar\")"));
+}
+
+void TestJsonReader::valueEncodings()
+{
+    const QByteArray data(R"({"MESSAGE":"tab\there \"quoted\" \\ \/ \u00e4\u20ac\ud83d\ude00 \ud800","EMPTY":"","BYTES":[0,255, 10 ,65],)"
+                          R"("NO_BYTES":[],"MULTI":["first",[115,101,99,111,110,100]],"LARGE":null,"NUMBER":42})");
+    JournaldJsonReader reader{QByteArrayView(data)};
+    QVERIFY(reader.readNext());
+    QCOMPARE(reader.fieldValue("MESSAGE").value_or(QByteArrayView()).toByteArray(),
+             QByteArray("tab\there \"quoted\" \\ / \xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80 \xef\xbf\xbd"));
+    QVERIFY(reader.fieldValue("EMPTY").has_value());
+    QVERIFY(reader.fieldValue("EMPTY")->isEmpty());
+    QCOMPARE(reader.fieldValue("BYTES").value_or(QByteArrayView()).toByteArray(), QByteArray("\x00\xff\nA", 4));
+    QVERIFY(reader.fieldValue("NO_BYTES").has_value());
+    QVERIFY(!reader.fieldValue("LARGE").has_value());
+    QCOMPARE(reader.fieldValue("NUMBER").value_or(QByteArrayView()).toByteArray(), QByteArray("42"));
+
+    // each value of a field with multiple values is provided as own field
+    QStringList values;
+    for (const auto &field : reader.fields()) {
+        if (field.mName == QByteArrayView("MULTI")) {
+            values.append(QString::fromUtf8(field.mValue));
+        }
+    }
+    QCOMPARE(values, (QStringList{QLatin1String("first"), QLatin1String("second")}));
+    QVERIFY(!reader.readNext());
+    QVERIFY(!reader.hasError());
+}
+
+void TestJsonReader::outputVariants()
+{
+    const QByteArray pretty("{\n\t\"MESSAGE\" : \"first\",\n\t\"PRIORITY\" : \"6\"\n}\n{\n\t\"MESSAGE\" : \"second\"\n}\n");
+    JournaldJsonReader prettyReader{QByteArrayView(pretty)};
+    const auto prettyEntries = readAll(prettyReader);
+    QCOMPARE(prettyEntries.size(), qsizetype(2));
+    QCOMPARE(prettyEntries.at(0).size(), qsizetype(2));
+    QCOMPARE(prettyEntries.at(1).at(0).second, QByteArray("second"));
+    QVERIFY(!prettyReader.hasError());
+
+    const QByteArray sequence("\x1e{\"MESSAGE\":\"first\"}\n\x1e{\"MESSAGE\":\"second\"}\n\x1e{}\n");
+    JournaldJsonReader sequenceReader{QByteArrayView(sequence)};
+    QCOMPARE(readAll(sequenceReader).size(), qsizetype(3));
+    QVERIFY(!sequenceReader.hasError());
+}
+
+void TestJsonReader::malformedInput_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<int>("entries");
+    QTest::newRow("truncated string") << QByteArray("{\"MESSAGE\":\"first\"}\n{\"MESSAGE\":\"sec") << 1;
+    QTest::newRow("truncated object") << QByteArray("{\"MESSAGE\":\"first\"}\n{\"MESSAGE\":\"second\"") << 1;
+    QTest::newRow("truncated escape") << QByteArray("{\"MESSAGE\":\"\\u00") << 0;
+    QTest::newRow("invalid escape") << QByteArray("{\"MESSAGE\":\"\\x\"}") << 0;
+    QTest::newRow("byte out of range") << QByteArray("{\"MESSAGE\":[256]}") << 0;
+    QTest::newRow("missing separator") << QByteArray("{\"MESSAGE\" \"first\"}") << 0;
+    QTest::newRow("no object") << QByteArray("{\"MESSAGE\":\"first\"}\nMESSAGE=second\n") << 1;
+}
+
+void TestJsonReader::malformedInput()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(int, entries);
+
+    JournaldJsonReader reader{QByteArrayView(data)};
+    QCOMPARE(readAll(reader).size(), qsizetype(entries));
+    QVERIFY(reader.hasError());
+    QVERIFY(reader.atEnd());
+
+    // streamed input reports the same error
+    QTemporaryDir directory;
+    const QString path = directory.filePath(QLatin1String("journal.json.gz"));
+    {
+        KCompressionDevice device(path, KCompressionDevice::GZip);
+        QVERIFY(device.open(QIODevice::WriteOnly));
+        QCOMPARE(device.write(data), qint64(data.size()));
+    }
+    JournaldJsonReader streamReader(path);
+    QCOMPARE(readAll(streamReader).size(), qsizetype(entries));
+    QVERIFY(streamReader.hasError());
+}
+
+void TestJsonReader::compressedInput()
+{
+    // large enough for several decompressed blocks, such that entries are split between blocks
+    QByteArray data;
+    while (data.size() < 5 * 1024 * 1024) {
+        data += readFixture(JOURNAL_JSON_FORMAT_EXAMPLE);
+    }
+    QTemporaryDir directory;
+    const QString path = directory.filePath(QLatin1String("journal.json.gz"));
+    {
+        KCompressionDevice device(path, KCompressionDevice::GZip);
+        QVERIFY(device.open(QIODevice::WriteOnly));
+        QCOMPARE(device.write(data), qint64(data.size()));
+    }
+
+    JournaldJsonReader sequentialReader{QByteArrayView(data)};
+    const auto expectedEntries = readAll(sequentialReader);
+    JournaldJsonReader reader(path);
+    QCOMPARE(readAll(reader), expectedEntries);
+    QVERIFY(reader.atEnd());
+    QVERIFY(!reader.hasError());
+    QCOMPARE(reader.position(), qint64(data.size()));
+}
+
+void TestJsonReader::memoryJournal()
+{
+    QVERIFY(JournaldJsonReader::isJsonFile(QString::fromLocal8Bit(JOURNAL_JSON_FORMAT_EXAMPLE)));
+    QVERIFY(!JournaldJsonReader::isJsonFile(QString::fromLocal8Bit(JOURNAL_EXPORT_FORMAT_EXAMPLE)));
+    QVERIFY(JournaldJsonReader::isJsonFile(QLatin1String("/nonexisting/journal.jsonl.zst")));
+
+    // JSON file without JSON extension is recognized by its content
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(readFixture(JOURNAL_JSON_FORMAT_EXAMPLE));
+    file.close();
+    QVERIFY(JournaldJsonReader::isJsonFile(file.fileName()));
+
+    MemoryJournal journal(file.fileName());
+    QVERIFY(journal.isValid());
+    QCOMPARE(journal.entryCount(), qint64(3));
+    journal.setFilter(FilterExpression::match(QLatin1String("_SYSTEMD_UNIT"), QLatin1String("user@1000.service")));
+    QCOMPARE(journal.next(), 1);
+    QCOMPARE(journal.realtimeUsec(), quint64(1627721964791353));
+    QCOMPARE(journal.fieldValue("_SELINUX_CONTEXT").value_or(QByteArrayView()).toByteArray(), QByteArray("unconfined\n"));
+    QCOMPARE(journal.next(), 0);
+}
+
+void TestJsonReader::parseBenchmark()
+{
+    const QByteArray fixture = readFixture(JOURNAL_JSON_FORMAT_EXAMPLE);
+    QVERIFY(!fixture.isEmpty());
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    const int repetitions = 16 * 1024 * 1024 / fixture.size();
+    for (int i = 0; i < repetitions; ++i) {
+        file.write(fixture);
+    }
+    file.close();
+
+    int entries{0};
+    qint64 elapsed{0};
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+        JournaldJsonReader reader(file.fileName());
+        entries = 0;
+        while (reader.readNext()) {
+            if (reader.fieldValue("MESSAGE")) {
+                ++entries;
+            }
+        }
+        elapsed = timer.nsecsElapsed();
+    }
+    QCOMPARE(entries, 3 * repetitions);
+    qDebug() << "parsed" << entries << "entries with" << (file.size() / 1024. / 1024.) / (elapsed / 1e9) << "MiB/s";
+}
+
+QTEST_GUILESS_MAIN(TestJsonReader);
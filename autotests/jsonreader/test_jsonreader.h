@@ -0,0 +1,43 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef TEST_JSONREADER_H
+#define TEST_JSONREADER_H
+
+#include <QObject>
+
+class TestJsonReader : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    /**
+     * JSON output of journalctl provides the same fields as the export format of the same entries
+     */
+    void sameAsExportFormat();
+    /**
+     * Escape sequences, byte arrays, multiple values and omitted values are decoded
+     */
+    void valueEncodings();
+    /**
+     * Entries of the json-pretty and json-seq variants are read as well
+     */
+    void outputVariants();
+    void malformedInput_data();
+    void malformedInput();
+    /**
+     * Compressed JSON files are decompressed and streamed while parsing
+     */
+    void compressedInput();
+    /**
+     * JSON files are imported into in-memory journals like export files
+     */
+    void memoryJournal();
+    /**
+     * Parse throughput for scaled up fixtures, the throughput is reported in debug output
+     */
+    void parseBenchmark();
+};
+#endif
@@ -7,11 +7,15 @@
 #include "../testdatalocation.h"
 #include <QDebug>
 #include <QDir>
+#include <QSignalSpy>
 #include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QTest>
 #include <QVector>
+#include <algorithm>
+#include <journalfileheader.h>
 #include <localjournal.h>
+#include <systemd/sd-journal.h>
 
 // note: this test request several data from a real example journald database
 //       you can check them by using "journalctl -D journal" and requesting the values
@@ -24,4 +28,203 @@ void TestLocalJournal::journalAccess()
     QCOMPARE(journal.usage(), 12845056);
 }
 
+void TestLocalJournal::readingInterface()
+{
+    LocalJournal journal(JOURNAL_LOCATION);
+    IJournal &reader = journal;
+    QVERIFY(reader.setFilter(FilterExpression::match(QLatin1String("_BOOT_ID"), mBoots.at(0))));
+
+    QVERIFY(reader.seekHead());
+    QCOMPARE(reader.next(), 1);
+    const QString firstCursor = reader.cursor();
+    QVERIFY(reader.testCursor(firstCursor));
+    QVERIFY(reader.realtimeUsec() > 0);
+    QCOMPARE(reader.fieldValue("_BOOT_ID").value_or(QByteArrayView()).toByteArray(), mBoots.at(0).toLatin1());
+    QVERIFY(!reader.fieldValue("NOT_EXISTING_FIELD").has_value());
+
+    // stepping by a count moves like the same number of single steps
+    QCOMPARE(reader.next(9), 9);
+    const QString tenthCursor = reader.cursor();
+    QVERIFY(reader.seekHead());
+    for (int i = 0; i < 10; ++i) {
+        QCOMPARE(reader.next(), 1);
+    }
+    QCOMPARE(reader.cursor(), tenthCursor);
+    QCOMPARE(reader.previous(9), 9);
+    QCOMPARE(reader.cursor(), firstCursor);
+
+    QVERIFY(reader.seekCursor(tenthCursor));
+    QCOMPARE(reader.next(), 1);
+    QVERIFY(reader.testCursor(tenthCursor));
+
+    QVector<QString> boots = reader.queryUnique(QLatin1String("_BOOT_ID"));
+    std::sort(boots.begin(), boots.end());
+    QStringList expectedBoots = mBoots;
+    std::sort(expectedBoots.begin(), expectedBoots.end());
+    QCOMPARE(boots, QVector<QString>(expectedBoots.cbegin(), expectedBoots.cend()));
+}
+
+void TestLocalJournal::directoryChangeNotification()
+{
+    const QString sourceDir = QLatin1String(JOURNAL_LOCATION) + QLatin1String("/83fc99b40aab448f8004215d83cb3f66/");
+    QTemporaryDir journalDir;
+    QVERIFY(journalDir.isValid());
+    QVERIFY(QFile::copy(sourceDir + QLatin1String("system@c485fef5d17c4272a4a539c4e4708f9e-0000000000000191-0005bd6c979f361b.journal"),
+                        journalDir.path() + QLatin1String("/system@c485fef5d17c4272a4a539c4e4708f9e-0000000000000191-0005bd6c979f361b.journal")));
+
+    LocalJournal journal(journalDir.path());
+    QVERIFY(journal.isValid());
+    QSignalSpy spy(&journal, &IJournal::journalUpdated);
+
+    // adding a journal file invalidates the journal's file set
+    QVERIFY(QFile::copy(sourceDir + QLatin1String("system@df3342d6d57b442da21c78027d3991f8-0000000000000191-0005bd6cc97083b1.journal"),
+                        journalDir.path() + QLatin1String("/system@df3342d6d57b442da21c78027d3991f8-0000000000000191-0005bd6cc97083b1.journal")));
+    QTRY_VERIFY(spy.count() > 0);
+    QCOMPARE(spy.last().at(1).value<IJournal::ChangeType>(), IJournal::ChangeType::INVALIDATE);
+}
+
+namespace
+{
+int countEntries(sd_journal *journal, const QString &bootId)
+{
+    sd_journal_flush_matches(journal);
+    const QByteArray match = QByteArray("_BOOT_ID=") + bootId.toLatin1();
+    sd_journal_add_match(journal, match.constData(), 0);
+    int count{0};
+    SD_JOURNAL_FOREACH(journal)
+    {
+        ++count;
+    }
+    return count;
+}
+}
+
+void TestLocalJournal::filePruning()
+{
+    LocalJournal referenceJournal(JOURNAL_LOCATION);
+    for (const QString &bootId : mBoots) {
+        LocalJournal journal(JOURNAL_LOCATION);
+        journal.prepareQuery(FilterExpression::match(QLatin1String("_BOOT_ID"), bootId));
+        QVERIFY(journal.isValid());
+        QVERIFY(!journal.openedFiles().isEmpty());
+        QVERIFY(journal.openedFiles().size() < 10);
+        QCOMPARE(countEntries(journal.sdJournal(), bootId), countEntries(referenceJournal.sdJournal(), bootId));
+    }
+
+    // file of boot 27acae2fe35a40ac93f9c7732c0b8e59 is outside of time range
+    LocalJournal journal(JOURNAL_LOCATION);
+    journal.prepareQuery(FilterExpression::inRealtimeRange(QDateTime::fromMSecsSinceEpoch(1615648981464), QDateTime::fromMSecsSinceEpoch(1615648982000)));
+    QVERIFY(std::any_of(journal.openedFiles().cbegin(), journal.openedFiles().cend(), [](const QString &file) {
+        return file.endsWith(QLatin1String("system@c485fef5d17c4272a4a539c4e4708f9e-0000000000000191-0005bd6c979f361b.journal"));
+    }));
+    QVERIFY(std::none_of(journal.openedFiles().cbegin(), journal.openedFiles().cend(), [](const QString &file) {
+        return file.contains(QLatin1String("df3342d6d57b442da21c78027d3991f8"));
+    }));
+
+    // unconstrained query opens complete directory again
+    journal.prepareQuery(FilterExpression());
+    QVERIFY(journal.openedFiles().isEmpty());
+    QCOMPARE(journal.usage(), 12845056);
+}
+
+void TestLocalJournal::prunedDirectoryChange()
+{
+    const QString sourceDir = QLatin1String(JOURNAL_LOCATION) + QLatin1String("/83fc99b40aab448f8004215d83cb3f66/");
+    const QString firstFile = QLatin1String("system@c485fef5d17c4272a4a539c4e4708f9e-0000000000000191-0005bd6c979f361b.journal");
+    const QString secondFile = QLatin1String("system@c485fef5d17c4272a4a539c4e4708f9e-000000000000033f-0005bd6c97ab07c6.journal");
+    const QString otherBootFile = QLatin1String("system@df3342d6d57b442da21c78027d3991f8-0000000000000191-0005bd6cc97083b1.journal");
+    QTemporaryDir journalDir;
+    QVERIFY(journalDir.isValid());
+    QVERIFY(QFile::copy(sourceDir + firstFile, journalDir.filePath(firstFile)));
+    QVERIFY(QFile::copy(sourceDir + otherBootFile, journalDir.filePath(otherBootFile)));
+
+    const FilterExpression filter = FilterExpression::match(QLatin1String("_BOOT_ID"), mBoots.at(0));
+    LocalJournal journal(journalDir.path());
+    journal.prepareQuery(filter);
+    QVERIFY(journal.setFilter(filter));
+    QCOMPARE(journal.openedFiles(), QStringList{journalDir.filePath(firstFile)});
+    QSignalSpy spy(&journal, &IJournal::journalUpdated);
+
+    // the rotated continuation of the boot is opened as well
+    QVERIFY(QFile::copy(sourceDir + secondFile, journalDir.filePath(secondFile)));
+    QTRY_COMPARE(journal.openedFiles().size(), 2);
+    QTRY_VERIFY(spy.count() > 0);
+    QCOMPARE(spy.last().at(1).value<IJournal::ChangeType>(), IJournal::ChangeType::INVALIDATE);
+
+    // the filter still applies after reopening
+    LocalJournal referenceJournal(journalDir.path());
+    QVERIFY(journal.seekHead());
+    int entries{0};
+    while (journal.next() > 0) {
+        ++entries;
+    }
+    QCOMPARE(entries, countEntries(referenceJournal.sdJournal(), mBoots.at(0)));
+}
+
+void TestLocalJournal::interleavedStreamPruning()
+{
+    const QString seqnumId = QLatin1String("c485fef5d17c4272a4a539c4e4708f9e");
+    const QString bootB = QLatin1String("0000000000000000000000000000000b");
+    const QString bootC = QLatin1String("0000000000000000000000000000000c");
+    const QString bootD = QLatin1String("0000000000000000000000000000000d");
+    auto header = [&seqnumId](const QString &name, quint64 headSeqnum, quint64 tailSeqnum, quint64 headRealtime, quint64 tailRealtime, const QString &tailBoot) {
+        JournalFileHeader header;
+        header.mPath = QLatin1String("/var/log/journal/83fc99b40aab448f8004215d83cb3f66/") + name;
+        header.mState = JournalFileHeader::State::ARCHIVED;
+        header.mSeqnumId = seqnumId;
+        header.mTailEntryBootId = tailBoot;
+        header.mHeadEntrySeqnum = headSeqnum;
+        header.mTailEntrySeqnum = tailSeqnum;
+        header.mEntryCount = tailSeqnum - headSeqnum + 1;
+        header.mHeadEntryRealtime = headRealtime;
+        header.mTailEntryRealtime = tailRealtime;
+        return header;
+    };
+    // system file with boot B, system file with all of boot C but the first entry of boot D as last entry, and a
+    // user file that was rotated during boot C; its sequence numbers interleave with the second system file
+    const QVector<JournalFileHeader> headers{
+        header(QLatin1String("system@") + seqnumId + QLatin1String("-0000000000000001-0005bd6c979f361b.journal"), 1, 10, 100, 200, bootB),
+        header(QLatin1String("system@") + seqnumId + QLatin1String("-000000000000000b-0005bd6c97ab07c6.journal"), 11, 30, 230, 400, bootD),
+        header(QLatin1String("user-1000@") + seqnumId + QLatin1String("-0000000000000019-0005bd6c97ab1000.journal"), 25, 28, 300, 350, bootC),
+    };
+
+    const QVector<JournalFileHeader> selected = JournalFileHeader::select(headers, FilterExpression::match(QLatin1String("_BOOT_ID"), bootC));
+    QStringList paths;
+    for (const JournalFileHeader &file : selected) {
+        paths.append(file.mPath);
+    }
+    QCOMPARE(paths, (QStringList{headers.at(1).mPath, headers.at(2).mPath}));
+}
+
+void TestLocalJournal::stopWatching()
+{
+    const QString sourceDir = QLatin1String(JOURNAL_LOCATION) + QLatin1String("/83fc99b40aab448f8004215d83cb3f66/");
+    const QString firstFile = QLatin1String("system@c485fef5d17c4272a4a539c4e4708f9e-0000000000000191-0005bd6c979f361b.journal");
+    const QString secondFile = QLatin1String("system@c485fef5d17c4272a4a539c4e4708f9e-000000000000033f-0005bd6c97ab07c6.journal");
+    const QString otherBootFile = QLatin1String("system@df3342d6d57b442da21c78027d3991f8-0000000000000191-0005bd6cc97083b1.journal");
+    QTemporaryDir journalDir;
+    QVERIFY(journalDir.isValid());
+    QVERIFY(QFile::copy(sourceDir + firstFile, journalDir.filePath(firstFile)));
+    QVERIFY(QFile::copy(sourceDir + otherBootFile, journalDir.filePath(otherBootFile)));
+
+    LocalJournal journal(journalDir.path());
+    LocalJournal prunedJournal(journalDir.path());
+    journal.stopWatching();
+    prunedJournal.stopWatching();
+    // reopening files for a query does not start watching again
+    const FilterExpression filter = FilterExpression::match(QLatin1String("_BOOT_ID"), mBoots.at(0));
+    prunedJournal.prepareQuery(filter);
+    QCOMPARE(prunedJournal.openedFiles(), QStringList{journalDir.filePath(firstFile)});
+    QSignalSpy spy(&journal, &IJournal::journalUpdated);
+    QSignalSpy prunedSpy(&prunedJournal, &IJournal::journalUpdated);
+
+    QVERIFY(QFile::copy(sourceDir + secondFile, journalDir.filePath(secondFile)));
+    QTest::qWait(500);
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(prunedSpy.count(), 0);
+    QCOMPARE(prunedJournal.openedFiles(), QStringList{journalDir.filePath(firstFile)});
+    QVERIFY(journal.seekHead());
+    QCOMPARE(journal.next(), 1);
+}
+
 QTEST_GUILESS_MAIN(TestLocalJournal);
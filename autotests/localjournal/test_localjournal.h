@@ -14,6 +14,31 @@ class TestLocalJournal : public QObject
 
 private Q_SLOTS:
     void journalAccess();
+    /**
+     * Reading methods of IJournal follow the sd_journal functions they wrap
+     */
+    void readingInterface();
+    /**
+     * Journal opened from a directory reports added journal files
+     */
+    void directoryChangeNotification();
+    /**
+     * Queries for a boot or time range only open files that may contain matching entries
+     */
+    void filePruning();
+    /**
+     * Journal with a subset of opened files updates the subset when files are added to the directory
+     */
+    void prunedDirectoryChange();
+    /**
+     * Files of system and user journals share the sequence numbers, a boot in the middle of a system file
+     * must not be pruned because a user file ends with the boot
+     */
+    void interleavedStreamPruning();
+    /**
+     * Journal that stopped watching neither reports nor applies changes of the directory
+     */
+    void stopWatching();
 
 private:
     const QStringList mBoots{"68f2e61d061247d8a8ba0b8d53a97a52", "27acae2fe35a40ac93f9c7732c0b8e59", "2dbe99dd855049af8f2865c5da2b8fda"};
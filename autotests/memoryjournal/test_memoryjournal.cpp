@@ -0,0 +1,374 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "test_memoryjournal.h"
+#include "../testdatalocation.h"
+#include <QAbstractItemModelTester>
+#include <QBuffer>
+#include <QDebug>
+#include <QFile>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+#include <bootmodel.h>
+#include <journaldexportreader.h>
+#include <journaldexportwriter.h>
+#include <journaldviewmodel.h>
+#include <localjournal.h>
+#include <memoryjournal.h>
+#include <algorithm>
+
+namespace
+{
+const QString sFirstCursor{
+    QLatin1String("s=739ad463348b4ceca5a9e69c95a3c93f;i=4ece7;b=6c7c6013a26343b29e964691ff25d04c;m=4fc72436e;t=4c508a72423d9;x=d3e5610681098c10;p=system.journal")};
+const QString sSecondCursor{
+    QLatin1String("s=739ad463348b4ceca5a9e69c95a3c93f;i=4ece8;b=6c7c6013a26343b29e964691ff25d04c;m=4fc72572f;t=4c508a7243799;x=68597058a89b7246;p=system.journal")};
+constexpr quint64 sFirstRealtime{1342540861416409};
+constexpr quint64 sSecondRealtime{1342540861421465};
+
+QByteArray exportJournal()
+{
+    QBuffer buffer;
+    JournaldExportWriter writer;
+    QSignalSpy spy(&writer, &JournaldExportWriter::finished);
+    if (!writer.start(std::make_unique<LocalJournal>(JOURNAL_LOCATION), FilterExpression(), &buffer, JournaldExportWriter::Format::EXPORT)) {
+        return QByteArray();
+    }
+    writer.waitForFinished();
+    if (spy.count() != 1 || !spy.first().at(0).toBool()) {
+        return QByteArray();
+    }
+    return buffer.data();
+}
+
+QStringList readCursors(JournaldViewModel &model)
+{
+    // fetch until the whole result set is part of the model
+    for (int i = 0; i < 100 && model.canFetchMore(QModelIndex()); ++i) {
+        model.fetchMore(QModelIndex());
+    }
+    QStringList cursors;
+    for (int row = 0; row < model.rowCount(); ++row) {
+        cursors.append(model.data(model.index(row, 0), JournaldViewModel::Roles::CURSOR).toString());
+    }
+    return cursors;
+}
+}
+
+void TestMemoryJournal::initTestCase()
+{
+    // BootModel of journal files uses the default metadata cache
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void TestMemoryJournal::fieldAccess()
+{
+    MemoryJournal journal(QString::fromLocal8Bit(JOURNAL_EXPORT_FORMAT_EXAMPLE));
+    QVERIFY(journal.isValid());
+    QCOMPARE(journal.sdJournal(), nullptr);
+    QCOMPARE(journal.entryCount(), qint64(2));
+
+    journal.seekHead();
+    QCOMPARE(journal.next(), 1);
+    QCOMPARE(journal.cursor(), sFirstCursor);
+    QCOMPARE(journal.realtimeUsec(), sFirstRealtime);
+    QCOMPARE(journal.monotonicUsec(), quint64(21415215982));
+    QCOMPARE(journal.fieldValue("PRIORITY").value_or(QByteArrayView()).toByteArray(), QByteArray("4"));
+    QCOMPARE(journal.fieldValue("_EXE").value_or(QByteArrayView()).toByteArray(), QByteArray("/usr/libexec/gdm-session-worker"));
+    QCOMPARE(journal.fieldValue("__REALTIME_TIMESTAMP").value_or(QByteArrayView()).toByteArray(), QByteArray("1342540861416409"));
+    QVERIFY(!journal.fieldValue("MESSAGE_ID").has_value());
+
+    QCOMPARE(journal.next(), 1);
+    QCOMPARE(journal.cursor(), sSecondCursor);
+    QCOMPARE(journal.fieldValue("MESSAGE").value_or(QByteArrayView()).toByteArray(), QByteArray("(root) CMD (run-parts /etc/cron.hourly)"));
+    QCOMPARE(journal.next(), 0);
+
+    QVector<QString> executables = journal.queryUnique(QLatin1String("_EXE"));
+    std::sort(executables.begin(), executables.end());
+    QCOMPARE(executables, (QVector<QString>{QLatin1String("/usr/bin/bash"), QLatin1String("/usr/libexec/gdm-session-worker")}));
+    QCOMPARE(journal.queryUnique(QLatin1String("_BOOT_ID")), QVector<QString>{QLatin1String("6c7c6013a26343b29e964691ff25d04c")});
+    QVERIFY(journal.queryUnique(QLatin1String("UNKNOWN_FIELD")).isEmpty());
+
+    // clones share the entries, but have their own position
+    std::unique_ptr<IJournal> clone = journal.clone();
+    auto memoryClone = qobject_cast<MemoryJournal *>(clone.get());
+    QVERIFY(memoryClone);
+    QCOMPARE(memoryClone->entryCount(), qint64(2));
+    QCOMPARE(memoryClone->next(), 1);
+    QCOMPARE(memoryClone->cursor(), sFirstCursor);
+    QCOMPARE(journal.cursor(), sSecondCursor);
+}
+
+void TestMemoryJournal::binaryFieldAccess()
+{
+    MemoryJournal journal(QString::fromLocal8Bit(JOURNAL_EXPORT_FORMAT_BINARY_EXAMPLE));
+    QVERIFY(journal.isValid());
+    QCOMPARE(journal.entryCount(), qint64(1));
+    QCOMPARE(journal.next(), 1);
+    QCOMPARE(journal.fieldValue("MESSAGE").value_or(QByteArrayView()).toByteArray(), QByteArray("foo\nbar"));
+    QCOMPARE(journal.fieldValue("_SELINUX_CONTEXT").value_or(QByteArrayView()).toByteArray(), QByteArray("unconfined\n"));
+    QCOMPARE(journal.fieldValue("_AUDIT_LOGINUID").value_or(QByteArrayView()).toByteArray(), QByteArray("1000"));
+
+    // a missing file results in an invalid journal
+    MemoryJournal missing(QLatin1String("/nonexistent/journal.export"));
+    QVERIFY(!missing.isValid());
+    QCOMPARE(missing.entryCount(), qint64(0));
+}
+
+void TestMemoryJournal::navigation()
+{
+    MemoryJournal journal(QString::fromLocal8Bit(JOURNAL_EXPORT_FORMAT_EXAMPLE));
+
+    journal.seekTail();
+    QCOMPARE(journal.previous(), 1);
+    QCOMPARE(journal.cursor(), sSecondCursor);
+    QCOMPARE(journal.previous(), 1);
+    QCOMPARE(journal.cursor(), sFirstCursor);
+    QCOMPARE(journal.previous(), 0);
+
+    // seeking a cursor does not make its entry current, but both directions step onto it
+    QVERIFY(journal.seekCursor(sSecondCursor));
+    QCOMPARE(journal.next(), 1);
+    QVERIFY(journal.testCursor(sSecondCursor));
+    QVERIFY(journal.seekCursor(sSecondCursor));
+    QCOMPARE(journal.previous(), 1);
+    QVERIFY(journal.testCursor(sSecondCursor));
+    QVERIFY(!journal.testCursor(sFirstCursor));
+    QVERIFY(!journal.seekCursor(QLatin1String("s=0;i=1;b=0;m=0;t=0;x=0")));
+
+    // realtime seeking positions between the entries before and at/after the timestamp
+    journal.seekRealtime(sFirstRealtime + 1);
+    QCOMPARE(journal.next(), 1);
+    QCOMPARE(journal.realtimeUsec(), sSecondRealtime);
+    journal.seekRealtime(sFirstRealtime + 1);
+    QCOMPARE(journal.previous(), 1);
+    QCOMPARE(journal.realtimeUsec(), sFirstRealtime);
+    journal.seekRealtime(sSecondRealtime);
+    QCOMPARE(journal.previous(), 1);
+    QCOMPARE(journal.realtimeUsec(), sSecondRealtime);
+    journal.seekRealtime(sSecondRealtime + 1);
+    QCOMPARE(journal.next(), 0);
+
+    journal.seekHead();
+    QCOMPARE(journal.next(5), 2);
+    QCOMPARE(journal.cursor(), sSecondCursor);
+    QCOMPARE(journal.next(5), 0);
+}
+
+void TestMemoryJournal::filter()
+{
+    MemoryJournal journal(QString::fromLocal8Bit(JOURNAL_EXPORT_FORMAT_EXAMPLE));
+
+    // indexed field
+    journal.setFilter(FilterExpression::matchAny(QLatin1String("PRIORITY"), {QLatin1String("5"), QLatin1String("6")}));
+    QCOMPARE(journal.next(), 1);
+    QCOMPARE(journal.cursor(), sSecondCursor);
+    QCOMPARE(journal.next(), 0);
+
+    // cursor of an entry that does not match is located between the matching entries
+    QVERIFY(journal.seekCursor(sFirstCursor));
+    QCOMPARE(journal.previous(), 0);
+    QVERIFY(journal.seekCursor(sFirstCursor));
+    QCOMPARE(journal.next(), 1);
+    QCOMPARE(journal.cursor(), sSecondCursor);
+
+    // not indexed field combined with indexed field
+    journal.setFilter(FilterExpression::allOf({FilterExpression::match(QLatin1String("_COMM"), QLatin1String("run-parts")),
+                                               FilterExpression::match(QLatin1String("_TRANSPORT"), QLatin1String("syslog"))}));
+    QCOMPARE(journal.next(), 1);
+    QCOMPARE(journal.cursor(), sSecondCursor);
+    QCOMPARE(journal.next(), 0);
+
+    // disjunction of terms
+    journal.setFilter(FilterExpression::anyOf({FilterExpression::match(QLatin1String("_EXE"), QLatin1String("/usr/bin/bash")),
+                                               FilterExpression::match(QLatin1String("SYSLOG_PID"), QLatin1String("587"))}));
+    QCOMPARE(journal.next(5), 2);
+
+    // contradicting matches
+    journal.setFilter(FilterExpression::allOf({FilterExpression::match(QLatin1String("_EXE"), QLatin1String("/usr/bin/bash")),
+                                               FilterExpression::match(QLatin1String("PRIORITY"), QLatin1String("4"))}));
+    QCOMPARE(journal.next(), 0);
+
+    // residual part is not evaluated
+    journal.setFilter(FilterExpression::contains(QLatin1String("MESSAGE"), QLatin1String("cron")));
+    QCOMPARE(journal.next(5), 2);
+
+    journal.setFilter(FilterExpression());
+    QCOMPARE(journal.next(5), 2);
+}
+
+void TestMemoryJournal::append()
+{
+    QFile file(QString::fromLocal8Bit(JOURNAL_EXPORT_FORMAT_EXAMPLE));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray data = file.readAll();
+    const qsizetype secondEntry = data.indexOf("\n\n") + 2;
+
+    MemoryJournal journal;
+    QSignalSpy spy(&journal, &IJournal::journalUpdated);
+    QVERIFY(journal.isValid());
+    QCOMPARE(journal.entryCount(), qint64(0));
+    journal.setFilter(FilterExpression::match(QLatin1String("PRIORITY"), QLatin1String("6")));
+    QCOMPARE(journal.next(), 0);
+
+    JournaldExportReader reader;
+    reader.addData(QByteArrayView(data).first(secondEntry));
+    QCOMPARE(journal.append(reader), qint64(1));
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().at(1).value<IJournal::ChangeType>(), IJournal::ChangeType::APPEND);
+    QCOMPARE(journal.entryCount(), qint64(1));
+    QCOMPARE(journal.next(), 0);
+    std::unique_ptr<IJournal> clone = journal.clone();
+
+    // incomplete entry is not appended
+    reader.addData(QByteArrayView(data).sliced(secondEntry, 100));
+    QCOMPARE(journal.append(reader), qint64(0));
+    QCOMPARE(spy.count(), 1);
+
+    reader.addData(QByteArrayView(data).sliced(secondEntry + 100));
+    QCOMPARE(journal.append(reader), qint64(1));
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(journal.entryCount(), qint64(2));
+    // the position after the last matching entry is continued like for sd_journal objects
+    QCOMPARE(journal.next(), 1);
+    QCOMPARE(journal.cursor(), sSecondCursor);
+    QCOMPARE(journal.queryUnique(QLatin1String("PRIORITY")).size(), qsizetype(2));
+
+    QCOMPARE(qobject_cast<MemoryJournal *>(clone.get())->entryCount(), qint64(1));
+    QCOMPARE(clone->next(), 1);
+    QCOMPARE(clone->cursor(), sFirstCursor);
+    QCOMPARE(clone->next(), 0);
+}
+
+void TestMemoryJournal::appendToClonedStore()
+{
+    QFile file(QString::fromLocal8Bit(JOURNAL_EXPORT_FORMAT_EXAMPLE));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray data = file.readAll();
+    const qsizetype secondEntry = data.indexOf("\n\n") + 2;
+    const QByteArrayView firstEntryData = QByteArrayView(data).first(secondEntry);
+    const QByteArrayView secondEntryData = QByteArrayView(data).sliced(secondEntry);
+
+    // alternately append both entries, such that clones end with the first entry
+    MemoryJournal journal;
+    JournaldExportReader reader;
+    std::vector<std::pair<qint64, std::unique_ptr<IJournal>>> clones;
+    for (qint64 entries = 0; entries < 5000; entries += 2) {
+        reader.addData(firstEntryData);
+        QCOMPARE(journal.append(reader), qint64(1));
+        if (entries == 10 || entries == 4094 || entries == 4096) {
+            clones.push_back({entries + 1, journal.clone()});
+        }
+        reader.addData(secondEntryData);
+        QCOMPARE(journal.append(reader), qint64(1));
+    }
+    QCOMPARE(journal.entryCount(), qint64(5000));
+    QVERIFY(journal.seekTail());
+    QCOMPARE(journal.previous(), 1);
+    QCOMPARE(journal.cursor(), sSecondCursor);
+
+    QCOMPARE(clones.size(), std::size_t(3));
+    for (const auto &[entryCount, clone] : clones) {
+        QCOMPARE(qobject_cast<MemoryJournal *>(clone.get())->entryCount(), entryCount);
+        QVERIFY(clone->seekTail());
+        QCOMPARE(clone->previous(), 1);
+        QCOMPARE(clone->cursor(), sFirstCursor);
+        QCOMPARE(clone->realtimeUsec(), sFirstRealtime);
+    }
+}
+
+void TestMemoryJournal::appendWithBootFilter()
+{
+    QFile file(QString::fromLocal8Bit(JOURNAL_EXPORT_FORMAT_EXAMPLE));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray data = file.readAll();
+    const qsizetype secondEntry = data.indexOf("\n\n") + 2;
+
+    auto journal = std::make_unique<MemoryJournal>();
+    MemoryJournal *journalPtr = journal.get();
+    JournaldViewModel model;
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::Fatal);
+    QVERIFY(model.setJournal(std::move(journal)));
+    model.setBootFilter({QLatin1String("6c7c6013a26343b29e964691ff25d04c")});
+    QCOMPARE(model.rowCount(), 0);
+
+    // the update notification does not name the boot of the appended entries
+    JournaldExportReader reader;
+    reader.addData(QByteArrayView(data).first(secondEntry));
+    QCOMPARE(journalPtr->append(reader), qint64(1));
+    QCOMPARE(model.rowCount(), 1);
+    reader.addData(QByteArrayView(data).sliced(secondEntry));
+    QCOMPARE(journalPtr->append(reader), qint64(1));
+    QCOMPARE(model.rowCount(), 2);
+    QCOMPARE(model.data(model.index(1, 0), JournaldViewModel::Roles::CURSOR).toString(), sSecondCursor);
+}
+
+void TestMemoryJournal::viewModel_data()
+{
+    QTest::addColumn<QStringList>("boots");
+    QTest::addColumn<int>("priority");
+    QTest::addColumn<bool>("kernel");
+    QTest::addColumn<QStringList>("units");
+
+    QTest::newRow("unfiltered") << QStringList() << -1 << false << QStringList();
+    QTest::newRow("boot") << QStringList{QLatin1String("68f2e61d061247d8a8ba0b8d53a97a52")} << -1 << false << QStringList();
+    QTest::newRow("boot with kernel") << QStringList{QLatin1String("27acae2fe35a40ac93f9c7732c0b8e59")} << -1 << true << QStringList();
+    QTest::newRow("priority") << QStringList() << 4 << true << QStringList();
+    QTest::newRow("unit") << QStringList() << -1 << false << QStringList{QLatin1String("systemd-timesyncd.service")};
+}
+
+void TestMemoryJournal::viewModel()
+{
+    QFETCH(QStringList, boots);
+    QFETCH(int, priority);
+    QFETCH(bool, kernel);
+    QFETCH(QStringList, units);
+
+    const QByteArray data = exportJournal();
+    QVERIFY(!data.isEmpty());
+    JournaldExportReader reader{QByteArrayView(data)};
+
+    JournaldViewModel memoryModel;
+    QAbstractItemModelTester tester(&memoryModel, QAbstractItemModelTester::FailureReportingMode::Fatal);
+    QVERIFY(memoryModel.setJournal(std::make_unique<MemoryJournal>(reader)));
+    JournaldViewModel localModel;
+    QVERIFY(localModel.setJournaldPath(JOURNAL_LOCATION));
+
+    for (JournaldViewModel *model : {&memoryModel, &localModel}) {
+        model->setFetchMoreChunkSize(100);
+        model->setBootFilter(boots);
+        model->setPriorityFilter(priority);
+        model->setKernelFilter(kernel);
+        model->setSystemdUnitFilter(units);
+    }
+    const QStringList expectedCursors = readCursors(localModel);
+    QVERIFY(!expectedCursors.isEmpty());
+    QCOMPARE(readCursors(memoryModel), expectedCursors);
+
+    // window is extended from both ends after seeking the tail
+    memoryModel.seekTail();
+    localModel.seekTail();
+    QCOMPARE(readCursors(memoryModel), readCursors(localModel));
+}
+
+void TestMemoryJournal::bootModel()
+{
+    const QByteArray data = exportJournal();
+    QVERIFY(!data.isEmpty());
+    JournaldExportReader reader{QByteArrayView(data)};
+
+    BootModel memoryModel(std::make_unique<MemoryJournal>(reader));
+    BootModel localModel(JOURNAL_LOCATION);
+    QTRY_COMPARE(memoryModel.rowCount(), 3);
+    QTRY_COMPARE(localModel.rowCount(), memoryModel.rowCount());
+    for (int row = 0; row < localModel.rowCount(); ++row) {
+        for (int role : {BootModel::Roles::BOOT_ID, BootModel::Roles::SINCE, BootModel::Roles::UNTIL}) {
+            QCOMPARE(memoryModel.data(memoryModel.index(row, 0), role), localModel.data(localModel.index(row, 0), role));
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestMemoryJournal);
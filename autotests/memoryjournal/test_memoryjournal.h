@@ -0,0 +1,49 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef TEST_MEMORYJOURNAL_H
+#define TEST_MEMORYJOURNAL_H
+
+#include <QObject>
+
+class TestMemoryJournal : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    /**
+     * The boot model of journal files writes its metadata cache to the test locations
+     */
+    void initTestCase();
+    void fieldAccess();
+    void binaryFieldAccess();
+    /**
+     * Seek and step operations follow the semantics of the sd_journal functions
+     */
+    void navigation();
+    void filter();
+    /**
+     * Appended entries are visible to the current filter and position, but not to clones
+     */
+    void append();
+    /**
+     * Appended entries are shown by a view model that filters for their boot
+     */
+    void appendWithBootFilter();
+    /**
+     * Clones keep their entries when appending beyond the current chunk of the shared store
+     */
+    void appendToClonedStore();
+    /**
+     * View model shows the same entries for an in-memory journal as for the journal files the export was created from
+     */
+    void viewModel_data();
+    void viewModel();
+    /**
+     * Boot model lists the same boots for an in-memory journal as for the journal files the export was created from
+     */
+    void bootModel();
+};
+#endif
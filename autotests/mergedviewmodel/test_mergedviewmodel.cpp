@@ -0,0 +1,99 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "test_mergedviewmodel.h"
+#include "../testdatalocation.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+#include <mergedjournaldviewmodel.h>
+#include <systemd/sd-journal.h>
+
+namespace
+{
+const QString sBootDir = QLatin1String(JOURNAL_LOCATION) + QLatin1String("/83fc99b40aab448f8004215d83cb3f66/");
+const QString sJournalFileFirst = QLatin1String("system@c485fef5d17c4272a4a539c4e4708f9e-0000000000000191-0005bd6c979f361b.journal");
+const QString sJournalFileSecond = QLatin1String("system@df3342d6d57b442da21c78027d3991f8-0000000000000191-0005bd6cc97083b1.journal");
+}
+
+bool TestMergedViewModel::fetchAll(MergedJournaldViewModel &model)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (model.canFetchMore(QModelIndex())) {
+        if (timer.elapsed() > 30000) {
+            return false;
+        }
+        model.fetchMore(QModelIndex());
+        QTest::qWait(1);
+    }
+    return true;
+}
+
+void TestMergedViewModel::mergeIdenticalJournals()
+{
+    // count entries with plain sd-journal API as reference
+    sd_journal *journal{nullptr};
+    QCOMPARE(sd_journal_open_directory(&journal, JOURNAL_LOCATION, 0), 0);
+    int expectedEntries{0};
+    SD_JOURNAL_FOREACH(journal)
+    {
+        ++expectedEntries;
+    }
+    sd_journal_close(journal);
+    QVERIFY(expectedEntries > 0);
+
+    MergedJournaldViewModel model;
+    model.setFetchMoreChunkSize(100);
+    model.setJournalPaths({QLatin1String(JOURNAL_LOCATION), QLatin1String(JOURNAL_LOCATION)});
+    QCOMPARE(model.sourceCount(), 2);
+    QVERIFY(fetchAll(model));
+    QCOMPARE(model.rowCount(), 2 * expectedEntries);
+
+    QVector<int> entriesPerSource{0, 0};
+    QDateTime previous;
+    for (int i = 0; i < model.rowCount(); ++i) {
+        const QModelIndex index = model.index(i, 0);
+        const QDateTime date = model.data(index, JournaldViewModel::DATETIME).toDateTime();
+        QVERIFY2(!previous.isValid() || previous <= date, qPrintable(QString::number(i)));
+        previous = date;
+        ++entriesPerSource[model.data(index, MergedJournaldViewModel::SOURCE).toInt()];
+    }
+    QCOMPARE(entriesPerSource.at(0), expectedEntries);
+    QCOMPARE(entriesPerSource.at(1), expectedEntries);
+}
+
+void TestMergedViewModel::mergeDisjointJournals()
+{
+    QTemporaryDir firstDir;
+    QTemporaryDir secondDir;
+    QVERIFY(firstDir.isValid());
+    QVERIFY(secondDir.isValid());
+    QVERIFY(QFile::copy(sBootDir + sJournalFileFirst, firstDir.path() + QLatin1Char('/') + sJournalFileFirst));
+    QVERIFY(QFile::copy(sBootDir + sJournalFileSecond, secondDir.path() + QLatin1Char('/') + sJournalFileSecond));
+
+    // sources are given in reverse order to ensure that merging does not rely on source order
+    MergedJournaldViewModel model;
+    model.setFetchMoreChunkSize(50);
+    model.setJournalPaths({secondDir.path(), firstDir.path()});
+    QVERIFY(fetchAll(model));
+    QVERIFY(model.rowCount() > 0);
+
+    bool secondSourceReached{false};
+    for (int i = 0; i < model.rowCount(); ++i) {
+        const int source = model.data(model.index(i, 0), MergedJournaldViewModel::SOURCE).toInt();
+        if (source == 0) {
+            secondSourceReached = true;
+        } else {
+            QVERIFY2(!secondSourceReached, qPrintable(QString::number(i)));
+        }
+    }
+    QVERIFY(secondSourceReached);
+}
+
+QTEST_GUILESS_MAIN(TestMergedViewModel);
@@ -0,0 +1,34 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef TEST_MERGEDVIEWMODEL_H
+#define TEST_MERGEDVIEWMODEL_H
+
+#include <QObject>
+
+class MergedJournaldViewModel;
+
+class TestMergedViewModel : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    /**
+     * Merging a journal with itself provides every entry twice and keeps timeline order
+     */
+    void mergeIdenticalJournals();
+    /**
+     * Merging journals of consecutive boots places all entries of the earlier boot first
+     */
+    void mergeDisjointJournals();
+
+private:
+    /**
+     * fetch all entries of @p model
+     * @return true if model was completely fetched
+     */
+    bool fetchAll(MergedJournaldViewModel &model);
+};
+#endif
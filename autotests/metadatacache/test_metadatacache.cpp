@@ -0,0 +1,261 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "test_metadatacache.h"
+#include "../testdatalocation.h"
+#include <QDateTime>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QtConcurrent>
+#include <algorithm>
+#include <filterexpression.h>
+#include <journaldhelper.h>
+#include <journalfileheader.h>
+#include <journalmetadatacache.h>
+#include <localjournal.h>
+#include <memoryjournal.h>
+
+namespace
+{
+int cacheableFiles(const QVector<JournalFileHeader> &headers)
+{
+    return static_cast<int>(std::count_if(headers.cbegin(), headers.cend(), [](const JournalFileHeader &header) {
+        return header.mState != JournalFileHeader::State::ONLINE;
+    }));
+}
+
+/**
+ * copy of an archived test journal file in @p directory
+ */
+std::optional<JournalFileHeader> copyArchivedFile(const QTemporaryDir &directory)
+{
+    LocalJournal journal(JOURNAL_LOCATION);
+    const QVector<JournalFileHeader> headers = journal.queryFiles();
+    const auto archived = std::find_if(headers.cbegin(), headers.cend(), [](const JournalFileHeader &header) {
+        return header.mState == JournalFileHeader::State::ARCHIVED;
+    });
+    if (archived == headers.cend()) {
+        return std::nullopt;
+    }
+    const QString path = directory.filePath(QLatin1String("archived.journal"));
+    if (!QFile::copy(archived->mPath, path)) {
+        return std::nullopt;
+    }
+    return JournalFileHeader::read(path);
+}
+}
+
+void TestMetadataCache::initTestCase()
+{
+    // the default cache directory is below QStandardPaths::CacheLocation
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void TestMetadataCache::key()
+{
+    LocalJournal journal(JOURNAL_LOCATION);
+    const QVector<JournalFileHeader> headers = journal.queryFiles();
+    QCOMPARE(headers.size(), 11);
+    for (const JournalFileHeader &header : headers) {
+        // online files change with every entry
+        QCOMPARE(JournalMetadataCache::key(header).isEmpty(), header.mState == JournalFileHeader::State::ONLINE);
+    }
+
+    QTemporaryDir directory;
+    const std::optional<JournalFileHeader> header = copyArchivedFile(directory);
+    QVERIFY(header);
+    const QString key = JournalMetadataCache::key(header.value());
+    QVERIFY(key.startsWith(header->mFileId));
+    QFile file(header->mPath);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.setFileTime(QDateTime::currentDateTimeUtc().addDays(1), QFileDevice::FileModificationTime));
+    file.close();
+    QVERIFY(JournalMetadataCache::key(header.value()) != key);
+}
+
+void TestMetadataCache::queryMatchesJournal()
+{
+    QTemporaryDir directory;
+    JournalMetadataCache cache(directory.path());
+    LocalJournal journal(JOURNAL_LOCATION);
+    QVERIFY(journal.isValid());
+    const std::optional<JournalMetadataCache::Metadata> metadata = cache.query(journal);
+    QVERIFY(metadata);
+    QCOMPARE(metadata->mCachedFiles, 0);
+    QCOMPARE(metadata->mSummarizedFiles, 11);
+
+    const QVector<JournaldHelper::BootInfo> boots = JournaldHelper::queryOrderedBootIds(journal);
+    QCOMPARE(metadata->mBoots.size(), boots.size());
+    for (int i = 0; i < boots.size(); ++i) {
+        QCOMPARE(metadata->mBoots.at(i).mBootId, boots.at(i).mBootId);
+        QCOMPARE(metadata->mBoots.at(i).mSince, boots.at(i).mSince);
+        QCOMPARE(metadata->mBoots.at(i).mUntil, boots.at(i).mUntil);
+    }
+
+    QVector<QString> units = JournaldHelper::queryUnique(journal, JournaldHelper::Field::_SYSTEMD_UNIT);
+    std::sort(units.begin(), units.end());
+    QCOMPARE(metadata->mUnits, units);
+    QVector<QString> exes = JournaldHelper::queryUnique(journal, JournaldHelper::Field::_EXE);
+    std::sort(exes.begin(), exes.end());
+    QCOMPARE(metadata->mExes, exes);
+
+    QVERIFY(journal.setFilter(FilterExpression()));
+    QVERIFY(journal.seekHead());
+    quint64 entries{0};
+    while (journal.next() > 0) {
+        ++entries;
+    }
+    QCOMPARE(metadata->mEntryCount, entries);
+    QCOMPARE(QDateTime::fromMSecsSinceEpoch(metadata->mHeadRealtime / 1000), boots.first().mSince);
+    QCOMPARE(QDateTime::fromMSecsSinceEpoch(metadata->mTailRealtime / 1000), boots.last().mUntil);
+}
+
+void TestMetadataCache::cachedFiles()
+{
+    QTemporaryDir directory;
+    JournalMetadataCache cache(directory.filePath(QLatin1String("cache")));
+    LocalJournal journal(JOURNAL_LOCATION);
+    const QVector<JournalFileHeader> headers = journal.queryFiles();
+    const JournalMetadataCache::Metadata summarized = cache.query(headers);
+    const JournalMetadataCache::Metadata cached = cache.query(headers);
+    QCOMPARE(summarized.mCachedFiles, 0);
+    QCOMPARE(cached.mCachedFiles, cacheableFiles(headers));
+    QCOMPARE(cached.mSummarizedFiles, int(headers.size()) - cacheableFiles(headers));
+    QCOMPARE(cached.mBoots.size(), summarized.mBoots.size());
+    QCOMPARE(cached.mUnits, summarized.mUnits);
+    QCOMPARE(cached.mExes, summarized.mExes);
+    QCOMPARE(cached.mEntryCount, summarized.mEntryCount);
+
+    // changed files are summarized again
+    const std::optional<JournalFileHeader> header = copyArchivedFile(directory);
+    QVERIFY(header);
+    QCOMPARE(cache.query({header.value()}).mSummarizedFiles, 1);
+    QCOMPARE(cache.query({header.value()}).mCachedFiles, 1);
+    QFile file(header->mPath);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.setFileTime(QDateTime::currentDateTimeUtc().addDays(1), QFileDevice::FileModificationTime));
+    file.close();
+    QCOMPARE(cache.query({header.value()}).mSummarizedFiles, 1);
+}
+
+void TestMetadataCache::corruptEntry()
+{
+    QTemporaryDir directory;
+    JournalMetadataCache cache(directory.filePath(QLatin1String("cache")));
+    const std::optional<JournalFileHeader> header = copyArchivedFile(directory);
+    QVERIFY(header);
+    const QString key = JournalMetadataCache::key(header.value());
+    QVERIFY(!cache.lookup(key));
+    const std::optional<JournalMetadataCache::FileMetadata> metadata = JournalMetadataCache::summarize(header.value());
+    QVERIFY(metadata);
+    QCOMPARE(metadata->mEntryCount, header->mEntryCount);
+    QVERIFY(cache.insert(key, metadata.value()));
+    QVERIFY(cache.lookup(key));
+    QCOMPARE(cache.lookup(key)->mUnits, metadata->mUnits);
+
+    QFile entry(cache.directory() + QLatin1Char('/') + key + QLatin1String(".metadata"));
+    QVERIFY(entry.open(QIODevice::ReadWrite));
+    QVERIFY(entry.resize(entry.size() / 2));
+    entry.close();
+    QVERIFY(!cache.lookup(key));
+    // corrupt entries are replaced
+    QCOMPARE(cache.query({header.value()}).mSummarizedFiles, 1);
+    QVERIFY(cache.lookup(key));
+}
+
+void TestMetadataCache::eviction()
+{
+    QTemporaryDir directory;
+    JournalMetadataCache cache(directory.filePath(QLatin1String("cache")), 2);
+    QCOMPARE(cache.maxEntries(), 2);
+    const QStringList keys{QLatin1String("a"), QLatin1String("b"), QLatin1String("c")};
+    for (int i = 0; i < keys.size(); ++i) {
+        QVERIFY(cache.insert(keys.at(i), JournalMetadataCache::FileMetadata()));
+        QFile entry(cache.directory() + QLatin1Char('/') + keys.at(i) + QLatin1String(".metadata"));
+        QVERIFY(entry.open(QIODevice::ReadWrite));
+        QVERIFY(entry.setFileTime(QDateTime::currentDateTimeUtc().addSecs(60 * (i - keys.size())), QFileDevice::FileModificationTime));
+    }
+    // looking up an entry marks it as most recently used
+    QVERIFY(cache.lookup(QLatin1String("a")));
+    cache.evict();
+    QVERIFY(cache.lookup(QLatin1String("a")));
+    QVERIFY(!cache.lookup(QLatin1String("b")));
+    QVERIFY(cache.lookup(QLatin1String("c")));
+
+    // kept entries are never removed
+    JournalMetadataCache emptyCache(cache.directory(), 0);
+    emptyCache.evict({QLatin1String("c")});
+    QVERIFY(!cache.lookup(QLatin1String("a")));
+    QVERIFY(cache.lookup(QLatin1String("c")));
+}
+
+void TestMetadataCache::summarizeFiles()
+{
+    LocalJournal journal(JOURNAL_LOCATION);
+    const QVector<JournalFileHeader> headers = journal.queryFiles();
+    for (const auto state : {JournalFileHeader::State::ONLINE, JournalFileHeader::State::ARCHIVED}) {
+        const auto header = std::find_if(headers.cbegin(), headers.cend(), [state](const JournalFileHeader &header) {
+            return header.mState == state;
+        });
+        QVERIFY(header != headers.cend());
+        const std::optional<JournalMetadataCache::FileMetadata> summary = JournalMetadataCache::summarize(*header);
+        QVERIFY(summary);
+
+        LocalJournal file(header->mPath);
+        QVector<QString> units = JournaldHelper::queryUnique(file, JournaldHelper::Field::_SYSTEMD_UNIT);
+        std::sort(units.begin(), units.end());
+        QVector<QString> summaryUnits = summary->mUnits;
+        std::sort(summaryUnits.begin(), summaryUnits.end());
+        QCOMPARE(summaryUnits, units);
+        QCOMPARE(summary->mBoots.size(), JournaldHelper::queryOrderedBootIds(file).size());
+
+        QVERIFY(file.setFilter(FilterExpression()));
+        QVERIFY(file.seekHead());
+        quint64 entries{0};
+        quint64 headRealtime{0};
+        quint64 tailRealtime{0};
+        while (file.next() > 0) {
+            headRealtime = entries == 0 ? file.realtimeUsec() : headRealtime;
+            tailRealtime = file.realtimeUsec();
+            ++entries;
+        }
+        QCOMPARE(summary->mEntryCount, entries);
+        QCOMPARE(summary->mHeadRealtime, headRealtime);
+        QCOMPARE(summary->mTailRealtime, tailRealtime);
+    }
+}
+
+void TestMetadataCache::sharedResult()
+{
+    auto query = []() {
+        LocalJournal journal(JOURNAL_LOCATION);
+        journal.stopWatching();
+        return JournalMetadataCache::shared(journal);
+    };
+    QFuture<std::shared_ptr<const JournalMetadataCache::Metadata>> first = QtConcurrent::run(query);
+    QFuture<std::shared_ptr<const JournalMetadataCache::Metadata>> second = QtConcurrent::run(query);
+    const std::shared_ptr<const JournalMetadataCache::Metadata> metadata = first.result();
+    QVERIFY(metadata);
+    QCOMPARE(second.result(), metadata);
+    QCOMPARE(query(), metadata);
+    QCOMPARE(metadata->mEntryCount, JournalMetadataCache().query(LocalJournal(JOURNAL_LOCATION))->mEntryCount);
+
+    // other files have their own result
+    QTemporaryDir directory;
+    const std::optional<JournalFileHeader> header = copyArchivedFile(directory);
+    QVERIFY(header);
+    LocalJournal archivedJournal(directory.path());
+    const std::shared_ptr<const JournalMetadataCache::Metadata> archivedMetadata = JournalMetadataCache::shared(archivedJournal);
+    QVERIFY(archivedMetadata);
+    QVERIFY(archivedMetadata != metadata);
+    QCOMPARE(archivedMetadata->mEntryCount, header->mEntryCount);
+
+    // journals that do not provide their files are not covered
+    QVERIFY(!JournalMetadataCache::shared(MemoryJournal()));
+}
+
+QTEST_GUILESS_MAIN(TestMetadataCache);
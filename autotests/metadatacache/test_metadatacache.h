@@ -0,0 +1,43 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef TEST_METADATACACHE_H
+#define TEST_METADATACACHE_H
+
+#include <QObject>
+
+class TestMetadataCache : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    /**
+     * shared() uses the default cache, which must not be written to the user's cache location
+     */
+    void initTestCase();
+    void key();
+    /**
+     * Merged metadata equals the values that are queried from the complete journal
+     */
+    void queryMatchesJournal();
+    /**
+     * Only changed files are summarized again, files that are written are summarized on every query
+     */
+    void cachedFiles();
+    void corruptEntry();
+    /**
+     * Least recently used entries are removed, such that entries of vacuumed files do not accumulate
+     */
+    void eviction();
+    /**
+     * Summaries of online and archived files provide the same values as iterating the files' entries
+     */
+    void summarizeFiles();
+    /**
+     * Concurrent and repeated queries of the same files share one result
+     */
+    void sharedResult();
+};
+#endif
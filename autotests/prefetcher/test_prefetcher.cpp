@@ -0,0 +1,112 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "test_prefetcher.h"
+#include "../testdatalocation.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSignalSpy>
+#include <QTest>
+#include <journalprefetcher.h>
+#include <algorithm>
+#include <limits>
+#include <localjournal.h>
+
+namespace
+{
+QVector<JournalFileHeader> testJournalFiles()
+{
+    const QDir directory(QLatin1String(JOURNAL_LOCATION) + QLatin1String("/83fc99b40aab448f8004215d83cb3f66/"));
+    QStringList files;
+    for (const QString &file : directory.entryList({QLatin1String("*.journal"), QLatin1String("*.journal~")}, QDir::Files)) {
+        files.append(directory.filePath(file));
+    }
+    return JournalFileHeader::readAll(files);
+}
+
+JournalFileHeader createHeader(const QString &path, quint64 head, quint64 tail)
+{
+    JournalFileHeader header;
+    header.mPath = path;
+    header.mHeadEntryRealtime = head;
+    header.mTailEntryRealtime = tail;
+    return header;
+}
+}
+
+void TestPrefetcher::prioritization()
+{
+    const QVector<JournalFileHeader> files{createHeader("a", 100, 200), createHeader("b", 300, 400), createHeader("c", 500, 600)};
+
+    auto paths = [](const QVector<JournalFileHeader> &headers) {
+        QStringList result;
+        for (const auto &header : headers) {
+            result.append(header.mPath);
+        }
+        return result;
+    };
+    QCOMPARE(paths(JournalPrefetcher::prioritized(files, 0)), QStringList({"a", "b", "c"}));
+    QCOMPARE(paths(JournalPrefetcher::prioritized(files, 350)), QStringList({"b", "a", "c"}));
+    QCOMPARE(paths(JournalPrefetcher::prioritized(files, 480)), QStringList({"c", "b", "a"}));
+    QCOMPARE(paths(JournalPrefetcher::prioritized(files, std::numeric_limits<quint64>::max())), QStringList({"c", "b", "a"}));
+}
+
+void TestPrefetcher::prefetchFiles()
+{
+    const QVector<JournalFileHeader> files = testJournalFiles();
+    QCOMPARE(files.size(), 11);
+    quint64 totalSize{0};
+    for (const auto &file : files) {
+        totalSize += QFileInfo(file.mPath).size();
+    }
+
+    JournalPrefetcher prefetcher;
+    QSignalSpy spy(&prefetcher, &JournalPrefetcher::finished);
+    prefetcher.prefetch(files, 0);
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(prefetcher.lastStatistics().mFileCount, 11);
+    QCOMPARE(prefetcher.lastStatistics().mBytes, totalSize);
+    QVERIFY(!prefetcher.lastStatistics().mCanceled);
+    QVERIFY(!prefetcher.isRunning());
+}
+
+void TestPrefetcher::byteLimit()
+{
+    const QVector<JournalFileHeader> files = JournalPrefetcher::prioritized(testJournalFiles(), 0);
+    const quint64 firstFileSize = QFileInfo(files.first().mPath).size();
+
+    JournalPrefetcher prefetcher;
+    prefetcher.setByteLimit(firstFileSize);
+    QSignalSpy spy(&prefetcher, &JournalPrefetcher::finished);
+    prefetcher.prefetch(files, 0);
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(prefetcher.lastStatistics().mFileCount, 1);
+    QCOMPARE(prefetcher.lastStatistics().mBytes, firstFileSize);
+
+    // files beyond the limit are skipped, but smaller files with lower priority are still prefetched
+    quint64 smallestFileSize{std::numeric_limits<quint64>::max()};
+    for (const auto &file : files) {
+        smallestFileSize = std::min<quint64>(smallestFileSize, QFileInfo(file.mPath).size());
+    }
+    const quint64 newestFileSize = QFileInfo(JournalPrefetcher::prioritized(files, std::numeric_limits<quint64>::max()).first().mPath).size();
+    QVERIFY(newestFileSize > smallestFileSize);
+    prefetcher.setByteLimit(smallestFileSize);
+    prefetcher.prefetch(files, std::numeric_limits<quint64>::max());
+    QTRY_COMPARE(spy.count(), 2);
+    QCOMPARE(prefetcher.lastStatistics().mFileCount, 1);
+    QCOMPARE(prefetcher.lastStatistics().mBytes, smallestFileSize);
+}
+
+void TestPrefetcher::localJournalQueryFiles()
+{
+    LocalJournal journal(JOURNAL_LOCATION);
+    QCOMPARE(journal.queryFiles().size(), 11);
+
+    journal.prepareQuery(FilterExpression::match(QLatin1String("_BOOT_ID"), QLatin1String("27acae2fe35a40ac93f9c7732c0b8e59")));
+    QCOMPARE(journal.queryFiles().size(), journal.openedFiles().size());
+}
+
+QTEST_GUILESS_MAIN(TestPrefetcher);
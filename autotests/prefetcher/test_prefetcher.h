@@ -0,0 +1,27 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef TEST_PREFETCHER_H
+#define TEST_PREFETCHER_H
+
+#include <QObject>
+
+class TestPrefetcher : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    /**
+     * Files nearest to the viewport are prefetched first
+     */
+    void prioritization();
+    void prefetchFiles();
+    void byteLimit();
+    /**
+     * The system journal directory layout is used for prefetching of local journals
+     */
+    void localJournalQueryFiles();
+};
+#endif
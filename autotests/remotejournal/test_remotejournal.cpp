@@ -6,15 +6,27 @@
 #include "test_remotejournal.h"
 #include "../testdatalocation.h"
 #include "journaldexportreader.h"
+#include "journaldviewmodel.h"
+#include <KCompressionDevice>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QProcess>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryDir>
 #include <QTest>
 #include <QVector>
 #include <systemd/sd-journal.h>
 #include <systemdjournalremote.h>
 
+void TestRemoteJournal::initTestCase()
+{
+    // imports are converted into the default import cache
+    QStandardPaths::setTestModeEnabled(true);
+}
+
 void TestRemoteJournal::exportFormatReaderBasicAccess()
 {
     QFile exportData(JOURNAL_EXPORT_FORMAT_EXAMPLE);
@@ -227,6 +239,38 @@ void TestRemoteJournal::systemdJournalRemoteJournalFromFile()
     }
 }
 
+void TestRemoteJournal::systemdJournalRemoteJournalFromCompressedFile()
+{
+    QTemporaryDir directory;
+    const QString compressedFile = directory.filePath(QLatin1String("journal.export.gz"));
+    {
+        QFile exportData(JOURNAL_EXPORT_FORMAT_EXAMPLE);
+        QVERIFY(exportData.open(QIODevice::ReadOnly));
+        KCompressionDevice device(compressedFile, KCompressionDevice::GZip);
+        QVERIFY(device.open(QIODevice::WriteOnly));
+        device.write(exportData.readAll());
+    }
+
+    SystemdJournalRemote journal(compressedFile);
+    QTRY_COMPARE_WITH_TIMEOUT(journal.isValid(), true, 5000);
+    auto countEntries = [&journal]() {
+        int count{0};
+        sd_journal_seek_head(journal.sdJournal());
+        while (sd_journal_next(journal.sdJournal()) > 0) {
+            ++count;
+        }
+        return count;
+    };
+    QTRY_COMPARE_WITH_TIMEOUT(countEntries(), 2, 5000);
+
+    const char *data;
+    size_t length;
+    QCOMPARE(sd_journal_seek_head(journal.sdJournal()), 0);
+    QCOMPARE(sd_journal_next(journal.sdJournal()), 1);
+    QCOMPARE(sd_journal_get_data(journal.sdJournal(), "_HOSTNAME", (const void **)&data, &length), 0);
+    QCOMPARE(QString::fromUtf8(data, length), QLatin1String("_HOSTNAME=epsilon"));
+}
+
 void TestRemoteJournal::systemdJournalRemoteJournalFromLocalhost()
 {
     // spawning systemd-journal-gatwayd to provide http access
@@ -261,4 +305,54 @@ void TestRemoteJournal::systemdJournalRemoteJournalFromLocalhost()
     QVERIFY(systemdJournalGatwaydProcess.state() == QProcess::NotRunning);
 }
 
+void TestRemoteJournal::systemdJournalRemoteImportProgress()
+{
+    SystemdJournalRemote journal(JOURNAL_EXPORT_FORMAT_EXAMPLE);
+    QSignalSpy progressSpy(&journal, &SystemdJournalRemote::importProgress);
+    QSignalSpy finishedSpy(&journal, &SystemdJournalRemote::importFinished);
+
+    // construction does not wait for systemd-journal-remote
+    QVERIFY(journal.isImporting());
+    QVERIFY(finishedSpy.wait(5000));
+    QCOMPARE(finishedSpy.first().at(0).toBool(), true);
+    QVERIFY(!journal.isImporting());
+
+    const qint64 fileSize = QFileInfo(JOURNAL_EXPORT_FORMAT_EXAMPLE).size();
+    QVERIFY(progressSpy.size() > 0);
+    QCOMPARE(progressSpy.last().at(1).toLongLong(), fileSize);
+    QCOMPARE(journal.bytesImported(), fileSize);
+    QCOMPARE(journal.entryCount(), 2);
+    QVERIFY(journal.isValid());
+}
+
+void TestRemoteJournal::systemdJournalRemoteMissingFile()
+{
+    QTemporaryDir directory;
+    SystemdJournalRemote journal(directory.filePath(QLatin1String("missing.export")));
+    QSignalSpy finishedSpy(&journal, &SystemdJournalRemote::importFinished);
+    QVERIFY(finishedSpy.wait(5000));
+    QCOMPARE(finishedSpy.size(), 1);
+    QCOMPARE(finishedSpy.first().at(0).toBool(), false);
+    QVERIFY(!journal.isImporting());
+    QVERIFY(!journal.isValid());
+}
+
+void TestRemoteJournal::systemdJournalRemoteViewModelDuringImport()
+{
+    auto journal = std::make_unique<SystemdJournalRemote>(JOURNAL_EXPORT_FORMAT_EXAMPLE);
+    QSignalSpy finishedSpy(journal.get(), &SystemdJournalRemote::importFinished);
+
+    // the journal is set before systemd-journal-remote created the journal file
+    JournaldViewModel model;
+    QVERIFY(!model.setJournal(std::move(journal)));
+    QCOMPARE(model.rowCount(), 0);
+    // appended entries are announced without boot ID and are still shown for a boot filter
+    model.setBootFilter({QLatin1String("6c7c6013a26343b29e964691ff25d04c")});
+
+    QVERIFY(finishedSpy.wait(5000));
+    QTRY_COMPARE_WITH_TIMEOUT(model.rowCount(), 2, 5000);
+    QCOMPARE(model.data(model.index(0, 0), JournaldViewModel::Roles::MESSAGE).toString(),
+             QLatin1String("AccountsService-DEBUG(+): ActUserManager: ignoring unspecified session '8' since it's not graphical: Success"));
+}
+
 QTEST_GUILESS_MAIN(TestRemoteJournal);
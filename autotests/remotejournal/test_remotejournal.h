@@ -13,11 +13,22 @@ class TestRemoteJournal : public QObject
     Q_OBJECT
 
 private Q_SLOTS:
+    /**
+     * Imported journal files are cached in the test locations instead of the user's cache
+     */
+    void initTestCase();
     // parser tests
     void exportFormatReaderBasicAccess();
     void exportFormatReaderBinaryMessageAccess();
 
     void systemdJournalRemoteJournalFromFile();
+    void systemdJournalRemoteJournalFromCompressedFile();
     void systemdJournalRemoteJournalFromLocalhost();
+    void systemdJournalRemoteImportProgress();
+    /**
+     * Failures are announced after construction, such that receivers that connect afterwards are notified
+     */
+    void systemdJournalRemoteMissingFile();
+    void systemdJournalRemoteViewModelDuringImport();
 };
 #endif
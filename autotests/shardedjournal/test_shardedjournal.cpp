@@ -0,0 +1,160 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "test_shardedjournal.h"
+#include "../testdatalocation.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+#include <journaldviewmodel.h>
+#include <journalfileheader.h>
+#include <localjournal.h>
+#include <shardedjournal.h>
+
+namespace
+{
+const QString sBootDir = QLatin1String(JOURNAL_LOCATION) + QLatin1String("/83fc99b40aab448f8004215d83cb3f66/");
+const QString sJournalFile = QLatin1String("system@c485fef5d17c4272a4a539c4e4708f9e-0000000000000191-0005bd6c979f361b.journal");
+constexpr qint64 sMachineIdOffset{40};
+
+/**
+ * copy of a journal file whose header claims to be written by machine @p machineId
+ */
+bool copyWithMachineId(const QString &source, const QString &target, const QString &machineId)
+{
+    if (!QFile::copy(source, target)) {
+        return false;
+    }
+    QFile file(target);
+    if (!file.open(QIODevice::ReadWrite) || !file.seek(sMachineIdOffset)) {
+        return false;
+    }
+    return file.write(QByteArray::fromHex(machineId.toLatin1())) == 16;
+}
+}
+
+void TestShardedJournal::fileHeader()
+{
+    const auto header = JournalFileHeader::read(sBootDir + sJournalFile);
+    QVERIFY(header.has_value());
+    QCOMPARE(header->mState, JournalFileHeader::State::ARCHIVED);
+    QCOMPARE(header->mMachineId, mMachineId);
+    QCOMPARE(header->mSeqnumId, "c485fef5d17c4272a4a539c4e4708f9e");
+    QCOMPARE(header->mTailEntryBootId, "68f2e61d061247d8a8ba0b8d53a97a52");
+    QCOMPARE(header->mEntryCount, 430);
+    QCOMPARE(header->mHeadEntrySeqnum, 401);
+    QCOMPARE(header->mTailEntrySeqnum, 830);
+    QCOMPARE(header->mHeadEntryRealtime, 1615648981464603);
+    QCOMPARE(header->mTailEntryRealtime, 1615648982239174);
+}
+
+void TestShardedJournal::invalidFileHeader()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QFile file(dir.path() + QLatin1String("/broken.journal"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QByteArray(512, 'x'));
+    file.close();
+    QVERIFY(!JournalFileHeader::read(file.fileName()).has_value());
+    QVERIFY(!JournalFileHeader::read(dir.path() + QLatin1String("/missing.journal")).has_value());
+}
+
+void TestShardedJournal::shardDiscovery()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(QDir(dir.path()).mkpath(QLatin1String("remote")));
+    QVERIFY(QFile::copy(sBootDir + sJournalFile, dir.path() + QLatin1Char('/') + sJournalFile));
+    QVERIFY(copyWithMachineId(sBootDir + sJournalFile, dir.path() + QLatin1String("/remote/remote-other.journal"), mOtherMachineId));
+    QFile broken(dir.path() + QLatin1String("/remote/broken.journal"));
+    QVERIFY(broken.open(QIODevice::WriteOnly));
+    broken.write(QByteArray(512, 'x'));
+    broken.close();
+
+    ShardedJournal journal(dir.path());
+    QVERIFY(journal.isValid());
+    QVERIFY(journal.openedMachineIds().isEmpty());
+    const auto shards = journal.shards();
+    QCOMPARE(shards.size(), 2);
+    QCOMPARE(shards.at(0).mMachineId, mOtherMachineId);
+    QCOMPARE(shards.at(0).mFiles, QStringList({dir.path() + QLatin1String("/remote/remote-other.journal")}));
+    QCOMPARE(shards.at(1).mMachineId, mMachineId);
+    QCOMPARE(shards.at(1).mEntryCount, 430);
+    QCOMPARE(shards.at(1).mHeadRealtime, 1615648981464603);
+    QCOMPARE(shards.at(1).mTailRealtime, 1615648982239174);
+}
+
+void TestShardedJournal::lazyShardOpening()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(QFile::copy(sBootDir + sJournalFile, dir.path() + QLatin1Char('/') + sJournalFile));
+    QVERIFY(copyWithMachineId(sBootDir + sJournalFile, dir.path() + QLatin1String("/remote-other.journal"), mOtherMachineId));
+
+    ShardedJournal journal(dir.path());
+    QVERIFY(journal.openedMachineIds().isEmpty());
+
+    journal.prepareQuery(FilterExpression::match(QLatin1String("_MACHINE_ID"), mMachineId));
+    QVERIFY(journal.openedMachineIds().isEmpty());
+    QVERIFY(journal.sdJournal() != nullptr);
+    QCOMPARE(journal.openedMachineIds(), QStringList({mMachineId}));
+
+    // same selection keeps the journal open
+    sd_journal *opened = journal.sdJournal();
+    journal.prepareQuery(FilterExpression::allOf({FilterExpression::match(QLatin1String("_MACHINE_ID"), mMachineId), FilterExpression::match("_PID", "1")}));
+    QCOMPARE(journal.sdJournal(), opened);
+
+    // unconstrained queries touch all shards
+    journal.prepareQuery(FilterExpression());
+    QVERIFY(journal.sdJournal() != nullptr);
+    QCOMPARE(journal.openedMachineIds(), QStringList({mOtherMachineId, mMachineId}));
+}
+
+void TestShardedJournal::cloneSharesHeaders()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(QFile::copy(sBootDir + sJournalFile, dir.path() + QLatin1Char('/') + sJournalFile));
+    QVERIFY(copyWithMachineId(sBootDir + sJournalFile, dir.path() + QLatin1String("/remote-other.journal"), mOtherMachineId));
+
+    ShardedJournal journal(dir.path());
+    QCOMPARE(journal.shards().size(), 2);
+    // a clone that discovered the files again would only find one shard
+    QVERIFY(QFile::remove(dir.path() + QLatin1String("/remote-other.journal")));
+    std::unique_ptr<IJournal> clone = journal.clone();
+    auto shardedClone = qobject_cast<ShardedJournal *>(clone.get());
+    QVERIFY(shardedClone);
+    QVERIFY(shardedClone->isValid());
+    QCOMPARE(shardedClone->shards().size(), 2);
+    QCOMPARE(shardedClone->shards().at(1).mMachineId, mMachineId);
+    QVERIFY(shardedClone->openedMachineIds().isEmpty());
+
+    shardedClone->prepareQuery(FilterExpression::match(QLatin1String("_MACHINE_ID"), mMachineId));
+    QVERIFY(shardedClone->sdJournal() != nullptr);
+    QCOMPARE(shardedClone->openedMachineIds(), QStringList({mMachineId}));
+}
+
+void TestShardedJournal::viewModelAccess()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(QFile::copy(sBootDir + sJournalFile, dir.path() + QLatin1Char('/') + sJournalFile));
+
+    JournaldViewModel referenceModel;
+    referenceModel.setJournal(std::make_unique<LocalJournal>(dir.path()));
+    JournaldViewModel model;
+    model.setJournal(std::make_unique<ShardedJournal>(dir.path()));
+    QVERIFY(model.rowCount() > 0);
+    QCOMPARE(model.rowCount(), referenceModel.rowCount());
+    QCOMPARE(model.data(model.index(0, 0), JournaldViewModel::CURSOR), referenceModel.data(referenceModel.index(0, 0), JournaldViewModel::CURSOR));
+
+    model.setFilterExpression(FilterExpression::match(QLatin1String("_MACHINE_ID"), mOtherMachineId));
+    QCOMPARE(model.rowCount(), 0);
+}
+
+QTEST_GUILESS_MAIN(TestShardedJournal);
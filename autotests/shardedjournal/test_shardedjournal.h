@@ -0,0 +1,39 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef TEST_SHARDEDJOURNAL_H
+#define TEST_SHARDEDJOURNAL_H
+
+#include <QObject>
+
+class TestShardedJournal : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void fileHeader();
+    void invalidFileHeader();
+    /**
+     * Files are grouped by machine ID without opening any of them
+     */
+    void shardDiscovery();
+    /**
+     * Only shards of machines that are required by the query are opened
+     */
+    void lazyShardOpening();
+    /**
+     * Clones use the file headers of the original journal instead of reading them again
+     */
+    void cloneSharesHeaders();
+    /**
+     * Model over sharded journal provides same entries as over a directory journal
+     */
+    void viewModelAccess();
+
+private:
+    const QString mMachineId{"83fc99b40aab448f8004215d83cb3f66"};
+    const QString mOtherMachineId{"0123456789abcdef0123456789abcdef"};
+};
+#endif
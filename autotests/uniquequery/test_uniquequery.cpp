@@ -5,10 +5,12 @@
 
 #include "test_uniquequery.h"
 #include "../testdatalocation.h"
+#include "journaldhelper.h"
 #include "journalduniquequerymodel.h"
 #include <QAbstractItemModelTester>
 #include <QDebug>
 #include <QDir>
+#include <QStandardPaths>
 #include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QTest>
@@ -18,6 +20,12 @@
 //       you can check them by using "journalctl -D journal" and requesting the values
 //       that are checked here
 
+void TestUniqueQuery::initTestCase()
+{
+    // unit values are read through the default metadata cache
+    QStandardPaths::setTestModeEnabled(true);
+}
+
 void TestUniqueQuery::journalAccess()
 {
     JournaldUniqueQueryModel model;
@@ -61,6 +69,8 @@ void TestUniqueQuery::systemdUnits()
     QCOMPARE(model.fieldString(), "_SYSTEMD_UNIT");
     model.setField(JournaldHelper::Field::_SYSTEMD_UNIT);
     QCOMPARE(model.fieldString(), "_SYSTEMD_UNIT");
+    // values are read in the background
+    QTRY_VERIFY(!model.isLoading());
     QCOMPARE(model.rowCount(), 17);
 
     QStringList values;
@@ -70,4 +80,21 @@ void TestUniqueQuery::systemdUnits()
     QVERIFY(values.contains("systemd-journald.service"));
 }
 
+void TestUniqueQuery::cursorParsing()
+{
+    const JournaldHelper::CursorInfo info = JournaldHelper::parseCursor(
+        QLatin1String("s=c485fef5d17c4272a4a539c4e4708f9e;i=191;b=68f2e61d061247d8a8ba0b8d53a97a52;m=3dce1a;t=5bd6c979f361b;x=766655f78763a257"));
+    QCOMPARE(info.mSeqnumId, QLatin1String("c485fef5d17c4272a4a539c4e4708f9e"));
+    QCOMPARE(info.mSeqnum, std::optional<quint64>(0x191));
+    QCOMPARE(info.mBootId, QLatin1String("68f2e61d061247d8a8ba0b8d53a97a52"));
+    QCOMPARE(info.mMonotonicUsec, std::optional<quint64>(0x3dce1a));
+    QCOMPARE(info.mRealtimeUsec, std::optional<quint64>(0x5bd6c979f361b));
+
+    // malformed fields are ignored
+    const JournaldHelper::CursorInfo malformed = JournaldHelper::parseCursor(QLatin1String("i=xyz;t=;garbage"));
+    QVERIFY(!malformed.mSeqnum.has_value());
+    QVERIFY(!malformed.mRealtimeUsec.has_value());
+    QVERIFY(malformed.mSeqnumId.isEmpty());
+}
+
 QTEST_GUILESS_MAIN(TestUniqueQuery);
@@ -13,8 +13,13 @@ class TestUniqueQuery : public QObject
     Q_OBJECT
 
 private Q_SLOTS:
+    /**
+     * Redirect the metadata cache of the query model to the test locations
+     */
+    void initTestCase();
     void journalAccess();
     void boots();
     void systemdUnits();
+    void cursorParsing();
 };
 #endif
@@ -8,9 +8,11 @@
 #include "../testdatalocation.h"
 #include "journaldviewmodel.h"
 #include "journaldviewmodel_p.h"
+#include "localjournal.h"
 #include <QAbstractItemModelTester>
 #include <QDebug>
 #include <QDir>
+#include <QSignalSpy>
 #include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QTest>
@@ -359,4 +361,130 @@ void TestViewModel::stringSearch()
     }
 }
 
+void TestViewModel::residualFilterSkipBudget()
+{
+    JournaldViewModel model;
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::Fatal);
+    QCOMPARE(model.setJournaldPath(JOURNAL_LOCATION), true);
+    model.setKernelFilter(true);
+    // no entry matches, thus every read skips entries until the skip budget is exhausted
+    model.setFilterExpression(FilterExpression::contains(QLatin1String("MESSAGE"), QLatin1String("message that is not in the journal")));
+    QCOMPARE(model.rowCount(), 0);
+
+    int fetches{0};
+    while (model.canFetchMore(QModelIndex()) && fetches < 1000) {
+        model.fetchMore(QModelIndex());
+        ++fetches;
+    }
+    QVERIFY(!model.canFetchMore(QModelIndex()));
+    QCOMPARE(model.rowCount(), 0);
+}
+
+void TestViewModel::followMode()
+{
+    JournaldViewModel model;
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::Fatal);
+    model.setFetchMoreChunkSize(100);
+    QCOMPARE(model.setJournaldPath(JOURNAL_LOCATION), true);
+    // boot has 925 non-kernel log entries
+    model.setBootFilter({mBoots.at(0)});
+    QCOMPARE(model.rowCount(), 100);
+    QCOMPARE(model.linesBehind(), 0);
+
+    QSignalSpy linesBehindSpy(&model, &JournaldViewModel::linesBehindChanged);
+    QSignalSpy insertSpy(&model, &JournaldViewModel::rowsInserted);
+    model.setFollowMode(true);
+    QVERIFY(model.isFollowModeEnabled());
+    QTRY_COMPARE(model.rowCount(), 925);
+    QCOMPARE(model.linesBehind(), 0);
+    // every batch is bounded by the chunk size
+    QVERIFY(insertSpy.count() >= 8);
+    QVERIFY(linesBehindSpy.count() > 0);
+}
+
+void TestViewModel::followModePaused()
+{
+    JournaldViewModel model;
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::Fatal);
+    model.setFetchMoreChunkSize(100);
+    QCOMPARE(model.setJournaldPath(JOURNAL_LOCATION), true);
+    model.setBootFilter({mBoots.at(0)});
+    QCOMPARE(model.rowCount(), 100);
+
+    model.setFollowPaused(true);
+    model.setFollowMode(true);
+    QTRY_COMPARE(model.linesBehind(), 825);
+    QCOMPARE(model.rowCount(), 100);
+    // buffered entries are not skipped by extending the model towards tail
+    QVERIFY(!model.canFetchMore(QModelIndex()));
+    model.fetchMore(QModelIndex());
+    QCOMPARE(model.rowCount(), 100);
+
+    QSignalSpy insertSpy(&model, &JournaldViewModel::rowsInserted);
+    model.setFollowPaused(false);
+    QCOMPARE(insertSpy.count(), 1);
+    QCOMPARE(model.rowCount(), 925);
+    QCOMPARE(model.linesBehind(), 0);
+    QCOMPARE(model.data(model.index(924, 0), JournaldViewModel::CURSOR).toString(),
+             QStringLiteral("s=c485fef5d17c4272a4a539c4e4708f9e;i=52b;b=68f2e61d061247d8a8ba0b8d53a97a52;m=312c5fa4;t=5bd6cc9746a62;x=fd8582373d87d313"));
+}
+
+void TestViewModel::journalChangeHandling()
+{
+    JournaldViewModel model;
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::Fatal);
+    auto journal = std::make_unique<LocalJournal>(JOURNAL_LOCATION);
+    LocalJournal *journalPtr = journal.get();
+    QCOMPARE(model.setJournal(std::move(journal)), true);
+    model.setBootFilter({mBoots.at(0)});
+    const int rows = model.rowCount();
+    const QString firstCursor = model.data(model.index(0, 0), JournaldViewModel::CURSOR).toString();
+    QVERIFY(rows > 0);
+
+    QSignalSpy resetSpy(&model, &JournaldViewModel::modelReset);
+    QSignalSpy insertSpy(&model, &JournaldViewModel::rowsInserted);
+
+    // no entries were appended in the static test journal
+    Q_EMIT journalPtr->journalUpdated(mBoots.at(0), IJournal::ChangeType::APPEND);
+    QCOMPARE(model.rowCount(), rows);
+    QCOMPARE(insertSpy.count(), 0);
+
+    // window boundaries still exist, such that no reset is needed
+    Q_EMIT journalPtr->journalUpdated(mBoots.at(0), IJournal::ChangeType::INVALIDATE);
+    QCOMPARE(resetSpy.count(), 0);
+    QCOMPARE(model.rowCount(), rows);
+    QCOMPARE(model.data(model.index(0, 0), JournaldViewModel::CURSOR).toString(), firstCursor);
+}
+
+void TestViewModel::vanishedJournalFile()
+{
+    const QString sourceDir = QLatin1String(JOURNAL_LOCATION) + QLatin1String("/83fc99b40aab448f8004215d83cb3f66/");
+    const QString bootFile = QLatin1String("system@c485fef5d17c4272a4a539c4e4708f9e-0000000000000191-0005bd6c979f361b.journal");
+    const QString laterBootFile = QLatin1String("system@df3342d6d57b442da21c78027d3991f8-0000000000000191-0005bd6cc97083b1.journal");
+    QTemporaryDir journalDir;
+    QVERIFY(QFile::copy(sourceDir + bootFile, journalDir.path() + QLatin1Char('/') + bootFile));
+    QVERIFY(QFile::copy(sourceDir + laterBootFile, journalDir.path() + QLatin1Char('/') + laterBootFile));
+
+    JournaldViewModel model;
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::Fatal);
+    QCOMPARE(model.setJournaldPath(journalDir.path()), true);
+    while (model.canFetchMore(QModelIndex())) {
+        model.fetchMore(QModelIndex());
+    }
+    const int rows = model.rowCount();
+    QVERIFY(rows > 0);
+
+    QSignalSpy removeSpy(&model, &JournaldViewModel::rowsRemoved);
+    QSignalSpy resetSpy(&model, &JournaldViewModel::modelReset);
+    // simulate vacuuming of the oldest file
+    QVERIFY(QFile::remove(journalDir.path() + QLatin1Char('/') + bootFile));
+    QTRY_VERIFY(removeSpy.count() > 0);
+    QCOMPARE(resetSpy.count(), 0);
+    QVERIFY(model.rowCount() > 0);
+    QVERIFY(model.rowCount() < rows);
+    for (int i = 0; i < model.rowCount(); ++i) {
+        QVERIFY(model.data(model.index(i, 0), JournaldViewModel::CURSOR).toString().startsWith(QLatin1String("s=df3342d6d57b442da21c78027d3991f8")));
+    }
+}
+
 QTEST_GUILESS_MAIN(TestViewModel);
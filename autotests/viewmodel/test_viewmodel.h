@@ -33,6 +33,31 @@ private Q_SLOTS:
      */
     void stringSearch();
 
+    /**
+     * Reading with a rarely matching residual filter returns partial chunks and still reaches the tail
+     */
+    void residualFilterSkipBudget();
+
+    /**
+     * Follow mode catches up with the journal's tail in bounded batches
+     */
+    void followMode();
+
+    /**
+     * Paused follow mode buffers entries and inserts them at once when resumed
+     */
+    void followModePaused();
+
+    /**
+     * Journal changes are handled according to their type without resetting a still valid window
+     */
+    void journalChangeHandling();
+
+    /**
+     * Entries of a removed journal file are removed from the window without resetting the model
+     */
+    void vanishedJournalFile();
+
 private:
     const QStringList mBoots{"68f2e61d061247d8a8ba0b8d53a97a52", "27acae2fe35a40ac93f9c7732c0b8e59", "2dbe99dd855049af8f2865c5da2b8fda"};
 };
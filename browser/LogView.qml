@@ -97,6 +97,7 @@ ListView {
     onContentYChanged: {
         if (snapToFollowMode === true) {
             root.__followMode = root.atYEnd
+            root.journalModel.followMode = root.__followMode
         }
     }
 
@@ -97,6 +97,30 @@ Kirigami.AbstractApplicationWindow {
                 implicitWidth: Math.max(300, implicitContentWidth)
                 model: bootModel
                 valueRole: "bootid"
+                // selection by boot ID, since boots are inserted and removed at any row while the journal changes
+                property string selectedBootId
+                onActivated: selectedBootId = currentValue
+                onSelectedBootIdChanged: restoreSelection()
+                // boots are loaded asynchronously, select the latest boot once available
+                function restoreSelection() {
+                    if (selectedBootId === "" && count > 0) {
+                        selectedBootId = valueAt(0)
+                    }
+                    currentIndex = indexOfValue(selectedBootId)
+                }
+                Connections {
+                    target: bootModel
+                    // the combo box updates its rows by the same signals, thus the selection is restored afterwards
+                    function onRowsInserted() {
+                        Qt.callLater(bootIdComboBox.restoreSelection)
+                    }
+                    function onRowsRemoved() {
+                        Qt.callLater(bootIdComboBox.restoreSelection)
+                    }
+                    function onModelReset() {
+                        bootIdComboBox.selectedBootId = ""
+                    }
+                }
                 textRole: SessionConfigProxy.timeDisplay
                           === SessionConfig.UTC ? "displayshort_utc" : "displayshort_localtime"
                 delegate: ItemDelegate {
@@ -263,19 +287,40 @@ Kirigami.AbstractApplicationWindow {
     BootModel {
         id: bootModel
         journalPath: SessionConfigProxy.sessionMode === SessionConfig.LOCALFOLDER
-                     || SessionConfigProxy.sessionMode
-                     === SessionConfig.REMOTE ? SessionConfigProxy.localJournalPath : undefined
+                     || SessionConfigProxy.sessionMode === SessionConfig.REMOTE
+                     && SessionConfigProxy.remoteJournal === null ? SessionConfigProxy.localJournalPath : undefined
     }
 
     JournaldViewModel {
         id: g_journalModel
         journalPath: SessionConfigProxy.sessionMode === SessionConfig.LOCALFOLDER
-                     || SessionConfigProxy.sessionMode
-                     === SessionConfig.REMOTE ? SessionConfigProxy.localJournalPath : undefined
+                     || SessionConfigProxy.sessionMode === SessionConfig.REMOTE
+                     && SessionConfigProxy.remoteJournal === null ? SessionConfigProxy.localJournalPath : undefined
         systemdUnitFilter: FilterCriteriaModelProxy.systemdUnitFilter
         exeFilter: FilterCriteriaModelProxy.exeFilter
-        bootFilter: bootIdComboBox.currentValue
+        bootFilter: bootIdComboBox.selectedBootId !== "" ? [bootIdComboBox.selectedBootId] : []
         priorityFilter: FilterCriteriaModelProxy.priorityFilter
         kernelFilter: FilterCriteriaModelProxy.kernelFilter
     }
+
+    // followed gatewayd endpoints have no journal path, the models read clones of the remote journal instead
+    Connections {
+        id: remoteJournalConnections
+        target: SessionConfigProxy
+
+        function showRemoteJournal() {
+            if (SessionConfigProxy.sessionMode !== SessionConfig.REMOTE || SessionConfigProxy.remoteJournal === null) {
+                return
+            }
+            bootModel.setJournalClone(SessionConfigProxy.remoteJournal)
+            g_journalModel.setJournalClone(SessionConfigProxy.remoteJournal)
+        }
+        // called later, such that the journal path bindings are updated first
+        function onModeChanged() {
+            Qt.callLater(remoteJournalConnections.showRemoteJournal)
+        }
+        function onRemoteJournalChanged() {
+            Qt.callLater(remoteJournalConnections.showRemoteJournal)
+        }
+    }
 }
@@ -28,6 +28,7 @@ void FlattenedFilterCriteriaProxyModel::setSourceModel(QAbstractItemModel *model
         disconnect(mSourceModel, &QAbstractItemModel::dataChanged, this, &FlattenedFilterCriteriaProxyModel::handleSourceModelDataChanged);
         disconnect(mSourceModel, &QAbstractItemModel::modelAboutToBeReset, this, &FlattenedFilterCriteriaProxyModel::handleSourceModelOnModelAboutToBeReset);
         disconnect(mSourceModel, &QAbstractItemModel::modelReset, this, &FlattenedFilterCriteriaProxyModel::handleSourceModelOnModelReset);
+        disconnect(mSourceModel, &QAbstractItemModel::rowsInserted, this, &FlattenedFilterCriteriaProxyModel::handleSourceModelRowsInserted);
     }
 
     // TODO add assert that this model only handles two level hierarchies
@@ -36,6 +37,7 @@ void FlattenedFilterCriteriaProxyModel::setSourceModel(QAbstractItemModel *model
     connect(mSourceModel, &QAbstractItemModel::dataChanged, this, &FlattenedFilterCriteriaProxyModel::handleSourceModelDataChanged);
     connect(mSourceModel, &QAbstractItemModel::modelAboutToBeReset, this, &FlattenedFilterCriteriaProxyModel::handleSourceModelOnModelAboutToBeReset);
     connect(mSourceModel, &QAbstractItemModel::modelReset, this, &FlattenedFilterCriteriaProxyModel::handleSourceModelOnModelReset);
+    connect(mSourceModel, &QAbstractItemModel::rowsInserted, this, &FlattenedFilterCriteriaProxyModel::handleSourceModelRowsInserted);
 
     handleSourceModelOnModelReset();
 }
@@ -55,6 +57,37 @@ void FlattenedFilterCriteriaProxyModel::handleSourceModelOnModelReset()
     endResetModel();
 }
 
+void FlattenedFilterCriteriaProxyModel::handleSourceModelRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    if (!parent.isValid()) {
+        // only children of categories are inserted, thus simply regenerate for new categories
+        handleSourceModelOnModelAboutToBeReset();
+        handleSourceModelOnModelReset();
+        return;
+    }
+    int parentRow{-1};
+    for (int i = 0; i < mMapToSourceIndex.size(); ++i) {
+        if (mMapToSourceIndex.at(i).mSourceIndex == parent) {
+            parentRow = i;
+            break;
+        }
+    }
+    // children of collapsed categories are added when expanding them
+    if (parentRow == -1 || !mMapToSourceIndex.at(parentRow).mIsExpanded) {
+        return;
+    }
+    beginInsertRows(QModelIndex(), parentRow + 1 + first, parentRow + 1 + last);
+    for (int i = first; i <= last; ++i) {
+        mMapToSourceIndex.insert(parentRow + 1 + i, {mSourceModel->index(i, 0, parent), false, 1});
+    }
+    endInsertRows();
+    // source indices of following children changed their rows
+    const int childrenCount = mSourceModel->rowCount(parent);
+    for (int i = last + 1; i < childrenCount; ++i) {
+        mMapToSourceIndex[parentRow + 1 + i].mSourceIndex = mSourceModel->index(i, 0, parent);
+    }
+}
+
 QAbstractItemModel *FlattenedFilterCriteriaProxyModel::sourceModel() const
 {
     return mSourceModel;
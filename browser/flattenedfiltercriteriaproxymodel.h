@@ -101,6 +101,7 @@ private Q_SLOTS:
     void handleSourceModelDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
     void handleSourceModelOnModelReset();
     void handleSourceModelOnModelAboutToBeReset();
+    void handleSourceModelRowsInserted(const QModelIndex &parent, int first, int last);
 
 Q_SIGNALS:
     /**
@@ -8,9 +8,11 @@
 #include "fieldfilterproxymodel.h"
 #include "filtercriteriamodel.h"
 #include "flattenedfiltercriteriaproxymodel.h"
+#include "journaldexportwriter.h"
 #include "journalduniquequerymodel.h"
 #include "journaldviewmodel.h"
 #include "kjournald_version.h"
+#include "mergedjournaldviewmodel.h"
 #include "sessionconfig.h"
 #include <KAboutData>
 #include <KLocalizedContext>
@@ -63,9 +65,11 @@ int main(int argc, char *argv[])
     });
 
     qmlRegisterType<JournaldViewModel>("kjournald", 1, 0, "JournaldViewModel");
+    qmlRegisterType<MergedJournaldViewModel>("kjournald", 1, 0, "MergedJournaldViewModel");
     qmlRegisterType<JournaldUniqueQueryModel>("kjournald", 1, 0, "JournaldUniqueQueryModel");
     qmlRegisterType<FieldFilterProxyModel>("kjournald", 1, 0, "FieldFilterProxyModel");
     qmlRegisterType<BootModel>("kjournald", 1, 0, "BootModel");
+    qmlRegisterType<JournaldExportWriter>("kjournald", 1, 0, "JournaldExportWriter");
     qmlRegisterSingletonInstance("kjournald", 1, 0, "FilterCriteriaModelProxy", &filterCriteriaModel);
     qmlRegisterSingletonInstance("kjournald", 1, 0, "ClipboardProxy", &clipboardProxy);
     qmlRegisterSingletonInstance("kjournald", 1, 0, "SessionConfigProxy", &sessionConfig);
@@ -86,7 +90,11 @@ int main(int argc, char *argv[])
             filterCriteriaModel.setSystemJournal();
             break;
         case SessionConfig::Mode::REMOTE:
-            // remote is handle like a local access
+            if (sessionConfig.remoteJournal()) {
+                filterCriteriaModel.setJournalClone(sessionConfig.remoteJournal());
+                break;
+            }
+            // journals imported by systemd-journal-remote are handled like a local access
             Q_FALLTHROUGH();
         case SessionConfig::Mode::LOCALFOLDER:
             filterCriteriaModel.setJournaldPath(sessionConfig.localJournalPath());
@@ -96,6 +104,11 @@ int main(int argc, char *argv[])
     QObject::connect(&sessionConfig, &SessionConfig::localJournalPathChanged, &sessionConfig, [&sessionConfig, &filterCriteriaModel]() {
         filterCriteriaModel.setJournaldPath(sessionConfig.localJournalPath());
     });
+    QObject::connect(&sessionConfig, &SessionConfig::remoteJournalChanged, &sessionConfig, [&sessionConfig, &filterCriteriaModel]() {
+        if (sessionConfig.mode() == SessionConfig::Mode::REMOTE && sessionConfig.remoteJournal()) {
+            filterCriteriaModel.setJournalClone(sessionConfig.remoteJournal());
+        }
+    });
 
     if (parser.isSet(pathOption)) {
         const QString path = parser.value(pathOption);
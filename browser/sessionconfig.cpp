@@ -6,6 +6,7 @@
 #include "sessionconfig.h"
 #include "kjournaldlib_log_general.h"
 #include <QFileInfo>
+#include <QUrl>
 
 SessionConfig::SessionConfig(QObject *parent)
     : QObject(parent)
@@ -125,6 +126,11 @@ quint32 SessionConfig::remoteJournalPort() const
     return mRemoteJournalPort;
 }
 
+IJournal *SessionConfig::remoteJournal() const
+{
+    return mGatewayJournal.get();
+}
+
 QString SessionConfig::localJournalPath() const
 {
     return mJournalPath;
@@ -135,6 +141,27 @@ void SessionConfig::initRemoteJournal()
     if (mRemoteJournalUrl.isEmpty() || mRemoteJournalPort == 0) {
         return;
     }
+    const bool hadGatewayJournal{mGatewayJournal != nullptr};
+    mGatewayJournal.reset();
+    mRemoteJournal.reset();
+
+    // gatewayd endpoints are followed in process, without importing the whole remote journal into a file first
+    QUrl url(mRemoteJournalUrl);
+    if (url.scheme() == QLatin1String("http") || url.scheme() == QLatin1String("https")) {
+        url.setPort(static_cast<int>(mRemoteJournalPort));
+        mGatewayJournal = std::make_unique<GatewayJournal>(url);
+        mGatewayJournal->setFollow(true);
+        connect(mGatewayJournal.get(), &GatewayJournal::errorOccurred, this, [](const QString &message) {
+            qCWarning(KJOURNALDLIB_GENERAL) << "Remote journal stopped:" << message;
+        });
+        mGatewayJournal->start();
+        Q_EMIT remoteJournalChanged();
+        return;
+    }
+    if (hadGatewayJournal) {
+        Q_EMIT remoteJournalChanged();
+    }
+
     mRemoteJournal = std::make_unique<SystemdJournalRemote>(mRemoteJournalUrl, QString::number(mRemoteJournalPort));
     connect(mRemoteJournal.get(), &SystemdJournalRemote::journalFileChanged, [=]() {
         setLocalJournalPath(QFileInfo(mRemoteJournal->journalFile()).absolutePath());
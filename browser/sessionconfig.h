@@ -6,6 +6,7 @@
 #ifndef SESSIONCONFIG_H
 #define SESSIONCONFIG_H
 
+#include "gatewayjournal.h"
 #include "systemdjournalremote.h"
 #include <QObject>
 #include <QSettings>
@@ -23,6 +24,11 @@ class SessionConfig : public QObject
     Q_PROPERTY(QString localJournalPath READ localJournalPath WRITE setLocalJournalPath NOTIFY localJournalPathChanged)
     Q_PROPERTY(QString remoteJournalUrl READ remoteJournalUrl WRITE setRemoteJournalUrl NOTIFY remoteJournalUrlChanged)
     Q_PROPERTY(quint32 remoteJournalPort READ remoteJournalPort WRITE setRemoteJournalPort NOTIFY remoteJournalPortChanged)
+    /**
+     * @note journal that follows the remote gatewayd endpoint, nullptr if the remote journal is imported
+     * into a local journal file at localJournalPath instead
+     */
+    Q_PROPERTY(IJournal *remoteJournal READ remoteJournal NOTIFY remoteJournalChanged)
     Q_PROPERTY(SessionConfig::TimeDisplay timeDisplay READ timeDisplay WRITE setTimeDisplay NOTIFY timeDisplayChanged)
     Q_PROPERTY(SessionConfig::FilterCriterium filterCriterium READ filterCriterium WRITE setFilterCriterium NOTIFY filterCriteriumChanged)
     Q_PROPERTY(SessionConfig::ViewMode viewMode READ viewMode WRITE setViewMode NOTIFY viewModeChanged)
@@ -73,6 +79,8 @@ public:
 
     quint32 remoteJournalPort() const;
 
+    IJournal *remoteJournal() const;
+
     void setTimeDisplay(TimeDisplay format);
 
     TimeDisplay timeDisplay() const;
@@ -90,6 +98,7 @@ Q_SIGNALS:
     void localJournalPathChanged();
     void remoteJournalUrlChanged();
     void remoteJournalPortChanged();
+    void remoteJournalChanged();
     void timeDisplayChanged();
     void filterCriteriumChanged();
     void viewModeChanged();
@@ -105,6 +114,7 @@ private:
     FilterCriterium mFilterCriterium{FilterCriterium::SYSTEMD_UNIT};
     ViewMode mViewMode{ViewMode::BROWSE};
     std::unique_ptr<SystemdJournalRemote> mRemoteJournal;
+    std::unique_ptr<GatewayJournal> mGatewayJournal;
     QSettings mSettings;
 };
 
@@ -6,7 +6,11 @@
 #include "bootmodel.h"
 #include "bootmodel_p.h"
 #include "kjournaldlib_log_general.h"
+#include "kjournaldlib_log_performance.h"
 #include "localjournal.h"
+#include <QElapsedTimer>
+#include <QSet>
+#include <QtConcurrent>
 
 BootModelPrivate::BootModelPrivate(std::unique_ptr<IJournal> journal)
     : mJournal(std::move(journal))
@@ -14,45 +18,216 @@ BootModelPrivate::BootModelPrivate(std::unique_ptr<IJournal> journal)
 }
 
 BootModel::BootModel(QObject *parent)
-    : QAbstractListModel(parent)
-    , d(new BootModelPrivate(std::make_unique<LocalJournal>()))
+    : BootModel(std::make_unique<LocalJournal>(), parent)
 {
-    d->mBootInfo = JournaldHelper::queryOrderedBootIds(*d->mJournal.get());
-    d->sort(Qt::SortOrder::DescendingOrder);
 }
 
 BootModel::BootModel(const QString &journaldPath, QObject *parent)
-    : QAbstractListModel(parent)
-    , d(new BootModelPrivate(std::make_unique<LocalJournal>(journaldPath)))
+    : BootModel(std::make_unique<LocalJournal>(journaldPath), parent)
 {
-    d->mBootInfo = JournaldHelper::queryOrderedBootIds(*d->mJournal.get());
-    d->sort(Qt::SortOrder::DescendingOrder);
 }
 
 BootModel::BootModel(std::unique_ptr<IJournal> journal, QObject *parent)
     : QAbstractListModel(parent)
     , d(new BootModelPrivate(std::move(journal)))
 {
-    d->mBootInfo = JournaldHelper::queryOrderedBootIds(*d->mJournal.get());
-    d->sort(Qt::SortOrder::DescendingOrder);
+    connect(&d->mWatcher, &QFutureWatcher<QVector<BootModelPrivate::BootInfo>>::finished, this, [this]() {
+        d->mLoading = false;
+        // canceled enumerations belong to a replaced journal
+        const QVector<BootModelPrivate::BootInfo> boots = d->mWatcher.isCanceled() ? QVector<BootModelPrivate::BootInfo>() : d->mWatcher.result();
+        if (!boots.isEmpty() && d->mBootInfo.isEmpty()) {
+            beginInsertRows(QModelIndex(), 0, boots.size() - 1);
+            d->mBootInfo = boots;
+            d->sort(Qt::SortOrder::DescendingOrder);
+            endInsertRows();
+        } else {
+            // boots that are already known, e.g. from a synchronous query of a replaced journal, are merged by ID
+            for (const BootModelPrivate::BootInfo &boot : boots) {
+                mergeBoot(boot);
+            }
+        }
+        Q_EMIT loadingChanged();
+        if (d->mUpdatePending) {
+            d->mUpdatePending = false;
+            d->mUpdateTimer.start();
+        }
+    });
+    d->mUpdateTimer.setSingleShot(true);
+    d->mUpdateTimer.setInterval(BootModelPrivate::sUpdateCoalescingInterval);
+    connect(&d->mUpdateTimer, &QTimer::timeout, this, &BootModel::updateBoots);
+    loadBoots();
 }
 
 BootModel::~BootModel() = default;
 
+void BootModel::loadBoots()
+{
+    if (!d->mBootInfo.isEmpty()) {
+        beginResetModel();
+        d->mBootInfo.clear();
+        endResetModel();
+    }
+    d->mUpdateTimer.stop();
+    d->mUpdatePending = false;
+    d->mInvalidated = false;
+    const bool wasLoading = d->mLoading;
+    d->mLoading = false;
+    if (d->mJournal) {
+        connect(d->mJournal.get(), &IJournal::journalUpdated, this, [this](const QString &, IJournal::ChangeType type) {
+            if (type == IJournal::ChangeType::INVALIDATE) {
+                d->mInvalidated = true;
+            }
+            if (!d->mUpdateTimer.isActive()) {
+                d->mUpdateTimer.start();
+            }
+        });
+    }
+    // entries after the tail are applied incrementally, entries that are also seen by the enumeration do no harm
+    d->mTailCursor = d->mJournal && d->mJournal->isValid() ? d->tailCursor() : QString();
+    std::unique_ptr<IJournal> journal = d->mJournal && d->mJournal->isValid() ? d->mJournal->clone() : nullptr;
+    if (!journal) {
+        d->mWatcher.cancel();
+        if (d->mJournal && d->mJournal->isValid()) {
+            beginResetModel();
+            d->mBootInfo = BootModelPrivate::queryBoots(*d->mJournal.get());
+            d->sort(Qt::SortOrder::DescendingOrder);
+            endResetModel();
+        }
+        if (wasLoading) {
+            Q_EMIT loadingChanged();
+        }
+        return;
+    }
+    // the clone is used by a pool thread without being moved there, thus it must not watch the journal
+    // in this thread while being read, and it is deleted in this thread
+    journal->stopWatching();
+    std::shared_ptr<IJournal> workerJournal(journal.release(), [](IJournal *journal) {
+        journal->deleteLater();
+    });
+    d->mLoading = true;
+    d->mWatcher.setFuture(QtConcurrent::run([workerJournal]() {
+        return BootModelPrivate::queryBoots(*workerJournal);
+    }));
+    if (!wasLoading) {
+        Q_EMIT loadingChanged();
+    }
+}
+
+void BootModel::mergeBoot(const JournaldHelper::BootInfo &boot)
+{
+    const int row = d->row(boot.mBootId);
+    if (row < 0) {
+        const int insertRow = d->insertPosition(boot);
+        beginInsertRows(QModelIndex(), insertRow, insertRow);
+        d->mBootInfo.insert(insertRow, boot);
+        endInsertRows();
+        return;
+    }
+    BootModelPrivate::BootInfo merged = d->mBootInfo.at(row);
+    if (boot.mSince < merged.mSince) {
+        // earlier start changes the position of the boot
+        merged.mSince = boot.mSince;
+        merged.mUntil = std::max(merged.mUntil, boot.mUntil);
+        beginRemoveRows(QModelIndex(), row, row);
+        d->mBootInfo.remove(row);
+        endRemoveRows();
+        mergeBoot(merged);
+    } else if (boot.mUntil > merged.mUntil) {
+        d->mBootInfo[row].mUntil = boot.mUntil;
+        const QModelIndex changed = index(row, 0);
+        Q_EMIT dataChanged(changed, changed, {BootModel::UNTIL, BootModel::DISPLAY_SHORT_UTC, BootModel::DISPLAY_SHORT_LOCALTIME});
+    }
+}
+
+void BootModel::updateBoots()
+{
+    // the watcher stops running before its finished signal is delivered, only then the boots are applied
+    if (d->mLoading) {
+        d->mUpdatePending = true;
+        return;
+    }
+    if (!d->mJournal || !d->mJournal->isValid()) {
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+
+    if (d->mInvalidated) {
+        d->mInvalidated = false;
+        const QVector<QString> bootIds = d->mJournal->queryUnique(QLatin1String("_BOOT_ID"));
+        for (int row = d->mBootInfo.size() - 1; row >= 0; --row) {
+            if (!bootIds.contains(d->mBootInfo.at(row).mBootId)) {
+                beginRemoveRows(QModelIndex(), row, row);
+                d->mBootInfo.remove(row);
+                endRemoveRows();
+            }
+        }
+        for (const QString &bootId : bootIds) {
+            if (d->row(bootId) >= 0) {
+                continue;
+            }
+            if (const std::optional<BootModelPrivate::BootInfo> boot = JournaldHelper::queryBoot(*d->mJournal, bootId)) {
+                const int row = d->insertPosition(boot.value());
+                beginInsertRows(QModelIndex(), row, row);
+                d->mBootInfo.insert(row, boot.value());
+                endInsertRows();
+            }
+        }
+    }
+
+    // walk only over the new entries and extend or add their boots
+    if (!d->mJournal->setFilter(FilterExpression())) {
+        return;
+    }
+    const bool seeked = d->mTailCursor.isEmpty() ? d->mJournal->seekHead() : d->mJournal->seekCursor(d->mTailCursor);
+    if (!seeked) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Could not seek to last known entry, skipping boot update";
+        return;
+    }
+    if (!d->mTailCursor.isEmpty() && d->mJournal->next() > 0 && !d->mJournal->testCursor(d->mTailCursor)) {
+        // tail entry was removed with its file, thus the seek already positioned at the following entry
+        d->mJournal->previous();
+    }
+    int entries{0};
+    QSet<QString> extendedBoots;
+    while (d->mJournal->next() > 0) {
+        ++entries;
+        const std::optional<QByteArrayView> value = d->mJournal->fieldValue("_BOOT_ID");
+        const quint64 time = d->mJournal->realtimeUsec();
+        if (!value || time == 0) {
+            continue;
+        }
+        const QString bootId = QString::fromUtf8(value.value());
+        const QDateTime dateTime = QDateTime::fromMSecsSinceEpoch(time / 1000);
+        if (const int row = d->row(bootId); row >= 0) {
+            BootModelPrivate::BootInfo &boot = d->mBootInfo[row];
+            if (dateTime > boot.mUntil) {
+                boot.mUntil = dateTime;
+                extendedBoots.insert(bootId);
+            }
+        } else {
+            const BootModelPrivate::BootInfo boot{bootId, dateTime, dateTime};
+            const int row = d->insertPosition(boot);
+            beginInsertRows(QModelIndex(), row, row);
+            d->mBootInfo.insert(row, boot);
+            endInsertRows();
+        }
+        d->mTailCursor = d->mJournal->cursor();
+    }
+    for (const QString &bootId : std::as_const(extendedBoots)) {
+        const QModelIndex changed = index(d->row(bootId), 0);
+        Q_EMIT dataChanged(changed, changed, {BootModel::UNTIL, BootModel::DISPLAY_SHORT_UTC, BootModel::DISPLAY_SHORT_LOCALTIME});
+    }
+    qCDebug(KJOURNALDLIB_PERFORMANCE) << "Updated boots with" << entries << "new entries in" << timer.elapsed() << "ms";
+}
+
 bool BootModel::setJournaldPath(const QString &path)
 {
     qCDebug(KJOURNALDLIB_GENERAL) << "load journal from path" << path;
-    bool success{true};
-    beginResetModel();
     d->mJournaldPath = path;
     d->mJournal = std::make_unique<LocalJournal>(path);
-    success = d->mJournal->isValid();
-    if (success) {
-        d->mBootInfo = JournaldHelper::queryOrderedBootIds(*d->mJournal.get());
-        d->sort(Qt::SortOrder::DescendingOrder);
-    }
-    endResetModel();
-    return success;
+    loadBoots();
+    return d->mJournal->isValid();
 }
 
 QString BootModel::journaldPath() const
@@ -63,12 +238,25 @@ QString BootModel::journaldPath() const
 void BootModel::setSystemJournal()
 {
     qCDebug(KJOURNALDLIB_GENERAL) << "load system journal";
-    beginResetModel();
     d->mJournaldPath = QString();
     d->mJournal = std::make_unique<LocalJournal>();
-    d->mBootInfo = JournaldHelper::queryOrderedBootIds(*d->mJournal.get());
-    d->sort(Qt::SortOrder::DescendingOrder);
-    endResetModel();
+    loadBoots();
+}
+
+void BootModel::setJournalClone(IJournal *journal)
+{
+    if (!journal) {
+        return;
+    }
+    qCDebug(KJOURNALDLIB_GENERAL) << "load journal clone";
+    d->mJournaldPath = QString();
+    d->mJournal = journal->clone();
+    loadBoots();
+}
+
+bool BootModel::isLoading() const
+{
+    return d->mLoading;
 }
 
 QHash<int, QByteArray> BootModel::roleNames() const
@@ -7,6 +7,7 @@
 #define BOOTMODEL_H
 
 #include "ijournal.h"
+#include "journaldhelper.h"
 #include "kjournald_export.h"
 #include <QAbstractItemModel>
 #include <memory>
@@ -18,11 +19,24 @@ class BootModelPrivate;
  *
  * This QAbstractItemModel derived class provides a model/view abstraction for information of all
  * boots provided by a given journald database.
+ *
+ * Boots are enumerated in a worker thread by clones of the journal and the rows are inserted once the
+ * enumeration is finished. Boots of journals that provide their files are read from JournalMetadataCache,
+ * otherwise they are queried, see JournaldHelper::queryOrderedBootIds(). Journals that cannot be cloned are
+ * enumerated synchronously.
+ *
+ * Afterwards the model follows journalUpdated(): new entries only extend the until time of their boot or add
+ * rows for new boots, which does not require to query all boots again. Only if journal files are added or
+ * removed, the set of boot IDs is compared and just the new boots are queried.
  */
 class KJOURNALD_EXPORT BootModel : public QAbstractListModel
 {
     Q_OBJECT
     Q_PROPERTY(QString journalPath WRITE setJournaldPath READ journaldPath RESET setSystemJournal)
+    /**
+     * true while boots are enumerated in the background
+     */
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged)
 
 public:
     enum Roles {
@@ -83,6 +97,18 @@ public:
      */
     void setSystemJournal();
 
+    /**
+     * Reset model by reading from a clone of @p journal
+     *
+     * Allows QML code to show the boots of journals that are owned by other objects, e.g. a GatewayJournal.
+     */
+    Q_INVOKABLE void setJournalClone(IJournal *journal);
+
+    /**
+     * @return true while boots are enumerated in the background
+     */
+    bool isLoading() const;
+
     /**
      * @copydoc QAbstractItemModel::roleNames()
      */
@@ -98,7 +124,25 @@ public:
      */
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
+Q_SIGNALS:
+    void loadingChanged();
+
 private:
+    /**
+     * Remove all boots and start enumerating the boots of the current journal
+     */
+    void loadBoots();
+
+    /**
+     * Apply the entries after the last known tail entry and, if journal files changed, added or removed boots
+     */
+    void updateBoots();
+
+    /**
+     * Add @p boot, or extend the time range of the known boot with the same ID
+     */
+    void mergeBoot(const JournaldHelper::BootInfo &boot);
+
     std::unique_ptr<BootModelPrivate> d;
 };
 
@@ -6,7 +6,12 @@
 #ifndef BOOT_MODEL_PRIVATE_H
 #define BOOT_MODEL_PRIVATE_H
 
+#include "filterexpression.h"
 #include "journaldhelper.h"
+#include "journalmetadatacache.h"
+#include <QFutureWatcher>
+#include <QTimer>
+#include <algorithm>
 
 class BootModelPrivate
 {
@@ -22,11 +27,39 @@ public:
 
     static QString prettyPrintBoot(const BootInfo &bootInfo, TIME_FORMAT format);
 
+    /**
+     * @return boots of @p journal, from the metadata cache if the journal provides its files
+     */
+    static QVector<BootInfo> queryBoots(IJournal &journal);
+
     void sort(Qt::SortOrder order);
 
+    /**
+     * @return row of boot @p bootId or -1 if the boot is unknown
+     */
+    int row(const QString &bootId) const;
+
+    /**
+     * @return row at which @p boot has to be inserted to keep the descending order
+     */
+    int insertPosition(const BootInfo &boot) const;
+
+    /**
+     * @return cursor of the last entry of the unfiltered journal, empty if the journal has no entries
+     */
+    QString tailCursor() const;
+
+    static constexpr int sUpdateCoalescingInterval{100}; //!< in milliseconds, journald writes in bursts
+
     QVector<BootInfo> mBootInfo;
     QString mJournaldPath;
     std::unique_ptr<IJournal> mJournal;
+    QFutureWatcher<QVector<BootInfo>> mWatcher; //!< running enumeration of boots
+    bool mLoading{false}; //!< enumeration was started and its result was not applied yet, unlike mWatcher.isRunning()
+    QString mTailCursor; //!< last entry that is reflected by the boots
+    QTimer mUpdateTimer; //!< coalesces journal updates
+    bool mUpdatePending{false}; //!< journal was updated during enumeration
+    bool mInvalidated{false}; //!< journal files were added or removed since the last update
 };
 
 QString BootModelPrivate::prettyPrintBoot(const BootInfo &bootInfo, TIME_FORMAT format)
@@ -66,4 +99,36 @@ void BootModelPrivate::sort(Qt::SortOrder order)
     });
 }
 
+QVector<BootModelPrivate::BootInfo> BootModelPrivate::queryBoots(IJournal &journal)
+{
+    if (const std::shared_ptr<const JournalMetadataCache::Metadata> metadata = JournalMetadataCache::shared(journal)) {
+        return metadata->mBoots;
+    }
+    return JournaldHelper::queryOrderedBootIds(journal);
+}
+
+int BootModelPrivate::row(const QString &bootId) const
+{
+    const auto it = std::find_if(mBootInfo.cbegin(), mBootInfo.cend(), [&bootId](const BootInfo &boot) {
+        return boot.mBootId == bootId;
+    });
+    return it == mBootInfo.cend() ? -1 : static_cast<int>(std::distance(mBootInfo.cbegin(), it));
+}
+
+int BootModelPrivate::insertPosition(const BootInfo &boot) const
+{
+    const auto it = std::find_if(mBootInfo.cbegin(), mBootInfo.cend(), [&boot](const BootInfo &other) {
+        return other.mSince < boot.mSince;
+    });
+    return static_cast<int>(std::distance(mBootInfo.cbegin(), it));
+}
+
+QString BootModelPrivate::tailCursor() const
+{
+    if (!mJournal || !mJournal->setFilter(FilterExpression()) || !mJournal->seekTail() || mJournal->previous() <= 0) {
+        return QString();
+    }
+    return mJournal->cursor();
+}
+
 #endif // JOURNAL_H
@@ -0,0 +1,193 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "decompressiondevice.h"
+#include "decompressiondevice_p.h"
+#include "kjournaldlib_log_general.h"
+#include <QDeadlineTimer>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cstring>
+
+KCompressionDevice::CompressionType DecompressionDevicePrivate::compressionType(const QString &path)
+{
+    if (path.endsWith(QLatin1String(".gz"))) {
+        return KCompressionDevice::GZip;
+    } else if (path.endsWith(QLatin1String(".bz2"))) {
+        return KCompressionDevice::BZip2;
+    } else if (path.endsWith(QLatin1String(".xz"))) {
+        return KCompressionDevice::Xz;
+    } else if (path.endsWith(QLatin1String(".zst"))) {
+        return KCompressionDevice::Zstd;
+    }
+    return KCompressionDevice::None;
+}
+
+void DecompressionDevicePrivate::decompress(DecompressionDevice *q)
+{
+    KCompressionDevice device(mPath, compressionType(mPath));
+    bool error{false};
+    if (!device.open(QIODevice::ReadOnly)) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Could not open compressed file" << mPath << device.errorString();
+        error = true;
+    }
+    while (!error) {
+        QByteArray block = device.read(sBlockSize);
+        if (block.isEmpty()) {
+            // KCompressionDevice reports corrupt data only by its error state
+            if (device.error() != KCompressionDevice::NoError) {
+                qCCritical(KJOURNALDLIB_GENERAL) << "Could not decompress file" << mPath << device.errorString();
+                error = true;
+            }
+            break;
+        }
+        QMutexLocker locker(&mMutex);
+        while (mBlocks.size() >= sMaxBlocks && !mCanceled) {
+            mSpaceAvailable.wait(&mMutex);
+        }
+        if (mCanceled) {
+            break;
+        }
+        mBufferedBytes += block.size();
+        mBlocks.push_back(std::move(block));
+        mDataAvailable.wakeAll();
+        locker.unlock();
+        Q_EMIT q->readyRead();
+    }
+    QMutexLocker locker(&mMutex);
+    mFinished = true;
+    mError = error;
+    mDataAvailable.wakeAll();
+    locker.unlock();
+    Q_EMIT q->readChannelFinished();
+}
+
+void DecompressionDevicePrivate::stop()
+{
+    if (!mThread) {
+        return;
+    }
+    {
+        QMutexLocker locker(&mMutex);
+        mCanceled = true;
+        mSpaceAvailable.wakeAll();
+    }
+    mThread->wait();
+    mThread.reset();
+    mBlocks.clear();
+    mBlockOffset = 0;
+    mBufferedBytes = 0;
+}
+
+DecompressionDevice::DecompressionDevice(const QString &path, QObject *parent)
+    : QIODevice(parent)
+    , d(new DecompressionDevicePrivate)
+{
+    d->mPath = path;
+}
+
+DecompressionDevice::~DecompressionDevice()
+{
+    d->stop();
+}
+
+bool DecompressionDevice::isCompressed(const QString &path)
+{
+    return DecompressionDevicePrivate::compressionType(path) != KCompressionDevice::None;
+}
+
+bool DecompressionDevice::open(OpenMode mode)
+{
+    if (isOpen() || (mode & QIODevice::WriteOnly)) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Decompression device can only be opened once for reading";
+        return false;
+    }
+    if (!isCompressed(d->mPath)) {
+        setErrorString(QLatin1String("Unsupported compression format"));
+        return false;
+    }
+    d->mFinished = false;
+    d->mCanceled = false;
+    d->mError = false;
+    // device is unbuffered, because the worker already provides the data in blocks
+    QIODevice::open(mode | QIODevice::Unbuffered);
+    d->mThread.reset(QThread::create(&DecompressionDevicePrivate::decompress, d.get(), this));
+    d->mThread->start();
+    return true;
+}
+
+void DecompressionDevice::close()
+{
+    d->stop();
+    QIODevice::close();
+}
+
+bool DecompressionDevice::isSequential() const
+{
+    return true;
+}
+
+qint64 DecompressionDevice::bytesAvailable() const
+{
+    QMutexLocker locker(&d->mMutex);
+    return d->mBufferedBytes - d->mBlockOffset + QIODevice::bytesAvailable();
+}
+
+bool DecompressionDevice::atEnd() const
+{
+    QMutexLocker locker(&d->mMutex);
+    return !isOpen() || (d->mFinished && d->mBlocks.empty());
+}
+
+bool DecompressionDevice::waitForReadyRead(int msecs)
+{
+    QDeadlineTimer deadline(msecs);
+    QMutexLocker locker(&d->mMutex);
+    while (d->mBlocks.empty() && !d->mFinished) {
+        if (!d->mDataAvailable.wait(&d->mMutex, deadline)) {
+            break;
+        }
+    }
+    return !d->mBlocks.empty();
+}
+
+bool DecompressionDevice::hasError() const
+{
+    QMutexLocker locker(&d->mMutex);
+    return d->mError;
+}
+
+qint64 DecompressionDevice::readData(char *data, qint64 maxSize)
+{
+    QMutexLocker locker(&d->mMutex);
+    while (d->mBlocks.empty() && !d->mFinished) {
+        d->mDataAvailable.wait(&d->mMutex);
+    }
+    if (d->mBlocks.empty()) {
+        return -1;
+    }
+    qint64 bytes{0};
+    while (bytes < maxSize && !d->mBlocks.empty()) {
+        const QByteArray &block = d->mBlocks.front();
+        const qint64 size = std::min(maxSize - bytes, block.size() - d->mBlockOffset);
+        std::memcpy(data + bytes, block.constData() + d->mBlockOffset, size);
+        bytes += size;
+        d->mBlockOffset += size;
+        if (d->mBlockOffset == block.size()) {
+            d->mBufferedBytes -= block.size();
+            d->mBlocks.pop_front();
+            d->mBlockOffset = 0;
+        }
+    }
+    d->mSpaceAvailable.wakeAll();
+    return bytes;
+}
+
+qint64 DecompressionDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(maxSize)
+    return -1;
+}
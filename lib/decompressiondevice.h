@@ -0,0 +1,87 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef DECOMPRESSIONDEVICE_H
+#define DECOMPRESSIONDEVICE_H
+
+#include "kjournald_export.h"
+#include <QIODevice>
+#include <memory>
+
+class DecompressionDevicePrivate;
+
+/**
+ * @brief Sequential device that provides the decompressed content of a compressed file
+ *
+ * Decompression runs in a worker thread that stays a bounded number of blocks ahead of the reader,
+ * such that decompression and processing of the data overlap without a temporary uncompressed copy.
+ * The compression format is detected by file name suffix, supported are ".gz", ".bz2", ".xz" and ".zst".
+ *
+ * Other than for usual sequential devices, read() blocks until data is decompressed or the end of the
+ * file is reached. Non-blocking access is possible by reading only bytesAvailable() bytes after readyRead().
+ */
+class KJOURNALD_EXPORT DecompressionDevice : public QIODevice
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Construct device for compressed file at @p path
+     */
+    explicit DecompressionDevice(const QString &path, QObject *parent = nullptr);
+
+    /**
+     * @brief Destroys the device and stops decompression
+     */
+    ~DecompressionDevice() override;
+
+    /**
+     * @return true if @p path has the suffix of a supported compression format
+     */
+    static bool isCompressed(const QString &path);
+
+    /**
+     * @brief Start decompression, only reading is supported
+     */
+    bool open(OpenMode mode) override;
+
+    /**
+     * @brief Stop decompression and close the device
+     */
+    void close() override;
+
+    /**
+     * @return true, since the data is only available in sequence
+     */
+    bool isSequential() const override;
+
+    /**
+     * @return number of decompressed bytes that can be read without blocking
+     */
+    qint64 bytesAvailable() const override;
+
+    /**
+     * @return true if all data was decompressed and read
+     */
+    bool atEnd() const override;
+
+    /**
+     * @brief Wait up to @p msecs for decompressed data, -1 waits without timeout
+     */
+    bool waitForReadyRead(int msecs) override;
+
+    /**
+     * @return true if the file could not be decompressed completely
+     */
+    bool hasError() const;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    std::unique_ptr<DecompressionDevicePrivate> d;
+};
+
+#endif // DECOMPRESSIONDEVICE_H
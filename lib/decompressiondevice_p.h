@@ -0,0 +1,54 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef DECOMPRESSIONDEVICE_P_H
+#define DECOMPRESSIONDEVICE_P_H
+
+#include "decompressiondevice.h"
+#include <KCompressionDevice>
+#include <QByteArray>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include <deque>
+#include <memory>
+
+class DecompressionDevicePrivate
+{
+public:
+    /**
+     * @return compression type for the suffix of @p path or KCompressionDevice::None if it is unknown
+     */
+    static KCompressionDevice::CompressionType compressionType(const QString &path);
+
+    /**
+     * decompress file in worker thread into mBlocks until the end of the file is reached or decompression is canceled
+     */
+    void decompress(DecompressionDevice *q);
+
+    /**
+     * stop worker thread and drop all decompressed data
+     */
+    void stop();
+
+    static constexpr qint64 sBlockSize{1024 * 1024};
+    static constexpr std::size_t sMaxBlocks{8}; //!< number of blocks the worker decompresses ahead of the reader
+
+    QString mPath;
+    std::unique_ptr<QThread> mThread;
+
+    // state shared with worker thread, guarded by mMutex
+    mutable QMutex mMutex;
+    QWaitCondition mDataAvailable;
+    QWaitCondition mSpaceAvailable;
+    std::deque<QByteArray> mBlocks;
+    qint64 mBlockOffset{0}; //!< read position in first block
+    qint64 mBufferedBytes{0};
+    bool mFinished{false};
+    bool mCanceled{false};
+    bool mError{false};
+};
+
+#endif // DECOMPRESSIONDEVICE_P_H
@@ -5,6 +5,7 @@
 
 #include "filtercriteriamodel.h"
 #include "filtercriteriamodel_p.h"
+#include "journalmetadatacache.h"
 #include "kjournald_export.h"
 #include "kjournaldlib_log_general.h"
 #include "localjournal.h"
@@ -12,10 +13,32 @@
 #include <QDebug>
 #include <QDir>
 #include <QString>
+#include <QtConcurrent>
+#include <algorithm>
 #include <memory>
 
 constexpr quint8 sDefaultPriorityLevel{5};
 
+namespace
+{
+QVector<QString> sortedValues(QVector<QString> values)
+{
+    std::sort(std::begin(values), std::end(values), [](const QString &a, const QString &b) {
+        return QString::compare(a, b, Qt::CaseInsensitive) < 0;
+    });
+    return values;
+}
+
+QVector<QString> serviceUnits(QVector<QString> units)
+{
+    // skip any non-service units, because we expect users only be interested in filtering those
+    units.removeIf([](const QString &unit) {
+        return !unit.endsWith(QLatin1String(".service"));
+    });
+    return sortedValues(std::move(units));
+}
+}
+
 QString FilterCriteriaModelPrivate::mapPriorityToString(int priority)
 {
     switch (priority) {
@@ -122,10 +145,7 @@ std::shared_ptr<SelectionEntry> SelectionEntry::parentItem()
     return mParentItem.lock();
 }
 
-FilterCriteriaModelPrivate::FilterCriteriaModelPrivate()
-{
-    rebuildModel();
-}
+FilterCriteriaModelPrivate::FilterCriteriaModelPrivate() = default;
 
 FilterCriteriaModelPrivate::~FilterCriteriaModelPrivate() = default;
 
@@ -174,19 +194,6 @@ void FilterCriteriaModelPrivate::rebuildModel()
                                                        false,
                                                        mRootItem);
         mRootItem->appendChild(parent);
-        QVector<QString> units = JournaldHelper::queryUnique(mJournal, JournaldHelper::Field::_SYSTEMD_UNIT);
-        std::sort(std::begin(units), std::end(units), [](const QString &a, const QString &b) {
-            return QString::compare(a, b, Qt::CaseInsensitive) <= 0;
-        });
-        for (const auto &unit : std::as_const(units)) {
-            // skip any non-service units, because we expect users only be interested in filtering those
-            if (!unit.endsWith(QLatin1String(".service"))) {
-                continue;
-            }
-            mRootItem->child(FilterCriteriaModel::Category::SYSTEMD_UNIT)
-                ->appendChild(std::move(
-                    std::make_unique<SelectionEntry>(JournaldHelper::cleanupString(unit), unit, FilterCriteriaModel::Category::SYSTEMD_UNIT, false, parent)));
-        }
     }
     {
         auto parent = std::make_shared<SelectionEntry>(i18nc("Section title for process list", "Process"),
@@ -195,48 +202,111 @@ void FilterCriteriaModelPrivate::rebuildModel()
                                                        false,
                                                        mRootItem);
         mRootItem->appendChild(parent);
-        QVector<QString> exes = JournaldHelper::queryUnique(mJournal, JournaldHelper::Field::_EXE);
-        std::sort(std::begin(exes), std::end(exes), [](const QString &a, const QString &b) {
-            return QString::compare(a, b, Qt::CaseInsensitive) <= 0;
-        });
-        for (const auto &exe : std::as_const(exes)) {
-            mRootItem->child(FilterCriteriaModel::Category::EXE)
-                ->appendChild(
-                    std::move(std::make_unique<SelectionEntry>(JournaldHelper::cleanupString(exe), exe, FilterCriteriaModel::Category::EXE, false, parent)));
+    }
+}
+
+void FilterCriteriaModelPrivate::queryValues(IJournal &journal, const std::function<bool(const CategoryValues &)> &report)
+{
+    // unique values of archived files are read from the cache, only files that are written are queried
+    if (const std::shared_ptr<const JournalMetadataCache::Metadata> metadata = JournalMetadataCache::shared(journal)) {
+        if (report(CategoryValues{FilterCriteriaModel::Category::SYSTEMD_UNIT, serviceUnits(metadata->mUnits)})) {
+            report(CategoryValues{FilterCriteriaModel::Category::EXE, sortedValues(metadata->mExes)});
         }
+        return;
+    }
+    if (!report(CategoryValues{FilterCriteriaModel::Category::SYSTEMD_UNIT,
+                               serviceUnits(JournaldHelper::queryUnique(journal, JournaldHelper::Field::_SYSTEMD_UNIT))})) {
+        return;
     }
+    report(CategoryValues{FilterCriteriaModel::Category::EXE, sortedValues(JournaldHelper::queryUnique(journal, JournaldHelper::Field::_EXE))});
 }
 
 FilterCriteriaModel::FilterCriteriaModel(QObject *parent)
-    : QAbstractItemModel(parent)
-    , d(new FilterCriteriaModelPrivate)
+    : FilterCriteriaModel(std::make_shared<LocalJournal>(), parent)
 {
-    beginResetModel();
-    d->mJournal = std::make_shared<LocalJournal>();
-    d->rebuildModel();
-    endResetModel();
 }
 
 FilterCriteriaModel::FilterCriteriaModel(const QString &journalPath, QObject *parent)
+    : FilterCriteriaModel(std::make_shared<LocalJournal>(journalPath), parent)
+{
+}
+
+FilterCriteriaModel::FilterCriteriaModel(std::shared_ptr<IJournal> journal, QObject *parent)
     : QAbstractItemModel(parent)
     , d(new FilterCriteriaModelPrivate)
 {
-    beginResetModel();
-    d->mJournal = std::make_shared<LocalJournal>(journalPath);
-    d->rebuildModel();
-    endResetModel();
+    connect(&d->mWatcher, &QFutureWatcher<FilterCriteriaModelPrivate::CategoryValues>::resultReadyAt, this, [this](int index) {
+        // canceled queries belong to a replaced journal
+        if (!d->mWatcher.isCanceled()) {
+            const FilterCriteriaModelPrivate::CategoryValues values = d->mWatcher.resultAt(index);
+            insertValues(values.mCategory, values.mValues);
+        }
+    });
+    connect(&d->mWatcher, &QFutureWatcher<FilterCriteriaModelPrivate::CategoryValues>::finished, this, &FilterCriteriaModel::loadingChanged);
+    setJournal(std::move(journal));
 }
 
 FilterCriteriaModel::~FilterCriteriaModel() = default;
 
 bool FilterCriteriaModel::setJournaldPath(const QString &path)
+{
+    setJournal(std::make_shared<LocalJournal>(path));
+    return d->mJournal->isValid();
+}
+
+void FilterCriteriaModel::setJournal(std::shared_ptr<IJournal> journal)
 {
     beginResetModel();
-    d->mJournal = std::make_shared<LocalJournal>(path);
-    bool success = d->mJournal->isValid();
+    d->mJournal = std::move(journal);
     d->rebuildModel();
     endResetModel();
-    return success;
+
+    // values of a replaced journal are not needed anymore
+    const bool wasLoading = d->mWatcher.isRunning();
+    d->mWatcher.cancel();
+    std::unique_ptr<IJournal> clone = d->mJournal && d->mJournal->isValid() ? d->mJournal->clone() : nullptr;
+    if (!clone) {
+        if (d->mJournal && d->mJournal->isValid()) {
+            FilterCriteriaModelPrivate::queryValues(*d->mJournal, [this](const FilterCriteriaModelPrivate::CategoryValues &values) {
+                insertValues(values.mCategory, values.mValues);
+                return true;
+            });
+        }
+        return;
+    }
+    // the pool thread reads the clone, which stays in this thread and thus must not watch for changes
+    clone->stopWatching();
+    std::shared_ptr<IJournal> workerJournal(clone.release(), [](IJournal *journal) {
+        journal->deleteLater();
+    });
+    d->mWatcher.setFuture(QtConcurrent::run([workerJournal](QPromise<FilterCriteriaModelPrivate::CategoryValues> &promise) {
+        FilterCriteriaModelPrivate::queryValues(*workerJournal, [&promise](const FilterCriteriaModelPrivate::CategoryValues &values) {
+            promise.addResult(values);
+            return !promise.isCanceled();
+        });
+    }));
+    if (!wasLoading) {
+        Q_EMIT loadingChanged();
+    }
+}
+
+void FilterCriteriaModel::insertValues(FilterCriteriaModel::Category category, const QVector<QString> &values)
+{
+    std::shared_ptr<SelectionEntry> parent = d->mRootItem->child(category);
+    if (!parent || values.isEmpty()) {
+        return;
+    }
+    const int first = parent->childCount();
+    beginInsertRows(index(category, 0), first, first + values.size() - 1);
+    for (const QString &value : values) {
+        parent->appendChild(std::make_shared<SelectionEntry>(JournaldHelper::cleanupString(value), value, category, false, parent));
+    }
+    endInsertRows();
+}
+
+bool FilterCriteriaModel::isLoading() const
+{
+    return d->mWatcher.isRunning();
 }
 
 QHash<int, QByteArray> FilterCriteriaModel::roleNames() const
@@ -252,10 +322,15 @@ QHash<int, QByteArray> FilterCriteriaModel::roleNames() const
 
 void FilterCriteriaModel::setSystemJournal()
 {
-    beginResetModel();
-    d->mJournal = std::make_shared<LocalJournal>();
-    d->rebuildModel();
-    endResetModel();
+    setJournal(std::make_shared<LocalJournal>());
+}
+
+void FilterCriteriaModel::setJournalClone(IJournal *journal)
+{
+    if (!journal) {
+        return;
+    }
+    setJournal(std::shared_ptr<IJournal>(journal->clone()));
 }
 
 int FilterCriteriaModel::priorityFilter() const
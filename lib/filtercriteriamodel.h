@@ -25,6 +25,9 @@ class FilterCriteriaModelPrivate;
  * The model can be create from an arbitrary local journald database by defining a path or from the
  * system's default journal. Values can either be set by @a setFieldString for arbitrary values or in a
  * typesafe manner via @a setField for most common fields.
+ *
+ * All categories are available immediately after construction or after changing the journal. Their units and
+ * processes are read by a worker thread and appended as rows of each category as soon as the category is ready.
  */
 class KJOURNALD_EXPORT FilterCriteriaModel : public QAbstractItemModel
 {
@@ -46,6 +49,10 @@ class KJOURNALD_EXPORT FilterCriteriaModel : public QAbstractItemModel
      * if set to true, Kernel messages are added to the log output
      **/
     Q_PROPERTY(bool kernelFilter READ isKernelFilterEnabled NOTIFY kernelFilterChanged)
+    /**
+     * true while units and processes are read in the background
+     **/
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged)
 
 public:
     enum Category : quint8 {
@@ -104,6 +111,18 @@ public:
      */
     void setSystemJournal();
 
+    /**
+     * Reset model by reading from a clone of @p journal
+     *
+     * Allows to show the units and processes of journals that are owned by other objects, e.g. a GatewayJournal.
+     */
+    Q_INVOKABLE void setJournalClone(IJournal *journal);
+
+    /**
+     * @return true while units and processes are read in the background
+     */
+    bool isLoading() const;
+
     /**
      * @return the currently selected priority threshold for displayed log entries
      */
@@ -169,8 +188,21 @@ Q_SIGNALS:
     void systemdUnitFilterChanged();
     void exeFilterChanged();
     void kernelFilterChanged();
+    void loadingChanged();
 
 private:
+    FilterCriteriaModel(std::shared_ptr<IJournal> journal, QObject *parent);
+
+    /**
+     * Recreate the categories for @p journal and start reading the units and processes
+     */
+    void setJournal(std::shared_ptr<IJournal> journal);
+
+    /**
+     * Append children with @p values to @p category
+     */
+    void insertValues(FilterCriteriaModel::Category category, const QVector<QString> &values);
+
     std::unique_ptr<FilterCriteriaModelPrivate> d;
 };
 
@@ -8,9 +8,11 @@
 
 #include "filtercriteriamodel.h"
 #include "ijournal.h"
+#include <QFutureWatcher>
 #include <QMap>
 #include <QString>
 #include <QVector>
+#include <functional>
 #include <memory>
 #include <optional>
 
@@ -46,16 +48,32 @@ private:
 class FilterCriteriaModelPrivate
 {
 public:
+    /**
+     * values of one category that are read from the journal
+     */
+    struct CategoryValues {
+        FilterCriteriaModel::Category mCategory;
+        QVector<QString> mValues; //!< sorted values
+    };
+
     FilterCriteriaModelPrivate();
     ~FilterCriteriaModelPrivate();
     /**
-     * @brief clear all model data and read units, processes... from currently set journal
+     * @brief clear all model data and create the categories, units, processes... are added by queryValues()
      */
     void rebuildModel();
 
+    /**
+     * @brief read values of all categories from @p journal and pass each category to @p report as soon as it is ready
+     *
+     * This method is thread-safe. Reading stops when @p report returns false.
+     */
+    static void queryValues(IJournal &journal, const std::function<bool(const CategoryValues &)> &report);
+
     static QString mapPriorityToString(int priority);
 
     std::shared_ptr<IJournal> mJournal;
+    QFutureWatcher<CategoryValues> mWatcher; //!< running query of category values
     std::shared_ptr<SelectionEntry> mRootItem;
     std::optional<quint8> mPriorityLevel;
 };
@@ -0,0 +1,569 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "filterexpression.h"
+#include "kjournaldlib_log_filtertrace.h"
+#include "kjournaldlib_log_general.h"
+#include <QDebug>
+#include <algorithm>
+#include <iterator>
+#include <systemd/sd-journal.h>
+
+namespace
+{
+using Term = FilterExpression::Term;
+using Disjunction = QVector<FilterExpression::Term>;
+
+// distribution of AND over OR can grow exponentially, warn when exceeding this number of terms
+constexpr int sDistributedTermsWarningThreshold{1024};
+
+// journald cannot express an empty result set; since fields with leading underscore can only be set by
+// journald itself, no entry can match this field
+const QLatin1String sUnsatisfiableMatch{"_KJOURNALD_UNSATISFIABLE=1"};
+
+QStringList sortedUnique(QStringList values)
+{
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    return values;
+}
+
+/**
+ * AND combination of two terms
+ * @return false if the combination cannot be satisfied
+ */
+bool mergeTerms(const Term &lhs, const Term &rhs, Term &result)
+{
+    result = lhs;
+    for (auto it = rhs.mMatches.cbegin(); it != rhs.mMatches.cend(); ++it) {
+        auto existing = result.mMatches.find(it.key());
+        if (existing == result.mMatches.end()) {
+            result.mMatches.insert(it.key(), it.value());
+            continue;
+        }
+        QStringList intersection;
+        for (const QString &value : std::as_const(existing.value())) {
+            if (it.value().contains(value)) {
+                intersection.append(value);
+            }
+        }
+        if (intersection.isEmpty()) {
+            return false;
+        }
+        existing.value() = intersection;
+    }
+    return true;
+}
+
+/**
+ * Remove duplicates and join terms that only differ in the values of a single field
+ * @note a disjunction that contains a term without matches is always true and is returned as single empty term
+ */
+Disjunction simplify(const Disjunction &disjunction)
+{
+    Disjunction result;
+    for (const Term &term : disjunction) {
+        if (term.mMatches.isEmpty()) {
+            return {Term{}};
+        }
+        if (term.mMatches.size() == 1) {
+            auto it = std::find_if(result.begin(), result.end(), [&term](const Term &candidate) {
+                return candidate.mMatches.size() == 1 && candidate.mMatches.firstKey() == term.mMatches.firstKey();
+            });
+            if (it != result.end()) {
+                it->mMatches.first() = sortedUnique(it->mMatches.first() + term.mMatches.first());
+                continue;
+            }
+        }
+        if (!result.contains(term)) {
+            result.append(term);
+        }
+    }
+    return result;
+}
+
+Disjunction disjunctionOf(const FilterExpression &expression)
+{
+    switch (expression.type()) {
+    case FilterExpression::Type::EMPTY:
+        return {Term{}};
+    case FilterExpression::Type::MATCH: {
+        Term term;
+        term.mMatches.insert(expression.field(), {expression.value()});
+        return {term};
+    }
+    case FilterExpression::Type::NONE_OF:
+        Q_FALLTHROUGH();
+    case FilterExpression::Type::CONTAINS:
+        Q_FALLTHROUGH();
+    case FilterExpression::Type::RANGE:
+        Q_FALLTHROUGH();
+    case FilterExpression::Type::REGULAR_EXPRESSION:
+        qCCritical(KJOURNALDLIB_GENERAL) << "Expression cannot be evaluated by journald:" << expression.toString();
+        return {Term{}};
+    case FilterExpression::Type::ANY_OF: {
+        Disjunction result;
+        for (const auto &operand : expression.operands()) {
+            result.append(disjunctionOf(operand));
+        }
+        return simplify(result);
+    }
+    case FilterExpression::Type::ALL_OF: {
+        Disjunction result{Term{}};
+        for (const auto &operand : expression.operands()) {
+            const Disjunction operandTerms = disjunctionOf(operand);
+            Disjunction product;
+            for (const Term &lhs : std::as_const(result)) {
+                for (const Term &rhs : operandTerms) {
+                    Term merged;
+                    if (mergeTerms(lhs, rhs, merged)) {
+                        product.append(merged);
+                    }
+                }
+            }
+            result = simplify(product);
+        }
+        if (result.size() > sDistributedTermsWarningThreshold) {
+            qCWarning(KJOURNALDLIB_GENERAL) << "Filter expression normalization created" << result.size() << "terms, consider simplifying the filter";
+        }
+        return result;
+    }
+    }
+    return {};
+}
+
+void collectConjuncts(const FilterExpression &expression, FilterExpression::NormalizedForm &form)
+{
+    switch (expression.type()) {
+    case FilterExpression::Type::EMPTY:
+        return;
+    case FilterExpression::Type::ALL_OF:
+        for (const auto &operand : expression.operands()) {
+            collectConjuncts(operand, form);
+        }
+        return;
+    case FilterExpression::Type::MATCH:
+        Q_FALLTHROUGH();
+    case FilterExpression::Type::ANY_OF: {
+        const Disjunction disjunction = disjunctionOf(expression);
+        if (disjunction.isEmpty()) {
+            form.mSatisfiable = false;
+        } else if (disjunction.size() == 1 && disjunction.first().mMatches.isEmpty()) {
+            // always true, nothing to add
+        } else if (!form.mConjunction.contains(disjunction)) {
+            form.mConjunction.append(disjunction);
+        }
+        return;
+    }
+    case FilterExpression::Type::NONE_OF:
+        Q_FALLTHROUGH();
+    case FilterExpression::Type::CONTAINS:
+        Q_FALLTHROUGH();
+    case FilterExpression::Type::RANGE:
+        Q_FALLTHROUGH();
+    case FilterExpression::Type::REGULAR_EXPRESSION:
+        // not indexable, handled by residual filter
+        return;
+    }
+}
+
+QString explainTerm(const Term &term)
+{
+    QStringList fields;
+    for (auto it = term.mMatches.cbegin(); it != term.mMatches.cend(); ++it) {
+        QStringList matches;
+        for (const QString &value : it.value()) {
+            matches.append(it.key() + QLatin1Char('=') + value);
+        }
+        if (matches.size() > 1 && term.mMatches.size() > 1) {
+            fields.append(QLatin1Char('(') + matches.join(QLatin1String(" OR ")) + QLatin1Char(')'));
+        } else {
+            fields.append(matches.join(QLatin1String(" OR ")));
+        }
+    }
+    return fields.join(QLatin1String(" AND "));
+}
+
+bool addMatch(sd_journal *journal, const QString &filterExpression)
+{
+    const int result = sd_journal_add_match(journal, filterExpression.toUtf8().constData(), 0);
+    qCDebug(KJOURNALDLIB_FILTERTRACE).nospace() << "add_match(" << filterExpression << ")";
+    if (result < 0) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Failed to set journal filter:" << strerror(-result) << filterExpression;
+        return false;
+    }
+    return true;
+}
+}
+
+FilterExpression FilterExpression::match(const QString &field, const QString &value)
+{
+    FilterExpression expression;
+    expression.mType = Type::MATCH;
+    expression.mField = field;
+    expression.mValue = value;
+    return expression;
+}
+
+FilterExpression FilterExpression::matchAny(const QString &field, const QStringList &values)
+{
+    std::vector<FilterExpression> operands;
+    operands.reserve(values.size());
+    for (const QString &value : values) {
+        operands.push_back(match(field, value));
+    }
+    return anyOf(operands);
+}
+
+FilterExpression FilterExpression::allOf(const std::vector<FilterExpression> &operands)
+{
+    FilterExpression expression;
+    for (const auto &operand : operands) {
+        if (operand.isEmpty()) {
+            continue;
+        }
+        // flatten nested AND operations, since they do not change the result
+        if (operand.type() == Type::ALL_OF) {
+            expression.mOperands.insert(expression.mOperands.end(), operand.mOperands.cbegin(), operand.mOperands.cend());
+        } else {
+            expression.mOperands.push_back(operand);
+        }
+    }
+    if (expression.mOperands.size() == 1) {
+        return expression.mOperands.front();
+    }
+    if (!expression.mOperands.empty()) {
+        expression.mType = Type::ALL_OF;
+    }
+    return expression;
+}
+
+FilterExpression FilterExpression::anyOf(const std::vector<FilterExpression> &operands)
+{
+    FilterExpression expression;
+    for (const auto &operand : operands) {
+        if (operand.isEmpty()) {
+            continue;
+        }
+        // flatten nested OR operations, since they do not change the result
+        if (operand.type() == Type::ANY_OF) {
+            expression.mOperands.insert(expression.mOperands.end(), operand.mOperands.cbegin(), operand.mOperands.cend());
+        } else {
+            expression.mOperands.push_back(operand);
+        }
+    }
+    if (expression.mOperands.size() == 1) {
+        return expression.mOperands.front();
+    }
+    if (!expression.mOperands.empty()) {
+        expression.mType = Type::ANY_OF;
+    }
+    return expression;
+}
+
+FilterExpression FilterExpression::noneOf(const std::vector<FilterExpression> &operands)
+{
+    const FilterExpression alternatives = anyOf(operands);
+    if (alternatives.isEmpty()) {
+        return alternatives;
+    }
+    FilterExpression expression;
+    expression.mType = Type::NONE_OF;
+    if (alternatives.type() == Type::ANY_OF) {
+        expression.mOperands = alternatives.mOperands;
+    } else {
+        expression.mOperands.push_back(alternatives);
+    }
+    return expression;
+}
+
+FilterExpression FilterExpression::contains(const QString &field, const QString &substring)
+{
+    FilterExpression expression;
+    expression.mType = Type::CONTAINS;
+    expression.mField = field;
+    expression.mValue = substring;
+    return expression;
+}
+
+FilterExpression FilterExpression::inRange(const QString &field, qint64 minimum, qint64 maximum)
+{
+    FilterExpression expression;
+    expression.mType = Type::RANGE;
+    expression.mField = field;
+    expression.mMinimum = minimum;
+    expression.mMaximum = maximum;
+    return expression;
+}
+
+FilterExpression FilterExpression::matchRegularExpression(const QString &field, const QString &pattern)
+{
+    FilterExpression expression;
+    expression.mType = Type::REGULAR_EXPRESSION;
+    expression.mField = field;
+    expression.mValue = pattern;
+    return expression;
+}
+
+FilterExpression FilterExpression::inRealtimeRange(const QDateTime &since, const QDateTime &until)
+{
+    return inRange(QLatin1String("__REALTIME_TIMESTAMP"),
+                   since.isValid() ? since.toMSecsSinceEpoch() * 1000 : std::numeric_limits<qint64>::min(),
+                   until.isValid() ? until.toMSecsSinceEpoch() * 1000 + 999 : std::numeric_limits<qint64>::max());
+}
+
+FilterExpression::Type FilterExpression::type() const
+{
+    return mType;
+}
+
+bool FilterExpression::isEmpty() const
+{
+    return mType == Type::EMPTY;
+}
+
+QString FilterExpression::field() const
+{
+    return mField;
+}
+
+QString FilterExpression::value() const
+{
+    return mValue;
+}
+
+qint64 FilterExpression::minimum() const
+{
+    return mMinimum;
+}
+
+qint64 FilterExpression::maximum() const
+{
+    return mMaximum;
+}
+
+const std::vector<FilterExpression> &FilterExpression::operands() const
+{
+    return mOperands;
+}
+
+bool FilterExpression::isIndexable() const
+{
+    switch (mType) {
+    case Type::EMPTY:
+        Q_FALLTHROUGH();
+    case Type::MATCH:
+        return true;
+    case Type::ALL_OF:
+        Q_FALLTHROUGH();
+    case Type::ANY_OF:
+        return std::all_of(mOperands.cbegin(), mOperands.cend(), [](const FilterExpression &operand) {
+            return operand.isIndexable();
+        });
+    case Type::NONE_OF:
+        Q_FALLTHROUGH();
+    case Type::CONTAINS:
+        Q_FALLTHROUGH();
+    case Type::RANGE:
+        Q_FALLTHROUGH();
+    case Type::REGULAR_EXPRESSION:
+        return false;
+    }
+    return false;
+}
+
+FilterExpression FilterExpression::indexablePart() const
+{
+    if (mType != Type::ALL_OF) {
+        return isIndexable() ? *this : FilterExpression();
+    }
+    std::vector<FilterExpression> operands;
+    std::copy_if(mOperands.cbegin(), mOperands.cend(), std::back_inserter(operands), [](const FilterExpression &operand) {
+        return operand.isIndexable();
+    });
+    return allOf(operands);
+}
+
+FilterExpression FilterExpression::residualPart() const
+{
+    if (mType != Type::ALL_OF) {
+        return isIndexable() ? FilterExpression() : *this;
+    }
+    std::vector<FilterExpression> operands;
+    std::copy_if(mOperands.cbegin(), mOperands.cend(), std::back_inserter(operands), [](const FilterExpression &operand) {
+        return !operand.isIndexable();
+    });
+    return allOf(operands);
+}
+
+QString FilterExpression::toString() const
+{
+    const auto joinOperands = [this](QLatin1String separator) -> QString {
+        QStringList operands;
+        for (const auto &operand : mOperands) {
+            operands.append(operand.toString());
+        }
+        return QLatin1Char('(') + operands.join(separator) + QLatin1Char(')');
+    };
+
+    switch (mType) {
+    case Type::EMPTY:
+        return QLatin1String("<match all>");
+    case Type::MATCH:
+        return mField + QLatin1Char('=') + mValue;
+    case Type::ALL_OF:
+        return joinOperands(QLatin1String(" AND "));
+    case Type::ANY_OF:
+        return joinOperands(QLatin1String(" OR "));
+    case Type::NONE_OF:
+        return QLatin1String("NOT ") + joinOperands(QLatin1String(" OR "));
+    case Type::CONTAINS:
+        return mField + QLatin1String(" CONTAINS \"") + mValue + QLatin1Char('"');
+    case Type::RANGE:
+        return mField + QLatin1String(" IN [") + QString::number(mMinimum) + QLatin1Char(',') + QString::number(mMaximum) + QLatin1Char(']');
+    case Type::REGULAR_EXPRESSION:
+        return mField + QLatin1String(" MATCHES \"") + mValue + QLatin1Char('"');
+    }
+    return QString();
+}
+
+FilterExpression::NormalizedForm FilterExpression::normalize() const
+{
+    NormalizedForm form;
+    collectConjuncts(indexablePart(), form);
+    if (!form.mSatisfiable) {
+        form.mConjunction.clear();
+    }
+    return form;
+}
+
+std::optional<QStringList> FilterExpression::requiredValues(const QString &field) const
+{
+    const NormalizedForm form = normalize();
+    if (!form.mSatisfiable) {
+        return QStringList();
+    }
+
+    // every conjunct whose terms all match the field bounds its values, all these bounds are intersected
+    std::optional<QStringList> values;
+    for (const auto &disjunction : form.mConjunction) {
+        QStringList conjunctValues;
+        const bool constrained = std::all_of(disjunction.cbegin(), disjunction.cend(), [&field, &conjunctValues](const Term &term) {
+            const auto it = term.mMatches.constFind(field);
+            if (it == term.mMatches.cend()) {
+                return false;
+            }
+            conjunctValues.append(it.value());
+            return true;
+        });
+        if (!constrained || disjunction.isEmpty()) {
+            continue;
+        }
+        conjunctValues = sortedUnique(conjunctValues);
+        if (!values) {
+            values = conjunctValues;
+            continue;
+        }
+        QStringList intersection;
+        std::set_intersection(values->cbegin(), values->cend(), conjunctValues.cbegin(), conjunctValues.cend(), std::back_inserter(intersection));
+        values = intersection;
+    }
+    return values;
+}
+
+std::optional<std::pair<qint64, qint64>> FilterExpression::requiredRange(const QString &field) const
+{
+    if (mType == Type::RANGE && mField == field) {
+        return std::make_pair(mMinimum, mMaximum);
+    }
+    if (mType != Type::ALL_OF) {
+        return std::nullopt;
+    }
+    std::optional<std::pair<qint64, qint64>> range;
+    for (const auto &operand : mOperands) {
+        const auto operandRange = operand.requiredRange(field);
+        if (!operandRange) {
+            continue;
+        }
+        if (!range) {
+            range = operandRange;
+        } else {
+            range->first = std::max(range->first, operandRange->first);
+            range->second = std::min(range->second, operandRange->second);
+        }
+    }
+    return range;
+}
+
+bool FilterExpression::apply(sd_journal *journal) const
+{
+    const NormalizedForm form = normalize();
+    qCDebug(KJOURNALDLIB_FILTERTRACE).noquote() << "explain filter:" << explain();
+
+    if (!form.mSatisfiable) {
+        return addMatch(journal, sUnsatisfiableMatch);
+    }
+
+    bool success{true};
+    for (const auto &disjunction : form.mConjunction) {
+        for (const Term &term : disjunction) {
+            for (auto it = term.mMatches.cbegin(); it != term.mMatches.cend(); ++it) {
+                for (const QString &value : it.value()) {
+                    success &= addMatch(journal, it.key() + QLatin1Char('=') + value);
+                }
+            }
+            const int result = sd_journal_add_disjunction(journal);
+            qCDebug(KJOURNALDLIB_FILTERTRACE).nospace() << "add_disjunction()";
+            Q_ASSERT(result >= 0);
+        }
+        const int result = sd_journal_add_conjunction(journal);
+        qCDebug(KJOURNALDLIB_FILTERTRACE).nospace() << "add_conjunction()";
+        Q_ASSERT(result >= 0);
+    }
+    return success;
+}
+
+QString FilterExpression::explain() const
+{
+    const FilterExpression residual = residualPart();
+    if (residual.isEmpty()) {
+        return explain(normalize());
+    }
+    return explain(normalize()) + QLatin1String(" RESIDUAL ") + residual.toString();
+}
+
+QString FilterExpression::explain(const NormalizedForm &form)
+{
+    if (!form.mSatisfiable) {
+        return QLatin1String("<match none>");
+    }
+    if (form.mConjunction.isEmpty()) {
+        return QLatin1String("<match all>");
+    }
+    QStringList conjuncts;
+    for (const auto &disjunction : form.mConjunction) {
+        QStringList terms;
+        for (const Term &term : disjunction) {
+            if (disjunction.size() > 1 && term.mMatches.size() > 1) {
+                terms.append(QLatin1Char('(') + explainTerm(term) + QLatin1Char(')'));
+            } else {
+                terms.append(explainTerm(term));
+            }
+        }
+        conjuncts.append(QLatin1Char('(') + terms.join(QLatin1String(" OR ")) + QLatin1Char(')'));
+    }
+    return conjuncts.join(QLatin1String(" AND "));
+}
+
+bool FilterExpression::operator==(const FilterExpression &other) const
+{
+    return mType == other.mType && mField == other.mField && mValue == other.mValue && mMinimum == other.mMinimum && mMaximum == other.mMaximum
+        && mOperands == other.mOperands;
+}
+
+bool FilterExpression::operator!=(const FilterExpression &other) const
+{
+    return !(*this == other);
+}
@@ -0,0 +1,255 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef FILTEREXPRESSION_H
+#define FILTEREXPRESSION_H
+
+#include "kjournald_export.h"
+#include <QDateTime>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+class sd_journal;
+
+/**
+ * @brief Boolean filter expression over journal fields
+ *
+ * A filter expression is a tree of AND/OR operations over field matches like "_PID=1" or
+ * "SYSLOG_IDENTIFIER=sddm". Before being applied to a journal, the expression is normalized
+ * into the four level form that is supported by journald's indexed matching, see
+ * https://www.freedesktop.org/software/systemd/man/sd_journal_add_match.html
+ * 1. level: AND over the result of level 2, created via add_conjunction
+ * 2. level: OR over terms, created via add_disjunction
+ * 3. level: AND over matches of different fields within one term
+ * 4. level: OR over matches of the same field within one term
+ *
+ * An empty expression does not add any constraint. When used as operand of @a allOf() or
+ * @a anyOf(), it is ignored, which is the same behavior as journald shows for empty terms.
+ *
+ * Negation, substring, numeric range and regular expression predicates cannot be expressed by
+ * journald matches. Such parts of the top-level conjunction are kept as residual expression that
+ * has to be evaluated on the read entries, see @a ResidualFilter.
+ */
+class KJOURNALD_EXPORT FilterExpression
+{
+public:
+    enum class Type {
+        EMPTY, //!< expression without any constraint
+        MATCH, //!< field must have exact value
+        ALL_OF, //!< AND combination of all operands
+        ANY_OF, //!< OR combination of all operands
+        NONE_OF, //!< negated OR combination of all operands, not indexable
+        CONTAINS, //!< field value must contain substring, not indexable
+        RANGE, //!< field value must be an integer within inclusive bounds, not indexable
+        REGULAR_EXPRESSION, //!< field value must match regular expression, not indexable
+    };
+
+    /**
+     * @brief Level 3/4 term: AND over the fields, OR over the values of each field
+     */
+    struct Term {
+        QMap<QString, QStringList> mMatches;
+
+        bool operator==(const Term &other) const
+        {
+            return mMatches == other.mMatches;
+        }
+    };
+
+    /**
+     * @brief Expression in the four level form that journald supports
+     *
+     * The outer vector forms the level 1 conjunction, each inner vector a level 2 disjunction.
+     */
+    struct NormalizedForm {
+        QVector<QVector<Term>> mConjunction;
+        bool mSatisfiable{true}; //!< false if normalization proved that no entry can match
+    };
+
+    /**
+     * @brief Create empty expression
+     */
+    FilterExpression() = default;
+
+    /**
+     * @brief Create expression that requires @p field to have value @p value
+     */
+    static FilterExpression match(const QString &field, const QString &value);
+
+    /**
+     * @brief Create expression that requires @p field to have any of the values @p values
+     *
+     * @note if @p values is empty, the created expression is empty
+     */
+    static FilterExpression matchAny(const QString &field, const QStringList &values);
+
+    /**
+     * @brief Create AND combination of all @p operands
+     */
+    static FilterExpression allOf(const std::vector<FilterExpression> &operands);
+
+    /**
+     * @brief Create OR combination of all @p operands
+     */
+    static FilterExpression anyOf(const std::vector<FilterExpression> &operands);
+
+    /**
+     * @brief Create expression that is true if none of the @p operands is true
+     *
+     * Example: noneOf({match("SYSLOG_IDENTIFIER", "NetworkManager")}) for all entries except of NetworkManager
+     */
+    static FilterExpression noneOf(const std::vector<FilterExpression> &operands);
+
+    /**
+     * @brief Create expression that requires value of @p field to contain @p substring
+     */
+    static FilterExpression contains(const QString &field, const QString &substring);
+
+    /**
+     * @brief Create expression that requires value of @p field to be an integer within [@p minimum, @p maximum]
+     */
+    static FilterExpression inRange(const QString &field, qint64 minimum, qint64 maximum = std::numeric_limits<qint64>::max());
+
+    /**
+     * @brief Create expression that requires value of @p field to match the regular expression @p pattern
+     */
+    static FilterExpression matchRegularExpression(const QString &field, const QString &pattern);
+
+    /**
+     * @brief Create expression that requires the entry's realtime timestamp to be within [@p since, @p until]
+     *
+     * The timestamp is addressed by the pseudo field "__REALTIME_TIMESTAMP" in microseconds, like in the
+     * journal export format. An invalid @p since or @p until leaves the respective side open.
+     */
+    static FilterExpression inRealtimeRange(const QDateTime &since, const QDateTime &until);
+
+    /**
+     * @return type of the expression's root node
+     */
+    Type type() const;
+
+    /**
+     * @return true if expression does not add any constraint
+     */
+    bool isEmpty() const;
+
+    /**
+     * @return field name for expressions of type MATCH, otherwise empty string
+     */
+    QString field() const;
+
+    /**
+     * @return field value for MATCH, substring for CONTAINS and pattern for REGULAR_EXPRESSION expressions,
+     *         otherwise empty string
+     */
+    QString value() const;
+
+    /**
+     * @return lower bound of RANGE expressions
+     */
+    qint64 minimum() const;
+
+    /**
+     * @return upper bound of RANGE expressions
+     */
+    qint64 maximum() const;
+
+    /**
+     * @return operands of ALL_OF, ANY_OF and NONE_OF expressions
+     */
+    const std::vector<FilterExpression> &operands() const;
+
+    /**
+     * @return true if the expression can be fully evaluated by journald matches
+     */
+    bool isIndexable() const;
+
+    /**
+     * @brief Part of the expression that can be evaluated by journald
+     *
+     * This are all indexable operands of the top-level conjunction or the whole expression if it is indexable.
+     */
+    FilterExpression indexablePart() const;
+
+    /**
+     * @brief Part of the expression that must be evaluated on the read entries
+     *
+     * The AND combination of @a indexablePart() and @a residualPart() is equivalent to this expression.
+     */
+    FilterExpression residualPart() const;
+
+    /**
+     * @brief Textual representation of the expression tree without any normalization
+     */
+    QString toString() const;
+
+    /**
+     * @brief Compute the four level form of the indexable part of this expression
+     *
+     * AND operations nested inside of OR operations are resolved by distribution. Two matches of the
+     * same field inside one term are intersected, because journald can only express them as OR.
+     */
+    NormalizedForm normalize() const;
+
+    /**
+     * @brief Values that @p field must have for an entry to match the indexable part of this expression
+     *
+     * Journals can use this information to skip data that cannot contain matching entries, e.g. all
+     * files of other machines when the expression requires a specific "_MACHINE_ID".
+     *
+     * @return sorted list of possible values, empty list if no entry can match and std::nullopt
+     *         if the expression does not constrain @p field
+     */
+    std::optional<QStringList> requiredValues(const QString &field) const;
+
+    /**
+     * @brief Inclusive bounds that the integer value of @p field must have for an entry to match this expression
+     *
+     * Only RANGE expressions that are part of the top-level conjunction are considered.
+     *
+     * @return minimum and maximum or std::nullopt if the expression does not constrain @p field
+     */
+    std::optional<std::pair<qint64, qint64>> requiredRange(const QString &field) const;
+
+    /**
+     * @brief Add matches for the indexable part of this expression to @p journal
+     *
+     * Existing matches of the journal are not flushed, such that the caller can decide to combine
+     * expressions. Every operation is traced in the KJOURNALDLIB_FILTERTRACE logging category.
+     *
+     * @return true if all matches could be added
+     */
+    bool apply(sd_journal *journal) const;
+
+    /**
+     * @brief Human readable representation of the normalized expression as passed to journald,
+     * followed by the residual expression if there is any
+     */
+    QString explain() const;
+
+    /**
+     * @copydoc explain()
+     */
+    static QString explain(const NormalizedForm &form);
+
+    bool operator==(const FilterExpression &other) const;
+    bool operator!=(const FilterExpression &other) const;
+
+private:
+    Type mType{Type::EMPTY};
+    QString mField;
+    QString mValue;
+    qint64 mMinimum{std::numeric_limits<qint64>::min()};
+    qint64 mMaximum{std::numeric_limits<qint64>::max()};
+    std::vector<FilterExpression> mOperands;
+};
+
+#endif // FILTEREXPRESSION_H
@@ -0,0 +1,177 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "gatewayjournal.h"
+#include "gatewayjournal_p.h"
+#include "kjournaldlib_log_general.h"
+#include <QNetworkReply>
+#include <QNetworkRequest>
+
+GatewayJournalPrivate::GatewayJournalPrivate(GatewayJournal *q)
+    : q(q)
+{
+}
+
+QByteArray GatewayJournalPrivate::rangeHeader() const
+{
+    // format: entries=[cursor][[:num_skip]:num_entries]
+    if (mRangeCursor.isEmpty() && mRangeSkip == 0 && mRangeCount < 0) {
+        return QByteArray();
+    }
+    QByteArray range = QByteArray("entries=") + mRangeCursor.toUtf8();
+    if (mRangeSkip != 0 || mRangeCount >= 0) {
+        range += ':' + QByteArray::number(mRangeSkip) + ':';
+        if (mRangeCount >= 0) {
+            range += QByteArray::number(mRangeCount);
+        }
+    }
+    return range;
+}
+
+void GatewayJournalPrivate::processReply()
+{
+    // error responses contain a message instead of entries
+    if (!mReply || mReply->error() != QNetworkReply::NoError) {
+        return;
+    }
+    const QByteArray data = mReply->readAll();
+    if (data.isEmpty()) {
+        return;
+    }
+    mBytesReceived += data.size();
+    mReader->addData(data);
+    appendEntries();
+}
+
+void GatewayJournalPrivate::appendEntries()
+{
+    // parsed into a separate store such that the clones can append the same entries
+    const std::shared_ptr<MemoryJournalStore> entries = MemoryJournalPrivate::parse(*mReader);
+    if (q->append(*entries) > 0) {
+        Q_EMIT mFeed.entriesAppended(entries);
+    }
+}
+
+void GatewayJournalPrivate::handleFinished()
+{
+    QNetworkReply *reply = mReply;
+    if (!reply) {
+        return;
+    }
+    if (reply->error() == QNetworkReply::NoError) {
+        processReply();
+        mReader->closeInput();
+        appendEntries();
+        if (mReader->hasError()) {
+            qCWarning(KJOURNALDLIB_GENERAL) << "Gateway response ends with a truncated entry" << reply->url();
+            Q_EMIT q->errorOccurred(QLatin1String("Response ends with a truncated entry"));
+        }
+    } else if (reply->error() != QNetworkReply::OperationCanceledError) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Could not receive entries from gateway" << reply->url() << reply->errorString();
+        Q_EMIT q->errorOccurred(reply->errorString());
+    }
+    mReply = nullptr;
+    mReader.reset();
+    reply->deleteLater();
+    Q_EMIT q->receivingChanged();
+}
+
+GatewayJournal::GatewayJournal(const QUrl &url)
+    : d(new GatewayJournalPrivate(this))
+{
+    d->mUrl = url;
+    if (!(url.scheme() == QLatin1String("http") || url.scheme() == QLatin1String("https"))) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "URL seems not begin a valid URL, no http/https prefix:" << url;
+    }
+}
+
+GatewayJournal::~GatewayJournal()
+{
+    if (d->mReply) {
+        QObject::disconnect(d->mReply, nullptr, this, nullptr);
+        d->mReply->abort();
+    }
+}
+
+QUrl GatewayJournal::url() const
+{
+    return d->mUrl;
+}
+
+void GatewayJournal::setRange(const QString &cursor, qint64 skip, qint64 count)
+{
+    d->mRangeCursor = cursor;
+    d->mRangeSkip = skip;
+    d->mRangeCount = count;
+}
+
+void GatewayJournal::setFollow(bool follow)
+{
+    d->mFollow = follow;
+}
+
+bool GatewayJournal::follow() const
+{
+    return d->mFollow;
+}
+
+std::unique_ptr<IJournal> GatewayJournal::clone() const
+{
+    return d->mFeed.follow(*this);
+}
+
+void GatewayJournal::start()
+{
+    if (d->mReply) {
+        QObject::disconnect(d->mReply, nullptr, this, nullptr);
+        d->mReply->abort();
+        d->mReply->deleteLater();
+    }
+
+    QUrl url = d->mUrl;
+    QString path = url.path();
+    if (!path.endsWith(QLatin1Char('/'))) {
+        path += QLatin1Char('/');
+    }
+    url.setPath(path + QLatin1String("entries"));
+    if (d->mFollow) {
+        url.setQuery(QLatin1String("follow"));
+    }
+    QNetworkRequest request(url);
+    request.setRawHeader("Accept", "application/vnd.fdo.journal");
+    const QByteArray range = d->rangeHeader();
+    if (!range.isEmpty()) {
+        request.setRawHeader("Range", range);
+    }
+    qCDebug(KJOURNALDLIB_GENERAL) << "Requesting entries from gateway" << url << range;
+
+    d->mReader = std::make_unique<JournaldExportReader>();
+    d->mReply = d->mNetworkManager.get(request);
+    connect(d->mReply, &QNetworkReply::readyRead, this, [this]() {
+        d->processReply();
+    });
+    connect(d->mReply, &QNetworkReply::finished, this, [this]() {
+        d->handleFinished();
+    });
+    Q_EMIT receivingChanged();
+}
+
+void GatewayJournal::stop()
+{
+    if (d->mReply) {
+        // finished() is emitted synchronously, which resets the request
+        d->mReply->abort();
+    }
+}
+
+bool GatewayJournal::isReceiving() const
+{
+    return d->mReply != nullptr;
+}
+
+qint64 GatewayJournal::bytesReceived() const
+{
+    return d->mBytesReceived;
+}
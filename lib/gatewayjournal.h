@@ -0,0 +1,117 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef GATEWAYJOURNAL_H
+#define GATEWAYJOURNAL_H
+
+#include "kjournald_export.h"
+#include "memoryjournal.h"
+#include <QString>
+#include <QUrl>
+#include <memory>
+
+class GatewayJournalPrivate;
+
+/**
+ * @brief Journal that receives the entries of a systemd-journal-gatewayd instance via HTTP
+ *
+ * Other than SystemdJournalRemote with the "--url" option, which stores the complete remote journal in a
+ * journal file before it can be read, the export format response of the gateway's "/entries" endpoint is
+ * parsed while it is received and the entries are appended to the journal right away, see MemoryJournal.
+ * Thus view models show the first entries as soon as they arrive and, in follow mode, new remote entries
+ * like for a local journal.
+ *
+ * To keep the transferred data small, only a window of the remote journal can be requested, see setRange().
+ *
+ * Gateway documentation: <https://www.freedesktop.org/software/systemd/man/systemd-journal-gatewayd.service.html>
+ */
+class KJOURNALD_EXPORT GatewayJournal : public MemoryJournal
+{
+    Q_OBJECT
+    Q_PROPERTY(bool receiving READ isReceiving NOTIFY receivingChanged)
+public:
+    /**
+     * @brief Construct journal for the gateway at @p url, e.g. "http://localhost:19531"
+     *
+     * Entries are not requested before start() is called.
+     */
+    explicit GatewayJournal(const QUrl &url);
+
+    /**
+     * @brief Destroys the journal and aborts a running request
+     */
+    ~GatewayJournal() override;
+
+    /**
+     * @return URL of the gateway
+     */
+    QUrl url() const;
+
+    /**
+     * @brief Request only a window of the remote journal
+     *
+     * The window starts @p skip entries after the entry of @p cursor. Without cursor, it starts at the head
+     * for non-negative @p skip, and for negative @p skip that many entries before the tail; e.g. skip -100
+     * and count 100 request the last 100 entries. The value -1 for @p count requests all entries up to the
+     * tail. The window is passed to the gateway as "Range" header and applies to the next start().
+     */
+    void setRange(const QString &cursor, qint64 skip, qint64 count);
+
+    /**
+     * @brief Keep the connection open and receive new remote entries as soon as they are written
+     *
+     * Applies to the next start().
+     */
+    void setFollow(bool follow);
+
+    /**
+     * @return true if follow mode is requested
+     */
+    bool follow() const;
+
+    /**
+     * @copydoc IJournal::clone()
+     *
+     * Other than clones of a MemoryJournal, the clone also receives the entries that arrive later, such
+     * that view models of the clone follow the remote journal.
+     */
+    std::unique_ptr<IJournal> clone() const override;
+
+    /**
+     * @brief Request the entries of the configured range from the gateway
+     *
+     * A running request is aborted. Received entries are appended to the entries of previous requests,
+     * such that an interrupted connection can be resumed by requesting the entries after the last cursor.
+     */
+    void start();
+
+    /**
+     * @brief Abort the running request, the received entries stay available
+     */
+    void stop();
+
+    /**
+     * @return true while a request is running
+     */
+    bool isReceiving() const;
+
+    /**
+     * @return number of bytes received by all requests
+     */
+    qint64 bytesReceived() const;
+
+Q_SIGNALS:
+    void receivingChanged();
+
+    /**
+     * @brief Emitted if a request failed, entries received before the error stay available
+     */
+    void errorOccurred(const QString &message);
+
+private:
+    std::unique_ptr<GatewayJournalPrivate> d;
+};
+
+#endif // GATEWAYJOURNAL_H
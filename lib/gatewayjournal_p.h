@@ -0,0 +1,55 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef GATEWAYJOURNAL_P_H
+#define GATEWAYJOURNAL_P_H
+
+#include "journaldexportreader.h"
+#include "memoryjournal_p.h"
+#include <QNetworkAccessManager>
+#include <QPointer>
+#include <QString>
+#include <QUrl>
+#include <memory>
+
+class GatewayJournal;
+class QNetworkReply;
+
+class GatewayJournalPrivate
+{
+public:
+    explicit GatewayJournalPrivate(GatewayJournal *q);
+
+    /**
+     * @return value of the "Range" header for the configured window, empty if all entries are requested
+     */
+    QByteArray rangeHeader() const;
+
+    /**
+     * pass the available data of the reply to the reader and append the complete entries
+     */
+    void processReply();
+
+    /**
+     * append the complete entries of the reader to the journal and pass them to its clones
+     */
+    void appendEntries();
+
+    void handleFinished();
+
+    GatewayJournal *q{nullptr};
+    QUrl mUrl;
+    QString mRangeCursor;
+    qint64 mRangeSkip{0};
+    qint64 mRangeCount{-1};
+    bool mFollow{false};
+    qint64 mBytesReceived{0};
+    QNetworkAccessManager mNetworkManager;
+    QPointer<QNetworkReply> mReply;
+    std::unique_ptr<JournaldExportReader> mReader; //!< incremental reader for the running request
+    MemoryJournalFeed mFeed; //!< clones receive the new entries from this feed
+};
+
+#endif // GATEWAYJOURNAL_P_H
@@ -0,0 +1,177 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "ijournal.h"
+#include "kjournaldlib_log_filtertrace.h"
+#include "kjournaldlib_log_general.h"
+#include <QVarLengthArray>
+#include <cerrno>
+#include <cstring>
+#include <systemd/sd-journal.h>
+
+bool IJournal::setFilter(const FilterExpression &expression)
+{
+    sd_journal *journal = sdJournal();
+    if (!journal) {
+        return false;
+    }
+    sd_journal_flush_matches(journal);
+    qCDebug(KJOURNALDLIB_FILTERTRACE) << "flush_matches()";
+    return expression.apply(journal);
+}
+
+bool IJournal::seekHead()
+{
+    const int result = sdJournal() ? sd_journal_seek_head(sdJournal()) : -EINVAL;
+    if (result < 0) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Failed to seek head:" << strerror(-result);
+    }
+    return result >= 0;
+}
+
+bool IJournal::seekTail()
+{
+    const int result = sdJournal() ? sd_journal_seek_tail(sdJournal()) : -EINVAL;
+    if (result < 0) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Failed to seek tail:" << strerror(-result);
+    }
+    return result >= 0;
+}
+
+bool IJournal::seekCursor(const QString &cursor)
+{
+    const int result = sdJournal() ? sd_journal_seek_cursor(sdJournal(), cursor.toLocal8Bit().constData()) : -EINVAL;
+    if (result < 0) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Failed to seek cursor:" << strerror(-result);
+    }
+    return result >= 0;
+}
+
+bool IJournal::seekRealtime(quint64 usec)
+{
+    const int result = sdJournal() ? sd_journal_seek_realtime_usec(sdJournal(), usec) : -EINVAL;
+    if (result < 0) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Failed to seek realtime:" << strerror(-result);
+    }
+    return result >= 0;
+}
+
+int IJournal::next(int count)
+{
+    if (!sdJournal() || count <= 0) {
+        return 0;
+    }
+    return count == 1 ? sd_journal_next(sdJournal()) : sd_journal_next_skip(sdJournal(), count);
+}
+
+int IJournal::previous(int count)
+{
+    if (!sdJournal() || count <= 0) {
+        return 0;
+    }
+    return count == 1 ? sd_journal_previous(sdJournal()) : sd_journal_previous_skip(sdJournal(), count);
+}
+
+QString IJournal::cursor() const
+{
+    char *data{nullptr};
+    if (!sdJournal() || sd_journal_get_cursor(sdJournal(), &data) < 0) {
+        return QString();
+    }
+    const QString cursor = QString::fromUtf8(data);
+    free(data);
+    return cursor;
+}
+
+bool IJournal::testCursor(const QString &cursor) const
+{
+    return sdJournal() && sd_journal_test_cursor(sdJournal(), cursor.toLocal8Bit().constData()) > 0;
+}
+
+quint64 IJournal::realtimeUsec() const
+{
+    uint64_t usec{0};
+    if (!sdJournal() || sd_journal_get_realtime_usec(sdJournal(), &usec) < 0) {
+        return 0;
+    }
+    return usec;
+}
+
+quint64 IJournal::monotonicUsec() const
+{
+    uint64_t usec{0};
+    sd_id128_t bootId;
+    if (!sdJournal() || sd_journal_get_monotonic_usec(sdJournal(), &usec, &bootId) < 0) {
+        return 0;
+    }
+    return usec;
+}
+
+std::optional<QByteArrayView> IJournal::fieldValue(QByteArrayView name) const
+{
+    if (!sdJournal()) {
+        return std::nullopt;
+    }
+    // sd_journal_get_data() requires a null-terminated field name
+    QVarLengthArray<char, 64> field(name.size() + 1);
+    std::memcpy(field.data(), name.data(), name.size());
+    field[name.size()] = '\0';
+    const char *data{nullptr};
+    size_t length{0};
+    if (sd_journal_get_data(sdJournal(), field.constData(), (const void **)&data, &length) < 0) {
+        return std::nullopt;
+    }
+    // skip "FIELD=" prefix
+    return QByteArrayView(data, length).sliced(name.size() + 1);
+}
+
+bool IJournal::forEachField(const std::function<void(QByteArrayView name, QByteArrayView value)> &callback) const
+{
+    sd_journal *journal = sdJournal();
+    if (!journal) {
+        return false;
+    }
+    // large fields are truncated to the data threshold, which is restored for the other readers of the journal
+    size_t threshold{0};
+    sd_journal_get_data_threshold(journal, &threshold);
+    sd_journal_set_data_threshold(journal, 0);
+    const void *data{nullptr};
+    size_t length{0};
+    int result{0};
+    sd_journal_restart_data(journal);
+    while ((result = sd_journal_enumerate_data(journal, &data, &length)) > 0) {
+        const QByteArrayView field(static_cast<const char *>(data), length);
+        const qsizetype separator = field.indexOf('=');
+        if (separator > 0) {
+            callback(field.first(separator), field.sliced(separator + 1));
+        }
+    }
+    sd_journal_set_data_threshold(journal, threshold);
+    if (result < 0) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Failed to read fields of entry:" << strerror(-result);
+    }
+    return result == 0;
+}
+
+QVector<QString> IJournal::queryUnique(const QString &field) const
+{
+    QVector<QString> values;
+    if (!sdJournal()) {
+        return values;
+    }
+    const int result = sd_journal_query_unique(sdJournal(), qUtf8Printable(field));
+    if (result < 0) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Failed to query journal:" << strerror(-result);
+        return values;
+    }
+    const void *data;
+    size_t length;
+    const int prefixLength = field.toUtf8().size() + 1;
+    SD_JOURNAL_FOREACH_UNIQUE(sdJournal(), data, length)
+    {
+        values << QString::fromUtf8(static_cast<const char *>(data) + prefixLength, length - prefixLength);
+    }
+    return values;
+}
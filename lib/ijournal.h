@@ -6,19 +6,45 @@
 #ifndef IJOURNAL_H
 #define IJOURNAL_H
 
+#include "filterexpression.h"
+#include "journalfileheader.h"
 #include "kjournald_export.h"
+#include <QByteArrayView>
 #include <QObject>
 #include <QString>
+#include <QVector>
+#include <functional>
+#include <memory>
+#include <optional>
 
 class sd_journal;
 
 /**
  * @brief Interface class for all journal types
+ *
+ * Besides access to the underlying sd_journal object, the interface provides backend neutral reading of
+ * entries: filtering, seeking to head, tail, cursor or realtime timestamp, stepping by one or several
+ * entries, access to single or all fields of the current entry and unique value queries. Changes of the journal are
+ * announced by journalUpdated(). Models only use this interface, such that backends without sd_journal
+ * object, e.g. MemoryJournal, can be used like journal files.
+ *
+ * The default implementations of the reading methods operate on sdJournal() with the semantics of the
+ * respective sd_journal functions, which other backends must follow. Like an sd_journal object, one journal
+ * object shall only be used by one query, see clone().
  */
 class KJOURNALD_EXPORT IJournal : public QObject
 {
     Q_OBJECT
 public:
+    /**
+     * @brief Kind of change that was detected for the journal files
+     */
+    enum class ChangeType {
+        APPEND, //!< new entries were appended to existing journal files
+        INVALIDATE, //!< journal files were added or removed, e.g. by rotation or vacuuming
+    };
+    Q_ENUM(ChangeType)
+
     /**
      * @brief Construct journal object for system journald DB
      */
@@ -49,12 +75,152 @@ public:
      */
     virtual QString currentBootId() const = 0;
 
+    /**
+     * @brief Announce the filter of the next query before its matches are added to the journal
+     *
+     * Journals that consist of many files can use this to only open the files that may contain matching
+     * entries. Hence, the pointer returned by @a sdJournal() may change with this call and must be
+     * obtained again afterwards. The default implementation does nothing.
+     *
+     * @param expression the complete filter expression of the query
+     */
+    virtual void prepareQuery(const FilterExpression &expression)
+    {
+        Q_UNUSED(expression)
+    }
+
+    /**
+     * @brief Headers of the journal files that back the journal after the last @a prepareQuery() call
+     *
+     * The files are used for IO hints like prefetching. The default implementation returns an empty
+     * list, which is also used when the files are not known.
+     */
+    virtual QVector<JournalFileHeader> queryFiles() const
+    {
+        return {};
+    }
+
+    /**
+     * @brief Open an independent journal object for the same journal files
+     *
+     * Since one sd_journal object shall only be used by one query, this allows to run additional queries,
+     * e.g. in worker threads. The default implementation returns nullptr, which means that the journal
+     * cannot be opened a second time.
+     */
+    virtual std::unique_ptr<IJournal> clone() const
+    {
+        return nullptr;
+    }
+
+    /**
+     * @brief Stop watching the journal for changes, afterwards journalUpdated() is not emitted anymore
+     *
+     * Changes are detected by event processing in the thread of the object, which would access the journal
+     * concurrently to a worker thread that reads it. Thus, clones that are passed to worker threads without
+     * moving them, e.g. to a thread pool, must stop watching before. Must be called from the thread of the
+     * object. The default implementation does nothing.
+     */
+    virtual void stopWatching()
+    {
+    }
+
+    /**
+     * @brief Restrict the entries that are read to those that match @p expression, replacing any previous filter
+     *
+     * Only the indexable part of the expression is evaluated, see FilterExpression::apply(), and the residual
+     * part must be checked for the read entries. The position after this call is undefined until seeking.
+     * @return true if the filter could be set
+     */
+    virtual bool setFilter(const FilterExpression &expression);
+
+    /**
+     * @brief Position before the first entry, such that next() makes it current
+     */
+    virtual bool seekHead();
+
+    /**
+     * @brief Position after the last entry, such that previous() makes it current
+     */
+    virtual bool seekTail();
+
+    /**
+     * @brief Position at the entry of @p cursor, such that next() and previous() make it current
+     *
+     * If the entry does not exist or does not match the filter, the position is between the closest entries.
+     * @return false if the cursor could not be located
+     */
+    virtual bool seekCursor(const QString &cursor);
+
+    /**
+     * @brief Position at realtime timestamp @p usec, next() makes the first entry with equal or later
+     * timestamp current and previous() the last entry with earlier or equal timestamp
+     */
+    virtual bool seekRealtime(quint64 usec);
+
+    /**
+     * @brief Make the entry @p count entries after the current position current
+     * @return number of entries the position moved, which is smaller than @p count at the tail, or a negative
+     * errno style value on error
+     */
+    virtual int next(int count = 1);
+
+    /**
+     * @brief Make the entry @p count entries before the current position current
+     * @return number of entries the position moved, which is smaller than @p count at the head, or a negative
+     * errno style value on error
+     */
+    virtual int previous(int count = 1);
+
+    /**
+     * @return cursor of the current entry, empty string if there is none
+     */
+    virtual QString cursor() const;
+
+    /**
+     * @return true if the current entry has @p cursor
+     */
+    virtual bool testCursor(const QString &cursor) const;
+
+    /**
+     * @return realtime timestamp of the current entry in microseconds
+     */
+    virtual quint64 realtimeUsec() const;
+
+    /**
+     * @return monotonic timestamp of the current entry in microseconds
+     */
+    virtual quint64 monotonicUsec() const;
+
+    /**
+     * @brief Raw value of data field @p name of the current entry, without "FIELD=" prefix
+     * @return value or std::nullopt if the entry does not have the field, the value is only valid until
+     * the next call of a method of this journal
+     */
+    virtual std::optional<QByteArrayView> fieldValue(QByteArrayView name) const;
+
+    /**
+     * @brief Call @p callback with name and raw value of every data field of the current entry, in the order
+     * of the entry
+     *
+     * Fields that occur several times in the entry are passed for every occurrence. Values are passed without
+     * "FIELD=" prefix and are not truncated, they are only valid during the call of @p callback.
+     * @return false if there is no current entry or the fields could not be read
+     */
+    virtual bool forEachField(const std::function<void(QByteArrayView name, QByteArrayView value)> &callback) const;
+
+    /**
+     * @return all distinct values of field @p field, independent of the filter
+     */
+    virtual QVector<QString> queryUnique(const QString &field) const;
+
 Q_SIGNALS:
     /**
-     * @brief signal is fired when new entries are added to the journal
-     * @param bootId the ID for the boot to which entries are added
+     * @brief signal is fired when new entries are added to the journal or its files changed
+     * @param bootId the ID of the running system's boot for local journals, otherwise empty; entries of other
+     * boots may be added as well, e.g. to journals that are opened by path
+     * @param type the kind of change as reported by sd_journal_process()
      */
-    void journalUpdated(const QString &bootId);
+    void journalUpdated(const QString &bootId, IJournal::ChangeType type);
 };
 
 #endif // IJOURNAL_H
@@ -0,0 +1,567 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "ingestserver.h"
+#include "ingestserver_p.h"
+#include "kjournaldlib_log_general.h"
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace
+{
+const QByteArrayView sHttpMethod{"POST "};
+const QByteArrayView sUploadPath{"/upload"};
+const QByteArrayView sLineEnd{"\r\n"};
+const QByteArrayView sHeaderEnd{"\r\n\r\n"};
+const QByteArrayView sExportContentType{"application/vnd.fdo.journal"};
+}
+
+IngestServerPrivate::IngestServerPrivate(IngestServer *q)
+    : q(q)
+{
+    mRateTimer.setInterval(1000);
+}
+
+void IngestServerPrivate::handleNewConnection()
+{
+    while (QTcpSocket *socket = mServer.nextPendingConnection()) {
+        auto connection = std::make_unique<IngestConnection>();
+        IngestConnection *rawConnection = connection.get();
+        connection->mSocket = socket;
+        connection->mAddress = socket->peerAddress().toString();
+        // a full read buffer stops reading from the socket, which slows down the sender while the pool is busy
+        socket->setReadBufferSize(sMaxPendingBytes);
+        QObject::connect(socket, &QTcpSocket::readyRead, q, [this, rawConnection]() {
+            readInput(rawConnection);
+        });
+        QObject::connect(socket, &QTcpSocket::disconnected, q, [this, rawConnection]() {
+            handleDisconnected(rawConnection);
+        });
+        QObject::connect(&connection->mWatcher, &QFutureWatcher<std::shared_ptr<MemoryJournalStore>>::finished, q, [this, rawConnection]() {
+            handleParsed(rawConnection);
+        });
+        mConnections.push_back(std::move(connection));
+        qCDebug(KJOURNALDLIB_GENERAL) << "Accepted ingest connection from" << rawConnection->mAddress;
+        readInput(rawConnection);
+    }
+}
+
+void IngestServerPrivate::readInput(IngestConnection *connection)
+{
+    // after a rejected request, the remaining input is discarded
+    if (!connection->mSocket || connection->mClosed || connection->mSocket->state() != QAbstractSocket::ConnectedState) {
+        return;
+    }
+    qsizetype pendingBytes{0};
+    for (const IngestConnection::Segment &segment : connection->mSegments) {
+        pendingBytes += segment.mData.size();
+    }
+    if (pendingBytes >= sMaxPendingBytes || connection->mSocket->bytesAvailable() == 0) {
+        return;
+    }
+    const QByteArray data = connection->mSocket->readAll();
+    if (connection->mSource) {
+        connection->mSource->mStatistics.mBytes += data.size();
+    } else {
+        connection->mUnassignedBytes += data.size();
+    }
+    connection->mInput.append(data);
+    if (!decode(connection)) {
+        connection->mInput.clear();
+        return;
+    }
+    scheduleParsing(connection);
+}
+
+bool IngestServerPrivate::decode(IngestConnection *connection)
+{
+    using State = IngestConnection::State;
+    qsizetype position{0};
+    bool waiting{false};
+    while (!waiting && position < connection->mInput.size()) {
+        const QByteArrayView input = QByteArrayView(connection->mInput).sliced(position);
+        switch (connection->mState) {
+        case State::DETECT:
+            if (input.size() < sHttpMethod.size() && sHttpMethod.startsWith(input)) {
+                waiting = true;
+                break;
+            }
+            if (input.startsWith(sHttpMethod)) {
+                connection->mState = State::HEADERS;
+            } else {
+                qCDebug(KJOURNALDLIB_GENERAL) << "Receiving raw export stream from" << connection->mAddress;
+                connection->mState = State::RAW;
+                connection->mReader = std::make_shared<JournaldExportReader>();
+            }
+            break;
+        case State::HEADERS: {
+            const qsizetype end = input.indexOf(sHeaderEnd);
+            if (end < 0) {
+                if (input.size() > sMaxHeaderBytes) {
+                    respond(connection, "431 Request Header Fields Too Large", true);
+                    return false;
+                }
+                waiting = true;
+                break;
+            }
+            if (!processHeader(connection, input.first(end))) {
+                return false;
+            }
+            position += end + sHeaderEnd.size();
+            break;
+        }
+        case State::BODY:
+        case State::CHUNK_DATA: {
+            const qsizetype size = static_cast<qsizetype>(std::min<qint64>(input.size(), connection->mRemaining));
+            addData(connection, input.first(size));
+            position += size;
+            connection->mRemaining -= size;
+            if (connection->mRemaining == 0) {
+                if (connection->mState == State::BODY) {
+                    finishRequest(connection);
+                } else {
+                    connection->mState = State::CHUNK_END;
+                }
+            }
+            break;
+        }
+        case State::CHUNK_SIZE: {
+            const qsizetype end = input.indexOf(sLineEnd);
+            if (end < 0) {
+                waiting = input.size() <= sMaxHeaderBytes;
+                if (!waiting) {
+                    respond(connection, "400 Bad Request", true);
+                    return false;
+                }
+                break;
+            }
+            // chunk extensions after ';' are ignored
+            QByteArrayView line = input.first(end);
+            const qsizetype extension = line.indexOf(';');
+            if (extension >= 0) {
+                line = line.first(extension);
+            }
+            bool ok{false};
+            const qint64 size = line.trimmed().toLongLong(&ok, 16);
+            if (!ok || size < 0) {
+                respond(connection, "400 Bad Request", true);
+                return false;
+            }
+            position += end + sLineEnd.size();
+            connection->mRemaining = size;
+            connection->mState = size == 0 ? State::TRAILER : State::CHUNK_DATA;
+            break;
+        }
+        case State::CHUNK_END:
+            if (input.size() < sLineEnd.size()) {
+                waiting = true;
+                break;
+            }
+            if (!input.startsWith(sLineEnd)) {
+                respond(connection, "400 Bad Request", true);
+                return false;
+            }
+            position += sLineEnd.size();
+            connection->mState = State::CHUNK_SIZE;
+            break;
+        case State::TRAILER: {
+            const qsizetype end = input.indexOf(sLineEnd);
+            if (end < 0) {
+                waiting = true;
+                break;
+            }
+            position += end + sLineEnd.size();
+            if (end == 0) {
+                finishRequest(connection);
+            }
+            break;
+        }
+        case State::RAW:
+            addData(connection, input);
+            position += input.size();
+            break;
+        }
+    }
+    connection->mInput.remove(0, position);
+    return true;
+}
+
+bool IngestServerPrivate::processHeader(IngestConnection *connection, QByteArrayView header)
+{
+    const QList<QByteArray> lines = header.toByteArray().split('\n');
+    const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    const QByteArray path = requestLine.size() >= 2 ? requestLine.at(1).split('?').first() : QByteArray();
+    if (path != sUploadPath) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Rejecting ingest request for unknown path" << path << "from" << connection->mAddress;
+        respond(connection, "404 Not Found", true);
+        return false;
+    }
+
+    qint64 contentLength{-1};
+    bool chunked{false};
+    bool expectContinue{false};
+    QByteArray contentType;
+    for (qsizetype i = 1; i < lines.size(); ++i) {
+        const QByteArray &line = lines.at(i);
+        const qsizetype colon = line.indexOf(':');
+        if (colon < 0) {
+            continue;
+        }
+        const QByteArray name = line.left(colon).trimmed().toLower();
+        const QByteArray value = line.mid(colon + 1).trimmed();
+        if (name == "content-length") {
+            contentLength = value.toLongLong();
+        } else if (name == "transfer-encoding") {
+            chunked = value.toLower().contains("chunked");
+        } else if (name == "expect") {
+            expectContinue = value.toLower() == "100-continue";
+        } else if (name == "content-type") {
+            contentType = value;
+        }
+    }
+    if (!contentType.startsWith(sExportContentType)) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Rejecting ingest request with content type" << contentType << "from" << connection->mAddress;
+        respond(connection, "415 Unsupported Media Type", true);
+        return false;
+    }
+    if (!chunked && contentLength < 0) {
+        respond(connection, "411 Length Required", true);
+        return false;
+    }
+
+    connection->mReader = std::make_shared<JournaldExportReader>();
+    if (expectContinue) {
+        connection->mSocket->write("HTTP/1.1 100 Continue\r\n\r\n");
+    }
+    if (chunked) {
+        connection->mState = IngestConnection::State::CHUNK_SIZE;
+    } else if (contentLength > 0) {
+        connection->mRemaining = contentLength;
+        connection->mState = IngestConnection::State::BODY;
+    } else {
+        finishRequest(connection);
+    }
+    return true;
+}
+
+void IngestServerPrivate::addData(IngestConnection *connection, QByteArrayView data)
+{
+    std::deque<IngestConnection::Segment> &segments = connection->mSegments;
+    if (segments.empty() || segments.back().mReader != connection->mReader || segments.back().mFinal) {
+        segments.push_back({connection->mReader, QByteArray(), false});
+    }
+    segments.back().mData.append(data.data(), data.size());
+}
+
+void IngestServerPrivate::finishData(IngestConnection *connection)
+{
+    if (!connection->mReader) {
+        return;
+    }
+    addData(connection, QByteArrayView());
+    connection->mSegments.back().mFinal = true;
+    connection->mReader.reset();
+}
+
+void IngestServerPrivate::finishRequest(IngestConnection *connection)
+{
+    finishData(connection);
+    respond(connection, "202 Accepted", false);
+    // further requests may follow on the same connection
+    connection->mState = IngestConnection::State::HEADERS;
+}
+
+void IngestServerPrivate::respond(IngestConnection *connection, QByteArrayView status, bool close)
+{
+    if (!connection->mSocket) {
+        return;
+    }
+    const QByteArray body = status.toByteArray() + '\n';
+    QByteArray response = QByteArray("HTTP/1.1 ") + status.toByteArray() + "\r\nContent-Type: text/plain\r\nContent-Length: " + QByteArray::number(body.size())
+        + "\r\n";
+    if (close) {
+        response += "Connection: close\r\n";
+    }
+    connection->mSocket->write(response + "\r\n" + body);
+    if (close) {
+        connection->mReader.reset();
+        connection->mSocket->disconnectFromHost();
+    }
+}
+
+void IngestServerPrivate::scheduleParsing(IngestConnection *connection)
+{
+    if (connection->mWatcher.isRunning() || connection->mSegments.empty()) {
+        return;
+    }
+    IngestConnection::Segment segment = std::move(connection->mSegments.front());
+    connection->mSegments.pop_front();
+    connection->mWatcher.setFuture(QtConcurrent::run(&mThreadPool, &IngestServerPrivate::parse, std::move(segment)));
+}
+
+std::shared_ptr<MemoryJournalStore> IngestServerPrivate::parse(IngestConnection::Segment segment)
+{
+    // the segments of one reader are parsed one after another, thus the reader is never used concurrently
+    segment.mReader->addData(segment.mData);
+    if (segment.mFinal) {
+        segment.mReader->closeInput();
+    }
+    return MemoryJournalPrivate::parse(*segment.mReader);
+}
+
+void IngestServerPrivate::handleParsed(IngestConnection *connection)
+{
+    const std::shared_ptr<MemoryJournalStore> entries = connection->mWatcher.result();
+    if (entries && !entries->mRealtime.empty()) {
+        if (!connection->mSource) {
+            assignSource(connection, *entries);
+        }
+        IngestSource *source = connection->mSource;
+        source->mStatistics.mEntries += source->mJournal->append(*entries);
+        // parsed entries are shared by all journals of the source, each appends them in its own thread
+        Q_EMIT source->mFeed.entriesAppended(entries);
+    }
+    scheduleParsing(connection);
+    readInput(connection);
+    removeIfDone(connection);
+}
+
+void IngestServerPrivate::assignSource(IngestConnection *connection, const MemoryJournalStore &entries)
+{
+    auto firstValue = [&entries](const char *field) -> QString {
+        const MemoryJournalStore::Column *column = entries.column(field);
+        const std::optional<QByteArrayView> value = column ? entries.value(*column, 0) : std::nullopt;
+        return value ? QString::fromUtf8(value.value()) : QString();
+    };
+    // hostnames are neither unique nor stable, the machine ID identifies a system also after renaming it
+    QString key = firstValue("_MACHINE_ID");
+    if (key.isEmpty()) {
+        key = connection->mAddress;
+    }
+
+    IngestSource *source = sourceByKey(key);
+    const bool added = source == nullptr;
+    if (added) {
+        QString name = firstValue("_HOSTNAME");
+        if (name.isEmpty()) {
+            name = key;
+        } else if (this->source(name)) {
+            name += QLatin1Char('-') + key;
+        }
+        qCDebug(KJOURNALDLIB_GENERAL) << "New ingest source" << name << "with key" << key << "from" << connection->mAddress;
+        auto newSource = std::make_unique<IngestSource>();
+        newSource->mKey = key;
+        newSource->mName = name;
+        newSource->mJournal = std::make_unique<MemoryJournal>();
+        source = newSource.get();
+        mSources.push_back(std::move(newSource));
+    }
+    source->mStatistics.mAddress = connection->mAddress;
+    source->mStatistics.mBytes += connection->mUnassignedBytes;
+    if (!connection->mClosed) {
+        ++source->mStatistics.mConnections;
+    }
+    connection->mUnassignedBytes = 0;
+    connection->mSource = source;
+    if (added) {
+        Q_EMIT q->sourcesChanged();
+    }
+}
+
+void IngestServerPrivate::handleDisconnected(IngestConnection *connection)
+{
+    if (connection->mClosed) {
+        return;
+    }
+    // data that was held back while the pool was busy is still in the socket's buffer
+    if (connection->mSocket && connection->mSocket->bytesAvailable() > 0) {
+        const QByteArray data = connection->mSocket->readAll();
+        if (connection->mSource) {
+            connection->mSource->mStatistics.mBytes += data.size();
+        } else {
+            connection->mUnassignedBytes += data.size();
+        }
+        connection->mInput.append(data);
+        decode(connection);
+    }
+    connection->mClosed = true;
+    if (connection->mState != IngestConnection::State::RAW && connection->mReader) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Ingest connection from" << connection->mAddress << "closed during upload";
+    }
+    finishData(connection);
+    if (connection->mSource) {
+        --connection->mSource->mStatistics.mConnections;
+    }
+    qCDebug(KJOURNALDLIB_GENERAL) << "Ingest connection from" << connection->mAddress << "closed";
+    scheduleParsing(connection);
+    removeIfDone(connection);
+}
+
+void IngestServerPrivate::removeIfDone(IngestConnection *connection)
+{
+    if (!connection->mClosed || connection->mWatcher.isRunning() || !connection->mSegments.empty()) {
+        return;
+    }
+    const auto it = std::find_if(mConnections.begin(), mConnections.end(), [connection](const std::unique_ptr<IngestConnection> &candidate) {
+        return candidate.get() == connection;
+    });
+    if (it == mConnections.end()) {
+        return;
+    }
+    if (connection->mSocket) {
+        QObject::disconnect(connection->mSocket, nullptr, q, nullptr);
+        connection->mSocket->deleteLater();
+    }
+    // this might be called by a signal of the connection's socket or watcher, thus the connection is deleted later
+    std::shared_ptr<IngestConnection> owner = std::move(*it);
+    mConnections.erase(it);
+    QMetaObject::invokeMethod(
+        q,
+        [owner]() {
+            Q_UNUSED(owner)
+        },
+        Qt::QueuedConnection);
+}
+
+IngestSource *IngestServerPrivate::source(const QString &name) const
+{
+    const auto it = std::find_if(mSources.cbegin(), mSources.cend(), [&name](const std::unique_ptr<IngestSource> &source) {
+        return source->mName == name;
+    });
+    return it != mSources.cend() ? it->get() : nullptr;
+}
+
+IngestSource *IngestServerPrivate::sourceByKey(const QString &key) const
+{
+    const auto it = std::find_if(mSources.cbegin(), mSources.cend(), [&key](const std::unique_ptr<IngestSource> &source) {
+        return source->mKey == key;
+    });
+    return it != mSources.cend() ? it->get() : nullptr;
+}
+
+void IngestServerPrivate::updateRates()
+{
+    const qint64 elapsed = mRateClock.restart();
+    if (elapsed <= 0) {
+        return;
+    }
+    bool changed{false};
+    for (const std::unique_ptr<IngestSource> &source : mSources) {
+        IngestServer::SourceStatistics &statistics = source->mStatistics;
+        const double bytesPerSecond = (statistics.mBytes - source->mRateBytes) * 1000.0 / elapsed;
+        const double entriesPerSecond = (statistics.mEntries - source->mRateEntries) * 1000.0 / elapsed;
+        changed = changed || bytesPerSecond != statistics.mBytesPerSecond || entriesPerSecond != statistics.mEntriesPerSecond;
+        statistics.mBytesPerSecond = bytesPerSecond;
+        statistics.mEntriesPerSecond = entriesPerSecond;
+        source->mRateBytes = statistics.mBytes;
+        source->mRateEntries = statistics.mEntries;
+    }
+    if (changed) {
+        Q_EMIT q->statisticsChanged();
+    }
+}
+
+IngestServer::IngestServer(QObject *parent)
+    : QObject(parent)
+    , d(new IngestServerPrivate(this))
+{
+    connect(&d->mServer, &QTcpServer::newConnection, this, [this]() {
+        d->handleNewConnection();
+    });
+    connect(&d->mRateTimer, &QTimer::timeout, this, [this]() {
+        d->updateRates();
+    });
+}
+
+IngestServer::~IngestServer()
+{
+    d->mServer.close();
+    for (const std::unique_ptr<IngestConnection> &connection : d->mConnections) {
+        if (connection->mSocket) {
+            QObject::disconnect(connection->mSocket, nullptr, this, nullptr);
+        }
+        QObject::disconnect(&connection->mWatcher, nullptr, this, nullptr);
+    }
+    d->mThreadPool.waitForDone();
+}
+
+bool IngestServer::listen(const QHostAddress &address, quint16 port)
+{
+    if (d->mServer.isListening()) {
+        d->mServer.close();
+    }
+    if (!d->mServer.listen(address, port)) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Could not listen for journal uploads at" << address << port << d->mServer.errorString();
+        return false;
+    }
+    qCDebug(KJOURNALDLIB_GENERAL) << "Listening for journal uploads at" << address << d->mServer.serverPort();
+    d->mRateClock.start();
+    d->mRateTimer.start();
+    Q_EMIT listeningChanged();
+    return true;
+}
+
+void IngestServer::close()
+{
+    const bool wasListening = d->mServer.isListening();
+    d->mServer.close();
+    d->mRateTimer.stop();
+    std::vector<IngestConnection *> connections;
+    for (const std::unique_ptr<IngestConnection> &connection : d->mConnections) {
+        connections.push_back(connection.get());
+    }
+    for (IngestConnection *connection : connections) {
+        if (connection->mSocket) {
+            connection->mSocket->abort();
+        }
+        d->handleDisconnected(connection);
+    }
+    if (wasListening) {
+        Q_EMIT listeningChanged();
+    }
+}
+
+bool IngestServer::isListening() const
+{
+    return d->mServer.isListening();
+}
+
+quint16 IngestServer::serverPort() const
+{
+    return d->mServer.serverPort();
+}
+
+QStringList IngestServer::sources() const
+{
+    QStringList names;
+    for (const std::unique_ptr<IngestSource> &source : d->mSources) {
+        names.append(source->mName);
+    }
+    return names;
+}
+
+std::unique_ptr<IJournal> IngestServer::journal(const QString &source) const
+{
+    IngestSource *ingestSource = d->source(source);
+    if (!ingestSource) {
+        return nullptr;
+    }
+    return ingestSource->mFeed.follow(*ingestSource->mJournal);
+}
+
+std::vector<std::unique_ptr<IJournal>> IngestServer::journals() const
+{
+    std::vector<std::unique_ptr<IJournal>> journals;
+    for (const std::unique_ptr<IngestSource> &source : d->mSources) {
+        journals.push_back(journal(source->mName));
+    }
+    return journals;
+}
+
+IngestServer::SourceStatistics IngestServer::statistics(const QString &source) const
+{
+    const IngestSource *ingestSource = d->source(source);
+    return ingestSource ? ingestSource->mStatistics : SourceStatistics();
+}
@@ -0,0 +1,133 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef INGESTSERVER_H
+#define INGESTSERVER_H
+
+#include "kjournald_export.h"
+#include <QHostAddress>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <vector>
+
+class IJournal;
+class IngestServerPrivate;
+
+/**
+ * @brief Receives journal entries that are pushed by many remote systems at the same time
+ *
+ * The server accepts the same connections as "systemd-journal-remote --listen-http" and "--listen-raw":
+ * HTTP uploads of the journal export format to "/upload", as sent by systemd-journal-upload, and plain
+ * export format streams, e.g. "journalctl -o export -f | nc host 19532". Both are distinguished by the first
+ * bytes of a connection.
+ *
+ * Received data is parsed by a pool of worker threads, where the batches of one connection are parsed in
+ * order and the connections are parsed concurrently; the main thread only appends the parsed batches to the
+ * journals. Every source is identified by the "_MACHINE_ID" field of its first entry, or by its peer address if
+ * the entry has no machine ID, such that reconnects of a system continue its source, also when the system was
+ * renamed or connects from another address. Sources are named by the "_HOSTNAME" field of their first entry,
+ * where the key is appended if another system already uses the hostname. The entries of each source are
+ * provided by journals that are updated live, which can be used by JournaldViewModel with all filters or be
+ * merged by MergedJournaldViewModel.
+ */
+class KJOURNALD_EXPORT IngestServer : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool listening READ isListening NOTIFY listeningChanged)
+    Q_PROPERTY(QStringList sources READ sources NOTIFY sourcesChanged)
+public:
+    /**
+     * @brief Counters of one source, rates are updated once per second
+     */
+    struct SourceStatistics {
+        QString mAddress; //!< peer address of the last connection of the source
+        int mConnections{0}; //!< number of open connections
+        qint64 mBytes{0}; //!< number of received bytes, including protocol overhead
+        qint64 mEntries{0}; //!< number of received entries
+        double mBytesPerSecond{0}; //!< received bytes per second during the last second
+        double mEntriesPerSecond{0}; //!< received entries per second during the last second
+    };
+
+    static constexpr quint16 sDefaultPort{19532}; //!< default port of systemd-journal-remote
+
+    /**
+     * @brief Construct server that does not listen yet
+     */
+    explicit IngestServer(QObject *parent = nullptr);
+
+    /**
+     * @brief Destroys the server, closes all connections and waits for running parsers
+     */
+    ~IngestServer() override;
+
+    /**
+     * @brief Listen for connections at @p address and @p port
+     *
+     * Port 0 selects any free port, see serverPort().
+     * @return true if listening succeeded
+     */
+    bool listen(const QHostAddress &address = QHostAddress::Any, quint16 port = sDefaultPort);
+
+    /**
+     * @brief Stop listening and close all connections, the received entries stay available
+     */
+    void close();
+
+    /**
+     * @return true if the server listens for connections
+     */
+    bool isListening() const;
+
+    /**
+     * @return port at which the server listens, 0 if not listening
+     */
+    quint16 serverPort() const;
+
+    /**
+     * @return names of all sources in the order of their first connection
+     */
+    QStringList sources() const;
+
+    /**
+     * @brief Create journal with the entries of @p source
+     *
+     * The journal contains all entries received so far and is updated with the entries received later while the
+     * server exists. It can be moved to another thread. Every call creates an independent journal object.
+     * @return journal of the source or nullptr if there is no such source
+     */
+    std::unique_ptr<IJournal> journal(const QString &source) const;
+
+    /**
+     * @brief Create journals for all sources, e.g. for MergedJournaldViewModel
+     * @return journals in the order of sources()
+     */
+    std::vector<std::unique_ptr<IJournal>> journals() const;
+
+    /**
+     * @return counters of @p source, all zero for unknown sources
+     */
+    SourceStatistics statistics(const QString &source) const;
+
+Q_SIGNALS:
+    void listeningChanged();
+
+    /**
+     * @brief Emitted when a new source sent its first entries
+     */
+    void sourcesChanged();
+
+    /**
+     * @brief Emitted every second while data is received
+     */
+    void statisticsChanged();
+
+private:
+    std::unique_ptr<IngestServerPrivate> d;
+    friend class IngestServerPrivate;
+};
+
+#endif // INGESTSERVER_H
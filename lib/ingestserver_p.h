@@ -0,0 +1,153 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef INGESTSERVER_P_H
+#define INGESTSERVER_P_H
+
+#include "ingestserver.h"
+#include "journaldexportreader.h"
+#include "memoryjournal.h"
+#include "memoryjournal_p.h"
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThreadPool>
+#include <QTimer>
+#include <deque>
+#include <memory>
+#include <vector>
+
+/**
+ * State of one source, i.e. of all connections of one remote system
+ */
+struct IngestSource {
+    QString mKey; //!< "_MACHINE_ID" of the first entry, or peer address if the entry has no machine ID
+    QString mName; //!< "_HOSTNAME" of the first entry, made unique if several systems use the same hostname
+    std::unique_ptr<MemoryJournal> mJournal; //!< all received entries, base for the journals that are handed out
+    MemoryJournalFeed mFeed; //!< handed out journals receive the new entries from this feed
+    IngestServer::SourceStatistics mStatistics;
+    qint64 mRateBytes{0}; //!< byte counter at the last rate update
+    qint64 mRateEntries{0}; //!< entry counter at the last rate update
+};
+
+/**
+ * State of one connection: the HTTP framing is decoded in the main thread, the export data is parsed by the pool
+ */
+struct IngestConnection {
+    enum class State {
+        DETECT, //!< neither HTTP nor raw stream detected yet
+        HEADERS, //!< waiting for complete request header
+        BODY, //!< body with content length
+        CHUNK_SIZE, //!< line with size of next chunk
+        CHUNK_DATA, //!< data of current chunk
+        CHUNK_END, //!< line break after chunk data
+        TRAILER, //!< trailer lines after the last chunk
+        RAW, //!< plain export stream until the connection is closed
+    };
+
+    /**
+     * export data of one upload for one reader, the reader is replaced for every HTTP request
+     */
+    struct Segment {
+        std::shared_ptr<JournaldExportReader> mReader;
+        QByteArray mData;
+        bool mFinal{false}; //!< no more data for this reader
+    };
+
+    QPointer<QTcpSocket> mSocket;
+    QString mAddress;
+    State mState{State::DETECT};
+    QByteArray mInput; //!< received bytes that are not decoded yet
+    qint64 mRemaining{0}; //!< remaining bytes of body or current chunk
+    std::shared_ptr<JournaldExportReader> mReader; //!< reader of current request or raw stream
+    std::deque<Segment> mSegments; //!< decoded export data that waits for parsing
+    QFutureWatcher<std::shared_ptr<MemoryJournalStore>> mWatcher; //!< running parse job, at most one per connection
+    IngestSource *mSource{nullptr}; //!< nullptr until the first entry was parsed
+    qint64 mUnassignedBytes{0}; //!< received bytes before the source is known
+    bool mClosed{false};
+};
+
+class IngestServerPrivate
+{
+public:
+    explicit IngestServerPrivate(IngestServer *q);
+
+    void handleNewConnection();
+
+    /**
+     * read available data of @p connection unless too much data waits for parsing
+     */
+    void readInput(IngestConnection *connection);
+
+    /**
+     * decode the available input of @p connection into export data segments
+     * @return false if the connection was closed due to a protocol error
+     */
+    bool decode(IngestConnection *connection);
+
+    /**
+     * parse request header at begin of input
+     * @return false if the request is rejected
+     */
+    bool processHeader(IngestConnection *connection, QByteArrayView header);
+
+    /**
+     * append @p data to the export data of the current reader
+     */
+    void addData(IngestConnection *connection, QByteArrayView data);
+
+    /**
+     * end export data of current reader and start a new one, e.g. at the end of an HTTP request
+     */
+    void finishData(IngestConnection *connection);
+
+    /**
+     * end the current HTTP request after its body was received
+     */
+    void finishRequest(IngestConnection *connection);
+
+    void respond(IngestConnection *connection, QByteArrayView status, bool close);
+
+    /**
+     * start parsing the next segment of @p connection in the pool, if no job is running
+     */
+    void scheduleParsing(IngestConnection *connection);
+
+    void handleParsed(IngestConnection *connection);
+
+    /**
+     * assign @p connection to the source of its first entry in @p entries, which is created if needed
+     */
+    void assignSource(IngestConnection *connection, const MemoryJournalStore &entries);
+
+    void handleDisconnected(IngestConnection *connection);
+
+    /**
+     * remove closed connection once all its data is parsed
+     */
+    void removeIfDone(IngestConnection *connection);
+
+    IngestSource *source(const QString &name) const;
+    IngestSource *sourceByKey(const QString &key) const;
+
+    void updateRates();
+
+    static std::shared_ptr<MemoryJournalStore> parse(IngestConnection::Segment segment);
+
+    static constexpr qsizetype sMaxPendingBytes{4 * 1024 * 1024}; //!< socket buffer per connection while the pool is busy
+    static constexpr qsizetype sMaxHeaderBytes{64 * 1024};
+
+    IngestServer *q{nullptr};
+    QTcpServer mServer;
+    QThreadPool mThreadPool; //!< dedicated pool such that parsing many streams does not block the global pool
+    std::vector<std::unique_ptr<IngestConnection>> mConnections;
+    std::vector<std::unique_ptr<IngestSource>> mSources;
+    QTimer mRateTimer;
+    QElapsedTimer mRateClock;
+};
+
+#endif // INGESTSERVER_P_H
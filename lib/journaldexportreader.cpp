@@ -4,24 +4,43 @@
 */
 
 #include "journaldexportreader.h"
+#include "journaldexportreader_p.h"
 #include "kjournaldlib_log_general.h"
 #include <QDebug>
-#include <QVector>
+#include <QFileDevice>
 #include <QIODevice>
-#include <climits>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
 
-JournaldExportReader::JournaldExportReader(QIODevice *device)
-    : mDevice(device)
+JournaldExportReaderPrivate::~JournaldExportReaderPrivate()
 {
-    if (!mDevice || !mDevice->open(QIODevice::ReadOnly)) {
-        qCCritical(KJOURNALDLIB_GENERAL) << "Could not open device for reading";
-        return;
-    }
+    // segments in flight refer to the input data
+    discardSegments();
 }
 
-bool JournaldExportReader::atEnd() const
+void JournaldExportReaderPrivate::load(QIODevice *device)
 {
-    return mDevice->atEnd();
+    if (!device || (!device->isOpen() && !device->open(QIODevice::ReadOnly))) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Could not open device for reading";
+        return;
+    }
+    if (device->isSequential()) {
+        mStreamDevice = device;
+        return;
+    }
+    if (auto file = qobject_cast<QFileDevice *>(device); file && file->size() > 0) {
+        if (const uchar *data = file->map(0, file->size())) {
+            mData = reinterpret_cast<const char *>(data);
+            mSize = file->size();
+            return;
+        }
+        qCDebug(KJOURNALDLIB_GENERAL) << "Could not map file, falling back to reading" << file->fileName();
+    }
+    mBuffer = device->readAll();
+    mData = mBuffer.constData();
+    mSize = mBuffer.size();
 }
 
 // Format description: <https://www.freedesktop.org/wiki/Software/systemd/export/>
@@ -46,44 +65,347 @@ bool JournaldExportReader::atEnd() const
 // - The order in which fields appear in an entry is undefined and might be different for each entry
 //   that is serialized.
 
-bool JournaldExportReader::readNext()
+const char *
+JournaldExportReaderPrivate::parseEntry(const char *begin, const char *end, QVector<JournaldExportReader::Field> &fields, bool &error, bool *terminated)
 {
-    if (mDevice->atEnd()) {
-        return false;
+    const char *position = begin;
+    while (position < end && *position == '\n') {
+        ++position;
+    }
+    while (position < end) {
+        const char *lineEnd = static_cast<const char *>(std::memchr(position, '\n', end - position));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        // empty line = end of log entry
+        if (lineEnd == position) {
+            if (terminated) {
+                *terminated = true;
+            }
+            return position + 1;
+        }
+
+        // if line does not contain "=" then it is the name of a binary field
+        const char *separator = static_cast<const char *>(std::memchr(position, '=', lineEnd - position));
+        if (separator) {
+            fields.append({QByteArrayView(position, separator), QByteArrayView(separator + 1, lineEnd)});
+            position = std::min(lineEnd + 1, end);
+            continue;
+        }
+        const QByteArrayView name(position, lineEnd);
+        position = std::min(lineEnd + 1, end);
+        if (end - position < static_cast<qint64>(sizeof(quint64))) {
+            qCWarning(KJOURNALDLIB_GENERAL) << "Binary field is truncated, missing size of field" << name;
+            error = true;
+            return end;
+        }
+        const quint64 size = qFromLittleEndian<quint64>(position);
+        position += sizeof(quint64);
+        if (size > static_cast<quint64>(end - position)) {
+            qCWarning(KJOURNALDLIB_GENERAL) << "Binary field is truncated, expected bytes:" << size << "available:" << end - position;
+            error = true;
+            return end;
+        }
+        fields.append({name, QByteArrayView(position, size)});
+        position += size;
+        // skip line break after binary content, such that position points to next line
+        if (position < end && *position == '\n') {
+            ++position;
+        }
+    }
+    return end;
+}
+
+JournaldExportReaderPrivate::Segment JournaldExportReaderPrivate::parseSegment(const char *begin, const char *proposedEnd, const char *end)
+{
+    Segment segment;
+    segment.mBegin = begin;
+    const char *position = begin;
+    while (position < proposedEnd) {
+        position = skipBlankLines(position, end);
+        if (position >= proposedEnd) {
+            break;
+        }
+        const qsizetype fieldCount = segment.mFields.size();
+        position = parseEntry(position, end, segment.mFields, segment.mError);
+        if (segment.mError) {
+            segment.mFields.resize(fieldCount);
+            break;
+        }
+        segment.mEntryEnds.append(segment.mFields.size());
+        segment.mEntryPositions.append(position);
+    }
+    segment.mEnd = position;
+    return segment;
+}
+
+const char *JournaldExportReaderPrivate::findSplitPoint(const char *from, const char *end)
+{
+    const QByteArrayView data(from, end);
+    qsizetype index = data.indexOf("\n\n");
+    while (index >= 0) {
+        const char *candidate = skipBlankLines(from + index, end);
+        // field names consist of uppercase letters, digits and underscores
+        const char *nameEnd = candidate;
+        while (nameEnd < end && ((*nameEnd >= 'A' && *nameEnd <= 'Z') || (*nameEnd >= '0' && *nameEnd <= '9') || *nameEnd == '_')) {
+            ++nameEnd;
+        }
+        if (nameEnd > candidate && nameEnd < end && (*nameEnd == '=' || *nameEnd == '\n')) {
+            return candidate;
+        }
+        index = data.indexOf("\n\n", candidate - from);
+    }
+    return end;
+}
+
+const char *JournaldExportReaderPrivate::skipBlankLines(const char *position, const char *end)
+{
+    while (position < end && *position == '\n') {
+        ++position;
     }
+    return position;
+}
+
+void JournaldExportReaderPrivate::scheduleSegments()
+{
+    const char *end = mData + mSize;
+    while (mPendingSegments.size() < static_cast<std::size_t>(2 * mThreadCount) && mScheduledEnd < end) {
+        const char *begin = mScheduledEnd;
+        const char *proposedEnd = end - begin > mSegmentSize ? findSplitPoint(begin + mSegmentSize, end) : end;
+        mPendingSegments.push_back(QtConcurrent::run(&mThreadPool, &JournaldExportReaderPrivate::parseSegment, begin, proposedEnd, end));
+        mScheduledEnd = proposedEnd;
+    }
+}
 
-    mCurrentEntry.clear();
-    while (!mDevice->atEnd()) {
-        QString line = QString::fromLocal8Bit(mDevice->readLine().trimmed());
-        // empty line = beginning of new log entry
-        if (line.isEmpty()) {
-            break; // found break in log entry
-        }
-
-        // if line does not contain "=" then switch to binary reading mode
-        int separatorIndex = line.indexOf(QLatin1Char('='));
-        if (separatorIndex > 0) {
-            mCurrentEntry[line.left(separatorIndex)] = line.right(line.length() - separatorIndex - 1).trimmed();
-        } else {
-            QString fieldId = line;
-            union {
-                uint64_t uint64;
-                char chars[4];
-            } size;
-            qint64 bytes = mDevice->read(size.chars, 8);
-            if (bytes != 8) {
-                qCWarning(KJOURNALDLIB_GENERAL) << "Journal entry read that has unexpected number of bytes (8 bytes expected)" << bytes;
+void JournaldExportReaderPrivate::discardSegments()
+{
+    for (auto &segment : mPendingSegments) {
+        segment.cancel();
+        segment.waitForFinished();
+    }
+    mPendingSegments.clear();
+}
+
+bool JournaldExportReaderPrivate::readNextParallel()
+{
+    const char *end = mData + mSize;
+    while (mCurrentSegmentEntry >= mCurrentSegment.mEntryEnds.size()) {
+        if (mCurrentSegment.mError) {
+            mError = true;
+            mFields.clear();
+            return false;
+        }
+        scheduleSegments();
+        if (mPendingSegments.empty()) {
+            mFields.clear();
+            mPosition = mSize;
+            return false;
+        }
+        Segment segment = mPendingSegments.front().result();
+        mPendingSegments.pop_front();
+        // a segment is only valid if the previous segment ended exactly at its start, otherwise the split
+        // point was located within binary field data and parsing restarts at the actual end of the last entry
+        const char *expectedBegin = mData + mPosition;
+        if (skipBlankLines(segment.mBegin, end) != skipBlankLines(expectedBegin, end)) {
+            qCDebug(KJOURNALDLIB_GENERAL) << "Discarding segment at invalid split point" << segment.mBegin - mData;
+            discardSegments();
+            mScheduledEnd = expectedBegin;
+            continue;
+        }
+        mCurrentSegment = std::move(segment);
+        mCurrentSegmentEntry = 0;
+    }
+
+    const qsizetype first = mCurrentSegmentEntry > 0 ? mCurrentSegment.mEntryEnds.at(mCurrentSegmentEntry - 1) : 0;
+    const qsizetype last = mCurrentSegment.mEntryEnds.at(mCurrentSegmentEntry);
+    mFields.clear();
+    for (qsizetype i = first; i < last; ++i) {
+        mFields.append(mCurrentSegment.mFields.at(i));
+    }
+    mPosition = mCurrentSegment.mEntryPositions.at(mCurrentSegmentEntry) - mData;
+    ++mCurrentSegmentEntry;
+    return true;
+}
+
+bool JournaldExportReaderPrivate::readNextStreaming()
+{
+    while (true) {
+        mFields.clear();
+        bool truncated{false};
+        bool terminated{false};
+        const char *begin = mBuffer.constData() + mBufferPosition;
+        const char *end = mBuffer.constData() + mBuffer.size();
+        const char *entryEnd = parseEntry(begin, end, mFields, truncated, &terminated);
+        // at the end of the input, the last entry does not need to be terminated by a blank line
+        if (terminated || (mStreamAtEnd && !truncated && skipBlankLines(begin, end) < end)) {
+            mPosition += entryEnd - begin;
+            mBufferPosition = entryEnd - mBuffer.constData();
+            return true;
+        }
+        if (mStreamAtEnd) {
+            mFields.clear();
+            mError = truncated;
+            return false;
+        }
+        if (mIncremental) {
+            // entry is incomplete, wait for addData()
+            mFields.clear();
+            return false;
+        }
+
+        // entry is incomplete, drop consumed data and append next block
+        mBuffer.remove(0, mBufferPosition);
+        mBufferPosition = 0;
+        const QByteArray block = mStreamDevice->read(sStreamBlockSize);
+        if (block.isEmpty() && !mStreamDevice->waitForReadyRead(-1)) {
+            mStreamAtEnd = true;
+            if (auto decompressionDevice = qobject_cast<DecompressionDevice *>(mStreamDevice); decompressionDevice && decompressionDevice->hasError()) {
+                mError = true;
+                mFields.clear();
+                return false;
             }
-            mCurrentEntry[fieldId] = QString::fromLocal8Bit(mDevice->read(le64toh(size.uint64)));
-            // read line break after binary content, such that reader points to next line
-            mDevice->read(1);
         }
+        mBuffer.append(block);
+    }
+}
+
+JournaldExportReader::JournaldExportReader(QIODevice *device)
+    : d(new JournaldExportReaderPrivate)
+{
+    d->load(device);
+}
+
+JournaldExportReader::JournaldExportReader(const QString &path)
+    : d(new JournaldExportReaderPrivate)
+{
+    if (DecompressionDevice::isCompressed(path)) {
+        d->mDecompressionDevice = std::make_unique<DecompressionDevice>(path);
+        d->load(d->mDecompressionDevice.get());
+        return;
     }
+    d->mFile = std::make_unique<QFile>(path);
+    d->load(d->mFile.get());
+}
+
+JournaldExportReader::JournaldExportReader(QByteArrayView data)
+    : d(new JournaldExportReaderPrivate)
+{
+    d->mData = data.data();
+    d->mSize = data.size();
+}
+
+JournaldExportReader::JournaldExportReader()
+    : d(new JournaldExportReaderPrivate)
+{
+    d->mIncremental = true;
+}
+
+JournaldExportReader::~JournaldExportReader() = default;
+
+void JournaldExportReader::addData(QByteArrayView data)
+{
+    if (!d->mIncremental || d->mStreamAtEnd) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Skipping data, reader does not accept further input";
+        return;
+    }
+    d->mDecodedEntry.reset();
+    d->mFields.clear();
+    // only the incomplete entry at the end of the buffer is kept
+    d->mBuffer.remove(0, d->mBufferPosition);
+    d->mBufferPosition = 0;
+    d->mBuffer.append(data.data(), data.size());
+}
+
+void JournaldExportReader::closeInput()
+{
+    d->mStreamAtEnd = true;
+}
+
+void JournaldExportReader::setParallelParsing(int threadCount, qint64 segmentSize)
+{
+    if (d->mStreamDevice || d->mIncremental) {
+        qCDebug(KJOURNALDLIB_GENERAL) << "Streamed input is parsed sequentially, ignoring parallel parsing";
+        return;
+    }
+    d->mThreadCount = std::max(1, threadCount);
+    d->mSegmentSize = std::max<qint64>(1, segmentSize);
+    d->mThreadPool.setMaxThreadCount(d->mThreadCount);
+    d->mScheduledEnd = d->mData + d->mPosition;
+}
 
+bool JournaldExportReader::atEnd() const
+{
+    if (d->mError) {
+        return true;
+    }
+    if (d->mStreamDevice || d->mIncremental) {
+        const char *end = d->mBuffer.constData() + d->mBuffer.size();
+        const bool bufferConsumed = JournaldExportReaderPrivate::skipBlankLines(d->mBuffer.constData() + d->mBufferPosition, end) == end;
+        return bufferConsumed && (d->mStreamAtEnd || (d->mStreamDevice && d->mStreamDevice->atEnd()));
+    }
+    // trailing blank lines do not start another entry
+    for (qint64 i = d->mPosition; i < d->mSize; ++i) {
+        if (d->mData[i] != '\n') {
+            return false;
+        }
+    }
     return true;
 }
 
+bool JournaldExportReader::readNext()
+{
+    d->mDecodedEntry.reset();
+    if (atEnd()) {
+        d->mFields.clear();
+        d->mPosition = d->mSize;
+        return false;
+    }
+    if (d->mStreamDevice || d->mIncremental) {
+        return d->readNextStreaming();
+    }
+    if (d->mThreadCount > 1) {
+        return d->readNextParallel();
+    }
+    d->mFields.clear();
+    const char *end = JournaldExportReaderPrivate::parseEntry(d->mData + d->mPosition, d->mData + d->mSize, d->mFields, d->mError);
+    d->mPosition = end - d->mData;
+    return !d->mError;
+}
+
+bool JournaldExportReader::hasError() const
+{
+    return d->mError;
+}
+
+qint64 JournaldExportReader::position() const
+{
+    return d->mPosition;
+}
+
+const QVector<JournaldExportReader::Field> &JournaldExportReader::fields() const
+{
+    return d->mFields;
+}
+
+std::optional<QByteArrayView> JournaldExportReader::fieldValue(QByteArrayView name) const
+{
+    for (const auto &field : std::as_const(d->mFields)) {
+        if (field.mName == name) {
+            return field.mValue;
+        }
+    }
+    return std::nullopt;
+}
+
 JournaldExportReader::LogEntry JournaldExportReader::entry() const
 {
-    return mCurrentEntry;
+    if (!d->mDecodedEntry) {
+        LogEntry entry;
+        entry.reserve(d->mFields.size());
+        for (const auto &field : std::as_const(d->mFields)) {
+            entry.insert(QString::fromUtf8(field.mName), QString::fromUtf8(field.mValue));
+        }
+        d->mDecodedEntry = std::move(entry);
+    }
+    return *d->mDecodedEntry;
 }
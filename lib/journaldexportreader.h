@@ -7,25 +7,132 @@
 #define JOURNALDEXPORTREADER_H
 
 #include "kjournald_export.h"
-#include <QObject>
-#include <QTextStream>
+#include <QByteArrayView>
 #include <QHash>
+#include <QObject>
+#include <QVector>
+#include <memory>
+#include <optional>
 
 class QIODevice;
+class JournaldExportReaderPrivate;
 
+/**
+ * @brief Parser for the journal export format
+ *
+ * The input is mapped into memory if it is a file, streamed block by block if it is a sequential device,
+ * otherwise it is read completely. Compressed export files are decompressed while parsing, see
+ * DecompressionDevice. Entries are iterated as views on the input data, i.e. without copying: readNext()
+ * only locates the fields of the next entry and their values are decoded not before they are requested.
+ *
+ * Format description: <https://systemd.io/JOURNAL_EXPORT_FORMATS/>
+ */
 class KJOURNALD_EXPORT JournaldExportReader : public QObject
 {
     Q_OBJECT
 public:
     using LogEntry = QHash<QString, QString>;
 
-    JournaldExportReader(QIODevice *device);
+    /**
+     * @brief Raw field of the current entry
+     * @note the views point into the input data and are valid as long as the reader exists, for streamed
+     * input only until the next call of readNext()
+     */
+    struct Field {
+        QByteArrayView mName;
+        QByteArrayView mValue;
+    };
+
+    /**
+     * @brief Construct reader for @p device, which is opened for reading if not open yet
+     *
+     * File devices are mapped into memory, other devices are read completely.
+     */
+    explicit JournaldExportReader(QIODevice *device);
+
+    /**
+     * @brief Construct reader for the export file at @p path
+     *
+     * Plain files are mapped into memory, compressed files are decompressed in a worker thread while parsing.
+     */
+    explicit JournaldExportReader(const QString &path);
+
+    /**
+     * @brief Construct reader for @p data, which must stay valid as long as the reader exists
+     */
+    explicit JournaldExportReader(QByteArrayView data);
+
+    /**
+     * @brief Construct reader for input that is provided incrementally by addData(), e.g. from a network reply
+     *
+     * In this mode, readNext() returns false without setting an error as long as the next entry is not
+     * complete, and reading can be continued after more data was added.
+     */
+    JournaldExportReader();
+
+    ~JournaldExportReader() override;
+
+    /**
+     * @brief Append @p data to the input of a reader that was constructed for incremental input
+     * @note the fields of the current entry are invalidated
+     */
+    void addData(QByteArrayView data);
+
+    /**
+     * @brief Mark the input of a reader that was constructed for incremental input as complete
+     *
+     * Afterwards, the last entry does not need to be terminated by a blank line and a truncated entry is
+     * reported as error.
+     */
+    void closeInput();
+
+    /**
+     * @brief Parse the input on @p threadCount threads
+     *
+     * The input is split into segments of about @p segmentSize bytes at entry boundaries, which are parsed
+     * concurrently while entries are still provided in input order. Memory usage is bounded by the two
+     * segments that are parsed ahead per thread. With a thread count of 1, entries are parsed on demand.
+     * @note must be called before the first entry is read
+     */
+    void setParallelParsing(int threadCount, qint64 segmentSize = 4 * 1024 * 1024);
+
+    /**
+     * @return true if no further entry can be read
+     */
     bool atEnd() const;
+
+    /**
+     * @brief Advance to the next entry
+     * @return true if an entry was read, false at the end of the input or on malformed input
+     */
     bool readNext();
+
+    /**
+     * @return true if parsing stopped at malformed or truncated input
+     */
+    bool hasError() const;
+
+    /**
+     * @return number of bytes of the input that are parsed
+     */
+    qint64 position() const;
+
+    /**
+     * @return fields of the current entry in input order
+     */
+    const QVector<Field> &fields() const;
+
+    /**
+     * @return raw value of field @p name of the current entry or std::nullopt if the entry has no such field
+     */
+    std::optional<QByteArrayView> fieldValue(QByteArrayView name) const;
+
+    /**
+     * @return decoded fields of the current entry, the map is created on first access
+     */
     LogEntry entry() const;
 
 private:
-    QIODevice *mDevice{};
-    LogEntry mCurrentEntry;
+    std::unique_ptr<JournaldExportReaderPrivate> d;
 };
 #endif
@@ -0,0 +1,121 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef JOURNALDEXPORTREADER_P_H
+#define JOURNALDEXPORTREADER_P_H
+
+#include "decompressiondevice.h"
+#include "journaldexportreader.h"
+#include <QByteArray>
+#include <QFile>
+#include <QFuture>
+#include <QThreadPool>
+#include <deque>
+#include <memory>
+#include <optional>
+
+class JournaldExportReaderPrivate
+{
+public:
+    /**
+     * entries of a part of the input that was parsed in parallel mode
+     */
+    struct Segment {
+        const char *mBegin{nullptr}; //!< start of first entry
+        const char *mEnd{nullptr}; //!< end of last entry, which is behind the proposed end if that was no entry boundary
+        QVector<JournaldExportReader::Field> mFields; //!< fields of all entries
+        QVector<qsizetype> mEntryEnds; //!< for each entry the index in mFields after its last field
+        QVector<const char *> mEntryPositions; //!< for each entry the position after it
+        bool mError{false};
+    };
+
+    ~JournaldExportReaderPrivate();
+
+    /**
+     * map @p device into memory if it is a file, stream sequential devices, otherwise read its complete content
+     */
+    void load(QIODevice *device);
+
+    /**
+     * @brief Locate the fields of the entry that starts at @p begin
+     *
+     * Blank lines before the entry are skipped.
+     * @param fields the fields of the entry are appended
+     * @param error is set to true if the entry is truncated
+     * @param terminated if not nullptr, set to true if the entry is terminated by a blank line
+     * @return position after the entry's terminating blank line
+     */
+    static const char *
+    parseEntry(const char *begin, const char *end, QVector<JournaldExportReader::Field> &fields, bool &error, bool *terminated = nullptr);
+
+    /**
+     * @brief Parse all entries that start before @p proposedEnd, beginning at entry start @p begin
+     */
+    static Segment parseSegment(const char *begin, const char *proposedEnd, const char *end);
+
+    /**
+     * @brief Find the first position at or after @p from that looks like the start of an entry
+     *
+     * A split point is a line that starts with a field name and follows a blank line. Since binary
+     * field data may contain the same byte sequence, split points are only candidates that are
+     * validated after parsing, see readNextParallel().
+     * @return the position or @p end if there is no such position
+     */
+    static const char *findSplitPoint(const char *from, const char *end);
+
+    /**
+     * @return first position at or after @p position that is no line break
+     */
+    static const char *skipBlankLines(const char *position, const char *end);
+
+    /**
+     * start parsing of further segments until enough segments are in flight
+     */
+    void scheduleSegments();
+
+    /**
+     * wait for all segments in flight and drop them
+     */
+    void discardSegments();
+
+    /**
+     * readNext() implementation that consumes segments parsed by the thread pool
+     */
+    bool readNextParallel();
+
+    /**
+     * readNext() implementation that reads the input from a sequential device block by block, or from the
+     * data that was added in incremental mode
+     */
+    bool readNextStreaming();
+
+    std::unique_ptr<QFile> mFile; //!< only set if the reader opened the file itself
+    std::unique_ptr<DecompressionDevice> mDecompressionDevice; //!< only set if the reader opened a compressed file itself
+    QByteArray mBuffer; //!< content of devices that cannot be mapped
+    const char *mData{nullptr};
+    qint64 mSize{0};
+    qint64 mPosition{0};
+    bool mError{false};
+    QVector<JournaldExportReader::Field> mFields;
+    mutable std::optional<JournaldExportReader::LogEntry> mDecodedEntry;
+
+    // streaming mode, in which mBuffer contains a window of the input
+    static constexpr qint64 sStreamBlockSize{1024 * 1024};
+    QIODevice *mStreamDevice{nullptr};
+    qint64 mBufferPosition{0}; //!< start of next entry in mBuffer
+    bool mStreamAtEnd{false};
+    bool mIncremental{false}; //!< input is provided by addData() instead of a device
+
+    // parallel mode
+    int mThreadCount{1};
+    qint64 mSegmentSize{4 * 1024 * 1024};
+    std::deque<QFuture<Segment>> mPendingSegments; //!< segments in input order, at most 2 per thread
+    const char *mScheduledEnd{nullptr}; //!< proposed end of last scheduled segment
+    Segment mCurrentSegment;
+    qsizetype mCurrentSegmentEntry{0}; //!< index of next entry in mCurrentSegment
+    QThreadPool mThreadPool;
+};
+
+#endif // JOURNALDEXPORTREADER_P_H
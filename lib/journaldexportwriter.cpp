@@ -0,0 +1,337 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "journaldexportwriter.h"
+#include "journaldexportwriter_p.h"
+#include "journaldhelper.h"
+#include "journaldviewmodel.h"
+#include "kjournaldlib_log_general.h"
+#include "kjournaldlib_log_performance.h"
+#include "residualfilter.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <QTimeZone>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+/**
+ * fields are serialized as text only if they consist of valid UTF-8 without control characters except TAB,
+ * see JournaldExportReader for the format description
+ */
+bool isTextSafe(QByteArrayView value)
+{
+    const bool hasControlCharacters = std::any_of(value.cbegin(), value.cend(), [](char c) {
+        return (static_cast<unsigned char>(c) < 32 && c != '\t') || c == 127;
+    });
+    return !hasControlCharacters && value.isValidUtf8();
+}
+
+QJsonValue jsonValue(QByteArrayView value)
+{
+    if (value.isValidUtf8()) {
+        return QString::fromUtf8(value);
+    }
+    // same representation as used by journalctl for binary data
+    QJsonArray bytes;
+    for (const char c : value) {
+        bytes.append(static_cast<unsigned char>(c));
+    }
+    return bytes;
+}
+}
+
+void JournaldExportWriter::appendEntry(const IJournal &journal, Format format, QByteArray &buffer)
+{
+    const quint64 realtime = journal.realtimeUsec();
+
+    if (format == Format::TEXT) {
+        // same layout as copying from the log view, but with date since the result set may span several days
+        const QDateTime date = QDateTime::fromMSecsSinceEpoch(realtime / 1000, QTimeZone::UTC);
+        buffer.append(date.toString(QLatin1String("yyyy-MM-dd HH:mm:ss.zzz")).toUtf8());
+        buffer.append(" UTC ");
+        buffer.append(JournaldHelper::cleanupString(QString::fromUtf8(journal.fieldValue("_SYSTEMD_UNIT").value_or(QByteArrayView()))).toUtf8());
+        buffer.append(' ');
+        buffer.append(journal.fieldValue("MESSAGE").value_or(QByteArrayView()));
+        buffer.append('\n');
+        return;
+    }
+
+    const QString cursor = journal.cursor();
+    const quint64 monotonic = journal.monotonicUsec();
+
+    if (format == Format::EXPORT) {
+        buffer.append("__CURSOR=");
+        buffer.append(cursor.toUtf8());
+        buffer.append("\n__REALTIME_TIMESTAMP=");
+        buffer.append(QByteArray::number(realtime));
+        buffer.append("\n__MONOTONIC_TIMESTAMP=");
+        buffer.append(QByteArray::number(monotonic));
+        buffer.append('\n');
+        journal.forEachField([&buffer](QByteArrayView name, QByteArrayView value) {
+            if (isTextSafe(value)) {
+                buffer.append(name);
+                buffer.append('=');
+                buffer.append(value);
+            } else {
+                const quint64 size = qToLittleEndian<quint64>(value.size());
+                buffer.append(name);
+                buffer.append('\n');
+                buffer.append(reinterpret_cast<const char *>(&size), sizeof(size));
+                buffer.append(value);
+            }
+            buffer.append('\n');
+        });
+        buffer.append('\n');
+    } else {
+        QJsonObject object;
+        object.insert(QLatin1String("__CURSOR"), cursor);
+        object.insert(QLatin1String("__REALTIME_TIMESTAMP"), QString::number(realtime));
+        object.insert(QLatin1String("__MONOTONIC_TIMESTAMP"), QString::number(monotonic));
+        QSet<QString> repeatedFields;
+        journal.forEachField([&object, &repeatedFields](QByteArrayView field, QByteArrayView fieldValue) {
+            const QString name = QString::fromUtf8(field);
+            const QJsonValue value = jsonValue(fieldValue);
+            auto it = object.find(name);
+            if (it == object.end()) {
+                object.insert(name, value);
+                return;
+            }
+            // fields that occur several times in one entry are combined into an array, like journalctl does
+            QJsonArray values = repeatedFields.contains(name) ? it.value().toArray() : QJsonArray{it.value()};
+            values.append(value);
+            it.value() = values;
+            repeatedFields.insert(name);
+        });
+        buffer.append(QJsonDocument(object).toJson(QJsonDocument::Compact));
+        buffer.append('\n');
+    }
+}
+
+void JournaldExportWriterPrivate::run(IJournal *journal, const FilterExpression &filter, QIODevice *device, JournaldExportWriter::Format format, Job &job)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // query is prepared first, because the journal might reopen a subset of its files for the filter
+    journal->prepareQuery(filter);
+    if (!journal->isValid() || !journal->setFilter(filter)) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Cannot export entries, no valid journal opened";
+        return;
+    }
+    const ResidualFilter residualFilter(filter.residualPart());
+
+    // progress is estimated by the position of the entry's timestamp within the time range of the result set
+    quint64 headRealtime{0};
+    quint64 tailRealtime{0};
+    if (journal->seekTail() && journal->previous() > 0) {
+        tailRealtime = journal->realtimeUsec();
+    }
+    if (!journal->seekHead()) {
+        return;
+    }
+
+    QByteArray buffer;
+    buffer.reserve(2 * sFlushSize);
+    auto flush = [&buffer, device]() {
+        if (buffer.isEmpty()) {
+            return true;
+        }
+        if (device->write(buffer) != buffer.size()) {
+            qCCritical(KJOURNALDLIB_GENERAL) << "Failed to write exported entries:" << device->errorString();
+            return false;
+        }
+        // keeps the allocated capacity for the next block
+        buffer.resize(0);
+        return true;
+    };
+
+    qint64 writtenEntries{0};
+    while (!job.mCanceled.load()) {
+        const int result = journal->next();
+        if (result < 0) {
+            qCCritical(KJOURNALDLIB_GENERAL) << "Failed to read next entry:" << strerror(-result);
+            return;
+        }
+        if (result == 0) {
+            break;
+        }
+        if (!residualFilter.matches(*journal)) {
+            continue;
+        }
+        const quint64 realtime = journal->realtimeUsec();
+        if (writtenEntries == 0) {
+            headRealtime = realtime;
+        }
+        JournaldExportWriter::appendEntry(*journal, format, buffer);
+        job.mWrittenEntries.store(++writtenEntries);
+        if (tailRealtime > headRealtime && realtime >= headRealtime) {
+            job.mProgressPermille.store(static_cast<int>(std::min<quint64>(1000, (realtime - headRealtime) * 1000 / (tailRealtime - headRealtime))));
+        }
+        if (buffer.size() >= sFlushSize && !flush()) {
+            return;
+        }
+    }
+    if (job.mCanceled.load() || !flush()) {
+        return;
+    }
+    job.mProgressPermille.store(1000);
+    job.mSuccess.store(true);
+    qCDebug(KJOURNALDLIB_PERFORMANCE) << "Exported" << writtenEntries << "entries in" << timer.elapsed() << "ms";
+}
+
+JournaldExportWriter::JournaldExportWriter(QObject *parent)
+    : QObject(parent)
+    , d(new JournaldExportWriterPrivate)
+{
+    d->mProgressTimer.setInterval(JournaldExportWriterPrivate::sProgressInterval);
+    connect(&d->mProgressTimer, &QTimer::timeout, this, [this]() {
+        const qint64 writtenEntries = d->mJob->mWrittenEntries.load();
+        const double progress = d->mJob->mProgressPermille.load() / 1000.;
+        if (writtenEntries != d->mWrittenEntries || progress != d->mProgress) {
+            d->mWrittenEntries = writtenEntries;
+            d->mProgress = progress;
+            Q_EMIT progressChanged();
+        }
+    });
+}
+
+JournaldExportWriter::~JournaldExportWriter()
+{
+    if (d->mThread) {
+        d->mJob->mCanceled.store(true);
+        d->mThread->wait();
+    }
+    if (d->mFile) {
+        d->mFile->cancelWriting();
+    }
+}
+
+bool JournaldExportWriter::start(std::unique_ptr<IJournal> journal, const FilterExpression &filter, QIODevice *device, Format format)
+{
+    if (d->mThread) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Export is already running, ignoring request";
+        return false;
+    }
+    if (!journal || !device) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Cannot export without journal and target device";
+        return false;
+    }
+    if (!device->isOpen() && !device->open(QIODevice::WriteOnly)) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Could not open device for writing:" << device->errorString();
+        return false;
+    }
+
+    d->mJob = std::make_shared<JournaldExportWriterPrivate::Job>();
+    d->mWrittenEntries = 0;
+    d->mProgress = 0;
+    // the journal is destroyed in the worker thread, because its socket notifier has the thread's affinity
+    IJournal *workerJournal = journal.release();
+    workerJournal->setParent(nullptr);
+    d->mThread.reset(QThread::create([workerJournal, filter, device, format, job = d->mJob]() {
+        JournaldExportWriterPrivate::run(workerJournal, filter, device, format, *job);
+        delete workerJournal;
+    }));
+    workerJournal->moveToThread(d->mThread.get());
+    // notifications of previous runs might still be queued when waitForFinished() handled them already
+    connect(d->mThread.get(), &QThread::finished, this, [this, job = d->mJob]() {
+        if (job == d->mJob) {
+            handleWorkerFinished();
+        }
+    });
+    d->mThread->start();
+    d->mProgressTimer.start();
+    Q_EMIT runningChanged();
+    Q_EMIT progressChanged();
+    return true;
+}
+
+bool JournaldExportWriter::exportModel(JournaldViewModel *model, const QString &path, JournaldExportWriter::Format format)
+{
+    if (!model || d->mThread) {
+        return false;
+    }
+    std::unique_ptr<IJournal> journal = model->cloneJournal();
+    if (!journal) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Journal of model cannot be opened for export";
+        return false;
+    }
+    auto file = std::make_unique<QSaveFile>(path);
+    if (!file->open(QIODevice::WriteOnly)) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Could not open export file" << path << file->errorString();
+        return false;
+    }
+    if (!start(std::move(journal), model->queryFilterExpression(), file.get(), format)) {
+        file->cancelWriting();
+        return false;
+    }
+    d->mFile = std::move(file);
+    return true;
+}
+
+void JournaldExportWriter::cancel()
+{
+    if (d->mJob) {
+        d->mJob->mCanceled.store(true);
+    }
+}
+
+void JournaldExportWriter::waitForFinished()
+{
+    if (!d->mThread) {
+        return;
+    }
+    // deliver the queued notification synchronously, such that state is final when returning
+    handleWorkerFinished();
+}
+
+bool JournaldExportWriter::isRunning() const
+{
+    return d->mThread != nullptr;
+}
+
+qint64 JournaldExportWriter::writtenEntries() const
+{
+    return d->mWrittenEntries;
+}
+
+double JournaldExportWriter::progress() const
+{
+    return d->mProgress;
+}
+
+void JournaldExportWriter::handleWorkerFinished()
+{
+    if (!d->mThread) {
+        return;
+    }
+    d->mThread->wait();
+    d->mThread.reset();
+    d->mProgressTimer.stop();
+    bool success = d->mJob->mSuccess.load();
+    if (d->mFile) {
+        if (success) {
+            success = d->mFile->commit();
+            if (!success) {
+                qCCritical(KJOURNALDLIB_GENERAL) << "Could not write export file" << d->mFile->fileName() << d->mFile->errorString();
+            }
+        } else {
+            d->mFile->cancelWriting();
+        }
+        d->mFile.reset();
+    }
+    d->mWrittenEntries = d->mJob->mWrittenEntries.load();
+    d->mProgress = d->mJob->mProgressPermille.load() / 1000.;
+    Q_EMIT progressChanged();
+    Q_EMIT runningChanged();
+    Q_EMIT finished(success, d->mWrittenEntries);
+}
@@ -0,0 +1,134 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef JOURNALDEXPORTWRITER_H
+#define JOURNALDEXPORTWRITER_H
+
+#include "filterexpression.h"
+#include "ijournal.h"
+#include "kjournald_export.h"
+#include <QObject>
+#include <memory>
+
+class JournaldExportWriterPrivate;
+class JournaldViewModel;
+class QIODevice;
+
+/**
+ * @brief Writes all entries of a filtered journal query to a device in a worker thread
+ *
+ * Other than copying from the view, the writer is not limited to the entries that are currently loaded
+ * into a model: it runs the complete query on its own journal object and streams every matching entry
+ * to the device. Entries are serialized one by one, such that memory usage does not depend on the size
+ * of the result set. Progress is estimated from the realtime timestamp of the last written entry
+ * relative to the time range of the result set.
+ *
+ * Supported formats are the journal export format (see JournaldExportReader), JSON lines with one
+ * object per entry in the field layout of "journalctl -o json", and plain text lines in the layout that
+ * is used when copying from the log view.
+ */
+class KJOURNALD_EXPORT JournaldExportWriter : public QObject
+{
+    Q_OBJECT
+    /**
+     * true while entries are written
+     **/
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
+    /**
+     * number of entries that were written in the current or last run
+     **/
+    Q_PROPERTY(qint64 writtenEntries READ writtenEntries NOTIFY progressChanged)
+    /**
+     * estimated progress of the current or last run in range [0,1]
+     **/
+    Q_PROPERTY(double progress READ progress NOTIFY progressChanged)
+
+public:
+    enum class Format {
+        EXPORT, //!< journal export format as produced by "journalctl -o export"
+        JSON, //!< one JSON object per line as produced by "journalctl -o json"
+        TEXT, //!< plain text with date, systemd unit and message per line
+    };
+    Q_ENUM(Format);
+
+    /**
+     * @brief Construct idle writer
+     */
+    explicit JournaldExportWriter(QObject *parent = nullptr);
+
+    /**
+     * @brief Destroys the writer, cancels and waits for a running export
+     */
+    ~JournaldExportWriter() override;
+
+    /**
+     * @brief Start writing all entries of @p journal that match @p filter to @p device
+     *
+     * @note the journal is moved to the worker thread and destroyed there once writing is finished
+     * @param journal journal object that is exclusively used for the export, see IJournal::clone()
+     * @param filter the filter of the query, which usually is JournaldViewModel::queryFilterExpression()
+     * @param device the target device, which is opened for writing if not open yet and must stay valid
+     *        until finished() is emitted
+     * @param format the output format
+     * @return true if the export was started, false if another export is running or arguments are invalid
+     */
+    bool start(std::unique_ptr<IJournal> journal, const FilterExpression &filter, QIODevice *device, Format format);
+
+    /**
+     * @brief Write the complete result set of @p model to the file at @p path
+     *
+     * The file is written atomically, i.e. it is only replaced when all entries were written successfully.
+     * @return true if the export was started
+     */
+    Q_INVOKABLE bool exportModel(JournaldViewModel *model, const QString &path, JournaldExportWriter::Format format);
+
+    /**
+     * @brief Cancel the running export, finished() is emitted with success false once the worker stopped
+     */
+    Q_INVOKABLE void cancel();
+
+    /**
+     * @brief Block until the running export is finished
+     */
+    void waitForFinished();
+
+    /**
+     * @return true while entries are written
+     */
+    bool isRunning() const;
+
+    /**
+     * @return number of entries that were written in the current or last run
+     */
+    qint64 writtenEntries() const;
+
+    /**
+     * @return estimated progress of the current or last run in range [0,1]
+     */
+    double progress() const;
+
+    /**
+     * @brief Serialize the current entry of @p journal to @p buffer in @p format
+     */
+    static void appendEntry(const IJournal &journal, Format format, QByteArray &buffer);
+
+Q_SIGNALS:
+    void runningChanged();
+    void progressChanged();
+
+    /**
+     * @brief Signal is emitted when the export is finished, canceled or failed
+     * @param success true if all entries were written
+     * @param entries number of written entries
+     */
+    void finished(bool success, qint64 entries);
+
+private:
+    void handleWorkerFinished();
+
+    std::unique_ptr<JournaldExportWriterPrivate> d;
+};
+
+#endif // JOURNALDEXPORTWRITER_H
@@ -0,0 +1,45 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef JOURNALDEXPORTWRITER_P_H
+#define JOURNALDEXPORTWRITER_P_H
+
+#include "journaldexportwriter.h"
+#include <QSaveFile>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+#include <memory>
+
+class JournaldExportWriterPrivate
+{
+public:
+    /**
+     * state that is shared between the writer and its worker thread
+     */
+    struct Job {
+        std::atomic_bool mCanceled{false};
+        std::atomic_bool mSuccess{false};
+        std::atomic<qint64> mWrittenEntries{0};
+        std::atomic<int> mProgressPermille{0};
+    };
+
+    /**
+     * write all entries of @p journal that match @p filter to @p device until @p job is canceled
+     */
+    static void run(IJournal *journal, const FilterExpression &filter, QIODevice *device, JournaldExportWriter::Format format, Job &job);
+
+    static constexpr int sFlushSize{1024 * 1024}; //!< serialized entries are written in blocks of about this size
+    static constexpr int sProgressInterval{100}; //!< interval in ms at which progress is published
+
+    std::unique_ptr<QThread> mThread;
+    std::shared_ptr<Job> mJob;
+    std::unique_ptr<QSaveFile> mFile; //!< target file of exportModel(), committed on success
+    QTimer mProgressTimer;
+    qint64 mWrittenEntries{0};
+    double mProgress{0};
+};
+
+#endif // JOURNALDEXPORTWRITER_P_H
@@ -4,33 +4,20 @@
 */
 
 #include "journaldhelper.h"
+#include "filterexpression.h"
 #include "kjournaldlib_log_general.h"
+#include "kjournaldlib_log_performance.h"
 #include "localjournal.h"
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QMetaEnum>
-#include <systemd/sd-journal.h>
+#include <QThread>
+#include <QtConcurrent>
+#include <algorithm>
 
 QVector<QString> JournaldHelper::queryUnique(const IJournal &journal, Field field)
 {
-    QVector<QString> dataList;
-    const void *data;
-    size_t length;
-    int result;
-
-    const QString fieldString = mapField(field);
-
-    result = sd_journal_query_unique(journal.sdJournal(), qUtf8Printable(fieldString));
-    if (result < 0) {
-        qCritical() << "Failed to query journal:" << strerror(-result);
-        return dataList;
-    }
-    const int fieldLength = fieldString.length() + 1;
-    SD_JOURNAL_FOREACH_UNIQUE(journal.sdJournal(), data, length)
-    {
-        QString dataStr = QString::fromUtf8(static_cast<const char *>(data), length);
-        dataList << dataStr.remove(0, fieldLength);
-    }
-    return dataList;
+    return journal.queryUnique(mapField(field));
 }
 
 QVector<QString> JournaldHelper::queryUnique(std::shared_ptr<IJournal> journal, Field field)
@@ -38,96 +25,141 @@ QVector<QString> JournaldHelper::queryUnique(std::shared_ptr<IJournal> journal,
     if (!journal) {
         return {};
     }
+    return journal->queryUnique(mapField(field));
+}
 
-    QVector<QString> dataList;
-    const void *data;
-    size_t length;
-    int result;
+std::optional<JournaldHelper::BootInfo> JournaldHelper::queryBoot(IJournal &journal, const QString &bootId)
+{
+    if (!journal.setFilter(FilterExpression::match(QLatin1String("_BOOT_ID"), bootId))) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Failed add filter for boot" << bootId;
+        return std::nullopt;
+    }
 
-    QString fieldString = mapField(field);
+    QDateTime since;
+    if (!journal.seekHead()) {
+        return std::nullopt;
+    }
+    if (journal.next() <= 0) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Failed to obtain first entry of boot" << bootId;
+        return std::nullopt;
+    }
+    if (const quint64 time = journal.realtimeUsec(); time > 0) {
+        since.setMSecsSinceEpoch(time / 1000);
+    } else {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Failed to obtain time of first entry of boot" << bootId;
+    }
 
-    result = sd_journal_query_unique(journal->sdJournal(), qUtf8Printable(fieldString));
-    if (result < 0) {
-        qCritical() << "Failed to query journal:" << strerror(-result);
-        return dataList;
+    QDateTime until;
+    if (!journal.seekTail()) {
+        return std::nullopt;
+    }
+    if (journal.previous() <= 0) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Failed to obtain last entry of boot" << bootId;
     }
-    const int fieldLength = fieldString.length() + 1;
-    SD_JOURNAL_FOREACH_UNIQUE(journal->sdJournal(), data, length)
-    {
-        QString dataStr = QString::fromUtf8(static_cast<const char *>(data), length);
-        dataList << dataStr.remove(0, fieldLength);
+    if (const quint64 time = journal.realtimeUsec(); time > 0) {
+        until.setMSecsSinceEpoch(time / 1000);
+    } else {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Failed to obtain time of last entry of boot" << bootId;
     }
-    return dataList;
+
+    if (!since.isValid() || !until.isValid()) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Could not correctly parse start/end time for boot" << bootId << "skipping from list";
+        return std::nullopt;
+    }
+    return BootInfo{bootId, since, until};
 }
 
-QVector<JournaldHelper::BootInfo> JournaldHelper::queryOrderedBootIds(const IJournal &journal)
+QVector<JournaldHelper::BootInfo> JournaldHelper::queryOrderedBootIds(IJournal &journal)
 {
-    QVector<JournaldHelper::BootInfo> boots;
-
-    QVector<QString> bootIds = JournaldHelper::queryUnique(journal, Field::_BOOT_ID);
-
-    sd_journal *sdJournal = journal.sdJournal();
-    for (const QString &id : bootIds) {
-        int result{0};
-        uint64_t time{0};
-
-        sd_journal_flush_matches(sdJournal);
-        QString filterExpression = QLatin1String("_BOOT_ID=") + id;
-        result = sd_journal_add_match(sdJournal, filterExpression.toStdString().c_str(), filterExpression.length());
-        if (result < 0) {
-            qCCritical(KJOURNALDLIB_GENERAL) << "Failed add filter:" << strerror(-result);
-            continue;
-        }
-
-        QDateTime since;
-        result = sd_journal_seek_head(sdJournal);
-        if (result < 0) {
-            qCCritical(KJOURNALDLIB_GENERAL) << "Failed to seek head:" << strerror(-result);
-            continue;
-        }
-        result = sd_journal_next(sdJournal);
-        if (result < 0) {
-            qCCritical(KJOURNALDLIB_GENERAL) << "Failed to obtain first entry:" << strerror(-result);
-            continue;
-        }
-        result = sd_journal_get_realtime_usec(sdJournal, &time);
-        if (result == 0) {
-            since.setMSecsSinceEpoch(time / 1000);
-        } else {
-            qCCritical(KJOURNALDLIB_GENERAL) << "Failed to obtain time:" << strerror(-result);
-        }
+    return queryOrderedBootIds(journal, QThread::idealThreadCount());
+}
 
-        QDateTime until;
-        result = sd_journal_seek_tail(sdJournal);
-        if (result < 0) {
-            qCCritical(KJOURNALDLIB_GENERAL) << "Failed to seek tail:" << strerror(-result);
-            continue;
-        }
-        result = sd_journal_previous(sdJournal);
-        if (result < 0) {
-            qCCritical(KJOURNALDLIB_GENERAL) << "Failed to obtain first entry:" << strerror(-result);
-        }
-        result = sd_journal_get_realtime_usec(sdJournal, &time);
-        if (result == 0) {
-            until.setMSecsSinceEpoch(time / 1000);
-        } else {
-            qCCritical(KJOURNALDLIB_GENERAL) << "Failed to obtain time:" << strerror(-result);
+QVector<JournaldHelper::BootInfo> JournaldHelper::queryOrderedBootIds(IJournal &journal, int threads)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<QString> bootIds = JournaldHelper::queryUnique(journal, Field::_BOOT_ID);
+
+    // every boot requires several seeks with a boot match, which are independent of each other and thus
+    // distributed over independent journal objects; few boots do not outweigh opening further journal objects
+    struct Part {
+        std::shared_ptr<IJournal> mJournal;
+        QVector<QString> mBootIds;
+    };
+    const int partCount = std::clamp<int>(bootIds.size() / sMinBootsPerThread, 1, std::max(threads, 1));
+    std::vector<Part> parts;
+    for (int i = 1; i < partCount; ++i) {
+        std::unique_ptr<IJournal> clone = journal.clone();
+        if (!clone || !clone->isValid()) {
+            break;
         }
+        // clones are read by pool threads, see IJournal::stopWatching()
+        clone->stopWatching();
+        parts.push_back({std::move(clone), {}});
+    }
+    // the calling journal takes the remaining part, it must not be deleted by the shared pointer
+    parts.push_back({std::shared_ptr<IJournal>(&journal, [](IJournal *) {}), {}});
+    for (qsizetype i = 0; i < bootIds.size(); ++i) {
+        parts[i * parts.size() / bootIds.size()].mBootIds.append(bootIds.at(i));
+    }
 
-        if (since.isValid() && until.isValid()) {
-            boots << BootInfo{id, since, until};
-        } else {
-            qCCritical(KJOURNALDLIB_GENERAL) << "Could not correctly parse start/end time for boot" << id << "skipping from list";
+    const QList<QVector<BootInfo>> results = QtConcurrent::blockingMapped(parts, [](const Part &part) {
+        QVector<BootInfo> boots;
+        for (const QString &id : part.mBootIds) {
+            if (const std::optional<BootInfo> boot = queryBoot(*part.mJournal, id)) {
+                boots.append(boot.value());
+            }
         }
+        return boots;
+    });
+    QVector<JournaldHelper::BootInfo> boots;
+    boots.reserve(bootIds.size());
+    for (const QVector<BootInfo> &result : results) {
+        boots.append(result);
     }
 
     std::sort(boots.begin(), boots.end(), [](const JournaldHelper::BootInfo &lhs, const JournaldHelper::BootInfo &rhs) {
-        return lhs.mSince < rhs.mUntil;
+        return lhs.mSince < rhs.mSince;
     });
+    qCDebug(KJOURNALDLIB_PERFORMANCE) << "Enumerated" << boots.size() << "boots with" << parts.size() << "journal objects in" << timer.elapsed() << "ms";
 
     return boots;
 }
 
+JournaldHelper::CursorInfo JournaldHelper::parseCursor(const QString &cursor)
+{
+    CursorInfo info;
+    const auto parseHex = [](QStringView value) -> std::optional<quint64> {
+        bool ok{false};
+        const quint64 number = value.toULongLong(&ok, 16);
+        return ok ? std::optional<quint64>(number) : std::nullopt;
+    };
+    for (const QStringView field : QStringView(cursor).split(QLatin1Char(';'))) {
+        if (field.size() < 2 || field.at(1) != QLatin1Char('=')) {
+            continue;
+        }
+        const QStringView value = field.sliced(2);
+        switch (field.at(0).toLatin1()) {
+        case 's':
+            info.mSeqnumId = value.toString();
+            break;
+        case 'i':
+            info.mSeqnum = parseHex(value);
+            break;
+        case 'b':
+            info.mBootId = value.toString();
+            break;
+        case 'm':
+            info.mMonotonicUsec = parseHex(value);
+            break;
+        case 't':
+            info.mRealtimeUsec = parseHex(value);
+            break;
+        }
+    }
+    return info;
+}
+
 QString JournaldHelper::mapField(Field field)
 {
     static QMetaEnum metaEnum = QMetaEnum::fromType<JournaldHelper::Field>();
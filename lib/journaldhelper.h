@@ -12,6 +12,7 @@
 #include <QObject>
 #include <QVector>
 #include <ijournal.h>
+#include <optional>
 
 class KJOURNALD_EXPORT JournaldHelper
 {
@@ -26,6 +27,19 @@ public:
         QDateTime mUntil; //!< time of newest log entry for the specific boot
     };
 
+    /**
+     * @brief Position information that is encoded in a journal cursor
+     *
+     * Example cursor: "s=c485fef5d17c4272a4a539c4e4708f9e;i=191;b=68f2e61d061247d8a8ba0b8d53a97a52;m=3dce1a;t=5bd6c979f361b;x=766655f78763a257"
+     */
+    struct CursorInfo {
+        QString mSeqnumId; //!< ID of the sequence number space, field "s"
+        std::optional<quint64> mSeqnum; //!< sequence number of entry, field "i"
+        QString mBootId; //!< boot ID of entry, field "b"
+        std::optional<quint64> mMonotonicUsec; //!< monotonic timestamp in microseconds, field "m"
+        std::optional<quint64> mRealtimeUsec; //!< realtime timestamp in microseconds, field "t"
+    };
+
     /**
      * @brief Enumeration of most prominent field contents
      *
@@ -60,11 +74,12 @@ public:
      * This method returns all unique values provided by a defined journald database
      * field, e.g. the list of all boot-ids or the list of all services.
      *
-     * This method wraps sd_journal_query_unique, which according to its documentation
-     * ignores any add_match settings of the used @a journal. Yet this may change in the
-     * future and it is encouraged to use a separate journal object to request unique valus.
+     * This method wraps IJournal::queryUnique, which for sd_journal objects according to
+     * the documentation of sd_journal_query_unique ignores any add_match settings of the
+     * used @a journal. Yet this may change in the future and it is encouraged to use a
+     * separate journal object to request unique valus.
      *
-     * @param journal the wrapper object for an sd_journal instance
+     * @param journal the journal object
      * @param field the requested field
      * @return the list of unique field contents
      */
@@ -78,9 +93,40 @@ public:
     /**
      * @brief Query boot information for @p journal
      *
+     * Boots are queried in parallel by clones of @p journal, see IJournal::clone(), with up to
+     * QThread::idealThreadCount() journal objects.
+     *
+     * @note this call replaces the filter of @p journal and moves its current entry
+     * @return ordered list of boots (first is earliest boot in time)
+     */
+    static QVector<BootInfo> queryOrderedBootIds(IJournal &journal);
+
+    /**
+     * @brief Query boot information for @p journal with up to @p threads journal objects in parallel
+     *
+     * @note this call replaces the filter of @p journal and moves its current entry
      * @return ordered list of boots (first is earliest boot in time)
      */
-    static QVector<BootInfo> queryOrderedBootIds(const IJournal &journal);
+    static QVector<BootInfo> queryOrderedBootIds(IJournal &journal, int threads);
+
+    /**
+     * @brief Query first and last entry of boot @p bootId
+     *
+     * @note this call replaces the filter of @p journal and moves its current entry
+     * @return boot information or std::nullopt if the boot has no entries
+     */
+    static std::optional<BootInfo> queryBoot(IJournal &journal, const QString &bootId);
+
+    /**
+     * @brief Parse the position fields of a journal cursor
+     *
+     * Cursors are opaque by documentation, yet their fields allow to find the closest position in a journal
+     * when the entry itself does not exist anymore. Fields that are missing or malformed are left empty.
+     *
+     * @param cursor the cursor as obtained by sd_journal_get_cursor
+     * @return parsed cursor fields
+     */
+    static CursorInfo parseCursor(const QString &cursor);
 
     /**
      * @brief Mapper method that maps from field enum to textual representation
@@ -96,6 +142,8 @@ public:
      * @return cleaned string
      */
     static QString cleanupString(const QString &string);
+
+    static constexpr int sMinBootsPerThread{8}; //!< minimal number of boots that justify another journal object
 };
 
 QDebug operator<<(QDebug debug, const JournaldHelper::BootInfo &bootInfo);
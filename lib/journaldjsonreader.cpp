@@ -0,0 +1,561 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "journaldjsonreader.h"
+#include "journaldjsonreader_p.h"
+#include "kjournaldlib_log_general.h"
+#include <QDebug>
+#include <QFileDevice>
+#include <QIODevice>
+#include <cstring>
+
+namespace
+{
+/**
+ * @return value of the four hex digits at @p position or -1 if they are no hex digits
+ */
+int parseHexUnit(const char *position)
+{
+    int value{0};
+    for (int i = 0; i < 4; ++i) {
+        const char c = position[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') {
+            value |= c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            value |= c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            value |= c - 'A' + 10;
+        } else {
+            return -1;
+        }
+    }
+    return value;
+}
+
+void appendUtf8(QByteArray &buffer, char32_t codePoint)
+{
+    if (codePoint < 0x80) {
+        buffer.append(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        buffer.append(static_cast<char>(0xC0 | (codePoint >> 6)));
+        buffer.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        buffer.append(static_cast<char>(0xE0 | (codePoint >> 12)));
+        buffer.append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        buffer.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+        buffer.append(static_cast<char>(0xF0 | (codePoint >> 18)));
+        buffer.append(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        buffer.append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        buffer.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+}
+
+void JournaldJsonReaderPrivate::load(QIODevice *device)
+{
+    if (!device || (!device->isOpen() && !device->open(QIODevice::ReadOnly))) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Could not open device for reading";
+        return;
+    }
+    if (device->isSequential()) {
+        mStreamDevice = device;
+        return;
+    }
+    if (auto file = qobject_cast<QFileDevice *>(device); file && file->size() > 0) {
+        if (const uchar *data = file->map(0, file->size())) {
+            mData = reinterpret_cast<const char *>(data);
+            mSize = file->size();
+            return;
+        }
+        qCDebug(KJOURNALDLIB_GENERAL) << "Could not map file, falling back to reading" << file->fileName();
+    }
+    mBuffer = device->readAll();
+    mData = mBuffer.constData();
+    mSize = mBuffer.size();
+}
+
+// Format description: <https://systemd.io/JOURNAL_EXPORT_FORMATS/#journal-json-format>
+// - Each entry is a JSON object, "journalctl -o json" prints one object per line, "-o json-pretty" spreads
+//   objects over several lines and "-o json-seq" prefixes each object with an ASCII record separator.
+// - Field values are strings if they are valid and printable UTF-8, otherwise arrays of byte values.
+// - Fields that occur multiple times in an entry are arrays of such values.
+// - Values that exceed the field size limit of journalctl are null.
+// - Like in the export format, __CURSOR, __REALTIME_TIMESTAMP and __MONOTONIC_TIMESTAMP are serialized
+//   like fields and timestamps are strings with decimal numbers.
+
+JournaldJsonReaderPrivate::Status JournaldJsonReaderPrivate::parseEntry(const char *begin, const char *end, const char *&entryEnd)
+{
+    // capacities are kept, such that entries of similar size do not allocate
+    mScratch.truncate(0);
+    mSlices.resize(0);
+
+    const char *position = skipWhitespace(begin, end);
+    if (position == end) {
+        return Status::INCOMPLETE;
+    }
+    if (*position != '{') {
+        return Status::MALFORMED;
+    }
+    position = skipWhitespace(position + 1, end);
+    if (position == end) {
+        return Status::INCOMPLETE;
+    }
+    bool closed = *position == '}';
+    if (closed) {
+        ++position;
+    }
+    while (!closed) {
+        if (*position != '"') {
+            return Status::MALFORMED;
+        }
+        Slice name;
+        if (const Status status = parseString(position, end, name); status != Status::SUCCESS) {
+            return status;
+        }
+        position = skipWhitespace(position, end);
+        if (position == end) {
+            return Status::INCOMPLETE;
+        }
+        if (*position != ':') {
+            return Status::MALFORMED;
+        }
+        position = skipWhitespace(position + 1, end);
+        if (const Status status = parseValue(name, position, end); status != Status::SUCCESS) {
+            return status;
+        }
+        position = skipWhitespace(position, end);
+        if (position == end) {
+            return Status::INCOMPLETE;
+        }
+        if (*position == ',') {
+            position = skipWhitespace(position + 1, end);
+            if (position == end) {
+                return Status::INCOMPLETE;
+            }
+        } else if (*position == '}') {
+            closed = true;
+            ++position;
+        } else {
+            return Status::MALFORMED;
+        }
+    }
+    entryEnd = position;
+
+    const auto view = [this](const Slice &slice) {
+        return slice.mInput ? QByteArrayView(slice.mInput, slice.mSize) : QByteArrayView(mScratch.constData() + slice.mOffset, slice.mSize);
+    };
+    mFields.resize(0);
+    mFields.reserve(mSlices.size());
+    for (const auto &[name, value] : std::as_const(mSlices)) {
+        mFields.append({view(name), view(value)});
+    }
+    return Status::SUCCESS;
+}
+
+JournaldJsonReaderPrivate::Status JournaldJsonReaderPrivate::parseValue(const Slice &name, const char *&position, const char *end)
+{
+    if (position == end) {
+        return Status::INCOMPLETE;
+    }
+    if (*position == '"') {
+        Slice value;
+        const Status status = parseString(position, end, value);
+        if (status == Status::SUCCESS) {
+            mSlices.append({name, value});
+        }
+        return status;
+    }
+    if (*position == '[') {
+        const char *current = skipWhitespace(position + 1, end);
+        if (current == end) {
+            return Status::INCOMPLETE;
+        }
+        if (*current != '"' && *current != '[') {
+            Slice value;
+            const Status status = parseByteArray(current, end, value);
+            if (status == Status::SUCCESS) {
+                mSlices.append({name, value});
+                position = current;
+            }
+            return status;
+        }
+        // field with multiple values, each value is a string or an array of bytes
+        while (true) {
+            Slice value;
+            Status status{Status::MALFORMED};
+            if (*current == '"') {
+                status = parseString(current, end, value);
+            } else if (*current == '[') {
+                ++current;
+                status = parseByteArray(current, end, value);
+            }
+            if (status != Status::SUCCESS) {
+                return status;
+            }
+            mSlices.append({name, value});
+            current = skipWhitespace(current, end);
+            if (current == end) {
+                return Status::INCOMPLETE;
+            }
+            if (*current == ']') {
+                position = current + 1;
+                return Status::SUCCESS;
+            }
+            if (*current != ',') {
+                return Status::MALFORMED;
+            }
+            current = skipWhitespace(current + 1, end);
+            if (current == end) {
+                return Status::INCOMPLETE;
+            }
+        }
+    }
+    if (*position == 'n') {
+        // value was omitted by journalctl, the field is skipped
+        if (end - position < 4) {
+            return Status::INCOMPLETE;
+        }
+        if (std::memcmp(position, "null", 4) != 0) {
+            return Status::MALFORMED;
+        }
+        position += 4;
+        return Status::SUCCESS;
+    }
+    if (*position == '-' || (*position >= '0' && *position <= '9')) {
+        // numbers are no output of journalctl, but are kept as they are written for hand-crafted input
+        const char *numberEnd = position;
+        while (numberEnd < end
+               && ((*numberEnd >= '0' && *numberEnd <= '9') || *numberEnd == '-' || *numberEnd == '+' || *numberEnd == '.' || *numberEnd == 'e'
+                   || *numberEnd == 'E')) {
+            ++numberEnd;
+        }
+        if (numberEnd == end) {
+            return Status::INCOMPLETE;
+        }
+        mSlices.append({name, Slice{position, 0, numberEnd - position}});
+        position = numberEnd;
+        return Status::SUCCESS;
+    }
+    return Status::MALFORMED;
+}
+
+JournaldJsonReaderPrivate::Status JournaldJsonReaderPrivate::parseString(const char *&position, const char *end, Slice &slice)
+{
+    const char *begin = position + 1;
+    const char *quote = static_cast<const char *>(std::memchr(begin, '"', end - begin));
+    if (!quote) {
+        return Status::INCOMPLETE;
+    }
+    const char *current = static_cast<const char *>(std::memchr(begin, '\\', quote - begin));
+    if (!current) {
+        // common case, the string is used in place
+        slice = Slice{begin, 0, quote - begin};
+        position = quote + 1;
+        return Status::SUCCESS;
+    }
+
+    const qsizetype offset = mScratch.size();
+    mScratch.append(begin, current - begin);
+    while (true) {
+        if (current == end) {
+            return Status::INCOMPLETE;
+        }
+        if (*current == '"') {
+            break;
+        }
+        if (*current != '\\') {
+            const char *run = current;
+            while (current < end && *current != '"' && *current != '\\') {
+                ++current;
+            }
+            mScratch.append(run, current - run);
+            continue;
+        }
+        if (end - current < 2) {
+            return Status::INCOMPLETE;
+        }
+        switch (current[1]) {
+        case '"':
+        case '\\':
+        case '/':
+            mScratch.append(current[1]);
+            break;
+        case 'b':
+            mScratch.append('\b');
+            break;
+        case 'f':
+            mScratch.append('\f');
+            break;
+        case 'n':
+            mScratch.append('\n');
+            break;
+        case 'r':
+            mScratch.append('\r');
+            break;
+        case 't':
+            mScratch.append('\t');
+            break;
+        case 'u': {
+            if (end - current < 6) {
+                return Status::INCOMPLETE;
+            }
+            const int unit = parseHexUnit(current + 2);
+            if (unit < 0) {
+                return Status::MALFORMED;
+            }
+            char32_t codePoint = unit;
+            if (unit >= 0xD800 && unit <= 0xDBFF) {
+                // high surrogate, which is combined with the following low surrogate
+                if (end - current < 12 && (end - current < 7 || current[6] == '\\')) {
+                    return Status::INCOMPLETE;
+                }
+                const int low = end - current >= 12 && current[6] == '\\' && current[7] == 'u' ? parseHexUnit(current + 8) : -1;
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    codePoint = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                    current += 6;
+                } else {
+                    codePoint = 0xFFFD;
+                }
+            } else if (unit >= 0xDC00 && unit <= 0xDFFF) {
+                codePoint = 0xFFFD;
+            }
+            appendUtf8(mScratch, codePoint);
+            current += 4;
+            break;
+        }
+        default:
+            return Status::MALFORMED;
+        }
+        current += 2;
+    }
+    slice = Slice{nullptr, offset, mScratch.size() - offset};
+    position = current + 1;
+    return Status::SUCCESS;
+}
+
+JournaldJsonReaderPrivate::Status JournaldJsonReaderPrivate::parseByteArray(const char *&position, const char *end, Slice &slice)
+{
+    const qsizetype offset = mScratch.size();
+    const char *current = skipWhitespace(position, end);
+    if (current < end && *current == ']') {
+        slice = Slice{nullptr, offset, 0};
+        position = current + 1;
+        return Status::SUCCESS;
+    }
+    while (true) {
+        if (current == end) {
+            return Status::INCOMPLETE;
+        }
+        if (*current < '0' || *current > '9') {
+            return Status::MALFORMED;
+        }
+        int value{0};
+        while (current < end && *current >= '0' && *current <= '9') {
+            value = value * 10 + (*current - '0');
+            if (value > 255) {
+                return Status::MALFORMED;
+            }
+            ++current;
+        }
+        mScratch.append(static_cast<char>(value));
+        current = skipWhitespace(current, end);
+        if (current == end) {
+            return Status::INCOMPLETE;
+        }
+        if (*current == ']') {
+            break;
+        }
+        if (*current != ',') {
+            return Status::MALFORMED;
+        }
+        current = skipWhitespace(current + 1, end);
+    }
+    slice = Slice{nullptr, offset, mScratch.size() - offset};
+    position = current + 1;
+    return Status::SUCCESS;
+}
+
+const char *JournaldJsonReaderPrivate::skipWhitespace(const char *position, const char *end)
+{
+    // 0x1E is the record separator of the json-seq format
+    while (position < end && (*position == ' ' || *position == '\n' || *position == '\r' || *position == '\t' || *position == '\x1e')) {
+        ++position;
+    }
+    return position;
+}
+
+bool JournaldJsonReaderPrivate::readNextStreaming()
+{
+    while (true) {
+        const char *begin = mBuffer.constData() + mBufferPosition;
+        const char *end = mBuffer.constData() + mBuffer.size();
+        const bool bufferConsumed = skipWhitespace(begin, end) == end;
+        const char *entryEnd{nullptr};
+        const Status status = bufferConsumed ? Status::INCOMPLETE : parseEntry(begin, end, entryEnd);
+        if (status == Status::SUCCESS) {
+            mPosition += entryEnd - begin;
+            mBufferPosition = entryEnd - mBuffer.constData();
+            return true;
+        }
+        if (status == Status::MALFORMED) {
+            qCWarning(KJOURNALDLIB_GENERAL) << "Malformed JSON entry at offset" << mPosition;
+            mError = true;
+            mFields.clear();
+            return false;
+        }
+        if (mStreamAtEnd) {
+            if (!bufferConsumed) {
+                qCWarning(KJOURNALDLIB_GENERAL) << "JSON entry is truncated at offset" << mPosition;
+            }
+            mFields.clear();
+            mError = !bufferConsumed;
+            return false;
+        }
+
+        // entry is incomplete, drop consumed data and append next block
+        mBuffer.remove(0, mBufferPosition);
+        mBufferPosition = 0;
+        const QByteArray block = mStreamDevice->read(sStreamBlockSize);
+        if (block.isEmpty() && !mStreamDevice->waitForReadyRead(-1)) {
+            mStreamAtEnd = true;
+            if (auto decompressionDevice = qobject_cast<DecompressionDevice *>(mStreamDevice); decompressionDevice && decompressionDevice->hasError()) {
+                mError = true;
+                mFields.clear();
+                return false;
+            }
+        }
+        mBuffer.append(block);
+    }
+}
+
+JournaldJsonReader::JournaldJsonReader(QIODevice *device)
+    : d(new JournaldJsonReaderPrivate)
+{
+    d->load(device);
+}
+
+JournaldJsonReader::JournaldJsonReader(const QString &path)
+    : d(new JournaldJsonReaderPrivate)
+{
+    if (DecompressionDevice::isCompressed(path)) {
+        d->mDecompressionDevice = std::make_unique<DecompressionDevice>(path);
+        d->load(d->mDecompressionDevice.get());
+        return;
+    }
+    d->mFile = std::make_unique<QFile>(path);
+    d->load(d->mFile.get());
+}
+
+JournaldJsonReader::JournaldJsonReader(QByteArrayView data)
+    : d(new JournaldJsonReaderPrivate)
+{
+    d->mData = data.data();
+    d->mSize = data.size();
+}
+
+JournaldJsonReader::~JournaldJsonReader() = default;
+
+bool JournaldJsonReader::isJsonFile(const QString &path)
+{
+    const bool compressed = DecompressionDevice::isCompressed(path);
+    const QString name = compressed ? path.left(path.lastIndexOf(QChar::fromLatin1('.'))) : path;
+    for (const auto &extension : {QLatin1String(".json"), QLatin1String(".jsonl"), QLatin1String(".ndjson")}) {
+        if (name.endsWith(extension, Qt::CaseInsensitive)) {
+            return true;
+        }
+    }
+    if (compressed) {
+        return false;
+    }
+    // entries of the export format start with a field name
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray head = file.read(4096);
+    const char *end = head.constData() + head.size();
+    const char *begin = JournaldJsonReaderPrivate::skipWhitespace(head.constData(), end);
+    return begin < end && *begin == '{';
+}
+
+bool JournaldJsonReader::atEnd() const
+{
+    if (d->mError) {
+        return true;
+    }
+    if (d->mStreamDevice) {
+        const char *end = d->mBuffer.constData() + d->mBuffer.size();
+        const bool bufferConsumed = JournaldJsonReaderPrivate::skipWhitespace(d->mBuffer.constData() + d->mBufferPosition, end) == end;
+        return bufferConsumed && (d->mStreamAtEnd || d->mStreamDevice->atEnd());
+    }
+    return JournaldJsonReaderPrivate::skipWhitespace(d->mData + d->mPosition, d->mData + d->mSize) == d->mData + d->mSize;
+}
+
+bool JournaldJsonReader::readNext()
+{
+    d->mDecodedEntry.reset();
+    if (atEnd()) {
+        d->mFields.clear();
+        d->mPosition = d->mStreamDevice ? d->mPosition : d->mSize;
+        return false;
+    }
+    if (d->mStreamDevice) {
+        return d->readNextStreaming();
+    }
+    const char *entryEnd{nullptr};
+    const auto status = d->parseEntry(d->mData + d->mPosition, d->mData + d->mSize, entryEnd);
+    if (status != JournaldJsonReaderPrivate::Status::SUCCESS) {
+        if (status == JournaldJsonReaderPrivate::Status::INCOMPLETE) {
+            qCWarning(KJOURNALDLIB_GENERAL) << "JSON entry is truncated at offset" << d->mPosition;
+        } else {
+            qCWarning(KJOURNALDLIB_GENERAL) << "Malformed JSON entry at offset" << d->mPosition;
+        }
+        d->mError = true;
+        d->mFields.clear();
+        return false;
+    }
+    d->mPosition = entryEnd - d->mData;
+    return true;
+}
+
+bool JournaldJsonReader::hasError() const
+{
+    return d->mError;
+}
+
+qint64 JournaldJsonReader::position() const
+{
+    return d->mPosition;
+}
+
+const QVector<JournaldJsonReader::Field> &JournaldJsonReader::fields() const
+{
+    return d->mFields;
+}
+
+std::optional<QByteArrayView> JournaldJsonReader::fieldValue(QByteArrayView name) const
+{
+    for (const auto &field : std::as_const(d->mFields)) {
+        if (field.mName == name) {
+            return field.mValue;
+        }
+    }
+    return std::nullopt;
+}
+
+JournaldJsonReader::LogEntry JournaldJsonReader::entry() const
+{
+    if (!d->mDecodedEntry) {
+        LogEntry entry;
+        entry.reserve(d->mFields.size());
+        for (const auto &field : std::as_const(d->mFields)) {
+            entry.insert(QString::fromUtf8(field.mName), QString::fromUtf8(field.mValue));
+        }
+        d->mDecodedEntry = std::move(entry);
+    }
+    return *d->mDecodedEntry;
+}
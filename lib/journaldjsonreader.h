@@ -0,0 +1,116 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef JOURNALDJSONREADER_H
+#define JOURNALDJSONREADER_H
+
+#include "journaldexportreader.h"
+#include "kjournald_export.h"
+#include <QByteArrayView>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include <optional>
+
+class QIODevice;
+class JournaldJsonReaderPrivate;
+
+/**
+ * @brief Parser for the JSON output of journalctl
+ *
+ * The reader accepts the output of "journalctl -o json", i.e. one JSON object per entry, as well as the
+ * "json-pretty" and "json-seq" variants. It provides the same interface as JournaldExportReader, such
+ * that both formats are imported the same way, see MemoryJournal.
+ *
+ * The input is parsed in place without building a JSON document: field names and string values without
+ * escape sequences are views on the input data, only escaped strings and the array-of-bytes encoding that
+ * journalctl uses for binary fields are decoded into a buffer that is reused for all entries. Fields with
+ * multiple values are provided once per value and fields that journalctl omitted as null are skipped.
+ *
+ * Format description: <https://systemd.io/JOURNAL_EXPORT_FORMATS/#journal-json-format>
+ */
+class KJOURNALD_EXPORT JournaldJsonReader : public QObject
+{
+    Q_OBJECT
+public:
+    using LogEntry = JournaldExportReader::LogEntry;
+
+    /**
+     * @brief Raw field of the current entry
+     * @note the views are valid until the next call of readNext()
+     */
+    using Field = JournaldExportReader::Field;
+
+    /**
+     * @brief Construct reader for @p device, which is opened for reading if not open yet
+     *
+     * File devices are mapped into memory, sequential devices are streamed block by block, other devices are
+     * read completely.
+     */
+    explicit JournaldJsonReader(QIODevice *device);
+
+    /**
+     * @brief Construct reader for the JSON file at @p path
+     *
+     * Plain files are mapped into memory, compressed files are decompressed in a worker thread while parsing.
+     */
+    explicit JournaldJsonReader(const QString &path);
+
+    /**
+     * @brief Construct reader for @p data, which must stay valid as long as the reader exists
+     */
+    explicit JournaldJsonReader(QByteArrayView data);
+
+    ~JournaldJsonReader() override;
+
+    /**
+     * @return true if the file at @p path contains journal entries in JSON format
+     *
+     * Files are recognized by the extensions ".json", ".jsonl" and ".ndjson" before an optional compression
+     * extension, uncompressed files also by the opening brace of their first entry.
+     */
+    static bool isJsonFile(const QString &path);
+
+    /**
+     * @return true if no further entry can be read
+     */
+    bool atEnd() const;
+
+    /**
+     * @brief Advance to the next entry
+     * @return true if an entry was read, false at the end of the input or on malformed input
+     */
+    bool readNext();
+
+    /**
+     * @return true if parsing stopped at malformed or truncated input
+     */
+    bool hasError() const;
+
+    /**
+     * @return number of bytes of the input that are parsed
+     */
+    qint64 position() const;
+
+    /**
+     * @return fields of the current entry in input order
+     */
+    const QVector<Field> &fields() const;
+
+    /**
+     * @return raw value of field @p name of the current entry or std::nullopt if the entry has no such field
+     */
+    std::optional<QByteArrayView> fieldValue(QByteArrayView name) const;
+
+    /**
+     * @return decoded fields of the current entry, the map is created on first access
+     */
+    LogEntry entry() const;
+
+private:
+    std::unique_ptr<JournaldJsonReaderPrivate> d;
+};
+#endif
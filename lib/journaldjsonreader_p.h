@@ -0,0 +1,93 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef JOURNALDJSONREADER_P_H
+#define JOURNALDJSONREADER_P_H
+
+#include "decompressiondevice.h"
+#include "journaldjsonreader.h"
+#include <QByteArray>
+#include <QFile>
+#include <QVector>
+#include <memory>
+#include <optional>
+#include <utility>
+
+class JournaldJsonReaderPrivate
+{
+public:
+    enum class Status {
+        SUCCESS,
+        INCOMPLETE, //!< input ends within the entry
+        MALFORMED,
+    };
+
+    /**
+     * decoded string that is either located in the input or, if mInput is nullptr, in mScratch
+     *
+     * Since mScratch may be reallocated while an entry is parsed, views are only created for complete entries.
+     */
+    struct Slice {
+        const char *mInput{nullptr};
+        qsizetype mOffset{0};
+        qsizetype mSize{0};
+    };
+
+    /**
+     * map @p device into memory if it is a file, stream sequential devices, otherwise read its complete content
+     */
+    void load(QIODevice *device);
+
+    /**
+     * @brief Parse the entry that starts at @p begin and provide its fields in mFields
+     * @param entryEnd is set to the position after the entry if it could be parsed
+     */
+    Status parseEntry(const char *begin, const char *end, const char *&entryEnd);
+
+    /**
+     * @brief Parse the value of field @p name at @p position and append one slice pair per value
+     */
+    Status parseValue(const Slice &name, const char *&position, const char *end);
+
+    /**
+     * @brief Parse the string that starts with a quote at @p position, escape sequences are decoded into mScratch
+     */
+    Status parseString(const char *&position, const char *end, Slice &slice);
+
+    /**
+     * @brief Parse an array of byte values at @p position, which is located after the opening bracket
+     */
+    Status parseByteArray(const char *&position, const char *end, Slice &slice);
+
+    /**
+     * @return first position at or after @p position that is no whitespace or json-seq record separator
+     */
+    static const char *skipWhitespace(const char *position, const char *end);
+
+    /**
+     * readNext() implementation that reads the input from a sequential device block by block
+     */
+    bool readNextStreaming();
+
+    std::unique_ptr<QFile> mFile; //!< only set if the reader opened the file itself
+    std::unique_ptr<DecompressionDevice> mDecompressionDevice; //!< only set if the reader opened a compressed file itself
+    QByteArray mBuffer; //!< content of devices that cannot be mapped
+    const char *mData{nullptr};
+    qint64 mSize{0};
+    qint64 mPosition{0};
+    bool mError{false};
+    QByteArray mScratch; //!< decoded values of the current entry, capacity is kept for the following entries
+    QVector<std::pair<Slice, Slice>> mSlices; //!< names and values of the current entry
+    QVector<JournaldJsonReader::Field> mFields;
+    mutable std::optional<JournaldJsonReader::LogEntry> mDecodedEntry;
+
+    // streaming mode, in which mBuffer contains a window of the input
+    static constexpr qint64 sStreamBlockSize{1024 * 1024};
+    QIODevice *mStreamDevice{nullptr};
+    qint64 mBufferPosition{0}; //!< start of next entry in mBuffer
+    bool mStreamAtEnd{false};
+};
+
+#endif // JOURNALDJSONREADER_P_H
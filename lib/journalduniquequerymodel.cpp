@@ -7,11 +7,18 @@
 #include "journalduniquequerymodel_p.h"
 #include "kjournald_export.h"
 #include "kjournaldlib_log_general.h"
+#include "localjournal.h"
 #include <QDebug>
 #include <QDir>
 #include <QString>
+#include <QtConcurrent>
 #include <memory>
 
+JournaldUniqueQueryModelPrivate::JournaldUniqueQueryModelPrivate(JournaldUniqueQueryModel *q)
+    : q(q)
+{
+}
+
 JournaldUniqueQueryModelPrivate::~JournaldUniqueQueryModelPrivate()
 {
     sd_journal_close(mJournal);
@@ -24,6 +31,15 @@ void JournaldUniqueQueryModelPrivate::closeJournal()
         sd_journal_close(mJournal);
         mJournal = nullptr;
     }
+    mPath.clear();
+    // a running query cannot be stopped, but its result is ignored
+    mMetadataWatcher.cancel();
+    mMetadata.reset();
+    mMetadataQueried = false;
+    if (mMetadataLoading) {
+        mMetadataLoading = false;
+        Q_EMIT q->loadingChanged();
+    }
 }
 
 bool JournaldUniqueQueryModelPrivate::openJournal()
@@ -64,10 +80,29 @@ bool JournaldUniqueQueryModelPrivate::openJournalFromPath(const QString &path)
             return false;
         }
     }
+    mPath = path;
 
     return true;
 }
 
+bool JournaldUniqueQueryModelPrivate::isCachedField() const
+{
+    return mFieldString == JournaldHelper::mapField(JournaldHelper::Field::_SYSTEMD_UNIT)
+        || mFieldString == JournaldHelper::mapField(JournaldHelper::Field::_EXE);
+}
+
+void JournaldUniqueQueryModelPrivate::loadMetadata()
+{
+    mMetadataQueried = true;
+    mMetadataLoading = true;
+    // the journal object is created and deleted by the worker thread, the result is shared with other models
+    mMetadataWatcher.setFuture(QtConcurrent::run([path = mPath]() {
+        const std::unique_ptr<LocalJournal> journal = path.isEmpty() ? std::make_unique<LocalJournal>() : std::make_unique<LocalJournal>(path);
+        return JournalMetadataCache::shared(*journal);
+    }));
+    Q_EMIT q->loadingChanged();
+}
+
 void JournaldUniqueQueryModelPrivate::runQuery()
 {
     if (!mJournal || mFieldString.isEmpty()) {
@@ -75,6 +110,24 @@ void JournaldUniqueQueryModelPrivate::runQuery()
     }
     mEntries.clear();
 
+    // unique values of archived files do not change and are read from the cache
+    if (isCachedField()) {
+        if (!mMetadataQueried) {
+            loadMetadata();
+        }
+        if (mMetadataLoading) {
+            // values are inserted once the metadata is loaded
+            return;
+        }
+        if (mMetadata) {
+            const QVector<QString> &values = mFieldString == JournaldHelper::mapField(JournaldHelper::Field::_EXE) ? mMetadata->mExes : mMetadata->mUnits;
+            for (const QString &value : values) {
+                mEntries << std::pair<QString, bool>{JournaldHelper::cleanupString(value), true};
+            }
+            return;
+        }
+    }
+
     QVector<std::pair<QString, bool>> dataList;
     const void *data;
     size_t length;
@@ -103,20 +156,36 @@ void JournaldUniqueQueryModelPrivate::runQuery()
 
 JournaldUniqueQueryModel::JournaldUniqueQueryModel(QObject *parent)
     : QAbstractItemModel(parent)
-    , d(new JournaldUniqueQueryModelPrivate)
+    , d(new JournaldUniqueQueryModelPrivate(this))
 {
+    connect(&d->mMetadataWatcher, &QFutureWatcherBase::finished, this, &JournaldUniqueQueryModel::handleMetadataLoaded);
     d->openJournal();
     d->runQuery();
 }
 
 JournaldUniqueQueryModel::JournaldUniqueQueryModel(const QString &journalPath, QObject *parent)
     : QAbstractItemModel(parent)
-    , d(new JournaldUniqueQueryModelPrivate)
+    , d(new JournaldUniqueQueryModelPrivate(this))
 {
+    connect(&d->mMetadataWatcher, &QFutureWatcherBase::finished, this, &JournaldUniqueQueryModel::handleMetadataLoaded);
     d->openJournalFromPath(journalPath);
     d->runQuery();
 }
 
+void JournaldUniqueQueryModel::handleMetadataLoaded()
+{
+    // canceled queries belong to a replaced journal
+    if (d->mMetadataWatcher.isCanceled()) {
+        return;
+    }
+    beginResetModel();
+    d->mMetadata = d->mMetadataWatcher.result();
+    d->mMetadataLoading = false;
+    d->runQuery();
+    endResetModel();
+    Q_EMIT loadingChanged();
+}
+
 JournaldUniqueQueryModel::~JournaldUniqueQueryModel() = default;
 
 bool JournaldUniqueQueryModel::setJournaldPath(const QString &path)
@@ -149,6 +218,11 @@ QString JournaldUniqueQueryModel::fieldString() const
     return d->mFieldString;
 }
 
+bool JournaldUniqueQueryModel::isLoading() const
+{
+    return d->mMetadataLoading;
+}
+
 QHash<int, QByteArray> JournaldUniqueQueryModel::roleNames() const
 {
     QHash<int, QByteArray> roles;
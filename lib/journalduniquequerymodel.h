@@ -24,12 +24,19 @@ class JournaldUniqueQueryModelPrivate;
  * The model can be create from an arbitrary local journald database by defining a path or from the
  * system's default journal. Values can either be set by @a setFieldString for arbitrary values or in a
  * typesafe manner via @a setField for most common fields.
+ *
+ * Values of "_SYSTEMD_UNIT" and "_EXE" are read from JournalMetadataCache in a worker thread and inserted
+ * by a model reset once they are loaded, see isLoading().
  */
 class KJOURNALD_EXPORT JournaldUniqueQueryModel : public QAbstractItemModel
 {
     Q_OBJECT
     Q_PROPERTY(QString journalPath WRITE setJournaldPath RESET setSystemJournal)
     Q_PROPERTY(QString field WRITE setFieldString)
+    /**
+     * true while the values of the field are read in the background
+     **/
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged)
 
 public:
     enum Roles {
@@ -93,6 +100,11 @@ public:
      */
     QString fieldString() const;
 
+    /**
+     * @return true while the values of the field are read in the background
+     */
+    bool isLoading() const;
+
     /**
      * @copydoc QAbstractItemModel::rolesNames()
      */
@@ -128,7 +140,15 @@ public:
      */
     Q_INVOKABLE bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
 
+Q_SIGNALS:
+    void loadingChanged();
+
 private:
+    /**
+     * Apply the metadata that was read in the background
+     */
+    void handleMetadataLoaded();
+
     std::unique_ptr<JournaldUniqueQueryModelPrivate> d;
 };
 
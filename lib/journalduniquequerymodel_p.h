@@ -6,22 +6,44 @@
 #ifndef JOURNALDUNIQUEQUERYMODEL_P_H
 #define JOURNALDUNIQUEQUERYMODEL_P_H
 
+#include "journalmetadatacache.h"
+#include <QFutureWatcher>
 #include <QString>
 #include <QVector>
 #include <memory>
+#include <optional>
 #include <systemd/sd-journal.h>
 
+class JournaldUniqueQueryModel;
+
 class JournaldUniqueQueryModelPrivate
 {
 public:
+    explicit JournaldUniqueQueryModelPrivate(JournaldUniqueQueryModel *q);
     ~JournaldUniqueQueryModelPrivate();
     void closeJournal();
     bool openJournal();
     bool openJournalFromPath(const QString &directory);
     void runQuery();
 
+    /**
+     * @return true if the unique values of mFieldString are provided by JournalMetadataCache
+     */
+    bool isCachedField() const;
+
+    /**
+     * start reading the metadata of the opened journal in a worker thread, runQuery() is applied again when done
+     */
+    void loadMetadata();
+
+    JournaldUniqueQueryModel *q;
     sd_journal *mJournal{nullptr};
+    QString mPath; //!< empty for the system journal
     QString mFieldString;
+    std::shared_ptr<const JournalMetadataCache::Metadata> mMetadata; //!< nullptr if the journal is not covered by the cache
+    QFutureWatcher<std::shared_ptr<const JournalMetadataCache::Metadata>> mMetadataWatcher;
+    bool mMetadataQueried{false}; //!< metadata was requested for the opened journal
+    bool mMetadataLoading{false}; //!< metadata was requested and is not applied yet
     QVector<std::pair<QString, bool>> mEntries;
 };
 
@@ -9,38 +9,29 @@
 #include "journaldviewmodel_p.h"
 #include "kjournaldlib_log_filtertrace.h"
 #include "kjournaldlib_log_general.h"
+#include "kjournaldlib_log_performance.h"
 #include "localjournal.h"
 #include <QColor>
 #include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QRandomGenerator>
 #include <QThread>
 #include <algorithm>
 #include <iterator>
+#include <limits>
 
-void JournaldViewModelPrivate::resetJournal()
+JournaldViewModelPrivate::JournaldViewModelPrivate()
 {
-    if (!mJournal->isValid()) {
-        qCWarning(KJOURNALDLIB_GENERAL) << "Skipping seek head, no valid journal open";
-        return;
-    }
-
-    int result{0};
-
-    // reset all filters
-    sd_journal_flush_matches(mJournal->sdJournal());
-
-    qCDebug(KJOURNALDLIB_FILTERTRACE) << "flush_matches()";
+    // all journal wakeups within one frame are coalesced into a single read
+    mFollowTimer.setSingleShot(true);
+    mFollowTimer.setTimerType(Qt::PreciseTimer);
+    mFollowTimer.setInterval(sFollowCoalescingInterval);
+}
 
-    // filter construction:
-    // The Journald API does not provide arbitrary logical phrases, but a 4 level syntax,
-    // see: https://www.freedesktop.org/software/systemd/man/sd_journal_add_match.html
-    // 1. level: AND, via add_conjunction (separates terms via AND)
-    // 2. level: OR, via add_disjunction (separates terms via OR or AND)
-    // 3: level: AND, via multiple add_match(...) in one term with different fields that are considered as AND combination
-    // 4: level: OR, via multiple add_match(...) in one term with same field that are considered as OR combination
-    //
+FilterExpression JournaldViewModelPrivate::createBaseFilterExpression() const
+{
     // The following boolean expression is created as follow for kernel transport option:
     //     (boot=123 OR boot=...)
     //     AND (priority=1 OR priority=...)
@@ -50,163 +41,109 @@ void JournaldViewModelPrivate::resetJournal()
     //     AND (priority=1 OR priority=...)
     //     AND (transport=not-kernel)
     //     AND (unit_1 OR unit_2 OR ...) OR (exe=x OR exe=y OR ...)
+    // Empty lists do not add any constraint, see FilterExpression.
 
-    // filter boots
-    for (const QString &boot : qAsConst(mBootFilter)) {
-        QString filterExpression = QLatin1String("_BOOT_ID=") + boot;
-        result = sd_journal_add_match(mJournal->sdJournal(), filterExpression.toLocal8Bit().constData(), 0);
-        qCDebug(KJOURNALDLIB_FILTERTRACE).nospace() << "add_match(" << filterExpression << ")";
-        if (result < 0) {
-            qCCritical(KJOURNALDLIB_GENERAL) << "Failed to set journal filter:" << strerror(-result) << filterExpression;
-        }
-    }
+    QStringList priorities;
     if (mPriorityFilter.has_value()) {
-        for (int i = 0; i <= mPriorityFilter; ++i) {
-            QString filterExpression = QLatin1String("PRIORITY=") + QString::number(i);
-            result = sd_journal_add_match(mJournal->sdJournal(), filterExpression.toLocal8Bit().constData(), 0);
-            qCDebug(KJOURNALDLIB_FILTERTRACE).nospace() << "add_match(" << filterExpression << ")";
-            if (result < 0) {
-                qCCritical(KJOURNALDLIB_GENERAL) << "Failed to set journal filter:" << strerror(-result) << filterExpression;
-            }
+        for (int i = 0; i <= mPriorityFilter.value(); ++i) {
+            priorities.append(QString::number(i));
         }
         qCDebug(KJOURNALDLIB_GENERAL) << "Use priority filter level:" << mPriorityFilter.value();
     } else {
         qCDebug(KJOURNALDLIB_GENERAL) << "Skip setting priority filter";
     }
 
-    // boot and priority filter shall always be enforced
-    result = sd_journal_add_conjunction(mJournal->sdJournal());
-    qCDebug(KJOURNALDLIB_FILTERTRACE).nospace() << "add_conjunction()";
-    Q_ASSERT(result >= 0);
-
     // see journal-fields documentation regarding list of valid transports
     // note: in case of kernel messages being activated, this filter automatically activates all kernel transport
     //       because kernel output will not match any further service/exe filter
-    QStringList kernelTransports{QLatin1String("audit"), QLatin1String("driver"), QLatin1String("kernel")};
-    QStringList nonKernelTransports{QLatin1String("syslog"), QLatin1String("journal"), QLatin1String("stdout")};
+    static const QStringList kernelTransports{QLatin1String("audit"), QLatin1String("driver"), QLatin1String("kernel")};
+    static const QStringList nonKernelTransports{QLatin1String("syslog"), QLatin1String("journal"), QLatin1String("stdout")};
+
+    const FilterExpression units = FilterExpression::matchAny(QLatin1String("_SYSTEMD_UNIT"), mSystemdUnitFilter);
+    const FilterExpression executables = FilterExpression::matchAny(QLatin1String("_EXE"), mExeFilter);
+    FilterExpression sources;
     if (mShowKernelMessages) {
-        for (const QString &transport : kernelTransports) {
-            QString filterExpression = QLatin1String("_TRANSPORT=") + transport;
-            result = sd_journal_add_match(mJournal->sdJournal(), filterExpression.toLocal8Bit().constData(), 0);
-            qCDebug(KJOURNALDLIB_FILTERTRACE).nospace() << "add_match(" << filterExpression << ")";
-            if (result < 0) {
-                qCCritical(KJOURNALDLIB_GENERAL) << "Failed to set journal filter:" << strerror(-result) << filterExpression;
-            }
-        }
-        result = sd_journal_add_disjunction(mJournal->sdJournal());
-        Q_ASSERT(result >= 0);
+        sources = FilterExpression::anyOf({FilterExpression::matchAny(QLatin1String("_TRANSPORT"), kernelTransports), units, executables});
     } else {
-        for (const QString &transport : nonKernelTransports) {
-            QString filterExpression = QLatin1String("_TRANSPORT=") + transport;
-            result = sd_journal_add_match(mJournal->sdJournal(), filterExpression.toLocal8Bit().constData(), 0);
-            qCDebug(KJOURNALDLIB_FILTERTRACE).nospace() << "add_match(" << filterExpression << ")";
-            if (result < 0) {
-                qCCritical(KJOURNALDLIB_GENERAL) << "Failed to set journal filter:" << strerror(-result) << filterExpression;
-            }
-        }
-        result = sd_journal_add_conjunction(mJournal->sdJournal());
-        Q_ASSERT(result >= 0);
+        sources = FilterExpression::allOf(
+            {FilterExpression::matchAny(QLatin1String("_TRANSPORT"), nonKernelTransports), FilterExpression::anyOf({units, executables})});
     }
 
-    // filter units
-    for (const QString &unit : qAsConst(mSystemdUnitFilter)) {
-        QString filterExpression = QLatin1String("_SYSTEMD_UNIT=") + unit;
-        result = sd_journal_add_match(mJournal->sdJournal(), filterExpression.toLocal8Bit().constData(), 0);
-        qCDebug(KJOURNALDLIB_FILTERTRACE).nospace() << "add_match(" << filterExpression << ")";
-        if (result < 0) {
-            qCCritical(KJOURNALDLIB_GENERAL) << "Failed to set journal filter:" << strerror(-result) << filterExpression;
-        }
+    return FilterExpression::allOf({
+        FilterExpression::matchAny(QLatin1String("_BOOT_ID"), mBootFilter),
+        FilterExpression::matchAny(QLatin1String("PRIORITY"), priorities),
+        sources,
+    });
+}
+
+void JournaldViewModelPrivate::resetJournal()
+{
+    if (!mJournal->isValid()) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Skipping seek head, no valid journal open";
+        return;
     }
 
-    result = sd_journal_add_disjunction(mJournal->sdJournal());
-    Q_ASSERT(result >= 0);
+    // indexable parts of the filter are pushed down to journald, see FilterExpression regarding its normalization,
+    // and the remaining predicates are evaluated while reading entries
+    const FilterExpression filter = FilterExpression::allOf({createBaseFilterExpression(), mFilterExpression});
+    mJournal->prepareQuery(filter);
+    mQueryFilter = filter;
 
-    // filter executable
-    for (const QString &executable : qAsConst(mExeFilter)) {
-        QString filterExpression = QLatin1String("_EXE=") + executable;
-        result = sd_journal_add_match(mJournal->sdJournal(), filterExpression.toLocal8Bit().constData(), 0);
-        qCDebug(KJOURNALDLIB_FILTERTRACE).nospace() << "add_match(" << filterExpression << ")";
-        if (result < 0) {
-            qCCritical(KJOURNALDLIB_GENERAL) << "Failed to set journal filter:" << strerror(-result) << filterExpression;
-        }
-    }
+    // replaces all filters of the previous query
+    mJournal->setFilter(filter);
+    mResidualFilter = ResidualFilter(filter.residualPart());
 
     qCDebug(KJOURNALDLIB_FILTERTRACE).nospace() << "Filter DONE";
+    discardFollowBuffer();
+    mHeadSkipCursor.clear();
+    mTailSkipCursor.clear();
     mTailCursorReached = false;
     seekHeadAndMakeCurrent();
+    startPrefetch(0);
     // clear all data which are in limbo with new head
     mLog.clear();
 }
 
+void JournaldViewModelPrivate::startPrefetch(quint64 viewportRealtimeUsec)
+{
+    // without a selected boot or time range, the view is backed by the whole journal, which is too large to prefetch
+    if (!mPrefetchEnabled || (!mQueryFilter.requiredValues(QLatin1String("_BOOT_ID")) && !mQueryFilter.requiredRange(QLatin1String("__REALTIME_TIMESTAMP")))) {
+        mPrefetcher.cancel();
+        return;
+    }
+    mPrefetcher.prefetch(JournalFileHeader::select(mJournal->queryFiles(), mQueryFilter), viewportRealtimeUsec);
+}
+
 QVector<LogEntry> JournaldViewModelPrivate::readEntries(Direction direction)
 {
-    static QMutex mutex;
-    QMutexLocker locker(&mutex);
+    QMutexLocker locker(&mReadMutex);
 
-    int result{0};
-    QVector<LogEntry> chunk;
     if (!mJournal->isValid()) {
         qCWarning(KJOURNALDLIB_GENERAL) << "Skipping data fetch, no valid journal opened";
-        return chunk;
+        return {};
     }
     if (direction == Direction::TOWARDS_TAIL) {
-        if (mLog.size() > 0) {
-            QString cursor = mLog.last().mCursor;
-            // note: seek cursor does not make it current, but a subsequenct sd_journal_next is required
-            result = sd_journal_seek_cursor(mJournal->sdJournal(), cursor.toLocal8Bit().constData());
-            if (result < 0) {
-                qCWarning(KJOURNALDLIB_GENERAL) << "seeking cursor but could not be found" << strerror(-result);
-            }
-            result = sd_journal_next(mJournal->sdJournal());
-            if (result == 0) {
-                mTailCursorReached = true;
-                return {};
-            }
-            result = sd_journal_test_cursor(mJournal->sdJournal(), cursor.toLocal8Bit().constData());
-            if (result <= 0) {
-                qCCritical(KJOURNALDLIB_GENERAL) << "current position does not match expected cursor:" << cursor;
-                if (result < 0) {
-                    qCCritical(KJOURNALDLIB_GENERAL) << "cursor test failed:" << strerror(-result);
-                }
-                return {};
-            }
-            // read first entry after cursor
-            result = sd_journal_next(mJournal->sdJournal());
-            if (result == 0) {
-                mTailCursorReached = true;
+        if (const QString cursor = tailReadCursor(); !cursor.isEmpty()) {
+            if (!seekBesideCursorAndMakeCurrent(cursor, direction)) {
                 return {};
             }
+        } else if (!mHeadSkipCursor.isEmpty()) {
+            // reading started at tail and all entries up to the skipped ones do not match
+            return {};
         } else {
             if (!seekHeadAndMakeCurrent()) {
                 return {};
             }
         }
     } else if (direction == Direction::TOWARDS_HEAD) {
-        if (mLog.size() > 0) {
-            QString cursor = mLog.first().mCursor;
-            result = sd_journal_seek_cursor(mJournal->sdJournal(), cursor.toLocal8Bit().constData());
-            if (result < 0) {
-                qCWarning(KJOURNALDLIB_GENERAL) << "seeking cursor but could not be found" << strerror(-result);
-            }
-            result = sd_journal_previous(mJournal->sdJournal());
-            if (result == 0) {
-                mHeadCursorReached = true;
-                return {};
-            }
-            result = sd_journal_test_cursor(mJournal->sdJournal(), cursor.toLocal8Bit().constData());
-            if (result <= 0) {
-                qCCritical(KJOURNALDLIB_GENERAL) << "current position does not match expected cursor:" << cursor;
-                if (result < 0) {
-                    qCCritical(KJOURNALDLIB_GENERAL) << "cursor test failed:" << strerror(-result);
-                }
-                return {};
-            }
-            // read first entry before cursor
-            result = sd_journal_previous(mJournal->sdJournal());
-            if (result == 0) {
-                mHeadCursorReached = true;
+        if (mLog.size() > 0 || !mHeadSkipCursor.isEmpty()) {
+            QString cursor = !mHeadSkipCursor.isEmpty() ? mHeadSkipCursor : mLog.first().mCursor;
+            if (!seekBesideCursorAndMakeCurrent(cursor, direction)) {
                 return {};
             }
+        } else if (!mTailSkipCursor.isEmpty()) {
+            // reading started at head and all entries up to the skipped ones do not match
+            return {};
         } else {
             if (!seekTailAndMakeCurrent()) {
                 return {};
@@ -218,87 +155,353 @@ QVector<LogEntry> JournaldViewModelPrivate::readEntries(Direction direction)
     }
 
     // at this point, the journal is guaranteed to point to the first valid entry
-    for (int counter = 0; counter < mChunkSize; ++counter) {
-        char *data{nullptr};
-        size_t length;
-        uint64_t time;
-        int result{1};
-        LogEntry entry;
-        result = sd_journal_get_realtime_usec(mJournal->sdJournal(), &time);
-        if (result == 0) {
-            entry.mDate.setMSecsSinceEpoch(time / 1000);
-        }
-        sd_id128_t bootId; // currently unused
-        result = sd_journal_get_monotonic_usec(mJournal->sdJournal(), &time, &bootId);
-        if (result == 0) {
-            entry.mMonotonicTimestamp = time;
-        }
-        result = sd_journal_get_data(mJournal->sdJournal(), "MESSAGE", (const void **)&data, &length);
+    return readEntriesFromCurrent(direction);
+}
+
+QVector<LogEntry> JournaldViewModelPrivate::readEntriesFromCursor(const QString &cursor)
+{
+    QMutexLocker locker(&mReadMutex);
+    if (!mJournal->isValid()) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Skipping data fetch, no valid journal opened";
+        return {};
+    }
+    mHeadSkipCursor.clear();
+    mTailSkipCursor.clear();
+    bool positioned{false};
+    if (!mJournal->seekCursor(cursor)) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "seeking cursor but could not be found" << cursor;
+    } else {
+        const int result = mJournal->next();
         if (result == 0) {
-            entry.mMessage = QString::fromUtf8(data, length).section(QChar::fromLatin1('='), 1);
+            mTailCursorReached = true;
+            return {};
         }
-        result = sd_journal_get_data(mJournal->sdJournal(), "MESSAGE_ID", (const void **)&data, &length);
-        if (result == 0) {
-            entry.mId = QString::fromUtf8(data, length).section(QChar::fromLatin1('='), 1);
+        // if the entry does not exist anymore, journald positions at the closest remaining entry
+        positioned = result > 0
+            && (mJournal->testCursor(cursor)
+                || isCurrentEntryBeyond(JournaldHelper::parseCursor(cursor), Direction::TOWARDS_TAIL));
+    }
+    if (!positioned && !seekRealtimeAndMakeCurrent(JournaldHelper::parseCursor(cursor), Direction::TOWARDS_TAIL)) {
+        return {};
+    }
+    return readEntriesFromCurrent(Direction::TOWARDS_TAIL);
+}
+
+bool JournaldViewModelPrivate::seekBesideCursorAndMakeCurrent(const QString &cursor, Direction direction)
+{
+    const auto step = [this, direction]() {
+        return direction == Direction::TOWARDS_TAIL ? mJournal->next() : mJournal->previous();
+    };
+    const auto markEndReached = [this, direction]() {
+        if (direction == Direction::TOWARDS_TAIL) {
+            mTailCursorReached = true;
+        } else {
+            mHeadCursorReached = true;
         }
-        result = sd_journal_get_data(mJournal->sdJournal(), "_SYSTEMD_UNIT", (const void **)&data, &length);
+    };
+
+    // note: seek cursor does not make it current, but a subsequent step is required
+    if (!mJournal->seekCursor(cursor)) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "seeking cursor but could not be found" << cursor;
+    } else {
+        int result = step();
         if (result == 0) {
-            entry.mSystemdUnit = JournaldHelper::cleanupString(QString::fromUtf8(data, length).section(QChar::fromLatin1('='), 1));
+            markEndReached();
+            return false;
         }
-        result = sd_journal_get_data(mJournal->sdJournal(), "_BOOT_ID", (const void **)&data, &length);
-        if (result == 0) {
-            entry.mBootId = QString::fromUtf8(data, length).section(QChar::fromLatin1('='), 1);
+        if (result > 0 && mJournal->testCursor(cursor)) {
+            // read first entry beside cursor
+            result = step();
+            if (result == 0) {
+                markEndReached();
+            }
+            return result > 0;
         }
-        result = sd_journal_get_data(mJournal->sdJournal(), "_EXE", (const void **)&data, &length);
-        if (result == 0) {
-            entry.mExe = QString::fromUtf8(data, length).section(QChar::fromLatin1('='), 1);
+        // the entry was removed by rotation or vacuuming and journald positioned at the closest
+        // surviving entry, which is only usable if it is located in reading direction
+        if (result > 0 && isCurrentEntryBeyond(JournaldHelper::parseCursor(cursor), direction)) {
+            qCDebug(KJOURNALDLIB_GENERAL) << "cursor entry vanished, re-anchored at closest surviving entry:" << cursor;
+            return true;
         }
-        result = sd_journal_get_data(mJournal->sdJournal(), "PRIORITY", (const void **)&data, &length);
-        if (result == 0) {
-            entry.mPriority = QString::fromUtf8(data, length).section(QChar::fromLatin1('='), 1).toInt();
+    }
+    return seekRealtimeAndMakeCurrent(JournaldHelper::parseCursor(cursor), direction);
+}
+
+bool JournaldViewModelPrivate::isCurrentEntryBeyond(const JournaldHelper::CursorInfo &anchor, Direction direction) const
+{
+    const QString cursor = mJournal->cursor();
+    if (cursor.isEmpty()) {
+        return false;
+    }
+    const JournaldHelper::CursorInfo current = JournaldHelper::parseCursor(cursor);
+
+    // sequence numbers are only comparable within the same sequence number space
+    if (!anchor.mSeqnumId.isEmpty() && anchor.mSeqnumId == current.mSeqnumId && anchor.mSeqnum && current.mSeqnum) {
+        return direction == Direction::TOWARDS_TAIL ? current.mSeqnum.value() > anchor.mSeqnum.value() : current.mSeqnum.value() < anchor.mSeqnum.value();
+    }
+    if (anchor.mRealtimeUsec && current.mRealtimeUsec) {
+        return direction == Direction::TOWARDS_TAIL ? current.mRealtimeUsec.value() >= anchor.mRealtimeUsec.value()
+                                                    : current.mRealtimeUsec.value() <= anchor.mRealtimeUsec.value();
+    }
+    return false;
+}
+
+bool JournaldViewModelPrivate::seekRealtimeAndMakeCurrent(const JournaldHelper::CursorInfo &anchor, Direction direction)
+{
+    if (!anchor.mRealtimeUsec) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Cannot re-anchor, cursor does not provide realtime timestamp";
+        return false;
+    }
+    // realtime seeking positions before the first entry with equal or later timestamp; entries with exactly the
+    // anchor's timestamp are skipped towards tail, because they cannot be distinguished from the anchor itself
+    const quint64 usec = direction == Direction::TOWARDS_TAIL ? anchor.mRealtimeUsec.value() + 1 : anchor.mRealtimeUsec.value();
+    if (!mJournal->seekRealtime(usec)) {
+        return false;
+    }
+    if (direction == Direction::TOWARDS_TAIL) {
+        if (mJournal->next() <= 0) {
+            mTailCursorReached = true;
+            return false;
         }
-        result = sd_journal_get_cursor(mJournal->sdJournal(), &data);
-        if (result == 0) {
-            entry.mCursor = QString::fromUtf8(data);
-            free(data);
+    } else {
+        if (mJournal->previous() <= 0) {
+            mHeadCursorReached = true;
+            return false;
         }
+    }
+    qCDebug(KJOURNALDLIB_GENERAL) << "re-anchored window by realtime timestamp" << anchor.mRealtimeUsec.value();
+    return true;
+}
 
-        if (direction == Direction::TOWARDS_TAIL) {
-            chunk.append(std::move(entry));
+bool JournaldViewModelPrivate::isCursorAvailable(const QString &cursor)
+{
+    QMutexLocker locker(&mReadMutex);
+    if (!mJournal->isValid() || !mJournal->seekCursor(cursor)) {
+        return false;
+    }
+    if (mJournal->next() <= 0) {
+        return false;
+    }
+    return mJournal->testCursor(cursor);
+}
+
+int JournaldViewModelPrivate::findAvailabilityBoundary(int first, int last, bool available)
+{
+    while (first < last) {
+        const int middle = first + (last - first) / 2;
+        if (isCursorAvailable(mLog.at(middle).mCursor) == available) {
+            last = middle;
         } else {
-            chunk.prepend(std::move(entry));
+            first = middle + 1;
+        }
+    }
+    return first;
+}
+
+QVector<LogEntry> JournaldViewModelPrivate::readEntriesFromCurrent(Direction direction)
+{
+    QElapsedTimer timer;
+    timer.start();
+    int result{0};
+    QVector<LogEntry> chunk;
+    QString &skipCursor = direction == Direction::TOWARDS_TAIL ? mTailSkipCursor : mHeadSkipCursor;
+    skipCursor.clear();
+    // entries that are rejected by the residual filter are skipped and reading continues until the chunk is filled
+    // or the skip budget is exhausted, such that rarely matching filters do not block the caller
+    int skippedEntries{0};
+    while (chunk.size() < static_cast<qsizetype>(mChunkSize)) {
+        if (mResidualFilter.matches(*mJournal)) {
+            if (direction == Direction::TOWARDS_TAIL) {
+                chunk.append(readEntry(*mJournal));
+            } else {
+                chunk.prepend(readEntry(*mJournal));
+            }
+        } else if (++skippedEntries >= sMaxSkippedEntries) {
+            skipCursor = mJournal->cursor();
+            qCDebug(KJOURNALDLIB_FILTERTRACE) << "skip budget exhausted, return partial chunk of" << chunk.size() << "entries";
+            break;
         }
 
         // obtain more data, 1 for success, 0 if reached end
         if (direction == Direction::TOWARDS_TAIL) {
-            result = sd_journal_next(mJournal->sdJournal());
+            result = mJournal->next();
             if (result == 0) {
                 mTailCursorReached = true;
                 qCDebug(KJOURNALDLIB_GENERAL) << "obtained journal until tail, stop reading";
                 break;
             }
         } else {
-            if (sd_journal_previous(mJournal->sdJournal()) <= 0) {
+            if (mJournal->previous() <= 0) {
                 mHeadCursorReached = true;
                 qCDebug(KJOURNALDLIB_GENERAL) << "obtained journal until head, stop reading";
                 break;
             }
         }
     }
+    if (skippedEntries > 0) {
+        qCDebug(KJOURNALDLIB_FILTERTRACE) << "residual filter skipped" << skippedEntries << "entries";
+    }
+    // comparing these latencies with and without prefetching shows the cold cache penalty that prefetching saves
+    qCDebug(KJOURNALDLIB_PERFORMANCE) << "Read chunk of" << chunk.size() << "entries in" << timer.nsecsElapsed() / 1000 << "us, prefetch"
+                                      << (!mPrefetchEnabled ? "disabled" : mPrefetcher.isRunning() ? "running" : "idle");
 
     return chunk;
 }
 
+LogEntry JournaldViewModelPrivate::readEntry(const IJournal &journal)
+{
+    const auto value = [&journal](QByteArrayView field) {
+        return QString::fromUtf8(journal.fieldValue(field).value_or(QByteArrayView()));
+    };
+    LogEntry entry;
+    entry.mRealtimeTimestamp = journal.realtimeUsec();
+    entry.mDate.setMSecsSinceEpoch(entry.mRealtimeTimestamp / 1000);
+    entry.mMonotonicTimestamp = journal.monotonicUsec();
+    entry.mMessage = value("MESSAGE");
+    entry.mId = value("MESSAGE_ID");
+    entry.mSystemdUnit = JournaldHelper::cleanupString(value("_SYSTEMD_UNIT"));
+    entry.mBootId = value("_BOOT_ID");
+    entry.mExe = value("_EXE");
+    entry.mPriority = value("PRIORITY").toInt();
+    entry.mCursor = journal.cursor();
+    return entry;
+}
+
+QString JournaldViewModelPrivate::tailReadCursor() const
+{
+    // entries buffered in paused follow mode are logically placed after the model's last entry and
+    // entries skipped by a previous read are placed after both
+    if (!mTailSkipCursor.isEmpty()) {
+        return mTailSkipCursor;
+    }
+    if (!mFollowBuffer.isEmpty()) {
+        return mFollowBuffer.last().mCursor;
+    }
+    return mLog.isEmpty() ? QString() : mLog.last().mCursor;
+}
+
+int JournaldViewModelPrivate::countRemainingEntries(int limit)
+{
+    QMutexLocker locker(&mReadMutex);
+    const QString cursor = tailReadCursor();
+    if (limit <= 0 || cursor.isEmpty() || !mJournal->isValid() || !seekBesideCursorAndMakeCurrent(cursor, Direction::TOWARDS_TAIL)) {
+        return 0;
+    }
+    int count{0};
+    for (int i = 0; i < limit; ++i) {
+        if (mResidualFilter.matches(*mJournal)) {
+            ++count;
+        }
+        if (mJournal->next() <= 0) {
+            break;
+        }
+    }
+    return count;
+}
+
+bool JournaldViewModelPrivate::isTailFetchBlocked() const
+{
+    return mFollowMode && mFollowPaused;
+}
+
+void JournaldViewModelPrivate::discardFollowBuffer()
+{
+    mFollowBuffer.clear();
+    mPendingEntries = 0;
+}
+
+int JournaldViewModelPrivate::linesBehind() const
+{
+    return mFollowBuffer.size() + mPendingEntries;
+}
+
+QHash<int, QByteArray> JournaldViewModelPrivate::entryRoleNames()
+{
+    QHash<int, QByteArray> roles;
+    roles[JournaldViewModel::DATE] = "date";
+    roles[JournaldViewModel::DATETIME] = "datetime";
+    roles[JournaldViewModel::MONOTONIC_TIMESTAMP] = "monotonictimestamp";
+    roles[JournaldViewModel::MESSAGE_ID] = "id";
+    roles[JournaldViewModel::MESSAGE] = "message";
+    roles[JournaldViewModel::PRIORITY] = "priority";
+    roles[JournaldViewModel::SYSTEMD_UNIT] = "systemdunit";
+    roles[JournaldViewModel::SYSTEMD_UNIT_CHANGED_SUBSTRING] = "systemdunit_changed_substring";
+    roles[JournaldViewModel::EXE] = "exe";
+    roles[JournaldViewModel::EXE_CHANGED_SUBSTRING] = "exe_changed_substring";
+    roles[JournaldViewModel::BOOT_ID] = "bootid";
+    roles[JournaldViewModel::SYSTEMD_UNIT_COLOR_BACKGROUND] = "systemdunitcolor_background";
+    roles[JournaldViewModel::SYSTEMD_UNIT_COLOR_FOREGROUND] = "systemdunitcolor_foreground";
+    roles[JournaldViewModel::EXE_COLOR_BACKGROUND] = "execolor_background";
+    roles[JournaldViewModel::EXE_COLOR_FOREGROUND] = "execolor_foreground";
+    roles[JournaldViewModel::CURSOR] = "cursor";
+    return roles;
+}
+
+QVariant JournaldViewModelPrivate::entryData(const LogEntry &entry, const LogEntry *previous, int role)
+{
+    switch (role) {
+    case JournaldViewModel::Roles::MESSAGE:
+        // TODO add handling for arbitrary color codes
+        return QString(entry.mMessage)
+            .remove(QLatin1String("\u001B[96m"))
+            .remove(QLatin1String("\u001B[0m"))
+            .remove(QLatin1String("\u001B[93m"))
+            .remove(QLatin1String("\u001B[31m"));
+    case JournaldViewModel::Roles::MESSAGE_ID:
+        return QString(entry.mId);
+    case JournaldViewModel::Roles::DATE:
+        return entry.mDate.date();
+    case JournaldViewModel::Roles::DATETIME:
+        return entry.mDate;
+    case JournaldViewModel::Roles::MONOTONIC_TIMESTAMP:
+        return entry.mMonotonicTimestamp;
+    case JournaldViewModel::Roles::BOOT_ID:
+        return entry.mBootId;
+    case JournaldViewModel::Roles::SYSTEMD_UNIT:
+        return entry.mSystemdUnit;
+    case JournaldViewModel::Roles::SYSTEMD_UNIT_CHANGED_SUBSTRING: {
+        QString unit = entry.mSystemdUnit;
+        if (previous) {
+            unit.remove(previous->mSystemdUnit);
+        }
+        return unit;
+    }
+    case JournaldViewModel::Roles::PRIORITY:
+        return entry.mPriority;
+    case JournaldViewModel::Roles::EXE:
+        return entry.mExe;
+    case JournaldViewModel::Roles::EXE_CHANGED_SUBSTRING: {
+        QString exe = entry.mExe;
+        if (previous) {
+            exe.remove(previous->mExe);
+        }
+        return exe;
+    }
+    case JournaldViewModel::Roles::SYSTEMD_UNIT_COLOR_BACKGROUND:
+        return Colorizer::color(entry.mSystemdUnit, Colorizer::COLOR_TYPE::BACKGROUND);
+    case JournaldViewModel::Roles::SYSTEMD_UNIT_COLOR_FOREGROUND:
+        return Colorizer::color(entry.mSystemdUnit, Colorizer::COLOR_TYPE::FOREGROUND);
+    case JournaldViewModel::Roles::EXE_COLOR_BACKGROUND:
+        return Colorizer::color(entry.mExe, Colorizer::COLOR_TYPE::BACKGROUND);
+    case JournaldViewModel::Roles::EXE_COLOR_FOREGROUND:
+        return Colorizer::color(entry.mExe, Colorizer::COLOR_TYPE::FOREGROUND);
+    case JournaldViewModel::Roles::CURSOR:
+        return entry.mCursor;
+    }
+    return QVariant();
+}
+
 bool JournaldViewModelPrivate::seekHeadAndMakeCurrent()
 {
     qCDebug(KJOURNALDLIB_GENERAL) << "seek head and make current";
-    int result = sd_journal_seek_head(mJournal->sdJournal());
-    if (result < 0) {
-        qCCritical(KJOURNALDLIB_GENERAL) << "Failed to seek head:" << strerror(-result);
+    if (!mJournal->seekHead()) {
         return false;
     }
-    if (sd_journal_next(mJournal->sdJournal()) <= 0) {
+    if (mJournal->next() <= 0) {
         qCWarning(KJOURNALDLIB_GENERAL) << "could not make head entry current";
+        // without any entry, both ends are reached and appended entries are read when they arrive
+        mHeadCursorReached = true;
+        mTailCursorReached = true;
         return false;
     }
     mHeadCursorReached = true;
@@ -308,12 +511,10 @@ bool JournaldViewModelPrivate::seekHeadAndMakeCurrent()
 bool JournaldViewModelPrivate::seekTailAndMakeCurrent()
 {
     qCDebug(KJOURNALDLIB_GENERAL) << "seek tail and make current";
-    int result = sd_journal_seek_tail(mJournal->sdJournal());
-    if (result < 0) {
-        qCCritical(KJOURNALDLIB_GENERAL) << "Failed to seek head:" << strerror(-result);
+    if (!mJournal->seekTail()) {
         return false;
     }
-    if (sd_journal_previous(mJournal->sdJournal()) <= 0) {
+    if (mJournal->previous() <= 0) {
         qCWarning(KJOURNALDLIB_GENERAL) << "could not make tail entry current";
         return false;
     }
@@ -325,6 +526,8 @@ JournaldViewModel::JournaldViewModel(QObject *parent)
     : QAbstractItemModel(parent)
     , d(new JournaldViewModelPrivate)
 {
+    connect(&d->mFollowTimer, &QTimer::timeout, this, &JournaldViewModel::processFollowUpdate);
+    connect(this, &QAbstractItemModel::modelReset, this, &JournaldViewModel::linesBehindChanged);
     setSystemJournal();
 }
 
@@ -332,6 +535,8 @@ JournaldViewModel::JournaldViewModel(const QString &path, QObject *parent)
     : QAbstractItemModel(parent)
     , d(new JournaldViewModelPrivate)
 {
+    connect(&d->mFollowTimer, &QTimer::timeout, this, &JournaldViewModel::processFollowUpdate);
+    connect(this, &QAbstractItemModel::modelReset, this, &JournaldViewModel::linesBehindChanged);
     setJournaldPath(path);
 }
 
@@ -342,6 +547,7 @@ bool JournaldViewModel::setJournal(std::unique_ptr<IJournal> journal)
     bool success{true};
     beginResetModel();
     d->mLog.clear();
+    d->discardFollowBuffer();
     d->mJournal = std::move(journal);
     success = d->mJournal->isValid();
     if (success) {
@@ -349,18 +555,18 @@ bool JournaldViewModel::setJournal(std::unique_ptr<IJournal> journal)
         fetchMoreLogEntries();
     }
     endResetModel();
-    connect(d->mJournal.get(), &IJournal::journalUpdated, this, [=](const QString &bootId) {
-        if (!d->mBootFilter.contains(bootId)) {
-            return;
-        }
-        if (d->mTailCursorReached) {
-            d->mTailCursorReached = false;
-            fetchMoreLogEntries();
-        }
-    });
+    connect(d->mJournal.get(), &IJournal::journalUpdated, this, &JournaldViewModel::handleJournalUpdate);
     return success;
 }
 
+bool JournaldViewModel::setJournalClone(IJournal *journal)
+{
+    if (!journal) {
+        return false;
+    }
+    return setJournal(journal->clone());
+}
+
 bool JournaldViewModel::setJournaldPath(const QString &path)
 {
     return setJournal(std::make_unique<LocalJournal>(path));
@@ -373,24 +579,7 @@ bool JournaldViewModel::setSystemJournal()
 
 QHash<int, QByteArray> JournaldViewModel::roleNames() const
 {
-    QHash<int, QByteArray> roles;
-    roles[JournaldViewModel::DATE] = "date";
-    roles[JournaldViewModel::DATETIME] = "datetime";
-    roles[JournaldViewModel::MONOTONIC_TIMESTAMP] = "monotonictimestamp";
-    roles[JournaldViewModel::MESSAGE_ID] = "id";
-    roles[JournaldViewModel::MESSAGE] = "message";
-    roles[JournaldViewModel::PRIORITY] = "priority";
-    roles[JournaldViewModel::SYSTEMD_UNIT] = "systemdunit";
-    roles[JournaldViewModel::SYSTEMD_UNIT_CHANGED_SUBSTRING] = "systemdunit_changed_substring";
-    roles[JournaldViewModel::EXE] = "exe";
-    roles[JournaldViewModel::EXE_CHANGED_SUBSTRING] = "exe_changed_substring";
-    roles[JournaldViewModel::BOOT_ID] = "bootid";
-    roles[JournaldViewModel::SYSTEMD_UNIT_COLOR_BACKGROUND] = "systemdunitcolor_background";
-    roles[JournaldViewModel::SYSTEMD_UNIT_COLOR_FOREGROUND] = "systemdunitcolor_foreground";
-    roles[JournaldViewModel::EXE_COLOR_BACKGROUND] = "execolor_background";
-    roles[JournaldViewModel::EXE_COLOR_FOREGROUND] = "execolor_foreground";
-    roles[JournaldViewModel::CURSOR] = "cursor";
-    return roles;
+    return JournaldViewModelPrivate::entryRoleNames();
 }
 
 QVariant JournaldViewModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -429,56 +618,7 @@ QVariant JournaldViewModel::data(const QModelIndex &index, int role) const
     if (index.row() < 0 || d->mLog.count() <= index.row()) {
         return QVariant();
     }
-    switch (role) {
-    case JournaldViewModel::Roles::MESSAGE:
-        // TODO add handling for arbitrary color codes
-        return QString(d->mLog.at(index.row()).mMessage)
-            .remove(QLatin1String("\u001B[96m"))
-            .remove(QLatin1String("\u001B[0m"))
-            .remove(QLatin1String("\u001B[93m"))
-            .remove(QLatin1String("\u001B[31m"));
-    case JournaldViewModel::Roles::MESSAGE_ID:
-        return QString(d->mLog.at(index.row()).mId);
-    case JournaldViewModel::Roles::DATE:
-        return d->mLog.at(index.row()).mDate.date();
-    case JournaldViewModel::Roles::DATETIME:
-        return d->mLog.at(index.row()).mDate;
-    case JournaldViewModel::Roles::MONOTONIC_TIMESTAMP:
-        return d->mLog.at(index.row()).mMonotonicTimestamp;
-    case JournaldViewModel::Roles::BOOT_ID:
-        return d->mLog.at(index.row()).mBootId;
-    case JournaldViewModel::Roles::SYSTEMD_UNIT:
-        return d->mLog.at(index.row()).mSystemdUnit;
-    case JournaldViewModel::Roles::SYSTEMD_UNIT_CHANGED_SUBSTRING: {
-        QString unit = d->mLog.at(index.row()).mSystemdUnit;
-        if (index.row() != 0) {
-            unit.remove(d->mLog.at(index.row() - 1).mSystemdUnit);
-        }
-        return unit;
-    }
-    case JournaldViewModel::Roles::PRIORITY:
-        return d->mLog.at(index.row()).mPriority;
-    case JournaldViewModel::Roles::EXE:
-        return d->mLog.at(index.row()).mExe;
-    case JournaldViewModel::Roles::EXE_CHANGED_SUBSTRING: {
-        QString exe = d->mLog.at(index.row()).mExe;
-        if (index.row() != 0) {
-            exe.remove(d->mLog.at(index.row() - 1).mExe);
-        }
-        return exe;
-    }
-    case JournaldViewModel::Roles::SYSTEMD_UNIT_COLOR_BACKGROUND:
-        return Colorizer::color(d->mLog.at(index.row()).mSystemdUnit, Colorizer::COLOR_TYPE::BACKGROUND);
-    case JournaldViewModel::Roles::SYSTEMD_UNIT_COLOR_FOREGROUND:
-        return Colorizer::color(d->mLog.at(index.row()).mSystemdUnit, Colorizer::COLOR_TYPE::FOREGROUND);
-    case JournaldViewModel::Roles::EXE_COLOR_BACKGROUND:
-        return Colorizer::color(d->mLog.at(index.row()).mExe, Colorizer::COLOR_TYPE::BACKGROUND);
-    case JournaldViewModel::Roles::EXE_COLOR_FOREGROUND:
-        return Colorizer::color(d->mLog.at(index.row()).mExe, Colorizer::COLOR_TYPE::FOREGROUND);
-    case JournaldViewModel::Roles::CURSOR:
-        return d->mLog.at(index.row()).mCursor;
-    }
-    return QVariant();
+    return JournaldViewModelPrivate::entryData(d->mLog.at(index.row()), index.row() > 0 ? &d->mLog.at(index.row() - 1) : nullptr, role);
 }
 
 QDateTime JournaldViewModel::datetime(int indexRow) const
@@ -488,7 +628,7 @@ QDateTime JournaldViewModel::datetime(int indexRow) const
 
 bool JournaldViewModel::canFetchMore(const QModelIndex &parent) const
 {
-    return !(d->mHeadCursorReached && d->mTailCursorReached);
+    return !d->mHeadCursorReached || (!d->mTailCursorReached && !d->isTailFetchBlocked());
 }
 
 void JournaldViewModel::fetchMore(const QModelIndex &parent)
@@ -510,7 +650,7 @@ std::pair<int, int> JournaldViewModel::fetchMoreLogEntries()
     // where we begin reading the log
 
     std::pair<int, int> fetchResult;
-    { // append to log
+    if (!d->isTailFetchBlocked()) { // append to log
         QVector<LogEntry> chunk = d->readEntries(JournaldViewModelPrivate::Direction::TOWARDS_TAIL);
         if (chunk.size() > 0) {
             beginInsertRows(QModelIndex(), d->mLog.size(), d->mLog.size() + chunk.size() - 1);
@@ -535,6 +675,214 @@ std::pair<int, int> JournaldViewModel::fetchMoreLogEntries()
     return fetchResult;
 }
 
+void JournaldViewModel::handleJournalUpdate(const QString &bootId, IJournal::ChangeType type)
+{
+    if (type == IJournal::ChangeType::INVALIDATE) {
+        reanchorWindow();
+        return;
+    }
+    // the boot ID only describes the running system for local journals and is empty for other sources,
+    // thus the filtered read decides if appended entries belong to the window
+    appendNewEntries();
+}
+
+void JournaldViewModel::appendNewEntries()
+{
+    if (d->mFollowMode) {
+        // wakeups are coalesced until the timer fires
+        if (!d->mFollowTimer.isActive()) {
+            d->mFollowTimer.start();
+        }
+        return;
+    }
+    // only extend window if it shows the tail, otherwise new entries are reached by fetchMore
+    if (d->mTailCursorReached) {
+        fetchTailEntries();
+    }
+}
+
+void JournaldViewModel::fetchTailEntries()
+{
+    int instance = d->mActiveFetchOperations.fetchAndAddRelaxed(1);
+    if (instance != 0) {
+        qWarning() << "Skipping fetch operation, already one in progress";
+        return;
+    }
+    d->mTailCursorReached = false;
+    QVector<LogEntry> chunk = d->readEntries(JournaldViewModelPrivate::Direction::TOWARDS_TAIL);
+    if (chunk.size() > 0) {
+        beginInsertRows(QModelIndex(), d->mLog.size(), d->mLog.size() + chunk.size() - 1);
+        d->mLog.append(chunk);
+        endInsertRows();
+        qCDebug(KJOURNALDLIB_GENERAL) << "appended entries at tail" << chunk.size();
+    }
+    d->mActiveFetchOperations = 0;
+}
+
+void JournaldViewModel::reanchorWindow()
+{
+    if (!d->mJournal || !d->mJournal->isValid()) {
+        return;
+    }
+    // journal files were added or removed; as long as the window's boundary entries still exist, the
+    // window is unchanged and only new entries might have been added
+    const bool headAvailable = !d->mLog.isEmpty() && d->isCursorAvailable(d->mLog.first().mCursor);
+    const bool tailAvailable = !d->mLog.isEmpty() && d->isCursorAvailable(d->mLog.last().mCursor);
+    if (headAvailable && tailAvailable) {
+        qCDebug(KJOURNALDLIB_GENERAL) << "journal files changed, current window is still valid";
+        appendNewEntries();
+        return;
+    }
+
+    qCDebug(KJOURNALDLIB_GENERAL) << "journal files changed, reconcile window";
+    const QString anchor = d->mLog.isEmpty() ? QString() : d->mLog.first().mCursor;
+
+    // files are vacuumed oldest first, thus vanished entries form the head or the tail of the window and the
+    // boundary to the surviving rows is found by binary search, i.e. with O(log n) cursor tests
+    if (headAvailable) {
+        const int firstVanishedRow = d->findAvailabilityBoundary(1, d->mLog.size() - 1, false);
+        const int lastRow = d->mLog.size() - 1;
+        beginRemoveRows(QModelIndex(), firstVanishedRow, lastRow);
+        d->mLog.remove(firstVanishedRow, lastRow - firstVanishedRow + 1);
+        endRemoveRows();
+        qCDebug(KJOURNALDLIB_GENERAL) << "removed vanished entries" << firstVanishedRow << "to" << lastRow;
+    } else if (tailAvailable) {
+        const int firstSurvivingRow = d->findAvailabilityBoundary(1, d->mLog.size() - 1, true);
+        beginRemoveRows(QModelIndex(), 0, firstSurvivingRow - 1);
+        d->mLog.remove(0, firstSurvivingRow);
+        endRemoveRows();
+        qCDebug(KJOURNALDLIB_GENERAL) << "removed vanished entries" << 0 << "to" << firstSurvivingRow - 1;
+    }
+    // files might have been added at both ends
+    d->mHeadCursorReached = false;
+    d->mTailCursorReached = false;
+
+    if (!headAvailable && !tailAvailable) {
+        // the whole window vanished, or at least both of its ends, rebuild it at the closest surviving position
+        beginResetModel();
+        d->discardFollowBuffer();
+        d->mLog.clear();
+        if (!anchor.isEmpty()) {
+            d->mLog = d->readEntriesFromCursor(anchor);
+        }
+        if (d->mLog.isEmpty()) {
+            // no entry remains at or after the anchor, restart from head; this also applies the query to
+            // journals that only became valid after they were set, like a starting remote import
+            d->resetJournal();
+            fetchMoreLogEntries();
+        }
+        endResetModel();
+    }
+    if (d->mFollowMode) {
+        d->mFollowTimer.start();
+    }
+}
+
+void JournaldViewModel::processFollowUpdate()
+{
+    if (!d->mFollowMode || !d->mJournal || !d->mJournal->isValid()) {
+        return;
+    }
+    // same guard as for fetchMoreLogEntries, retry in next frame if a fetch is in progress
+    int instance = d->mActiveFetchOperations.fetchAndAddRelaxed(1);
+    if (instance != 0) {
+        d->mFollowTimer.start();
+        return;
+    }
+
+    const int previousLinesBehind = d->linesBehind();
+    const bool bufferFull = d->mFollowPaused && d->mFollowBuffer.size() >= JournaldViewModelPrivate::sFollowBufferLimit;
+    if (!bufferFull) {
+        // only read towards tail and at most one chunk per frame
+        d->mTailCursorReached = false;
+        QVector<LogEntry> chunk = d->readEntries(JournaldViewModelPrivate::Direction::TOWARDS_TAIL);
+        if (d->mFollowPaused) {
+            d->mFollowBuffer.append(chunk);
+        } else if (chunk.size() > 0) {
+            beginInsertRows(QModelIndex(), d->mLog.size(), d->mLog.size() + chunk.size() - 1);
+            d->mLog.append(chunk);
+            endInsertRows();
+        }
+        // counting is bounded to a few chunks, because it is repeated in every frame until the model caught up
+        d->mPendingEntries = d->mTailCursorReached ? 0 : d->countRemainingEntries(static_cast<int>(JournaldViewModelPrivate::sMaxCountedChunks * d->mChunkSize));
+        qCDebug(KJOURNALDLIB_GENERAL) << "follow mode read" << chunk.size() << "entries, lines behind:" << d->linesBehind();
+    } else {
+        qCDebug(KJOURNALDLIB_GENERAL) << "follow buffer is full, stop reading until resumed";
+    }
+    d->mActiveFetchOperations = 0;
+
+    if (d->linesBehind() != previousLinesBehind) {
+        Q_EMIT linesBehindChanged();
+    }
+    // continue catching up in the next frame
+    if (!d->mTailCursorReached && !bufferFull) {
+        d->mFollowTimer.start();
+    }
+}
+
+void JournaldViewModel::flushFollowBuffer()
+{
+    if (d->mFollowBuffer.isEmpty()) {
+        return;
+    }
+    beginInsertRows(QModelIndex(), d->mLog.size(), d->mLog.size() + d->mFollowBuffer.size() - 1);
+    d->mLog.append(d->mFollowBuffer);
+    endInsertRows();
+    qCDebug(KJOURNALDLIB_GENERAL) << "inserted" << d->mFollowBuffer.size() << "buffered entries";
+    d->mFollowBuffer.clear();
+    Q_EMIT linesBehindChanged();
+}
+
+void JournaldViewModel::setFollowMode(bool enabled)
+{
+    if (d->mFollowMode == enabled) {
+        return;
+    }
+    d->mFollowMode = enabled;
+    if (enabled) {
+        // catch up with entries that were added since the last read
+        d->mFollowTimer.start();
+    } else {
+        d->mFollowTimer.stop();
+        flushFollowBuffer();
+        if (d->mPendingEntries != 0) {
+            d->mPendingEntries = 0;
+            Q_EMIT linesBehindChanged();
+        }
+    }
+    Q_EMIT followModeChanged();
+}
+
+bool JournaldViewModel::isFollowModeEnabled() const
+{
+    return d->mFollowMode;
+}
+
+void JournaldViewModel::setFollowPaused(bool paused)
+{
+    if (d->mFollowPaused == paused) {
+        return;
+    }
+    d->mFollowPaused = paused;
+    if (!paused) {
+        flushFollowBuffer();
+        if (d->mFollowMode && !d->mTailCursorReached) {
+            d->mFollowTimer.start();
+        }
+    }
+    Q_EMIT followPausedChanged();
+}
+
+bool JournaldViewModel::isFollowPaused() const
+{
+    return d->mFollowPaused;
+}
+
+int JournaldViewModel::linesBehind() const
+{
+    return d->linesBehind();
+}
+
 void JournaldViewModel::setFetchMoreChunkSize(quint32 size)
 {
     if (size > 0) {
@@ -544,12 +892,42 @@ void JournaldViewModel::setFetchMoreChunkSize(quint32 size)
     }
 }
 
+void JournaldViewModel::setPrefetchEnabled(bool enabled)
+{
+    d->mPrefetchEnabled = enabled;
+    if (!enabled) {
+        d->mPrefetcher.cancel();
+    }
+}
+
+bool JournaldViewModel::isPrefetchEnabled() const
+{
+    return d->mPrefetchEnabled;
+}
+
+FilterExpression JournaldViewModel::queryFilterExpression() const
+{
+    return d->mQueryFilter;
+}
+
+std::unique_ptr<IJournal> JournaldViewModel::cloneJournal() const
+{
+    if (!d->mJournal) {
+        return nullptr;
+    }
+    return d->mJournal->clone();
+}
+
 void JournaldViewModel::seekHead()
 {
     beginResetModel();
     d->mLog.clear();
+    d->discardFollowBuffer();
+    d->mHeadSkipCursor.clear();
+    d->mTailSkipCursor.clear();
     if (d->mJournal && d->mJournal->isValid()) {
         d->seekHeadAndMakeCurrent();
+        d->startPrefetch(0);
         QVector<LogEntry> chunk = d->readEntries(JournaldViewModelPrivate::Direction::TOWARDS_TAIL);
         d->mLog = chunk;
     } else {
@@ -562,8 +940,12 @@ void JournaldViewModel::seekTail()
 {
     beginResetModel();
     d->mLog.clear();
+    d->discardFollowBuffer();
+    d->mHeadSkipCursor.clear();
+    d->mTailSkipCursor.clear();
     if (d->mJournal && d->mJournal->isValid()) {
         d->seekTailAndMakeCurrent();
+        d->startPrefetch(std::numeric_limits<quint64>::max());
         QVector<LogEntry> chunk = d->readEntries(JournaldViewModelPrivate::Direction::TOWARDS_HEAD);
         d->mLog = chunk;
     } else {
@@ -670,6 +1052,25 @@ bool JournaldViewModel::isKernelFilterEnabled() const
     return d->mShowKernelMessages;
 }
 
+void JournaldViewModel::setFilterExpression(const FilterExpression &expression)
+{
+    if (d->mFilterExpression == expression) {
+        return;
+    }
+    qCDebug(KJOURNALDLIB_FILTERTRACE).noquote() << "Set filter expression:" << expression.explain();
+    beginResetModel();
+    d->mFilterExpression = expression;
+    d->resetJournal();
+    fetchMoreLogEntries();
+    endResetModel();
+    Q_EMIT filterExpressionChanged();
+}
+
+FilterExpression JournaldViewModel::filterExpression() const
+{
+    return d->mFilterExpression;
+}
+
 int JournaldViewModel::search(const QString &searchString, int startRow, Direction direction)
 {
     int row = startRow;
@@ -6,6 +6,7 @@
 #ifndef JOURNALDVIEWMODEL_H
 #define JOURNALDVIEWMODEL_H
 
+#include "filterexpression.h"
 #include "kjournald_export.h"
 #include <QAbstractItemModel>
 #include <ijournal.h>
@@ -43,6 +44,18 @@ class KJOURNALD_EXPORT JournaldViewModel : public QAbstractItemModel
      * Configure model to only provide messages with stated priority or higher. Default: no filter is set.
      **/
     Q_PROPERTY(int priorityFilter WRITE setPriorityFilter READ priorityFilter NOTIFY priorityFilterChanged RESET resetPriorityFilter)
+    /**
+     * if set to true, new journal entries are appended to the model when the journal grows
+     **/
+    Q_PROPERTY(bool followMode WRITE setFollowMode READ isFollowModeEnabled NOTIFY followModeChanged)
+    /**
+     * if set to true while in follow mode, new entries are read but only inserted into the model when resumed
+     **/
+    Q_PROPERTY(bool followPaused WRITE setFollowPaused READ isFollowPaused NOTIFY followPausedChanged)
+    /**
+     * number of journal entries that are not yet inserted into the model in follow mode
+     **/
+    Q_PROPERTY(int linesBehind READ linesBehind NOTIFY linesBehindChanged)
 
 public:
     enum Roles {
@@ -131,6 +144,16 @@ public:
      */
     bool setJournal(std::unique_ptr<IJournal> journal);
 
+    /**
+     * Reset model by using a clone of the given journal object
+     *
+     * Allows QML code to show journals that are owned by other objects, e.g. a GatewayJournal.
+     *
+     * @param journal The journald access wrapper
+     * @return true if the clone could be opened, otherwise false
+     */
+    Q_INVOKABLE bool setJournalClone(IJournal *journal);
+
     /**
      * @copydoc QAbstractItemModel::rolesNames()
      */
@@ -263,6 +286,65 @@ public:
      */
     void resetPriorityFilter();
 
+    /**
+     * @brief Configure filter expression over arbitrary journal fields
+     *
+     * The expression is combined by AND with all other filters of this model and is evaluated by
+     * journald's indexed matching, e.g. for filtering by "_PID", "SYSLOG_IDENTIFIER" or "_COMM".
+     * Predicates that journald cannot express (negation, substring, numeric range, regular expression)
+     * are evaluated while reading, such that excluded entries never enter the model. The normalized
+     * expression is logged in the KJOURNALDLIB_FILTERTRACE category.
+     *
+     * @param expression the filter expression, an empty expression deactivates this filter
+     */
+    void setFilterExpression(const FilterExpression &expression);
+
+    /**
+     * @return currently set filter expression
+     */
+    FilterExpression filterExpression() const;
+
+    /**
+     * @brief Configure if the model follows the tail of the journal
+     *
+     * In follow mode, journal update notifications are coalesced such that at most one read is performed
+     * per frame. Every read only extends the model towards the tail and is bounded by the fetch-more chunk
+     * size; if the journal grows faster, the model catches up over the next frames and reports the
+     * difference via @a linesBehind(). Enabling follow mode immediately reads all entries that were added
+     * after the model's last entry.
+     *
+     * @param enabled parameter that defines if the model follows the journal
+     */
+    void setFollowMode(bool enabled);
+
+    /**
+     * @return true if follow mode is enabled, otherwise false
+     */
+    bool isFollowModeEnabled() const;
+
+    /**
+     * @brief Pause insertion of new entries in follow mode
+     *
+     * While paused, the journal is still read and new entries are buffered. When resuming, all buffered
+     * entries are inserted with a single row insertion. Until then, fetchMore() only extends the model
+     * towards head, such that no entry can be inserted after the model's last entry before the buffered ones.
+     *
+     * @param paused parameter that defines if insertion of new rows is paused
+     */
+    void setFollowPaused(bool paused);
+
+    /**
+     * @return true if follow mode is paused, otherwise false
+     */
+    bool isFollowPaused() const;
+
+    /**
+     * @return number of buffered and not yet read journal entries in follow mode
+     * @note the number of not yet read entries is an estimate, because only a few chunks after the last read
+     * entry are counted in every frame
+     */
+    int linesBehind() const;
+
     /**
      * @return row index of searched string
      */
@@ -309,6 +391,34 @@ public:
      */
     void setFetchMoreChunkSize(quint32 size);
 
+    /**
+     * @brief Enable background prefetching of journal files when a boot or time range is selected
+     *
+     * The files that can contain entries of the selected boots or time range are announced to the kernel,
+     * starting with the files nearest to the viewport, see JournalPrefetcher. Read latencies are logged in
+     * the kjournald.lib.performance category, such that the effect can be compared on cold caches.
+     * @note prefetching is enabled by default
+     */
+    void setPrefetchEnabled(bool enabled);
+
+    /**
+     * @return true if background prefetching is enabled
+     */
+    bool isPrefetchEnabled() const;
+
+    /**
+     * @return complete filter of the current query, i.e. the configured filters together with the custom filter expression
+     */
+    FilterExpression queryFilterExpression() const;
+
+    /**
+     * @brief Open an independent journal object for the model's journal, see IJournal::clone()
+     *
+     * This allows to run queries on the same journal in other threads, e.g. for exporting the complete result set.
+     * @return the new journal or nullptr if the journal cannot be opened a second time
+     */
+    std::unique_ptr<IJournal> cloneJournal() const;
+
 private Q_SLOTS:
     /**
      * Decoupled fetching for log entries that can enforce sequence of fetching calls.
@@ -316,6 +426,16 @@ private Q_SLOTS:
      */
     std::pair<int, int> fetchMoreLogEntries();
 
+    /**
+     * Read next batch of entries towards tail in follow mode, called once per coalescing interval
+     */
+    void processFollowUpdate();
+
+    /**
+     * Append new entries on journal growth and re-anchor the window when journal files changed
+     */
+    void handleJournalUpdate(const QString &bootId, IJournal::ChangeType type);
+
 Q_SIGNALS:
     /**
      * Signal is emitted when Kernel message filter is changed
@@ -337,8 +457,44 @@ Q_SIGNALS:
      * Signal is emitted when log level priority filter is changed
      */
     void priorityFilterChanged();
+    /**
+     * Signal is emitted when the filter expression is changed
+     */
+    void filterExpressionChanged();
+    /**
+     * Signal is emitted when follow mode is enabled or disabled
+     */
+    void followModeChanged();
+    /**
+     * Signal is emitted when follow mode is paused or resumed
+     */
+    void followPausedChanged();
+    /**
+     * Signal is emitted when the number of entries that are not yet inserted in follow mode changes
+     */
+    void linesBehindChanged();
 
 private:
+    /**
+     * Insert all entries that were buffered while follow mode was paused
+     */
+    void flushFollowBuffer();
+
+    /**
+     * Schedule follow mode update or extend the window if it shows the journal's tail
+     */
+    void appendNewEntries();
+
+    /**
+     * Read one chunk towards tail and append it to the model
+     */
+    void fetchTailEntries();
+
+    /**
+     * Rebuild the window at its first entry, or the closest remaining entry, after journal files changed
+     */
+    void reanchorWindow();
+
     std::unique_ptr<JournaldViewModelPrivate> d;
 };
 
@@ -6,12 +6,19 @@
 #ifndef JOURNALDVIEWMODEL_P_H
 #define JOURNALDVIEWMODEL_P_H
 
+#include "filterexpression.h"
 #include "ijournal.h"
+#include "journaldhelper.h"
+#include "journalprefetcher.h"
+#include "residualfilter.h"
 #include <QAtomicInt>
 #include <QColor>
 #include <QDateTime>
 #include <QHash>
+#include <QMutex>
 #include <QString>
+#include <QTimer>
+#include <QVariant>
 #include <QVector>
 #include <memory>
 #include <optional>
@@ -19,6 +26,7 @@
 
 struct LogEntry {
     QDateTime mDate;
+    quint64 mRealtimeTimestamp{0}; //!< in microseconds, precise variant of mDate
     quint64 mMonotonicTimestamp{0};
     QString mId;
     QString mMessage;
@@ -28,6 +36,7 @@ struct LogEntry {
     int mPriority{0};
     QString mCursor;
 };
+Q_DECLARE_METATYPE(LogEntry)
 
 class JournaldViewModelPrivate
 {
@@ -37,6 +46,13 @@ public:
         TOWARDS_TAIL,
     };
 
+    JournaldViewModelPrivate();
+
+    /**
+     * @return filter expression for the unit, exe, boot, priority and kernel filter properties
+     */
+    FilterExpression createBaseFilterExpression() const;
+
     /**
      * reapply all filters and seek journal at head
      * ensure to guard this call with beginModelReset and endModelReset
@@ -77,17 +93,133 @@ public:
      */
     QVector<LogEntry> readEntries(Direction direction);
 
+    /**
+     * seek entry with @p cursor, or the closest entry if it does not exist anymore, and read entries
+     * from there towards tail
+     */
+    QVector<LogEntry> readEntriesFromCursor(const QString &cursor);
+
+    /**
+     * Seek the entry that follows @p cursor in @p direction and make it current
+     *
+     * If the entry of @p cursor does not exist anymore, e.g. due to rotation or vacuuming, the closest surviving
+     * entry is used, which is found via the cursor's sequence number and falls back to its realtime timestamp.
+     *
+     * @return true if an entry is current, false if head/tail is reached or seeking failed
+     */
+    bool seekBesideCursorAndMakeCurrent(const QString &cursor, Direction direction);
+
+    /**
+     * @return true if the journal's current entry is located after (for TOWARDS_TAIL) or before (for TOWARDS_HEAD) @p anchor
+     */
+    bool isCurrentEntryBeyond(const JournaldHelper::CursorInfo &anchor, Direction direction) const;
+
+    /**
+     * Seek by the realtime timestamp of @p anchor and make the first entry in @p direction current
+     */
+    bool seekRealtimeAndMakeCurrent(const JournaldHelper::CursorInfo &anchor, Direction direction);
+
+    /**
+     * read entries starting at the journal's current entry
+     *
+     * At most sMaxSkippedEntries entries that are rejected by the residual filter are skipped per call. If this
+     * budget is exhausted, the partial chunk is returned without marking head/tail as reached and the next read in
+     * @p direction continues after the last skipped entry, see mHeadSkipCursor and mTailSkipCursor.
+     */
+    QVector<LogEntry> readEntriesFromCurrent(Direction direction);
+
+    /**
+     * @return true if the entry for @p cursor exists in the journal
+     * @note this call moves the journal's current entry
+     */
+    bool isCursorAvailable(const QString &cursor);
+
+    /**
+     * @return first row in range [@p first, @p last) of mLog whose entry's availability is @p available, or @p last
+     * if there is none
+     * @note rows must be partitioned by availability, i.e. no row with other availability follows the result
+     */
+    int findAvailabilityBoundary(int first, int last, bool available);
+
+    /**
+     * read all fields of the current entry of @p journal
+     */
+    static LogEntry readEntry(const IJournal &journal);
+
+    /**
+     * @return data for @p role of @p entry, see JournaldViewModel::Roles
+     * @param previous the entry in the row before or nullptr, used for the *_CHANGED_SUBSTRING roles
+     */
+    static QVariant entryData(const LogEntry &entry, const LogEntry *previous, int role);
+
+    /**
+     * @return role names for all roles of JournaldViewModel::Roles
+     */
+    static QHash<int, QByteArray> entryRoleNames();
+
+    /**
+     * prefetch journal files that back the current query if it selects boots or a time range
+     * @param viewportRealtimeUsec realtime timestamp of the entries that are read next
+     */
+    void startPrefetch(quint64 viewportRealtimeUsec);
+
+    /**
+     * @return cursor after which the next read towards tail continues, or an empty string if nothing was read
+     * @note this considers entries that are buffered in follow mode and entries skipped by the residual filter
+     */
+    QString tailReadCursor() const;
+
+    /**
+     * estimate the number of entries after tailReadCursor() that match the current query
+     * @note at most @p limit entries are examined, such that the result is a lower bound for larger remainders
+     */
+    int countRemainingEntries(int limit);
+
+    /**
+     * @return true if the model must not be extended towards tail by fetchMore, because paused follow mode
+     * buffers all entries after the model's last entry until it is resumed
+     */
+    bool isTailFetchBlocked() const;
+
+    /**
+     * drop entries that were read in follow mode but not yet inserted into the model
+     */
+    void discardFollowBuffer();
+
+    /**
+     * @return number of entries that are not yet part of the model in follow mode
+     */
+    int linesBehind() const;
+
+    static constexpr int sFollowCoalescingInterval{16}; //!< in milliseconds, aligned with a 60 Hz frame
+    static constexpr int sFollowBufferLimit{100000}; //!< maximal number of entries buffered while paused
+    static constexpr int sMaxCountedChunks{4}; //!< entries that are behind are counted for at most this many chunks
+    static constexpr int sMaxSkippedEntries{5000}; //!< residual filter rejections per read before returning a partial chunk
+
     std::unique_ptr<IJournal> mJournal;
     QVector<LogEntry> mLog;
     QStringList mSystemdUnitFilter;
     QStringList mExeFilter;
     QStringList mBootFilter;
     std::optional<quint8> mPriorityFilter;
+    FilterExpression mFilterExpression;
+    FilterExpression mQueryFilter; //!< complete filter of the current query, see resetJournal()
+    ResidualFilter mResidualFilter;
     bool mShowKernelMessages{false};
     bool mHeadCursorReached{false};
     bool mTailCursorReached{false};
+    QString mHeadSkipCursor; //!< last entry skipped towards head if the skip budget was exhausted
+    QString mTailSkipCursor; //!< last entry skipped towards tail if the skip budget was exhausted
     QAtomicInt mActiveFetchOperations{0};
+    QMutex mReadMutex; //!< serializes all operations that move the journal's current entry
     uint32_t mChunkSize{500};
+    bool mFollowMode{false};
+    bool mFollowPaused{false};
+    QTimer mFollowTimer;
+    QVector<LogEntry> mFollowBuffer; //!< entries read while follow mode is paused
+    int mPendingEntries{0}; //!< entries in journal that were not yet read in follow mode
+    JournalPrefetcher mPrefetcher;
+    bool mPrefetchEnabled{true};
 };
 
 #endif // JOURNALDVIEWMODEL_P_H
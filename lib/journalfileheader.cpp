@@ -0,0 +1,205 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "journalfileheader.h"
+#include "kjournaldlib_log_general.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace
+{
+// header layout as defined in systemd's src/libsystemd/sd-journal/journal-def.h, all integers are little endian
+constexpr const char sSignature[] = {'L', 'P', 'K', 'S', 'H', 'H', 'R', 'H'};
+constexpr qint64 sStateOffset{16};
+constexpr qint64 sFileIdOffset{24};
+constexpr qint64 sMachineIdOffset{40};
+constexpr qint64 sTailEntryBootIdOffset{56};
+constexpr qint64 sSeqnumIdOffset{72};
+constexpr qint64 sHeaderSizeOffset{88};
+constexpr qint64 sEntryCountOffset{152};
+constexpr qint64 sTailEntrySeqnumOffset{160};
+constexpr qint64 sHeadEntrySeqnumOffset{168};
+constexpr qint64 sHeadEntryRealtimeOffset{184};
+constexpr qint64 sTailEntryRealtimeOffset{192};
+constexpr qint64 sTailEntryMonotonicOffset{200};
+// size of the oldest header version, all later versions only append fields
+constexpr qint64 sMinimalHeaderSize{208};
+
+/**
+ * name of the journal file's writer stream, e.g. "system" or "user-1000", archived and dirty files of a
+ * stream are named "<stream>@<suffix>.journal" or "<stream>@<suffix>.journal~"
+ */
+QString fileLineage(const QString &path)
+{
+    const QString name = QFileInfo(path).fileName();
+    const qsizetype separator = name.indexOf(QLatin1Char('@'));
+    return separator >= 0 ? name.left(separator) : name.left(name.indexOf(QLatin1String(".journal")));
+}
+
+QString readId(const uchar *data, qint64 offset)
+{
+    return QString::fromLatin1(QByteArray::fromRawData(reinterpret_cast<const char *>(data + offset), 16).toHex());
+}
+
+quint64 readUint64(const uchar *data, qint64 offset)
+{
+    return qFromLittleEndian<quint64>(data + offset);
+}
+}
+
+std::optional<JournalFileHeader> JournalFileHeader::read(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Could not open journal file" << path << file.errorString();
+        return std::nullopt;
+    }
+    if (file.size() < sMinimalHeaderSize) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Skipping journal file with truncated header" << path;
+        return std::nullopt;
+    }
+    // mapping only the header avoids reading any data of possibly huge files
+    const uchar *data = file.map(0, sMinimalHeaderSize);
+    if (!data) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Could not map journal file header" << path << file.errorString();
+        return std::nullopt;
+    }
+
+    std::optional<JournalFileHeader> header;
+    if (std::memcmp(data, sSignature, sizeof(sSignature)) != 0) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Skipping file without journal signature" << path;
+    } else if (readUint64(data, sHeaderSizeOffset) < static_cast<quint64>(sMinimalHeaderSize)) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Skipping journal file with invalid header size" << path;
+    } else {
+        header = JournalFileHeader();
+        header->mPath = path;
+        header->mState = static_cast<State>(data[sStateOffset]);
+        header->mFileId = readId(data, sFileIdOffset);
+        header->mMachineId = readId(data, sMachineIdOffset);
+        header->mTailEntryBootId = readId(data, sTailEntryBootIdOffset);
+        header->mSeqnumId = readId(data, sSeqnumIdOffset);
+        header->mEntryCount = readUint64(data, sEntryCountOffset);
+        header->mTailEntrySeqnum = readUint64(data, sTailEntrySeqnumOffset);
+        header->mHeadEntrySeqnum = readUint64(data, sHeadEntrySeqnumOffset);
+        header->mHeadEntryRealtime = readUint64(data, sHeadEntryRealtimeOffset);
+        header->mTailEntryRealtime = readUint64(data, sTailEntryRealtimeOffset);
+        header->mTailEntryMonotonic = readUint64(data, sTailEntryMonotonicOffset);
+    }
+    file.unmap(const_cast<uchar *>(data));
+    return header;
+}
+
+QVector<JournalFileHeader> JournalFileHeader::readAll(const QStringList &paths)
+{
+    // header reads are IO bound on cold caches, thus read headers in parallel
+    const QList<std::optional<JournalFileHeader>> results = QtConcurrent::blockingMapped(paths, &JournalFileHeader::read);
+    QVector<JournalFileHeader> headers;
+    headers.reserve(results.size());
+    for (const auto &header : results) {
+        if (header) {
+            headers.append(header.value());
+        }
+    }
+    return headers;
+}
+
+QVector<JournalFileHeader> JournalFileHeader::select(const QVector<JournalFileHeader> &headers, const FilterExpression &expression)
+{
+    const std::optional<QStringList> bootIds = expression.requiredValues(QLatin1String("_BOOT_ID"));
+    const std::optional<std::pair<qint64, qint64>> range = expression.requiredRange(QLatin1String("__REALTIME_TIMESTAMP"));
+    if (!bootIds && !range) {
+        return headers;
+    }
+
+    std::vector<bool> selected(headers.size(), true);
+    if (bootIds) {
+        std::vector<bool> bootSelected(headers.size(), false);
+        // journald numbers the entries of the system and all user files by one counter, thus only the files of one
+        // stream, which share sequence number ID and file name prefix, contain contiguous sequence numbers
+        QHash<QString, QVector<int>> chains;
+        for (int i = 0; i < headers.size(); ++i) {
+            chains[headers.at(i).mSeqnumId + QLatin1Char('/') + fileLineage(headers.at(i).mPath)].append(i);
+        }
+        quint64 envelopeBegin{std::numeric_limits<quint64>::max()};
+        quint64 envelopeEnd{0};
+        QVector<QVector<int>> undecidedChains;
+        for (auto &chain : chains) {
+            std::sort(chain.begin(), chain.end(), [&headers](int lhs, int rhs) {
+                return headers.at(lhs).mHeadEntrySeqnum < headers.at(rhs).mHeadEntrySeqnum;
+            });
+            bool decided{false};
+            for (int i = 0; i < chain.size(); ++i) {
+                const JournalFileHeader &header = headers.at(chain.at(i));
+                const bool endsWithBoot = bootIds->contains(header.mTailEntryBootId);
+                const bool continuesBoot = i > 0 && bootIds->contains(headers.at(chain.at(i - 1)).mTailEntryBootId);
+                if (!endsWithBoot && !continuesBoot) {
+                    continue;
+                }
+                decided = true;
+                bootSelected[chain.at(i)] = true;
+                if (header.mEntryCount > 0) {
+                    envelopeBegin = std::min(envelopeBegin, header.mHeadEntryRealtime);
+                    envelopeEnd = std::max(envelopeEnd, header.mTailEntryRealtime);
+                }
+            }
+            if (!decided) {
+                undecidedChains.append(chain);
+            }
+        }
+
+        if (envelopeEnd == 0) {
+            qCDebug(KJOURNALDLIB_GENERAL) << "No journal file ends with any of the boots" << bootIds.value() << ", cannot prune by boot";
+            std::fill(bootSelected.begin(), bootSelected.end(), true);
+        } else {
+            for (const auto &chain : std::as_const(undecidedChains)) {
+                for (int index : chain) {
+                    const JournalFileHeader &header = headers.at(index);
+                    bootSelected[index] = header.mHeadEntryRealtime <= envelopeEnd && header.mTailEntryRealtime >= envelopeBegin;
+                }
+            }
+        }
+        selected = bootSelected;
+    }
+
+    if (range) {
+        for (int i = 0; i < headers.size(); ++i) {
+            const JournalFileHeader &header = headers.at(i);
+            // timestamps of a file with a clock jump are no reliable bounds, keep such files
+            if (header.mHeadEntryRealtime > header.mTailEntryRealtime) {
+                continue;
+            }
+            const qint64 head = static_cast<qint64>(header.mHeadEntryRealtime);
+            const qint64 tail = static_cast<qint64>(header.mTailEntryRealtime);
+            if (head > range->second || tail < range->first) {
+                selected[i] = false;
+            }
+        }
+    }
+
+    QVector<JournalFileHeader> result;
+    for (int i = 0; i < headers.size(); ++i) {
+        const JournalFileHeader &header = headers.at(i);
+        if (header.mState == State::ONLINE || (selected.at(i) && header.mEntryCount > 0)) {
+            result.append(header);
+        }
+    }
+    qCDebug(KJOURNALDLIB_GENERAL) << "Selected" << result.size() << "of" << headers.size() << "journal files";
+    return result;
+}
+
+QDebug operator<<(QDebug debug, const JournalFileHeader &header)
+{
+    QDebugStateSaver saver(debug);
+    debug.nospace() << "JournalFileHeader(" << header.mPath << ", machine " << header.mMachineId << ", " << header.mEntryCount << " entries, realtime "
+                    << header.mHeadEntryRealtime << "-" << header.mTailEntryRealtime << ")";
+    return debug;
+}
@@ -0,0 +1,83 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef JOURNALFILEHEADER_H
+#define JOURNALFILEHEADER_H
+
+#include "filterexpression.h"
+#include "kjournald_export.h"
+#include <QDebug>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <optional>
+
+/**
+ * @brief Meta data from the header of a journald ".journal" file
+ *
+ * The header is read directly from the file without opening it via libsystemd, which makes it cheap
+ * to inspect large numbers of files. See https://systemd.io/JOURNAL_FILE_FORMAT/ for the format.
+ * All IDs are formatted as 32 lowercase hex characters, like journald formats them in fields and cursors.
+ */
+struct KJOURNALD_EXPORT JournalFileHeader {
+    /**
+     * @brief State of the file as recorded in its header
+     */
+    enum class State {
+        OFFLINE = 0, //!< file is closed, but may be opened again for writing
+        ONLINE = 1, //!< file is currently opened for writing
+        ARCHIVED = 2, //!< file was rotated and will not be written anymore
+    };
+
+    QString mPath;
+    State mState{State::OFFLINE};
+    QString mFileId;
+    QString mMachineId;
+    QString mTailEntryBootId; //!< boot ID of last entry in file
+    QString mSeqnumId; //!< ID of the sequence number space, shared by files of the same writer
+    quint64 mEntryCount{0};
+    quint64 mHeadEntrySeqnum{0};
+    quint64 mTailEntrySeqnum{0};
+    quint64 mHeadEntryRealtime{0}; //!< realtime timestamp of first entry in microseconds
+    quint64 mTailEntryRealtime{0}; //!< realtime timestamp of last entry in microseconds
+    quint64 mTailEntryMonotonic{0}; //!< monotonic timestamp of last entry in microseconds
+
+    /**
+     * @brief Read and validate header of journal file at @p path
+     *
+     * @return the header or std::nullopt if the file cannot be read or is no journal file
+     */
+    static std::optional<JournalFileHeader> read(const QString &path);
+
+    /**
+     * @brief Read headers of all @p paths in parallel
+     *
+     * @return headers of all valid journal files, in order of @p paths
+     */
+    static QVector<JournalFileHeader> readAll(const QStringList &paths);
+
+    /**
+     * @brief Select files that may contain entries matching @p expression
+     *
+     * The selection considers the "_BOOT_ID" values and the "__REALTIME_TIMESTAMP" range required by
+     * @p expression, see FilterExpression::requiredValues() and FilterExpression::requiredRange().
+     * Headers only record the boot ID of the last entry of each file. Thus, files of one stream, i.e. with
+     * the same sequence number ID and file name prefix like "system" or "user-1000", are ordered by
+     * sequence numbers and a file is selected if it or its predecessor ends with a requested boot. Streams
+     * of one writer share the sequence numbers, such that their files interleave. For streams whose files
+     * do not end with a requested boot, e.g. because a boot is contained
+     * in the middle of a file, files are selected by overlap with the time range of the already selected
+     * files. If no file ends with a requested boot, all files are selected. Online files are always
+     * selected, because they may receive entries of the running boot.
+     *
+     * @note time based selection assumes that the realtime clock did not jump backwards
+     * @return selected headers in order of @p headers
+     */
+    static QVector<JournalFileHeader> select(const QVector<JournalFileHeader> &headers, const FilterExpression &expression);
+};
+
+QDebug operator<<(QDebug debug, const JournalFileHeader &header);
+
+#endif // JOURNALFILEHEADER_H
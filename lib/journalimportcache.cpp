@@ -0,0 +1,139 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "journalimportcache.h"
+#include "kjournaldlib_log_general.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <algorithm>
+
+namespace
+{
+constexpr qint64 sSampleSize{64 * 1024};
+const QLatin1String sJournalSuffix(".journal");
+}
+
+JournalImportCache::JournalImportCache(const QString &directory, qint64 maxSize)
+    : mDirectory(directory)
+    , mMaxSize(maxSize)
+{
+    if (mDirectory.isEmpty()) {
+        mDirectory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/imports");
+    }
+    if (!QDir().mkpath(mDirectory)) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Could not create import cache directory" << mDirectory;
+    }
+}
+
+QString JournalImportCache::directory() const
+{
+    return mDirectory;
+}
+
+qint64 JournalImportCache::maxSize() const
+{
+    return mMaxSize;
+}
+
+QString JournalImportCache::key(const QString &exportPath)
+{
+    QFile file(exportPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Could not open export file for computing cache key" << exportPath << file.errorString();
+        return QString();
+    }
+    const QFileInfo info(file);
+    const qint64 size = file.size();
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(QByteArray::number(size));
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    // samples at both ends and in the middle change for appended, truncated and rewritten exports
+    for (const qint64 offset : {qint64(0), std::max<qint64>(0, size / 2 - sSampleSize / 2), std::max<qint64>(0, size - sSampleSize)}) {
+        if (!file.seek(offset)) {
+            qCWarning(KJOURNALDLIB_GENERAL) << "Could not read export file for computing cache key" << exportPath << file.errorString();
+            return QString();
+        }
+        hash.addData(file.read(sSampleSize));
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString JournalImportCache::journalFile(const QString &key) const
+{
+    return mDirectory + QLatin1Char('/') + key + sJournalSuffix;
+}
+
+QString JournalImportCache::lookup(const QString &key) const
+{
+    if (key.isEmpty()) {
+        return QString();
+    }
+    const QString path = journalFile(key);
+    QFile file(path);
+    if (!file.exists()) {
+        return QString();
+    }
+    // the modification time is the last use, since cached files are never written
+    if (!file.open(QIODevice::ReadWrite) || !file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime)) {
+        qCDebug(KJOURNALDLIB_GENERAL) << "Could not mark cached journal file as used" << path << file.errorString();
+    }
+    return path;
+}
+
+bool JournalImportCache::insert(const QString &key, const QString &journalFile) const
+{
+    if (key.isEmpty()) {
+        return false;
+    }
+    const QString target = this->journalFile(key);
+    if (QFile::exists(target)) {
+        // another import of the same export completed first
+        return true;
+    }
+    // QFile::rename() copies between file systems, the intermediate name hides partially copied files
+    const QString partialTarget = target + QLatin1String(".part");
+    QFile::remove(partialTarget);
+    if (!QFile::rename(journalFile, partialTarget) || !QFile::rename(partialTarget, target)) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Could not move journal file into import cache" << journalFile << target;
+        QFile::remove(partialTarget);
+        return QFile::exists(target);
+    }
+    evict(key);
+    return true;
+}
+
+void JournalImportCache::evict(const QString &keep) const
+{
+    QFileInfoList entries = QDir(mDirectory).entryInfoList({QLatin1String("*.journal")}, QDir::Files);
+    qint64 totalSize{0};
+    for (const QFileInfo &entry : std::as_const(entries)) {
+        totalSize += entry.size();
+    }
+    if (totalSize <= mMaxSize) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const QFileInfo &lhs, const QFileInfo &rhs) {
+        return lhs.lastModified() < rhs.lastModified();
+    });
+    const QString keptFile = keep.isEmpty() ? QString() : QFileInfo(journalFile(keep)).absoluteFilePath();
+    for (const QFileInfo &entry : std::as_const(entries)) {
+        if (totalSize <= mMaxSize) {
+            break;
+        }
+        if (entry.absoluteFilePath() == keptFile) {
+            continue;
+        }
+        if (QFile::remove(entry.absoluteFilePath())) {
+            qCDebug(KJOURNALDLIB_GENERAL) << "Evicted cached journal file" << entry.absoluteFilePath() << entry.size();
+            totalSize -= entry.size();
+        }
+    }
+}
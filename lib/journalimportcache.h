@@ -0,0 +1,87 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef JOURNALIMPORTCACHE_H
+#define JOURNALIMPORTCACHE_H
+
+#include "kjournald_export.h"
+#include <QString>
+
+/**
+ * @brief Directory of journal files that were converted from journal export files
+ *
+ * Converting a large export with systemd-journal-remote takes minutes, while the resulting ".journal"
+ * file can be opened instantly. The cache keeps converted files named by a key of the export file,
+ * see key(), such that the same export is only imported once. The total size of the cache is bounded:
+ * when inserting a file, the least recently used files are removed until the cache fits into maxSize().
+ *
+ * Cache objects only describe the directory and are cheap to copy. Since removed files stay readable
+ * until they are closed, several processes may use the same cache directory.
+ */
+class KJOURNALD_EXPORT JournalImportCache
+{
+public:
+    static constexpr qint64 sDefaultMaxSize{10LL * 1024 * 1024 * 1024}; //!< 10 GiB
+
+    /**
+     * @brief Create cache in @p directory, which is created if it does not exist
+     *
+     * If @p directory is empty, the "imports" folder in the user's cache location is used.
+     */
+    explicit JournalImportCache(const QString &directory = QString(), qint64 maxSize = sDefaultMaxSize);
+
+    /**
+     * @return directory containing the cached journal files
+     */
+    QString directory() const;
+
+    /**
+     * @return size in bytes up to which cached files are kept
+     */
+    qint64 maxSize() const;
+
+    /**
+     * @brief Compute cache key of the export file at @p exportPath
+     *
+     * Hashing multi-GB exports completely would take almost as long as converting them. Thus the key is a
+     * hash of the file size, modification time and samples from the beginning, middle and end of the file.
+     *
+     * @return key or empty string if the file cannot be read
+     */
+    static QString key(const QString &exportPath);
+
+    /**
+     * @return path of the cached journal file for @p key, regardless whether it exists
+     */
+    QString journalFile(const QString &key) const;
+
+    /**
+     * @brief Find the cached journal file for @p key and mark it as recently used
+     * @return path of the cached journal file or empty string if none exists
+     */
+    QString lookup(const QString &key) const;
+
+    /**
+     * @brief Move the complete journal file @p journalFile into the cache as entry for @p key
+     *
+     * Files on the same file system as the cache directory are renamed, others are copied. Afterwards,
+     * least recently used files are evicted, see evict().
+     *
+     * @return true if the cache contains an entry for @p key
+     */
+    bool insert(const QString &key, const QString &journalFile) const;
+
+    /**
+     * @brief Remove least recently used files until the cache fits into maxSize()
+     * @param keep key of an entry that is never removed, e.g. the one that was just inserted
+     */
+    void evict(const QString &keep = QString()) const;
+
+private:
+    QString mDirectory;
+    qint64 mMaxSize{sDefaultMaxSize};
+};
+
+#endif // JOURNALIMPORTCACHE_H
@@ -0,0 +1,349 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "journalmetadatacache.h"
+#include "filterexpression.h"
+#include "kjournaldlib_log_general.h"
+#include "kjournaldlib_log_performance.h"
+#include "localjournal.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <algorithm>
+#include <deque>
+#include <future>
+
+namespace
+{
+constexpr quint32 sMagic{0x4b4a4d44}; // "KJMD"
+constexpr quint32 sFormatVersion{2};
+const QLatin1String sMetadataSuffix(".metadata");
+constexpr std::size_t sMaxSharedResults{4}; //!< journals whose results are kept by JournalMetadataCache::shared()
+
+using SharedResult = std::shared_future<std::shared_ptr<const JournalMetadataCache::Metadata>>;
+QMutex sSharedResultsMutex;
+std::deque<std::pair<QString, SharedResult>> sSharedResults; //!< most recent result last
+
+/**
+ * key of the state of all files @p headers, see JournalMetadataCache::shared()
+ */
+QString sharedKey(const QVector<JournalFileHeader> &headers)
+{
+    QStringList keys;
+    keys.reserve(headers.size());
+    for (const JournalFileHeader &header : headers) {
+        const QString key = JournalMetadataCache::key(header);
+        // every entry written to an online file increases its tail sequence number
+        keys.append(key.isEmpty() ? header.mPath + QLatin1Char('-') + QString::number(header.mTailEntrySeqnum) : key);
+    }
+    keys.sort();
+    return keys.join(QLatin1Char('/'));
+}
+
+QString metadataFile(const QString &directory, const QString &key)
+{
+    return directory + QLatin1Char('/') + key + sMetadataSuffix;
+}
+
+QVector<QString> sortedUnique(QSet<QString> values)
+{
+    QVector<QString> result(values.cbegin(), values.cend());
+    std::sort(result.begin(), result.end());
+    return result;
+}
+}
+
+JournalMetadataCache::JournalMetadataCache(const QString &directory, int maxEntries)
+    : mDirectory(directory)
+    , mMaxEntries(maxEntries)
+{
+    if (mDirectory.isEmpty()) {
+        mDirectory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/metadata");
+    }
+    if (!QDir().mkpath(mDirectory)) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Could not create metadata cache directory" << mDirectory;
+    }
+}
+
+QString JournalMetadataCache::directory() const
+{
+    return mDirectory;
+}
+
+int JournalMetadataCache::maxEntries() const
+{
+    return mMaxEntries;
+}
+
+QString JournalMetadataCache::key(const JournalFileHeader &header)
+{
+    if (header.mState == JournalFileHeader::State::ONLINE || header.mFileId.isEmpty()) {
+        return QString();
+    }
+    const QFileInfo info(header.mPath);
+    if (!info.exists()) {
+        return QString();
+    }
+    return header.mFileId + QLatin1Char('-') + QString::number(info.size()) + QLatin1Char('-')
+        + QString::number(info.lastModified().toMSecsSinceEpoch());
+}
+
+std::optional<JournalMetadataCache::FileMetadata> JournalMetadataCache::lookup(const QString &key) const
+{
+    if (key.isEmpty()) {
+        return std::nullopt;
+    }
+    QFile file(metadataFile(mDirectory, key));
+    // opened for writing if possible, such that the entry can be marked as used
+    if (!file.open(QIODevice::ReadWrite | QIODevice::ExistingOnly) && !file.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic{0};
+    quint32 version{0};
+    QString storedKey;
+    stream >> magic >> version >> storedKey;
+    if (magic != sMagic || version != sFormatVersion || storedKey != key) {
+        qCDebug(KJOURNALDLIB_GENERAL) << "Ignoring incompatible metadata cache entry" << file.fileName();
+        return std::nullopt;
+    }
+
+    FileMetadata metadata;
+    qint32 bootCount{0};
+    stream >> bootCount;
+    for (qint32 i = 0; i < bootCount && stream.status() == QDataStream::Ok; ++i) {
+        JournaldHelper::BootInfo boot;
+        stream >> boot.mBootId >> boot.mSince >> boot.mUntil;
+        metadata.mBoots.append(boot);
+    }
+    stream >> metadata.mUnits >> metadata.mExes;
+    stream >> metadata.mEntryCount >> metadata.mHeadRealtime >> metadata.mTailRealtime;
+    if (stream.status() != QDataStream::Ok) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Ignoring corrupt metadata cache entry" << file.fileName();
+        return std::nullopt;
+    }
+    // the modification time is the last use, since entries are never written again
+    if (!file.isWritable() || !file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime)) {
+        qCDebug(KJOURNALDLIB_GENERAL) << "Could not mark metadata cache entry as used" << file.fileName() << file.errorString();
+    }
+    return metadata;
+}
+
+bool JournalMetadataCache::insert(const QString &key, const FileMetadata &metadata) const
+{
+    if (key.isEmpty()) {
+        return false;
+    }
+    // QSaveFile replaces the entry atomically, thus readers never see partially written entries
+    QSaveFile file(metadataFile(mDirectory, key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Could not write metadata cache entry" << file.fileName() << file.errorString();
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << sMagic << sFormatVersion << key;
+    stream << qint32(metadata.mBoots.size());
+    for (const JournaldHelper::BootInfo &boot : metadata.mBoots) {
+        stream << boot.mBootId << boot.mSince << boot.mUntil;
+    }
+    stream << metadata.mUnits << metadata.mExes;
+    stream << metadata.mEntryCount << metadata.mHeadRealtime << metadata.mTailRealtime;
+    return file.commit();
+}
+
+void JournalMetadataCache::evict(const QSet<QString> &keep) const
+{
+    QFileInfoList entries = QDir(mDirectory).entryInfoList({QLatin1Char('*') + sMetadataSuffix}, QDir::Files);
+    if (entries.size() <= mMaxEntries) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const QFileInfo &lhs, const QFileInfo &rhs) {
+        return lhs.lastModified() < rhs.lastModified();
+    });
+    qsizetype count = entries.size();
+    for (const QFileInfo &entry : std::as_const(entries)) {
+        if (count <= mMaxEntries) {
+            break;
+        }
+        if (keep.contains(entry.completeBaseName())) {
+            continue;
+        }
+        if (QFile::remove(entry.absoluteFilePath())) {
+            qCDebug(KJOURNALDLIB_GENERAL) << "Evicted metadata cache entry" << entry.absoluteFilePath();
+            --count;
+        }
+    }
+}
+
+std::optional<JournalMetadataCache::FileMetadata> JournalMetadataCache::summarize(const JournalFileHeader &header)
+{
+    LocalJournal journal(header.mPath);
+    if (!journal.isValid()) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Could not open journal file for computing metadata" << header.mPath;
+        return std::nullopt;
+    }
+    FileMetadata metadata;
+    metadata.mUnits = journal.queryUnique(JournaldHelper::mapField(JournaldHelper::Field::_SYSTEMD_UNIT));
+    metadata.mExes = journal.queryUnique(JournaldHelper::mapField(JournaldHelper::Field::_EXE));
+    // the header is updated with every entry, thus it is as recent as the file's entries
+    metadata.mEntryCount = header.mEntryCount;
+
+    // the file has few boots, each of them costs two seeks
+    const QVector<QString> bootIds = journal.queryUnique(QLatin1String("_BOOT_ID"));
+    for (const QString &bootId : bootIds) {
+        if (const std::optional<JournaldHelper::BootInfo> boot = JournaldHelper::queryBoot(journal, bootId)) {
+            metadata.mBoots.append(boot.value());
+        }
+    }
+    std::sort(metadata.mBoots.begin(), metadata.mBoots.end(), [](const JournaldHelper::BootInfo &lhs, const JournaldHelper::BootInfo &rhs) {
+        return lhs.mSince < rhs.mSince;
+    });
+
+    if (!journal.setFilter(FilterExpression())) {
+        return std::nullopt;
+    }
+    if (journal.seekHead() && journal.next() > 0) {
+        metadata.mHeadRealtime = journal.realtimeUsec();
+    }
+    if (journal.seekTail() && journal.previous() > 0) {
+        metadata.mTailRealtime = journal.realtimeUsec();
+    }
+    return metadata;
+}
+
+JournalMetadataCache::Metadata JournalMetadataCache::query(const QVector<JournalFileHeader> &headers) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    struct Result {
+        std::optional<FileMetadata> mMetadata;
+        QString mKey;
+        bool mCached{false};
+    };
+    const JournalMetadataCache cache = *this;
+    const QList<Result> results = QtConcurrent::blockingMapped(headers, [cache](const JournalFileHeader &header) {
+        const QString key = JournalMetadataCache::key(header);
+        if (std::optional<FileMetadata> metadata = cache.lookup(key)) {
+            return Result{std::move(metadata), key, true};
+        }
+        std::optional<FileMetadata> metadata = JournalMetadataCache::summarize(header);
+        if (metadata && !key.isEmpty()) {
+            cache.insert(key, metadata.value());
+        }
+        return Result{std::move(metadata), key, false};
+    });
+
+    QVector<FileMetadata> files;
+    files.reserve(results.size());
+    QSet<QString> keys;
+    int cachedFiles{0};
+    bool inserted{false};
+    for (const Result &result : results) {
+        keys.insert(result.mKey);
+        if (result.mMetadata) {
+            files.append(result.mMetadata.value());
+            cachedFiles += result.mCached ? 1 : 0;
+            inserted = inserted || (!result.mCached && !result.mKey.isEmpty());
+        }
+    }
+    if (inserted) {
+        evict(keys);
+    }
+    Metadata metadata = merge(files);
+    metadata.mCachedFiles = cachedFiles;
+    metadata.mSummarizedFiles = static_cast<int>(files.size()) - cachedFiles;
+    qCDebug(KJOURNALDLIB_PERFORMANCE) << "Metadata of" << files.size() << "journal files," << metadata.mSummarizedFiles << "summarized, in" << timer.elapsed()
+                                      << "ms";
+    return metadata;
+}
+
+std::optional<JournalMetadataCache::Metadata> JournalMetadataCache::query(const IJournal &journal) const
+{
+    const QVector<JournalFileHeader> headers = journal.queryFiles();
+    if (headers.isEmpty()) {
+        return std::nullopt;
+    }
+    return query(headers);
+}
+
+std::shared_ptr<const JournalMetadataCache::Metadata> JournalMetadataCache::shared(const IJournal &journal)
+{
+    const QVector<JournalFileHeader> headers = journal.queryFiles();
+    if (headers.isEmpty()) {
+        return nullptr;
+    }
+    const QString key = sharedKey(headers);
+    std::promise<std::shared_ptr<const Metadata>> promise;
+    SharedResult result;
+    {
+        QMutexLocker locker(&sSharedResultsMutex);
+        const auto it = std::find_if(sSharedResults.cbegin(), sSharedResults.cend(), [&key](const std::pair<QString, SharedResult> &entry) {
+            return entry.first == key;
+        });
+        if (it != sSharedResults.cend()) {
+            result = it->second;
+        } else {
+            sSharedResults.emplace_back(key, promise.get_future().share());
+            if (sSharedResults.size() > sMaxSharedResults) {
+                sSharedResults.pop_front();
+            }
+        }
+    }
+    if (result.valid()) {
+        // waits for the caller that queries the same files concurrently
+        qCDebug(KJOURNALDLIB_PERFORMANCE) << "Using shared metadata of" << headers.size() << "journal files";
+        return result.get();
+    }
+    auto metadata = std::make_shared<const Metadata>(JournalMetadataCache().query(headers));
+    promise.set_value(metadata);
+    return metadata;
+}
+
+JournalMetadataCache::Metadata JournalMetadataCache::merge(const QVector<FileMetadata> &files)
+{
+    Metadata metadata;
+    QHash<QString, JournaldHelper::BootInfo> boots;
+    QSet<QString> units;
+    QSet<QString> exes;
+    for (const FileMetadata &file : files) {
+        // boots continue in the following files after rotation
+        for (const JournaldHelper::BootInfo &boot : file.mBoots) {
+            auto it = boots.find(boot.mBootId);
+            if (it == boots.end()) {
+                boots.insert(boot.mBootId, boot);
+            } else {
+                it->mSince = std::min(it->mSince, boot.mSince);
+                it->mUntil = std::max(it->mUntil, boot.mUntil);
+            }
+        }
+        units.unite(QSet<QString>(file.mUnits.cbegin(), file.mUnits.cend()));
+        exes.unite(QSet<QString>(file.mExes.cbegin(), file.mExes.cend()));
+        metadata.mEntryCount += file.mEntryCount;
+        if (file.mHeadRealtime > 0) {
+            metadata.mHeadRealtime = metadata.mHeadRealtime == 0 ? file.mHeadRealtime : std::min(metadata.mHeadRealtime, file.mHeadRealtime);
+        }
+        metadata.mTailRealtime = std::max(metadata.mTailRealtime, file.mTailRealtime);
+    }
+    metadata.mBoots = QVector<JournaldHelper::BootInfo>(boots.cbegin(), boots.cend());
+    std::sort(metadata.mBoots.begin(), metadata.mBoots.end(), [](const JournaldHelper::BootInfo &lhs, const JournaldHelper::BootInfo &rhs) {
+        return lhs.mSince < rhs.mSince;
+    });
+    metadata.mUnits = sortedUnique(std::move(units));
+    metadata.mExes = sortedUnique(std::move(exes));
+    return metadata;
+}
@@ -0,0 +1,160 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef JOURNALMETADATACACHE_H
+#define JOURNALMETADATACACHE_H
+
+#include "journaldhelper.h"
+#include "journalfileheader.h"
+#include "kjournald_export.h"
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include <optional>
+
+class IJournal;
+
+/**
+ * @brief Persistent cache of the meta data of journal files that are not written anymore
+ *
+ * Boots, unique "_SYSTEMD_UNIT" and "_EXE" values, the number of entries and the time range of a journal file
+ * never change once the file is archived. Yet, computing them requires to query every file of a journal on each
+ * start. The cache stores the meta data of each file in a sidecar file in the user's cache location, named by a
+ * key of the file ID, size and modification time of the journal file, see key(). Thus, only files that were not
+ * seen before are summarized by unique queries and seeks, see query() and summarize(). Files that are opened for
+ * writing are summarized on every query.
+ *
+ * Entries of files that were vacuumed or written again are never looked up anymore. Thus, the number of entries
+ * is bounded: after inserting entries, the least recently used entries are removed until at most maxEntries()
+ * remain, see evict().
+ *
+ * Cache objects only describe the directory and are cheap to copy. Entries are written atomically, such that
+ * several processes may use the same cache directory.
+ */
+class KJOURNALD_EXPORT JournalMetadataCache
+{
+public:
+    static constexpr int sDefaultMaxEntries{1000}; //!< about ten times the files of a journal with default size limits
+
+    /**
+     * @brief Meta data of a single journal file
+     */
+    struct FileMetadata {
+        QVector<JournaldHelper::BootInfo> mBoots; //!< boots with entries in the file, ordered by since time
+        QVector<QString> mUnits; //!< unique values of "_SYSTEMD_UNIT"
+        QVector<QString> mExes; //!< unique values of "_EXE"
+        quint64 mEntryCount{0};
+        quint64 mHeadRealtime{0}; //!< realtime timestamp of first entry in microseconds
+        quint64 mTailRealtime{0}; //!< realtime timestamp of last entry in microseconds
+    };
+
+    /**
+     * @brief Meta data of all files of a journal
+     */
+    struct Metadata {
+        QVector<JournaldHelper::BootInfo> mBoots; //!< boots ordered by since time, boots spanning several files are merged
+        QVector<QString> mUnits; //!< sorted unique values of "_SYSTEMD_UNIT"
+        QVector<QString> mExes; //!< sorted unique values of "_EXE"
+        quint64 mEntryCount{0};
+        quint64 mHeadRealtime{0};
+        quint64 mTailRealtime{0};
+        int mCachedFiles{0}; //!< number of files whose meta data was read from the cache
+        int mSummarizedFiles{0}; //!< number of files that were summarized, because they are not cached or opened for writing
+    };
+
+    /**
+     * @brief Create cache in @p directory, which is created if it does not exist
+     *
+     * If @p directory is empty, the "metadata" folder in the user's cache location is used.
+     */
+    explicit JournalMetadataCache(const QString &directory = QString(), int maxEntries = sDefaultMaxEntries);
+
+    /**
+     * @return directory containing the cached meta data
+     */
+    QString directory() const;
+
+    /**
+     * @return number of entries up to which cached meta data is kept
+     */
+    int maxEntries() const;
+
+    /**
+     * @brief Compute cache key of the journal file described by @p header
+     *
+     * Files that are opened for writing are never cached, because their meta data changes with every entry.
+     * Files that are only offline may be opened for writing again, which changes their size and modification
+     * time and thus their key.
+     *
+     * @return key or empty string if the file cannot be cached
+     */
+    static QString key(const JournalFileHeader &header);
+
+    /**
+     * @brief Read the entry for @p key and mark it as recently used
+     * @return cached meta data for @p key or std::nullopt if there is no valid entry
+     */
+    std::optional<FileMetadata> lookup(const QString &key) const;
+
+    /**
+     * @brief Store @p metadata as entry for @p key
+     * @return true if the entry was written
+     */
+    bool insert(const QString &key, const FileMetadata &metadata) const;
+
+    /**
+     * @brief Remove least recently used entries until the cache contains at most maxEntries() entries
+     * @param keep keys of entries that are never removed, e.g. those of the files that were just queried
+     */
+    void evict(const QSet<QString> &keep = QSet<QString>()) const;
+
+    /**
+     * @brief Compute meta data of the journal file @p header without iterating its entries
+     *
+     * Boots, unique values and the time range are obtained by unique queries and seeks, which only read the
+     * files' indexes, and the entry count is taken from the header.
+     * @return meta data or std::nullopt if the file cannot be opened
+     */
+    static std::optional<FileMetadata> summarize(const JournalFileHeader &header);
+
+    /**
+     * @brief Meta data of all journal files @p headers
+     *
+     * Cached files are read from the cache and all other files are summarized in parallel, the summaries of files
+     * that are not opened for writing are stored in the cache. If entries were stored, the cache is evicted
+     * afterwards, keeping the entries of @p headers. This method blocks and is meant to be called from a
+     * worker thread.
+     */
+    Metadata query(const QVector<JournalFileHeader> &headers) const;
+
+    /**
+     * @brief Meta data of all files of @p journal, see IJournal::queryFiles()
+     * @return meta data or std::nullopt if the journal does not provide its files, e.g. for in-memory journals
+     */
+    std::optional<Metadata> query(const IJournal &journal) const;
+
+    /**
+     * @brief Meta data of all files of @p journal in the default cache, shared by all callers in the process
+     *
+     * BootModel, FilterCriteriaModel and JournaldUniqueQueryModel need the meta data of the same journal at the
+     * same time. Calls for the same unchanged files, also concurrent ones, share the result of a single query();
+     * files are considered changed if their cache key or, for files opened for writing, their last entry changes.
+     * This method blocks and is meant to be called from a worker thread.
+     * @return meta data or nullptr if the journal does not provide its files
+     */
+    static std::shared_ptr<const Metadata> shared(const IJournal &journal);
+
+    /**
+     * @brief Combine the meta data of several files
+     */
+    static Metadata merge(const QVector<FileMetadata> &files);
+
+private:
+    QString mDirectory;
+    int mMaxEntries;
+};
+
+#endif // JOURNALMETADATACACHE_H
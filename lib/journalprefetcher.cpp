@@ -0,0 +1,142 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "journalprefetcher.h"
+#include "journalprefetcher_p.h"
+#include "kjournaldlib_log_general.h"
+#include "kjournaldlib_log_performance.h"
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+quint64 distance(const JournalFileHeader &header, quint64 realtimeUsec)
+{
+    if (realtimeUsec < header.mHeadEntryRealtime) {
+        return header.mHeadEntryRealtime - realtimeUsec;
+    }
+    if (realtimeUsec > header.mTailEntryRealtime) {
+        return realtimeUsec - header.mTailEntryRealtime;
+    }
+    return 0;
+}
+}
+
+JournalPrefetcher::Statistics
+JournalPrefetcherPrivate::run(const QVector<JournalFileHeader> &files, quint64 byteLimit, std::shared_ptr<std::atomic_bool> canceled)
+{
+    QElapsedTimer timer;
+    timer.start();
+    JournalPrefetcher::Statistics statistics;
+    for (const auto &file : files) {
+        if (canceled->load()) {
+            statistics.mCanceled = true;
+            break;
+        }
+        const int fd = ::open(file.mPath.toLocal8Bit().constData(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            qCWarning(KJOURNALDLIB_GENERAL) << "Could not open file for prefetching" << file.mPath << strerror(errno);
+            continue;
+        }
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) < 0) {
+            qCWarning(KJOURNALDLIB_GENERAL) << "Could not obtain size of file for prefetching" << file.mPath << strerror(errno);
+            ::close(fd);
+            continue;
+        }
+        if (statistics.mBytes + static_cast<quint64>(fileStat.st_size) > byteLimit) {
+            // a smaller file with lower priority may still fit
+            ::close(fd);
+            continue;
+        }
+        // the advice is given in blocks, such that a cancellation does not wait for a complete large file
+        const quint64 size = fileStat.st_size;
+        for (quint64 offset = 0; offset < size && !canceled->load(); offset += sAdviseBlockSize) {
+            const int result = posix_fadvise(fd, offset, std::min(sAdviseBlockSize, size - offset), POSIX_FADV_WILLNEED);
+            if (result != 0) {
+                qCWarning(KJOURNALDLIB_GENERAL) << "Could not prefetch file" << file.mPath << strerror(result);
+                break;
+            }
+            statistics.mBytes += std::min(sAdviseBlockSize, size - offset);
+        }
+        ::close(fd);
+        ++statistics.mFileCount;
+    }
+    statistics.mDurationMs = timer.elapsed();
+    return statistics;
+}
+
+JournalPrefetcher::JournalPrefetcher(QObject *parent)
+    : QObject(parent)
+    , d(new JournalPrefetcherPrivate)
+{
+    d->mThreadPool.setMaxThreadCount(1);
+    connect(&d->mWatcher, &QFutureWatcher<Statistics>::finished, this, [this]() {
+        if (d->mWatcher.future().resultCount() == 0) {
+            return;
+        }
+        d->mLastStatistics = d->mWatcher.result();
+        qCDebug(KJOURNALDLIB_PERFORMANCE) << "Prefetched" << d->mLastStatistics.mFileCount << "files with" << d->mLastStatistics.mBytes / 1024 << "KiB in"
+                                          << d->mLastStatistics.mDurationMs << "ms" << (d->mLastStatistics.mCanceled ? "(canceled)" : "");
+        Q_EMIT finished(d->mLastStatistics);
+    });
+}
+
+JournalPrefetcher::~JournalPrefetcher()
+{
+    cancel();
+    d->mThreadPool.waitForDone();
+}
+
+void JournalPrefetcher::prefetch(const QVector<JournalFileHeader> &files, quint64 viewportRealtimeUsec)
+{
+    cancel();
+    if (files.isEmpty()) {
+        return;
+    }
+    d->mCanceled = std::make_shared<std::atomic_bool>(false);
+    d->mWatcher.setFuture(QtConcurrent::run(&d->mThreadPool, &JournalPrefetcherPrivate::run, prioritized(files, viewportRealtimeUsec), d->mByteLimit, d->mCanceled));
+}
+
+void JournalPrefetcher::cancel()
+{
+    if (d->mCanceled) {
+        d->mCanceled->store(true);
+    }
+}
+
+bool JournalPrefetcher::isRunning() const
+{
+    return d->mWatcher.isRunning();
+}
+
+void JournalPrefetcher::waitForFinished()
+{
+    d->mWatcher.waitForFinished();
+}
+
+JournalPrefetcher::Statistics JournalPrefetcher::lastStatistics() const
+{
+    return d->mLastStatistics;
+}
+
+void JournalPrefetcher::setByteLimit(quint64 bytes)
+{
+    d->mByteLimit = bytes;
+}
+
+QVector<JournalFileHeader> JournalPrefetcher::prioritized(QVector<JournalFileHeader> files, quint64 viewportRealtimeUsec)
+{
+    std::stable_sort(files.begin(), files.end(), [viewportRealtimeUsec](const JournalFileHeader &lhs, const JournalFileHeader &rhs) {
+        return distance(lhs, viewportRealtimeUsec) < distance(rhs, viewportRealtimeUsec);
+    });
+    return files;
+}
@@ -0,0 +1,103 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef JOURNALPREFETCHER_H
+#define JOURNALPREFETCHER_H
+
+#include "journalfileheader.h"
+#include "kjournald_export.h"
+#include <QObject>
+#include <QVector>
+#include <memory>
+
+class JournalPrefetcherPrivate;
+
+/**
+ * @brief Warms the page cache for journal files in a background thread
+ *
+ * libsystemd accesses journal files via mmap, such that the first access to an archived boot on
+ * spinning disks or network storage is dominated by page faults that are served one after another.
+ * The prefetcher instead announces the files via posix_fadvise(POSIX_FADV_WILLNEED), which lets the
+ * kernel read them ahead in large requests. Files whose time range is nearest to the viewport are
+ * announced first.
+ *
+ * Statistics of each prefetch run are logged in the kjournald.lib.performance category.
+ */
+class KJOURNALD_EXPORT JournalPrefetcher : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Result of one prefetch run
+     */
+    struct Statistics {
+        int mFileCount{0}; //!< number of announced files
+        quint64 mBytes{0}; //!< number of announced bytes
+        qint64 mDurationMs{0}; //!< duration of the run
+        bool mCanceled{false}; //!< true if the run was canceled before all files were announced
+    };
+
+    /**
+     * @brief Construct idle prefetcher
+     */
+    explicit JournalPrefetcher(QObject *parent = nullptr);
+
+    /**
+     * @brief Destroys the prefetcher and cancels a running prefetch
+     */
+    ~JournalPrefetcher() override;
+
+    /**
+     * @brief Start prefetching @p files in background, canceling any running prefetch
+     *
+     * @param files the journal files that back the current view
+     * @param viewportRealtimeUsec realtime timestamp of the viewport, files nearest to it are prefetched first
+     */
+    void prefetch(const QVector<JournalFileHeader> &files, quint64 viewportRealtimeUsec);
+
+    /**
+     * @brief Cancel running prefetch, if any
+     */
+    void cancel();
+
+    /**
+     * @return true while a prefetch is running
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Block until the running prefetch is finished
+     */
+    void waitForFinished();
+
+    /**
+     * @return statistics of the last finished prefetch
+     */
+    Statistics lastStatistics() const;
+
+    /**
+     * @brief Set maximal number of bytes that are prefetched per run
+     * @note the initial value is 256 MiB, files beyond the limit are skipped
+     */
+    void setByteLimit(quint64 bytes);
+
+    /**
+     * @return @p files ordered by distance of their time range to @p viewportRealtimeUsec, nearest first
+     */
+    static QVector<JournalFileHeader> prioritized(QVector<JournalFileHeader> files, quint64 viewportRealtimeUsec);
+
+Q_SIGNALS:
+    /**
+     * @brief Signal is emitted when a prefetch run is finished or was canceled
+     */
+    void finished(const JournalPrefetcher::Statistics &statistics);
+
+private:
+    std::unique_ptr<JournalPrefetcherPrivate> d;
+};
+
+Q_DECLARE_METATYPE(JournalPrefetcher::Statistics)
+
+#endif // JOURNALPREFETCHER_H
@@ -0,0 +1,32 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef JOURNALPREFETCHER_P_H
+#define JOURNALPREFETCHER_P_H
+
+#include "journalprefetcher.h"
+#include <QFutureWatcher>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+
+class JournalPrefetcherPrivate
+{
+public:
+    /**
+     * announce @p files to the kernel until @p canceled is set
+     */
+    static JournalPrefetcher::Statistics run(const QVector<JournalFileHeader> &files, quint64 byteLimit, std::shared_ptr<std::atomic_bool> canceled);
+
+    static constexpr quint64 sAdviseBlockSize{8 * 1024 * 1024}; //!< granularity at which cancellation is checked
+
+    QThreadPool mThreadPool; //!< dedicated pool such that IO bound prefetching never blocks the global pool
+    QFutureWatcher<JournalPrefetcher::Statistics> mWatcher;
+    std::shared_ptr<std::atomic_bool> mCanceled;
+    JournalPrefetcher::Statistics mLastStatistics;
+    quint64 mByteLimit{256 * 1024 * 1024};
+};
+
+#endif // JOURNALPREFETCHER_P_H
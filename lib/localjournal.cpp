@@ -7,7 +7,12 @@
 #include "localjournal_p.h"
 #include "kjournaldlib_log_general.h"
 #include <QDir>
+#include <QRegularExpression>
+#include <QSet>
+#include <algorithm>
+#include <iterator>
 #include <systemd/sd-journal.h>
+#include <vector>
 
 LocalJournalPrivate::LocalJournalPrivate()
 {
@@ -21,6 +26,43 @@ LocalJournalPrivate::LocalJournalPrivate()
     }
 }
 
+QStringList LocalJournalPrivate::journalDirectories(const QString &path)
+{
+    // same layout as considered by sd_journal_open_directory: the directory and its machine ID subdirectories
+    static const QRegularExpression machineIdPattern(QLatin1String("^[0-9a-f]{32}$"));
+    QStringList directories{path};
+    const QDir directory(path);
+    for (const QString &subdirectory : directory.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        if (machineIdPattern.match(subdirectory).hasMatch()) {
+            directories.append(directory.filePath(subdirectory));
+        }
+    }
+    return directories;
+}
+
+QStringList LocalJournalPrivate::journalFiles(const QString &path)
+{
+    const QStringList nameFilters{QLatin1String("*.journal"), QLatin1String("*.journal~")};
+    QStringList files;
+    for (const QString &directoryPath : journalDirectories(path)) {
+        const QDir directory(directoryPath);
+        for (const QString &file : directory.entryList(nameFilters, QDir::Files)) {
+            files.append(directory.filePath(file));
+        }
+    }
+    return files;
+}
+
+QString LocalJournalPrivate::localMachineId()
+{
+    QFile file(QLatin1String("/etc/machine-id"));
+    if (!file.open(QIODevice::ReadOnly | QFile::Text)) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Could not obtain machine ID";
+        return QString();
+    }
+    return QString::fromLatin1(file.readAll().trimmed());
+}
+
 LocalJournal::LocalJournal()
     : d(new LocalJournalPrivate)
 {
@@ -29,14 +71,7 @@ LocalJournal::LocalJournal()
         qCCritical(KJOURNALDLIB_GENERAL) << "Failed to open journal:" << strerror(-expectedJournal.ret);
     } else {
         d->mJournal = std::move(expectedJournal.value);
-        d->mFd = sd_journal_get_fd(d->mJournal.get());
-        if (d->mFd > 0) {
-            d->mJournalSocketNotifier = std::make_unique<QSocketNotifier>(d->mFd, QSocketNotifier::Read);
-            connect(d->mJournalSocketNotifier.get(), &QSocketNotifier::activated, this, &LocalJournal::handleJournalDescriptorUpdate);
-        } else {
-            qCWarning(KJOURNALDLIB_GENERAL) << "Could not create FD" << strerror(-d->mFd);
-            d->mFd = 0;
-        }
+        setupJournalDescriptorNotifier();
     }
 }
 
@@ -47,30 +82,71 @@ LocalJournal::LocalJournal(const QString &path)
         qCCritical(KJOURNALDLIB_GENERAL) << "Journal directory does not exist, abort opening" << path;
         return;
     }
+    d->mSourcePath = path;
     if (QFileInfo(path).isDir()) {
-        auto expectedJournal = owning_ptr_call<sd_journal>(sd_journal_open_directory, path.toStdString().c_str(), 0 /* no flags, directory defines type */);
-        if (expectedJournal.ret < 0) {
-            qCCritical(KJOURNALDLIB_GENERAL) << "Could not open journal from directory" << path << ":" << strerror(-expectedJournal.ret);
-        } else {
-            d->mJournal = std::move(expectedJournal.value);
-        }
+        d->mPath = path;
+        openDirectory(path);
     } else if (QFileInfo(path).isFile()) {
-        const char **files = new const char *[1];
-        QByteArray journalPath = path.toLocal8Bit();
-        files[0] = journalPath.data();
-
-        auto expectedJournal = owning_ptr_call<sd_journal>(sd_journal_open_files, files, 0 /* no flags, directory defines type */);
-        if (expectedJournal.ret < 0) {
-            qCCritical(KJOURNALDLIB_GENERAL) << "Could not open journal from file" << path << ":" << strerror(-expectedJournal.ret);
-        } else {
-            d->mJournal = std::move(expectedJournal.value);
-        }
-        delete[] files;
+        openFiles({path});
     }
 }
 
 LocalJournal::~LocalJournal() = default;
 
+void LocalJournal::openDirectory(const QString &path)
+{
+    d->mJournalSocketNotifier.reset();
+    d->mJournal.reset();
+    d->mOpenedFiles.clear();
+    auto expectedJournal = owning_ptr_call<sd_journal>(sd_journal_open_directory, path.toStdString().c_str(), 0 /* no flags, directory defines type */);
+    if (expectedJournal.ret < 0) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Could not open journal from directory" << path << ":" << strerror(-expectedJournal.ret);
+    } else {
+        d->mJournal = std::move(expectedJournal.value);
+        setupJournalDescriptorNotifier();
+    }
+}
+
+void LocalJournal::openFiles(const QStringList &paths)
+{
+    d->mJournalSocketNotifier.reset();
+    d->mJournal.reset();
+    QVector<QByteArray> journalPaths;
+    std::vector<const char *> files;
+    for (const QString &path : paths) {
+        journalPaths.append(path.toLocal8Bit());
+    }
+    for (const QByteArray &path : std::as_const(journalPaths)) {
+        files.push_back(path.constData());
+    }
+    files.push_back(nullptr);
+
+    auto expectedJournal = owning_ptr_call<sd_journal>(sd_journal_open_files, files.data(), 0 /* no flags, directory defines type */);
+    if (expectedJournal.ret < 0) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Could not open journal from files" << paths << ":" << strerror(-expectedJournal.ret);
+    } else {
+        d->mJournal = std::move(expectedJournal.value);
+        setupJournalDescriptorNotifier();
+    }
+}
+
+void LocalJournal::setupJournalDescriptorNotifier()
+{
+    if (!d->mWatching) {
+        return;
+    }
+    // for journals opened from a path, the descriptor watches the opened directory or files via inotify
+    d->mFd = sd_journal_get_fd(d->mJournal.get());
+    if (d->mFd > 0) {
+        // notifier is child such that it follows the journal when moved to another thread
+        d->mJournalSocketNotifier = std::make_unique<QSocketNotifier>(d->mFd, QSocketNotifier::Read, this);
+        connect(d->mJournalSocketNotifier.get(), &QSocketNotifier::activated, this, &LocalJournal::handleJournalDescriptorUpdate);
+    } else {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Could not create FD" << strerror(-d->mFd);
+        d->mFd = 0;
+    }
+}
+
 sd_journal *LocalJournal::sdJournal() const
 {
     return d->mJournal.get();
@@ -86,6 +162,134 @@ QString LocalJournal::currentBootId() const
     return d->mCurrentBootId;
 }
 
+void LocalJournal::prepareQuery(const FilterExpression &expression)
+{
+    if (d->mPath.isEmpty()) {
+        return;
+    }
+    d->mQueryExpression = expression;
+    openSelectedFiles();
+}
+
+bool LocalJournal::setFilter(const FilterExpression &expression)
+{
+    d->mFilter = expression;
+    return IJournal::setFilter(expression);
+}
+
+bool LocalJournal::openSelectedFiles()
+{
+    const FilterExpression &expression = d->mQueryExpression;
+    const bool prunable = expression.requiredValues(QLatin1String("_BOOT_ID")) || expression.requiredRange(QLatin1String("__REALTIME_TIMESTAMP"));
+    if (prunable && !d->mFileHeaders) {
+        d->mFileHeaders = JournalFileHeader::readAll(LocalJournalPrivate::journalFiles(d->mPath));
+    }
+
+    QStringList selectedFiles;
+    if (prunable) {
+        const QVector<JournalFileHeader> selection = JournalFileHeader::select(d->mFileHeaders.value(), expression);
+        if (selection.isEmpty()) {
+            // nothing can match, which the query's matches already ensure with the currently opened files
+            return false;
+        }
+        QSet<QString> selectedPaths;
+        for (const auto &header : selection) {
+            selectedPaths.insert(header.mPath);
+        }
+        for (const auto &header : d->mFileHeaders.value()) {
+            // headers of files that are written to are outdated with the next entry
+            if (header.mState == JournalFileHeader::State::ONLINE || selectedPaths.contains(header.mPath)) {
+                selectedFiles.append(header.mPath);
+            }
+        }
+        if (selectedFiles.size() == d->mFileHeaders->size()) {
+            selectedFiles.clear();
+        }
+    }
+    if (selectedFiles == d->mOpenedFiles) {
+        return false;
+    }
+    if (selectedFiles.isEmpty()) {
+        qCDebug(KJOURNALDLIB_GENERAL) << "Reopen complete journal directory" << d->mPath;
+        openDirectory(d->mPath);
+        if (d->mDirectoryWatcher && !d->mDirectoryWatcher->directories().isEmpty()) {
+            // the journal's descriptor watches the directory itself
+            d->mDirectoryWatcher->removePaths(d->mDirectoryWatcher->directories());
+        }
+    } else {
+        qCDebug(KJOURNALDLIB_GENERAL) << "Open" << selectedFiles.size() << "of" << d->mFileHeaders->size() << "journal files in" << d->mPath;
+        openFiles(selectedFiles);
+        if (d->mJournal) {
+            d->mOpenedFiles = selectedFiles;
+        }
+        // the journal's descriptor only watches the opened files, thus new files are noticed by watching the directory
+        if (!d->mWatching) {
+            return true;
+        }
+        if (!d->mDirectoryWatcher) {
+            d->mDirectoryWatcher = std::make_unique<QFileSystemWatcher>(this);
+            connect(d->mDirectoryWatcher.get(), &QFileSystemWatcher::directoryChanged, this, &LocalJournal::handleDirectoryChange);
+        }
+        const QStringList directories = LocalJournalPrivate::journalDirectories(d->mPath);
+        for (const QString &directory : directories) {
+            if (!d->mDirectoryWatcher->directories().contains(directory)) {
+                d->mDirectoryWatcher->addPath(directory);
+            }
+        }
+    }
+    return true;
+}
+
+QVector<JournalFileHeader> LocalJournal::queryFiles() const
+{
+    if (!isValid()) {
+        return {};
+    }
+    if (d->mPath.isEmpty()) {
+        // files of the system journal are rotated all the time, thus they are not cached
+        const QString machineId = LocalJournalPrivate::localMachineId();
+        if (machineId.isEmpty()) {
+            return {};
+        }
+        QStringList files;
+        for (const QLatin1String &root : {QLatin1String("/run/log/journal/"), QLatin1String("/var/log/journal/")}) {
+            files.append(LocalJournalPrivate::journalFiles(root + machineId));
+        }
+        return JournalFileHeader::readAll(files);
+    }
+    if (!d->mFileHeaders) {
+        d->mFileHeaders = JournalFileHeader::readAll(LocalJournalPrivate::journalFiles(d->mPath));
+    }
+    if (d->mOpenedFiles.isEmpty()) {
+        return d->mFileHeaders.value();
+    }
+    QVector<JournalFileHeader> headers;
+    std::copy_if(d->mFileHeaders->cbegin(), d->mFileHeaders->cend(), std::back_inserter(headers), [this](const JournalFileHeader &header) {
+        return d->mOpenedFiles.contains(header.mPath);
+    });
+    return headers;
+}
+
+std::unique_ptr<IJournal> LocalJournal::clone() const
+{
+    if (d->mSourcePath.isEmpty()) {
+        return std::make_unique<LocalJournal>();
+    }
+    return std::make_unique<LocalJournal>(d->mSourcePath);
+}
+
+void LocalJournal::stopWatching()
+{
+    d->mWatching = false;
+    d->mJournalSocketNotifier.reset();
+    d->mDirectoryWatcher.reset();
+}
+
+QStringList LocalJournal::openedFiles() const
+{
+    return d->mOpenedFiles;
+}
+
 uint64_t LocalJournal::usage() const
 {
     uint64_t size{0};
@@ -98,11 +302,34 @@ uint64_t LocalJournal::usage() const
 
 void LocalJournal::handleJournalDescriptorUpdate()
 {
-    // reset descriptor
-    QFile file;
-    file.open(d->mFd, QIODevice::ReadOnly);
-    file.readAll();
-    file.close();
-    qCDebug(KJOURNALDLIB_GENERAL) << "Local journal FD updated";
-    Q_EMIT journalUpdated(d->mCurrentBootId);
+    // processing the inotify events also resets the descriptor
+    const int result = sd_journal_process(d->mJournal.get());
+    switch (result) {
+    case SD_JOURNAL_NOP:
+        break;
+    case SD_JOURNAL_APPEND:
+        qCDebug(KJOURNALDLIB_GENERAL) << "Local journal FD updated, entries appended";
+        Q_EMIT journalUpdated(d->mCurrentBootId, IJournal::ChangeType::APPEND);
+        break;
+    case SD_JOURNAL_INVALIDATE:
+        qCDebug(KJOURNALDLIB_GENERAL) << "Local journal FD updated, journal files changed";
+        d->mFileHeaders.reset();
+        Q_EMIT journalUpdated(d->mCurrentBootId, IJournal::ChangeType::INVALIDATE);
+        break;
+    default:
+        if (result < 0) {
+            qCWarning(KJOURNALDLIB_GENERAL) << "Could not process journal changes:" << strerror(-result);
+        }
+    }
+}
+
+void LocalJournal::handleDirectoryChange()
+{
+    qCDebug(KJOURNALDLIB_GENERAL) << "Journal directory changed while only a subset of its files is opened";
+    d->mFileHeaders.reset();
+    if (openSelectedFiles() && d->mJournal) {
+        // reopening replaced the sd_journal object and with it all matches
+        IJournal::setFilter(d->mFilter);
+    }
+    Q_EMIT journalUpdated(d->mCurrentBootId, IJournal::ChangeType::INVALIDATE);
 }
@@ -34,7 +34,8 @@ public:
 
     /**
      * @brief Construct journal object from journald DB at path @p path
-     * This path can be a directory or a file.
+     * This path can be a directory or a file. Like for the system journal, changes of the journal files
+     * are reported via journalUpdated, e.g. when the directory is written by systemd-journal-remote.
      */
     LocalJournal(const QString &path);
 
@@ -61,6 +62,48 @@ public:
      */
     QString currentBootId() const override;
 
+    /**
+     * @brief Open only the files of a journal directory that may contain entries matching @p expression
+     *
+     * For journals opened from a directory, the headers of the journal files are inspected when the
+     * query requires specific "_BOOT_ID" values or a "__REALTIME_TIMESTAMP" range, and only the
+     * files that can contain matching entries are opened, see JournalFileHeader::select(). Files that are
+     * opened for writing are always opened, because their headers change with every entry. While only a
+     * subset of files is opened, the directory is watched and the selection is updated when files are added,
+     * removed or rotated, which is reported as IJournal::ChangeType::INVALIDATE.
+     */
+    void prepareQuery(const FilterExpression &expression) override;
+
+    /**
+     * @copydoc IJournal::setFilter()
+     *
+     * The filter is applied again when the opened files are replaced due to changes of the journal directory.
+     */
+    bool setFilter(const FilterExpression &expression) override;
+
+    /**
+     * @copydoc IJournal::queryFiles()
+     *
+     * For the system journal, these are the files of the local machine in the runtime and persistent journal directories.
+     */
+    QVector<JournalFileHeader> queryFiles() const override;
+
+    /**
+     * @copydoc IJournal::clone()
+     */
+    std::unique_ptr<IJournal> clone() const override;
+
+    /**
+     * @copydoc IJournal::stopWatching()
+     */
+    void stopWatching() override;
+
+    /**
+     * @return paths of the opened journal files if only a subset of the journal directory is opened,
+     *         otherwise an empty list
+     */
+    QStringList openedFiles() const;
+
     /**
      * @brief Get file system usage of journal
      * @return size of journal in bytes
@@ -69,8 +112,32 @@ public:
 
 private
     Q_SLOT : void handleJournalDescriptorUpdate();
+    Q_SLOT void handleDirectoryChange();
 
 private:
+    /**
+     * Open all journal files in directory @p path, replacing any opened journal
+     */
+    void openDirectory(const QString &path);
+
+    /**
+     * Open journal files @p paths, replacing any opened journal
+     */
+    void openFiles(const QStringList &paths);
+
+    /**
+     * Open the files of the journal directory that may contain entries matching the last prepareQuery()
+     * expression, or the whole directory if no file can be skipped
+     * @return true if the journal was reopened
+     */
+    bool openSelectedFiles();
+
+    /**
+     * Watch the journal's inotify descriptor for changes, such that journalUpdated is emitted, unless
+     * watching was stopped
+     */
+    void setupJournalDescriptorNotifier();
+
     std::unique_ptr<LocalJournalPrivate> d;
 };
 
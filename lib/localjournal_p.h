@@ -6,19 +6,49 @@
 #ifndef LOCALJOURNAL_PRIVATE_H
 #define LOCALJOURNAL_PRIVATE_H
 
+#include "filterexpression.h"
+#include "journalfileheader.h"
 #include "memory.h"
+#include <QFileSystemWatcher>
 #include <QSocketNotifier>
+#include <QStringList>
+#include <QVector>
 #include <QtGlobal>
+#include <optional>
 #include <systemd/sd-journal.h>
 
 class LocalJournalPrivate
 {
 public:
     LocalJournalPrivate();
+
+    /**
+     * @return directory @p path and its machine ID subdirectories
+     */
+    static QStringList journalDirectories(const QString &path);
+
+    /**
+     * @return journal files in directory @p path and its machine ID subdirectories
+     */
+    static QStringList journalFiles(const QString &path);
+
+    /**
+     * @return ID of the local machine
+     */
+    static QString localMachineId();
+
     mutable std::unique_ptr<sd_journal> mJournal;
     qintptr mFd{0};
     QString mCurrentBootId;
+    QString mSourcePath; //!< path the journal was opened from, empty for system journal
+    QString mPath; //!< path of journal directory, empty for system journal and journal files
+    std::optional<QVector<JournalFileHeader>> mFileHeaders; //!< headers of all files in mPath, read on first use
+    QStringList mOpenedFiles; //!< opened subset of files in mPath, empty if the whole directory is opened
+    FilterExpression mQueryExpression; //!< expression of the last prepareQuery() call
+    FilterExpression mFilter; //!< expression of the last setFilter() call, reapplied when reopening files
     std::unique_ptr<QSocketNotifier> mJournalSocketNotifier;
+    std::unique_ptr<QFileSystemWatcher> mDirectoryWatcher; //!< watches mPath while only a subset of files is opened
+    bool mWatching{true}; //!< false after stopWatching(), then neither notifier nor watcher is created
 };
 
 #endif // LOCALJOURNAL_H
@@ -0,0 +1,685 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "memoryjournal.h"
+#include "journaldexportreader.h"
+#include "journaldjsonreader.h"
+#include "journaldhelper.h"
+#include "kjournaldlib_log_filtertrace.h"
+#include "kjournaldlib_log_general.h"
+#include "kjournaldlib_log_performance.h"
+#include "memoryjournal_p.h"
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QThread>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+namespace
+{
+const QByteArrayView sRealtimeTimestampField{"__REALTIME_TIMESTAMP"};
+const QByteArrayView sMonotonicTimestampField{"__MONOTONIC_TIMESTAMP"};
+const QByteArrayView sCursorField{"__CURSOR"};
+
+std::vector<quint32> intersect(const std::vector<quint32> &lhs, const std::vector<quint32> &rhs)
+{
+    std::vector<quint32> result;
+    std::set_intersection(lhs.cbegin(), lhs.cend(), rhs.cbegin(), rhs.cend(), std::back_inserter(result));
+    return result;
+}
+
+std::vector<quint32> unite(const std::vector<quint32> &lhs, const std::vector<quint32> &rhs)
+{
+    std::vector<quint32> result;
+    result.reserve(lhs.size() + rhs.size());
+    std::set_union(lhs.cbegin(), lhs.cend(), rhs.cbegin(), rhs.cend(), std::back_inserter(result));
+    return result;
+}
+}
+
+const QList<QByteArray> MemoryJournalPrivate::sIndexedFields{
+    QByteArray("_BOOT_ID"),
+    QByteArray("_SYSTEMD_UNIT"),
+    QByteArray("_EXE"),
+    QByteArray("PRIORITY"),
+    QByteArray("_TRANSPORT"),
+    QByteArray("SYSLOG_IDENTIFIER"),
+};
+
+std::optional<QByteArrayView> MemoryJournalStore::value(const Column &column, quint32 entry) const
+{
+    const quint32 id = column.mValues[entry];
+    if (id == 0) {
+        return std::nullopt;
+    }
+    return QByteArrayView(column.mDictionary[id - 1]);
+}
+
+const MemoryJournalStore::Column *MemoryJournalStore::column(QByteArrayView name) const
+{
+    const int index = mColumnIndex.value(QByteArray::fromRawData(name.data(), name.size()), -1);
+    return index >= 0 ? &mColumns[index] : nullptr;
+}
+
+QByteArray MemoryJournalStore::cursor(quint32 entry) const
+{
+    if (mCursorColumn >= 0) {
+        if (const auto value = this->value(mColumns[mCursorColumn], entry)) {
+            return value->toByteArray();
+        }
+    }
+    // same layout as journald cursors, such that JournaldHelper::parseCursor() can be used
+    const std::optional<QByteArrayView> bootId = mBootIdColumn >= 0 ? this->value(mColumns[mBootIdColumn], entry) : std::nullopt;
+    return QByteArray("s=0;i=") + QByteArray::number(entry + 1, 16) + QByteArray(";b=") + bootId.value_or(QByteArrayView()).toByteArray()
+        + QByteArray(";m=") + QByteArray::number(mMonotonic[entry], 16) + QByteArray(";t=") + QByteArray::number(mRealtime[entry], 16)
+        + QByteArray(";x=0");
+}
+
+quint32 MemoryJournalStore::lowerBound(quint64 usec) const
+{
+    std::size_t first{0};
+    std::size_t last{mRealtimeMaximum.size()};
+    while (first < last) {
+        const std::size_t middle = first + (last - first) / 2;
+        if (mRealtimeMaximum[middle] < usec) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return static_cast<quint32>(first);
+}
+
+template<typename Reader>
+std::shared_ptr<MemoryJournalStore> MemoryJournalPrivate::load(Reader &reader)
+{
+    auto store = std::make_shared<MemoryJournalStore>();
+    // lookups are only needed while loading
+    Lookups lookups;
+    append(*store, lookups, reader);
+    return store;
+}
+
+void MemoryJournalPrivate::completeLookups(const MemoryJournalStore &store, Lookups &lookups)
+{
+    for (std::size_t columnIndex = lookups.size(); columnIndex < store.mColumns.size(); ++columnIndex) {
+        const MemoryJournalStore::Column &column = store.mColumns[columnIndex];
+        QHash<QByteArray, quint32> &lookup = lookups.emplace_back();
+        lookup.reserve(static_cast<qsizetype>(column.mDictionary.size()));
+        for (quint32 id = 0; id < static_cast<quint32>(column.mDictionary.size()); ++id) {
+            lookup.insert(column.mDictionary[id], id);
+        }
+    }
+}
+
+int MemoryJournalPrivate::addColumn(MemoryJournalStore &store, Lookups &lookups, QByteArrayView name)
+{
+    // raw data wrappers avoid copies for lookups of already known field names
+    int columnIndex = store.mColumnIndex.value(QByteArray::fromRawData(name.data(), name.size()), -1);
+    if (columnIndex < 0) {
+        columnIndex = static_cast<int>(store.mColumns.size());
+        MemoryJournalStore::Column column;
+        column.mName = name.toByteArray();
+        store.mColumnIndex.insert(column.mName, columnIndex);
+        store.mColumns.push_back(std::move(column));
+        lookups.emplace_back();
+    }
+    return columnIndex;
+}
+
+quint32 MemoryJournalPrivate::addValue(MemoryJournalStore::Column &column, QHash<QByteArray, quint32> &lookup, QByteArrayView value)
+{
+    const auto it = lookup.constFind(QByteArray::fromRawData(value.data(), value.size()));
+    if (it != lookup.cend()) {
+        return it.value();
+    }
+    const quint32 id = static_cast<quint32>(column.mDictionary.size());
+    column.mDictionary.push_back(value.toByteArray());
+    lookup.insert(column.mDictionary.back(), id);
+    return id;
+}
+
+void MemoryJournalPrivate::finishAppend(MemoryJournalStore &store, quint32 firstEntry)
+{
+    const quint32 entryCount = static_cast<quint32>(store.mRealtime.size());
+    for (MemoryJournalStore::Column &column : store.mColumns) {
+        column.mValues.resize(entryCount, 0);
+    }
+
+    for (MemoryJournalStore::Column &column : store.mColumns) {
+        if (!sIndexedFields.contains(column.mName)) {
+            continue;
+        }
+        column.mPostings.resize(column.mDictionary.size());
+        for (quint32 i = firstEntry; i < entryCount; ++i) {
+            if (column.mValues[i] > 0) {
+                column.mPostings[column.mValues[i] - 1].push_back(i);
+            }
+        }
+    }
+    store.mCursorColumn = store.mColumnIndex.value(sCursorField.toByteArray(), -1);
+    store.mBootIdColumn = store.mColumnIndex.value(QByteArray("_BOOT_ID"), -1);
+}
+
+template<typename Reader>
+quint32 MemoryJournalPrivate::append(MemoryJournalStore &store, Lookups &lookups, Reader &reader)
+{
+    completeLookups(store, lookups);
+
+    const quint32 firstEntry = static_cast<quint32>(store.mRealtime.size());
+    quint32 entry{firstEntry};
+    while (reader.readNext()) {
+        const QVector<typename Reader::Field> &fields = reader.fields();
+        if (fields.isEmpty()) {
+            continue;
+        }
+        quint64 realtime{0};
+        quint64 monotonic{0};
+        for (const typename Reader::Field &field : fields) {
+            if (field.mName == sRealtimeTimestampField) {
+                realtime = field.mValue.toULongLong();
+                continue;
+            }
+            if (field.mName == sMonotonicTimestampField) {
+                monotonic = field.mValue.toULongLong();
+                continue;
+            }
+            const int columnIndex = addColumn(store, lookups, field.mName);
+            MemoryJournalStore::Column &column = store.mColumns[columnIndex];
+            if (column.mValues.size() > entry) {
+                // journald permits fields to occur multiple times in an entry, like sd_journal_get_data() only the first value is used
+                continue;
+            }
+            const quint32 id = addValue(column, lookups[columnIndex], field.mValue);
+            column.mValues.resize(entry, 0);
+            column.mValues.push_back(id + 1);
+        }
+        store.mRealtime.push_back(realtime);
+        store.mRealtimeMaximum.push_back(store.mRealtimeMaximum.empty() ? realtime : std::max(realtime, store.mRealtimeMaximum.back()));
+        store.mMonotonic.push_back(monotonic);
+        ++entry;
+    }
+    if (reader.hasError()) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Journal data is malformed, only" << entry << "entries before the error are loaded";
+    }
+    finishAppend(store, firstEntry);
+    return entry - firstEntry;
+}
+
+quint32 MemoryJournalPrivate::merge(MemoryJournalStore &store, Lookups &lookups, const MemoryJournalStore &entries)
+{
+    completeLookups(store, lookups);
+
+    const quint32 firstEntry = static_cast<quint32>(store.mRealtime.size());
+    const quint32 count = static_cast<quint32>(entries.mRealtime.size());
+    for (const MemoryJournalStore::Column &source : entries.mColumns) {
+        const int columnIndex = addColumn(store, lookups, source.mName);
+        MemoryJournalStore::Column &column = store.mColumns[columnIndex];
+        // dictionaries are small compared to the number of entries, thus every distinct value is looked up only once
+        std::vector<quint32> ids;
+        ids.reserve(source.mDictionary.size());
+        for (std::size_t id = 0; id < source.mDictionary.size(); ++id) {
+            ids.push_back(addValue(column, lookups[columnIndex], source.mDictionary[id]) + 1);
+        }
+        column.mValues.resize(firstEntry, 0);
+        for (std::size_t entry = 0; entry < source.mValues.size(); ++entry) {
+            const quint32 id = source.mValues[entry];
+            column.mValues.push_back(id > 0 ? ids[id - 1] : 0);
+        }
+    }
+    for (quint32 entry = 0; entry < count; ++entry) {
+        const quint64 realtime = entries.mRealtime[entry];
+        store.mRealtime.push_back(realtime);
+        store.mMonotonic.push_back(entries.mMonotonic[entry]);
+        store.mRealtimeMaximum.push_back(store.mRealtimeMaximum.empty() ? realtime : std::max(realtime, store.mRealtimeMaximum.back()));
+    }
+    finishAppend(store, firstEntry);
+    return count;
+}
+
+void MemoryJournalPrivate::detach()
+{
+    if (!mStore) {
+        mStore = std::make_shared<MemoryJournalStore>();
+    } else if (mStore.use_count() > 1) {
+        // clones, which might be used by other threads, keep their entries; the copy shares them and only
+        // the last chunk of each vector is copied when appending to it
+        mStore = std::make_shared<MemoryJournalStore>(*mStore);
+    }
+}
+
+void MemoryJournalPrivate::addMatches(quint32 firstEntry, quint32 count)
+{
+    // positions of the navigation state stay valid, because matching entries are only added at the end
+    if (!mMatches) {
+        return;
+    }
+    for (quint32 entry = firstEntry; entry < firstEntry + count; ++entry) {
+        if (matches(mFilter, entry)) {
+            mMatches->push_back(entry);
+        }
+    }
+}
+
+std::shared_ptr<MemoryJournalStore> MemoryJournalPrivate::parse(JournaldExportReader &reader)
+{
+    return load(reader);
+}
+
+std::optional<std::vector<quint32>> MemoryJournalPrivate::evaluate(const FilterExpression::NormalizedForm &form) const
+{
+    if (!form.mSatisfiable) {
+        return std::vector<quint32>();
+    }
+    // same semantics as the matches that FilterExpression::apply() adds to an sd_journal object
+    std::optional<std::vector<quint32>> result;
+    for (const QVector<FilterExpression::Term> &disjunction : form.mConjunction) {
+        std::vector<quint32> disjunctionEntries;
+        bool matchesAll{disjunction.isEmpty()};
+        for (const FilterExpression::Term &term : disjunction) {
+            std::optional<std::vector<quint32>> termEntries;
+            for (auto it = term.mMatches.cbegin(); it != term.mMatches.cend(); ++it) {
+                std::vector<quint32> fieldEntries = entriesWithValue(it.key(), it.value());
+                termEntries = termEntries ? intersect(termEntries.value(), fieldEntries) : std::move(fieldEntries);
+            }
+            if (!termEntries) {
+                matchesAll = true;
+                break;
+            }
+            disjunctionEntries = unite(disjunctionEntries, termEntries.value());
+        }
+        if (matchesAll) {
+            continue;
+        }
+        result = result ? intersect(result.value(), disjunctionEntries) : std::move(disjunctionEntries);
+    }
+    return result;
+}
+
+bool MemoryJournalPrivate::matches(const FilterExpression::NormalizedForm &form, quint32 entry) const
+{
+    if (!form.mSatisfiable) {
+        return false;
+    }
+    for (const QVector<FilterExpression::Term> &disjunction : form.mConjunction) {
+        // terms without matches and empty disjunctions match all entries
+        bool disjunctionMatches{disjunction.isEmpty()};
+        for (const FilterExpression::Term &term : disjunction) {
+            bool termMatches{true};
+            for (auto it = term.mMatches.cbegin(); termMatches && it != term.mMatches.cend(); ++it) {
+                const MemoryJournalStore::Column *column = mStore->column(it.key().toUtf8());
+                const std::optional<QByteArrayView> value = column ? mStore->value(*column, entry) : std::nullopt;
+                termMatches = value && it.value().contains(QString::fromUtf8(value.value()));
+            }
+            if (termMatches) {
+                disjunctionMatches = true;
+                break;
+            }
+        }
+        if (!disjunctionMatches) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<quint32> MemoryJournalPrivate::entriesWithValue(const QString &name, const QStringList &values) const
+{
+    const QByteArray rawName = name.toUtf8();
+    const MemoryJournalStore::Column *column = mStore->column(rawName);
+    if (!column) {
+        return {};
+    }
+    QVector<quint32> ids;
+    for (const QString &value : values) {
+        const QByteArray rawValue = value.toUtf8();
+        for (std::size_t index = 0; index < column->mDictionary.size(); ++index) {
+            if (column->mDictionary[index] == rawValue) {
+                ids.append(static_cast<quint32>(index + 1));
+                break;
+            }
+        }
+    }
+
+    std::vector<quint32> entries;
+    if (!column->mPostings.empty()) {
+        for (quint32 id : std::as_const(ids)) {
+            const ChunkedVector<quint32> &postings = column->mPostings[id - 1];
+            for (std::size_t i = 0; i < postings.size(); ++i) {
+                entries.push_back(postings[i]);
+            }
+        }
+        if (ids.size() > 1) {
+            std::sort(entries.begin(), entries.end());
+        }
+        return entries;
+    }
+    qCDebug(KJOURNALDLIB_FILTERTRACE) << "field" << name << "is not indexed, scanning all entries";
+    for (quint32 i = 0; i < column->mValues.size(); ++i) {
+        if (column->mValues[i] > 0 && ids.contains(column->mValues[i])) {
+            entries.push_back(i);
+        }
+    }
+    return entries;
+}
+
+qint64 MemoryJournalPrivate::matchCount() const
+{
+    if (!mStore) {
+        return 0;
+    }
+    return mMatches ? mMatches->size() : mStore->mRealtime.size();
+}
+
+quint32 MemoryJournalPrivate::entryAt(qint64 position) const
+{
+    return mMatches ? mMatches.value()[position] : static_cast<quint32>(position);
+}
+
+qint64 MemoryJournalPrivate::positionOf(quint32 entry) const
+{
+    if (!mMatches) {
+        return entry;
+    }
+    return std::distance(mMatches->cbegin(), std::lower_bound(mMatches->cbegin(), mMatches->cend(), entry));
+}
+
+qint64 MemoryJournalPrivate::lowerBoundPosition(quint64 usec) const
+{
+    // matching entries are a subset of all entries in the same order, hence the first one at or after the
+    // first entry of the timestamp is the first matching entry of the timestamp
+    return positionOf(mStore->lowerBound(usec));
+}
+
+MemoryJournalFeed::MemoryJournalFeed()
+{
+    qRegisterMetaType<std::shared_ptr<const MemoryJournalStore>>();
+}
+
+std::unique_ptr<IJournal> MemoryJournalFeed::follow(const MemoryJournal &journal)
+{
+    // not virtual, subclasses implement clone() by this method
+    std::unique_ptr<IJournal> clone = journal.MemoryJournal::clone();
+    auto memoryJournal = static_cast<MemoryJournal *>(clone.get());
+    connect(
+        this,
+        &MemoryJournalFeed::entriesAppended,
+        memoryJournal,
+        [memoryJournal](const std::shared_ptr<const MemoryJournalStore> &entries) {
+            memoryJournal->append(*entries);
+        },
+        Qt::QueuedConnection);
+    return clone;
+}
+
+MemoryJournal::MemoryJournal()
+    : d(new MemoryJournalPrivate)
+{
+    d->mStore = std::make_shared<MemoryJournalStore>();
+}
+
+MemoryJournal::MemoryJournal(const QString &path)
+    : MemoryJournal()
+{
+    if (!QFileInfo::exists(path)) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Export file does not exist:" << path;
+        d->mStore.reset();
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    if (JournaldJsonReader::isJsonFile(path)) {
+        JournaldJsonReader reader(path);
+        d->mStore = MemoryJournalPrivate::load(reader);
+    } else {
+        JournaldExportReader reader(path);
+        reader.setParallelParsing(QThread::idealThreadCount());
+        d->mStore = MemoryJournalPrivate::load(reader);
+    }
+    qCDebug(KJOURNALDLIB_PERFORMANCE) << "Loaded" << entryCount() << "entries of" << path << "in" << timer.elapsed() << "ms";
+}
+
+MemoryJournal::MemoryJournal(JournaldExportReader &reader)
+    : MemoryJournal()
+{
+    d->mStore = MemoryJournalPrivate::load(reader);
+}
+
+MemoryJournal::MemoryJournal(JournaldJsonReader &reader)
+    : MemoryJournal()
+{
+    d->mStore = MemoryJournalPrivate::load(reader);
+}
+
+MemoryJournal::~MemoryJournal() = default;
+
+sd_journal *MemoryJournal::sdJournal() const
+{
+    return nullptr;
+}
+
+bool MemoryJournal::isValid() const
+{
+    return d->mStore != nullptr;
+}
+
+QString MemoryJournal::currentBootId() const
+{
+    return QString();
+}
+
+std::unique_ptr<IJournal> MemoryJournal::clone() const
+{
+    std::unique_ptr<MemoryJournal> journal(new MemoryJournal);
+    journal->d->mStore = d->mStore;
+    return journal;
+}
+
+qint64 MemoryJournal::entryCount() const
+{
+    return d->mStore ? d->mStore->mRealtime.size() : 0;
+}
+
+qint64 MemoryJournal::append(JournaldExportReader &reader)
+{
+    d->detach();
+    const quint32 firstEntry = static_cast<quint32>(d->mStore->mRealtime.size());
+    const quint32 count = MemoryJournalPrivate::append(*d->mStore, d->mLookups, reader);
+    if (count == 0) {
+        return 0;
+    }
+    d->addMatches(firstEntry, count);
+    Q_EMIT journalUpdated(QString(), IJournal::ChangeType::APPEND);
+    return count;
+}
+
+qint64 MemoryJournal::append(const MemoryJournalStore &entries)
+{
+    if (entries.mRealtime.empty()) {
+        return 0;
+    }
+    d->detach();
+    const quint32 firstEntry = static_cast<quint32>(d->mStore->mRealtime.size());
+    const quint32 count = MemoryJournalPrivate::merge(*d->mStore, d->mLookups, entries);
+    d->addMatches(firstEntry, count);
+    Q_EMIT journalUpdated(QString(), IJournal::ChangeType::APPEND);
+    return count;
+}
+
+bool MemoryJournal::setFilter(const FilterExpression &expression)
+{
+    if (!d->mStore) {
+        return false;
+    }
+    qCDebug(KJOURNALDLIB_FILTERTRACE).noquote() << "explain filter:" << expression.explain();
+    d->mFilter = expression.normalize();
+    d->mMatches = d->evaluate(d->mFilter);
+    qCDebug(KJOURNALDLIB_FILTERTRACE) << "filter matches" << d->matchCount() << "of" << entryCount() << "entries";
+    seekHead();
+    return true;
+}
+
+bool MemoryJournal::forEachField(const std::function<void(QByteArrayView name, QByteArrayView value)> &callback) const
+{
+    if (d->mCurrent < 0) {
+        return false;
+    }
+    const quint32 entry = d->entryAt(d->mCurrent);
+    for (const MemoryJournalStore::Column &column : d->mStore->mColumns) {
+        // columns of address fields like "__CURSOR" are no data fields
+        if (column.mName.startsWith("__") || entry >= column.mValues.size()) {
+            continue;
+        }
+        if (const auto value = d->mStore->value(column, entry)) {
+            callback(column.mName, *value);
+        }
+    }
+    return true;
+}
+
+QVector<QString> MemoryJournal::queryUnique(const QString &field) const
+{
+    QVector<QString> values;
+    const MemoryJournalStore::Column *column = d->mStore ? d->mStore->column(field.toUtf8()) : nullptr;
+    if (!column) {
+        return values;
+    }
+    values.reserve(static_cast<qsizetype>(column->mDictionary.size()));
+    for (std::size_t id = 0; id < column->mDictionary.size(); ++id) {
+        values.append(QString::fromUtf8(column->mDictionary[id]));
+    }
+    return values;
+}
+
+bool MemoryJournal::seekHead()
+{
+    d->mCurrent = -1;
+    d->mNext = 0;
+    d->mPrevious = -1;
+    return d->mStore != nullptr;
+}
+
+bool MemoryJournal::seekTail()
+{
+    d->mCurrent = -1;
+    d->mNext = d->matchCount();
+    d->mPrevious = d->matchCount() - 1;
+    return d->mStore != nullptr;
+}
+
+bool MemoryJournal::seekCursor(const QString &cursor)
+{
+    if (!d->mStore) {
+        return false;
+    }
+    const QByteArray rawCursor = cursor.toUtf8();
+    const auto seekEntry = [this, &rawCursor](quint32 begin, quint32 end) {
+        for (quint32 entry = begin; entry < end; ++entry) {
+            if (d->mStore->cursor(entry) != rawCursor) {
+                continue;
+            }
+            const qint64 position = d->positionOf(entry);
+            const bool matches = position < d->matchCount() && d->entryAt(position) == entry;
+            d->mCurrent = -1;
+            d->mNext = position;
+            d->mPrevious = matches ? position : position - 1;
+            return true;
+        }
+        return false;
+    };
+    // usually only the entries of the cursor's timestamp have to be compared, only if the clock jumped
+    // backwards the entry is located behind them
+    const JournaldHelper::CursorInfo info = JournaldHelper::parseCursor(cursor);
+    if (info.mRealtimeUsec && info.mRealtimeUsec.value() < std::numeric_limits<quint64>::max()
+        && seekEntry(d->mStore->lowerBound(info.mRealtimeUsec.value()), d->mStore->lowerBound(info.mRealtimeUsec.value() + 1))) {
+        return true;
+    }
+    return seekEntry(0, d->mStore->mRealtime.size());
+}
+
+bool MemoryJournal::seekRealtime(quint64 usec)
+{
+    if (!d->mStore) {
+        return false;
+    }
+    d->mCurrent = -1;
+    d->mNext = d->lowerBoundPosition(usec);
+    d->mPrevious = (usec == std::numeric_limits<quint64>::max() ? d->matchCount() : d->lowerBoundPosition(usec + 1)) - 1;
+    return true;
+}
+
+int MemoryJournal::next(int count)
+{
+    const qint64 moved = std::clamp<qint64>(d->matchCount() - d->mNext, 0, std::max(count, 0));
+    if (moved > 0) {
+        d->mCurrent = d->mNext + moved - 1;
+        d->mNext = d->mCurrent + 1;
+        d->mPrevious = d->mCurrent - 1;
+    }
+    return static_cast<int>(moved);
+}
+
+int MemoryJournal::previous(int count)
+{
+    const qint64 moved = std::clamp<qint64>(d->mPrevious + 1, 0, std::max(count, 0));
+    if (moved > 0) {
+        d->mCurrent = d->mPrevious - moved + 1;
+        d->mNext = d->mCurrent + 1;
+        d->mPrevious = d->mCurrent - 1;
+    }
+    return static_cast<int>(moved);
+}
+
+bool MemoryJournal::testCursor(const QString &cursor) const
+{
+    if (d->mCurrent < 0) {
+        return false;
+    }
+    return d->mStore->cursor(d->entryAt(d->mCurrent)) == cursor.toUtf8();
+}
+
+QString MemoryJournal::cursor() const
+{
+    if (d->mCurrent < 0) {
+        return QString();
+    }
+    return QString::fromUtf8(d->mStore->cursor(d->entryAt(d->mCurrent)));
+}
+
+quint64 MemoryJournal::realtimeUsec() const
+{
+    return d->mCurrent < 0 ? 0 : d->mStore->mRealtime[d->entryAt(d->mCurrent)];
+}
+
+quint64 MemoryJournal::monotonicUsec() const
+{
+    return d->mCurrent < 0 ? 0 : d->mStore->mMonotonic[d->entryAt(d->mCurrent)];
+}
+
+std::optional<QByteArrayView> MemoryJournal::fieldValue(QByteArrayView name) const
+{
+    if (d->mCurrent < 0) {
+        return std::nullopt;
+    }
+    const quint32 entry = d->entryAt(d->mCurrent);
+    if (name == sRealtimeTimestampField) {
+        d->mBuffer = QByteArray::number(d->mStore->mRealtime[entry]);
+        return QByteArrayView(d->mBuffer);
+    }
+    if (name == sMonotonicTimestampField) {
+        d->mBuffer = QByteArray::number(d->mStore->mMonotonic[entry]);
+        return QByteArrayView(d->mBuffer);
+    }
+    if (name == sCursorField) {
+        d->mBuffer = d->mStore->cursor(entry);
+        return QByteArrayView(d->mBuffer);
+    }
+    const MemoryJournalStore::Column *column = d->mStore->column(name);
+    if (!column) {
+        return std::nullopt;
+    }
+    return d->mStore->value(*column, entry);
+}
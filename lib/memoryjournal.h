@@ -0,0 +1,198 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef MEMORYJOURNAL_H
+#define MEMORYJOURNAL_H
+
+#include "ijournal.h"
+#include "kjournald_export.h"
+#include <QByteArrayView>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include <optional>
+
+class JournaldExportReader;
+class JournaldJsonReader;
+class MemoryJournalPrivate;
+struct MemoryJournalStore;
+
+/**
+ * @brief Journal that keeps all entries of a journal export in memory
+ *
+ * Other than SystemdJournalRemote, which converts an export into a journal file with the external
+ * systemd-journal-remote tool, the export is parsed in process and the journal is usable as soon as
+ * the data is loaded. Entries are stored column-wise with a dictionary of distinct values per field,
+ * and the fields that the view model filters on ("_BOOT_ID", "_SYSTEMD_UNIT", "_EXE", "PRIORITY",
+ * "_TRANSPORT" and "SYSLOG_IDENTIFIER") are indexed. This makes the journal suitable for exports up to a
+ * few GB; larger journals should be converted to journal files.
+ *
+ * Since there is no sd_journal object, entries are only accessible by the reading methods of IJournal.
+ * Like for sd_journal objects, only one query shall use a journal object at a time; clone() provides
+ * additional journal objects for the same entries without copying them.
+ *
+ * Entries of incrementally received exports, e.g. from a network connection, are added by append(). Like
+ * for local journal files, the new entries are announced by journalUpdated().
+ */
+class KJOURNALD_EXPORT MemoryJournal : public IJournal
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Construct journal without entries, entries are added by append()
+     */
+    MemoryJournal();
+
+    /**
+     * @brief Load all entries of the journal export file at @p path, which may be compressed
+     *
+     * Files with the JSON output of journalctl are loaded as well, see JournaldJsonReader::isJsonFile().
+     */
+    explicit MemoryJournal(const QString &path);
+
+    /**
+     * @brief Load all remaining entries of @p reader
+     */
+    explicit MemoryJournal(JournaldExportReader &reader);
+
+    /**
+     * @brief Load all remaining entries of @p reader
+     */
+    explicit MemoryJournal(JournaldJsonReader &reader);
+
+    /**
+     * @brief Destroys the journal
+     */
+    ~MemoryJournal() override;
+
+    /**
+     * @return nullptr, because the entries are not provided by an sd_journal object
+     */
+    sd_journal *sdJournal() const override;
+
+    /**
+     * @return true if the export could be read, for malformed exports the entries before the error are loaded
+     */
+    bool isValid() const override;
+
+    /**
+     * @return empty string, because the journal of an export does not belong to the running system
+     */
+    QString currentBootId() const override;
+
+    /**
+     * @copydoc IJournal::clone()
+     *
+     * The clone shares the loaded entries with this journal.
+     */
+    std::unique_ptr<IJournal> clone() const override;
+
+    /**
+     * @return number of loaded entries
+     */
+    qint64 entryCount() const;
+
+    /**
+     * @brief Append all entries that @p reader can provide at the moment
+     *
+     * Entries must be appended in journal order. Appended entries are visible to the current filter and
+     * navigation state like entries that journald appended to a journal file, clones keep the entries
+     * they were created with.
+     * @return number of appended entries
+     */
+    qint64 append(JournaldExportReader &reader);
+
+    /**
+     * @brief Append the entries of @p entries, which were parsed in advance, e.g. by a worker thread
+     *
+     * Same semantics as append() for a reader, but the main work of parsing and building the dictionaries
+     * is already done, see IngestServer.
+     * @return number of appended entries
+     */
+    qint64 append(const MemoryJournalStore &entries);
+
+    /**
+     * @copydoc IJournal::setFilter()
+     *
+     * The matches are evaluated by the indexes of the indexed fields, other fields are compared for all entries.
+     */
+    bool setFilter(const FilterExpression &expression) override;
+
+    /**
+     * @copydoc IJournal::seekHead()
+     */
+    bool seekHead() override;
+
+    /**
+     * @copydoc IJournal::seekTail()
+     */
+    bool seekTail() override;
+
+    /**
+     * @copydoc IJournal::seekCursor()
+     */
+    bool seekCursor(const QString &cursor) override;
+
+    /**
+     * @copydoc IJournal::seekRealtime()
+     */
+    bool seekRealtime(quint64 usec) override;
+
+    /**
+     * @copydoc IJournal::next()
+     */
+    int next(int count = 1) override;
+
+    /**
+     * @copydoc IJournal::previous()
+     */
+    int previous(int count = 1) override;
+
+    /**
+     * @copydoc IJournal::cursor()
+     */
+    QString cursor() const override;
+
+    /**
+     * @copydoc IJournal::testCursor()
+     */
+    bool testCursor(const QString &cursor) const override;
+
+    /**
+     * @copydoc IJournal::realtimeUsec()
+     */
+    quint64 realtimeUsec() const override;
+
+    /**
+     * @copydoc IJournal::monotonicUsec()
+     */
+    quint64 monotonicUsec() const override;
+
+    /**
+     * @copydoc IJournal::fieldValue()
+     *
+     * Additionally, the timestamps and cursor are provided by the pseudo fields "__REALTIME_TIMESTAMP",
+     * "__MONOTONIC_TIMESTAMP" and "__CURSOR" like in the journal export format.
+     */
+    std::optional<QByteArrayView> fieldValue(QByteArrayView name) const override;
+
+    /**
+     * @copydoc IJournal::forEachField()
+     *
+     * The pseudo fields of fieldValue() are not passed and only the first value of fields that occurred several
+     * times in the loaded entry is kept, see fieldValue().
+     */
+    bool forEachField(const std::function<void(QByteArrayView name, QByteArrayView value)> &callback) const override;
+
+    /**
+     * @copydoc IJournal::queryUnique()
+     */
+    QVector<QString> queryUnique(const QString &field) const override;
+
+private:
+    std::unique_ptr<MemoryJournalPrivate> d;
+};
+
+#endif // MEMORYJOURNAL_H
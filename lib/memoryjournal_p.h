@@ -0,0 +1,268 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef MEMORYJOURNAL_P_H
+#define MEMORYJOURNAL_P_H
+
+#include "filterexpression.h"
+#include "journaldexportreader.h"
+#include "journaldjsonreader.h"
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QVector>
+#include <memory>
+#include <optional>
+#include <vector>
+
+class IJournal;
+class MemoryJournal;
+
+/**
+ * Append-only vector that stores its elements in chunks of fixed size
+ *
+ * Copies share all chunks and appending to a copy only copies the last chunk if it is shared. Thus, a copy
+ * is a cheap snapshot of the elements appended so far, which is not affected by later appends to the original.
+ */
+template<typename T>
+class ChunkedVector
+{
+public:
+    static constexpr std::size_t sChunkSize{4096};
+
+    std::size_t size() const
+    {
+        return mSize;
+    }
+
+    bool empty() const
+    {
+        return mSize == 0;
+    }
+
+    const T &operator[](std::size_t index) const
+    {
+        return (*mChunks[index / sChunkSize])[index % sChunkSize];
+    }
+
+    const T &back() const
+    {
+        return (*this)[mSize - 1];
+    }
+
+    void push_back(const T &value)
+    {
+        if (mSize % sChunkSize == 0) {
+            mChunks.push_back(std::make_shared<std::vector<T>>());
+        } else if (mChunks.back().use_count() > 1) {
+            // chunk is part of a snapshot, which must neither see the new element nor be reallocated
+            mChunks.back() = std::make_shared<std::vector<T>>(*mChunks.back());
+        }
+        mChunks.back()->push_back(value);
+        ++mSize;
+    }
+
+    /**
+     * append copies of @p value until the vector has @p size elements, the vector never shrinks
+     */
+    void resize(std::size_t size, const T &value)
+    {
+        while (mSize < size) {
+            push_back(value);
+        }
+    }
+
+private:
+    std::vector<std::shared_ptr<std::vector<T>>> mChunks;
+    std::size_t mSize{0};
+};
+
+/**
+ * Column oriented storage of all loaded entries in the order of the export, i.e. in journal order
+ *
+ * Every field is stored as column with one value ID per entry, which refers to the column's dictionary
+ * of distinct values. Since most fields have only few distinct values, e.g. hostname, unit or boot ID,
+ * this stores each value only once. The store is shared by all clones; since entries are only appended to
+ * a store that is not shared, clones keep the entries they were created with. All per entry and per value
+ * data is kept in ChunkedVector objects, such that copying a shared store before appending shares all
+ * existing entries with the clones' store.
+ */
+struct MemoryJournalStore {
+    struct Column {
+        QByteArray mName;
+        ChunkedVector<quint32> mValues; //!< for every entry the index in mDictionary plus 1, 0 if entry has no such field
+        ChunkedVector<QByteArray> mDictionary;
+        std::vector<ChunkedVector<quint32>> mPostings; //!< only for indexed fields: for every value the sorted entries with this value
+    };
+
+    /**
+     * @return raw value of field @p column for @p entry or std::nullopt if the entry does not have the field
+     */
+    std::optional<QByteArrayView> value(const Column &column, quint32 entry) const;
+
+    /**
+     * @return column for field @p name or nullptr if no entry has this field
+     */
+    const Column *column(QByteArrayView name) const;
+
+    /**
+     * @return cursor of @p entry as exported, or a cursor that is created from the entry's position and timestamps
+     * if the export does not contain cursors
+     */
+    QByteArray cursor(quint32 entry) const;
+
+    /**
+     * @return index of the first entry at which the realtime clock reached @p usec, see mRealtimeMaximum
+     */
+    quint32 lowerBound(quint64 usec) const;
+
+    ChunkedVector<quint64> mRealtime;
+    ChunkedVector<quint64> mRealtimeMaximum; //!< for every entry the latest realtime timestamp up to it, ordered even if the clock jumped backwards
+    ChunkedVector<quint64> mMonotonic;
+    std::vector<Column> mColumns;
+    QHash<QByteArray, int> mColumnIndex;
+    int mCursorColumn{-1}; //!< index in mColumns, indexes stay valid when the store is copied
+    int mBootIdColumn{-1};
+};
+
+class MemoryJournalPrivate
+{
+public:
+    /**
+     * for every column the dictionary index of each value
+     */
+    using Lookups = std::vector<QHash<QByteArray, quint32>>;
+
+    /**
+     * read all entries of @p reader into a new store, the fields in sIndexedFields are indexed
+     * @note Reader is JournaldExportReader or JournaldJsonReader
+     */
+    template<typename Reader>
+    static std::shared_ptr<MemoryJournalStore> load(Reader &reader);
+
+    /**
+     * append all entries that @p reader provides to @p store
+     * @param lookups dictionary lookups of @p store, which are completed for columns without lookup
+     * @return number of appended entries
+     */
+    template<typename Reader>
+    static quint32 append(MemoryJournalStore &store, Lookups &lookups, Reader &reader);
+
+    /**
+     * append the entries of @p entries, which were loaded into a separate store, to @p store
+     * @param lookups dictionary lookups of @p store, which are completed for columns without lookup
+     * @return number of appended entries
+     */
+    static quint32 merge(MemoryJournalStore &store, Lookups &lookups, const MemoryJournalStore &entries);
+
+    /**
+     * read all entries that @p reader provides at the moment into a new store, safe to be called from worker threads
+     */
+    static std::shared_ptr<MemoryJournalStore> parse(JournaldExportReader &reader);
+
+    /**
+     * create the missing lookups of @p lookups for the columns of @p store
+     */
+    static void completeLookups(const MemoryJournalStore &store, Lookups &lookups);
+
+    /**
+     * @return index of the column for field @p name, which is created if it does not exist yet
+     */
+    static int addColumn(MemoryJournalStore &store, Lookups &lookups, QByteArrayView name);
+
+    /**
+     * @return dictionary index of @p value in @p column, which is added if it does not exist yet
+     */
+    static quint32 addValue(MemoryJournalStore::Column &column, QHash<QByteArray, quint32> &lookup, QByteArrayView value);
+
+    /**
+     * fill up the columns for the entries from @p firstEntry on and index them
+     */
+    static void finishAppend(MemoryJournalStore &store, quint32 firstEntry);
+
+    /**
+     * ensure that the store exists and is not shared with clones before appending to it
+     * @note the copy of a shared store shares all entries with it, see ChunkedVector
+     */
+    void detach();
+
+    /**
+     * add the appended entries from @p firstEntry on that match the current filter to mMatches
+     */
+    void addMatches(quint32 firstEntry, quint32 count);
+
+    /**
+     * @return true if @p entry matches the journald matches of @p form, same semantics as evaluate()
+     */
+    bool matches(const FilterExpression::NormalizedForm &form, quint32 entry) const;
+
+    /**
+     * @return sorted entries that match the journald matches of @p form, std::nullopt if all entries match
+     */
+    std::optional<std::vector<quint32>> evaluate(const FilterExpression::NormalizedForm &form) const;
+
+    /**
+     * @return sorted entries that have any of @p values for field @p name
+     */
+    std::vector<quint32> entriesWithValue(const QString &name, const QStringList &values) const;
+
+    /**
+     * @return number of entries that match the current filter
+     */
+    qint64 matchCount() const;
+
+    /**
+     * @return entry at @p position of the entries that match the current filter
+     */
+    quint32 entryAt(qint64 position) const;
+
+    /**
+     * @return position of first matching entry at or after @p entry
+     */
+    qint64 positionOf(quint32 entry) const;
+
+    /**
+     * @return position of first matching entry with realtime timestamp equal or later than @p usec
+     */
+    qint64 lowerBoundPosition(quint64 usec) const;
+
+    static const QList<QByteArray> sIndexedFields; //!< fields that are used by the view model's filters
+
+    std::shared_ptr<MemoryJournalStore> mStore; //!< shallow copied before appending if shared with clones
+    Lookups mLookups; //!< only created when appending to the store
+    std::optional<std::vector<quint32>> mMatches; //!< entries that match the current filter, std::nullopt for all entries
+    FilterExpression::NormalizedForm mFilter; //!< current filter, needed for appended entries
+    // position state in the list of matching entries that mirrors sd_journal semantics
+    qint64 mCurrent{-1};
+    qint64 mNext{0};
+    qint64 mPrevious{-1};
+    mutable QByteArray mBuffer; //!< storage for values that are computed on access
+};
+
+/**
+ * Distributes entries that are appended to a journal to the clones that were handed out
+ *
+ * The clones may live in and be deleted from any thread. Connections with the clone as context are removed
+ * when it is destroyed and queued connections deliver the entries in the thread of the clone.
+ */
+class MemoryJournalFeed : public QObject
+{
+    Q_OBJECT
+public:
+    MemoryJournalFeed();
+
+    /**
+     * @return clone of @p journal that also receives the entries that are published later by this feed
+     */
+    std::unique_ptr<IJournal> follow(const MemoryJournal &journal);
+
+Q_SIGNALS:
+    /**
+     * emitted with the entries that were appended to the followed journal
+     */
+    void entriesAppended(const std::shared_ptr<const MemoryJournalStore> &entries);
+};
+
+#endif // MEMORYJOURNAL_P_H
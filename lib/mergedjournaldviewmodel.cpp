@@ -0,0 +1,299 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "mergedjournaldviewmodel.h"
+#include "colorizer.h"
+#include "kjournaldlib_log_general.h"
+#include "localjournal.h"
+#include "mergedjournaldviewmodel_p.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+JournalSourceReader::JournalSourceReader(std::unique_ptr<IJournal> journal, quint32 chunkSize)
+    : mJournal(journal.release())
+    , mChunkSize(chunkSize)
+{
+    qRegisterMetaType<QVector<LogEntry>>();
+    mJournal->setParent(this);
+    connect(mJournal, &IJournal::journalUpdated, this, &JournalSourceReader::journalGrown);
+}
+
+void JournalSourceReader::readChunk()
+{
+    QVector<LogEntry> chunk;
+    if (!mJournal->isValid()) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Skipping data fetch, no valid journal opened";
+        Q_EMIT chunkRead(chunk, true);
+        return;
+    }
+    if (!mHeadSeeked) {
+        if (!mJournal->seekHead()) {
+            Q_EMIT chunkRead(chunk, true);
+            return;
+        }
+        mHeadSeeked = true;
+    }
+
+    // after reaching the tail, next() continues with entries that were appended meanwhile
+    bool tailReached{false};
+    chunk.reserve(mChunkSize);
+    while (chunk.size() < static_cast<qsizetype>(mChunkSize)) {
+        const int result = mJournal->next();
+        if (result < 0) {
+            qCCritical(KJOURNALDLIB_GENERAL) << "Failed to read next entry:" << strerror(-result);
+        }
+        if (result <= 0) {
+            tailReached = true;
+            break;
+        }
+        chunk.append(JournaldViewModelPrivate::readEntry(*mJournal));
+    }
+    Q_EMIT chunkRead(chunk, tailReached);
+}
+
+void MergedJournaldViewModelPrivate::clearSources()
+{
+    for (auto &source : mSources) {
+        source.mThread->quit();
+        source.mThread->wait();
+    }
+    mSources.clear();
+}
+
+void MergedJournaldViewModelPrivate::requestChunk(Source &source)
+{
+    if (source.mRequestPending || source.mTailReached) {
+        return;
+    }
+    source.mRequestPending = true;
+    QMetaObject::invokeMethod(source.mReader, &JournalSourceReader::readChunk, Qt::QueuedConnection);
+}
+
+bool MergedJournaldViewModelPrivate::isBefore(const LogEntry &lhs, const LogEntry &rhs)
+{
+    if (lhs.mRealtimeTimestamp != rhs.mRealtimeTimestamp) {
+        return lhs.mRealtimeTimestamp < rhs.mRealtimeTimestamp;
+    }
+    if (lhs.mMonotonicTimestamp != rhs.mMonotonicTimestamp) {
+        return lhs.mMonotonicTimestamp < rhs.mMonotonicTimestamp;
+    }
+    return lhs.mBootId < rhs.mBootId;
+}
+
+MergedJournaldViewModel::MergedJournaldViewModel(QObject *parent)
+    : QAbstractItemModel(parent)
+    , d(new MergedJournaldViewModelPrivate)
+{
+}
+
+MergedJournaldViewModel::MergedJournaldViewModel(std::vector<std::unique_ptr<IJournal>> journals, QObject *parent)
+    : QAbstractItemModel(parent)
+    , d(new MergedJournaldViewModelPrivate)
+{
+    setJournals(std::move(journals));
+}
+
+MergedJournaldViewModel::~MergedJournaldViewModel()
+{
+    d->clearSources();
+}
+
+void MergedJournaldViewModel::setJournals(std::vector<std::unique_ptr<IJournal>> journals)
+{
+    beginResetModel();
+    d->clearSources();
+    d->mLog.clear();
+    d->mLogSources.clear();
+    ++d->mGeneration;
+
+    const int generation = d->mGeneration;
+    for (int i = 0; i < static_cast<int>(journals.size()); ++i) {
+        MergedJournaldViewModelPrivate::Source source;
+        source.mThread = std::make_unique<QThread>();
+        source.mReader = new JournalSourceReader(std::move(journals.at(i)), d->mChunkSize);
+        source.mReader->moveToThread(source.mThread.get());
+        connect(source.mThread.get(), &QThread::finished, source.mReader, &QObject::deleteLater);
+        // the generation check drops chunks that were queued before the last reset
+        connect(source.mReader, &JournalSourceReader::chunkRead, this, [this, i, generation](const QVector<LogEntry> &chunk, bool tailReached) {
+            if (generation == d->mGeneration) {
+                handleChunkRead(i, chunk, tailReached);
+            }
+        });
+        connect(source.mReader, &JournalSourceReader::journalGrown, this, [this, i, generation]() {
+            if (generation == d->mGeneration) {
+                d->mSources.at(i).mTailReached = false;
+                d->requestChunk(d->mSources.at(i));
+            }
+        });
+        source.mThread->start();
+        d->mSources.push_back(std::move(source));
+    }
+
+    // initial fill of the model
+    d->mMergeRequested = true;
+    for (auto &source : d->mSources) {
+        d->requestChunk(source);
+    }
+    endResetModel();
+}
+
+void MergedJournaldViewModel::setJournalPaths(const QStringList &paths)
+{
+    if (d->mJournalPaths == paths) {
+        return;
+    }
+    d->mJournalPaths = paths;
+    std::vector<std::unique_ptr<IJournal>> journals;
+    for (const QString &path : paths) {
+        journals.push_back(std::make_unique<LocalJournal>(path));
+    }
+    setJournals(std::move(journals));
+    Q_EMIT journalPathsChanged();
+}
+
+QStringList MergedJournaldViewModel::journalPaths() const
+{
+    return d->mJournalPaths;
+}
+
+int MergedJournaldViewModel::sourceCount() const
+{
+    return d->mSources.size();
+}
+
+void MergedJournaldViewModel::setFetchMoreChunkSize(quint32 size)
+{
+    if (size > 0) {
+        d->mChunkSize = size;
+    } else {
+        qCWarning(KJOURNALDLIB_GENERAL) << "chunk size 0 is currently ignored";
+    }
+}
+
+void MergedJournaldViewModel::handleChunkRead(int source, const QVector<LogEntry> &chunk, bool tailReached)
+{
+    auto &state = d->mSources.at(source);
+    state.mRequestPending = false;
+    state.mTailReached = tailReached;
+    state.mBuffer.insert(state.mBuffer.end(), chunk.cbegin(), chunk.cend());
+    qCDebug(KJOURNALDLIB_GENERAL) << "source" << source << "provided" << chunk.size() << "entries, tail reached:" << tailReached;
+    if (d->mMergeRequested) {
+        mergeBufferedEntries();
+    }
+}
+
+void MergedJournaldViewModel::mergeBufferedEntries()
+{
+    QVector<LogEntry> merged;
+    QVector<int> mergedSources;
+    while (merged.size() < static_cast<qsizetype>(d->mChunkSize)) {
+        // k-way merge: the next entry is the earliest head of all source buffers, which is only decidable
+        // if every source that might still provide entries has at least one buffered entry
+        int next{-1};
+        bool waitingForSource{false};
+        for (int i = 0; i < static_cast<int>(d->mSources.size()); ++i) {
+            const auto &source = d->mSources.at(i);
+            if (source.mBuffer.empty()) {
+                if (!source.mTailReached) {
+                    waitingForSource = true;
+                    break;
+                }
+                continue;
+            }
+            if (next < 0 || MergedJournaldViewModelPrivate::isBefore(source.mBuffer.front(), d->mSources.at(next).mBuffer.front())) {
+                next = i;
+            }
+        }
+        if (waitingForSource || next < 0) {
+            break;
+        }
+        auto &buffer = d->mSources.at(next).mBuffer;
+        merged.append(std::move(buffer.front()));
+        buffer.pop_front();
+        mergedSources.append(next);
+    }
+
+    if (merged.size() > 0) {
+        beginInsertRows(QModelIndex(), d->mLog.size(), d->mLog.size() + merged.size() - 1);
+        d->mLog.append(merged);
+        d->mLogSources.append(mergedSources);
+        endInsertRows();
+        qCDebug(KJOURNALDLIB_GENERAL) << "merged entries" << merged.size();
+    }
+    if (merged.size() >= static_cast<qsizetype>(d->mChunkSize) || !canFetchMore(QModelIndex())) {
+        d->mMergeRequested = false;
+    }
+
+    // pipelining: refill buffers before they run empty, such that the next merge does not wait
+    for (auto &source : d->mSources) {
+        if (source.mBuffer.size() < d->mChunkSize) {
+            d->requestChunk(source);
+        }
+    }
+}
+
+QHash<int, QByteArray> MergedJournaldViewModel::roleNames() const
+{
+    QHash<int, QByteArray> roles = JournaldViewModelPrivate::entryRoleNames();
+    roles[MergedJournaldViewModel::SOURCE] = "source";
+    roles[MergedJournaldViewModel::SOURCE_COLOR_BACKGROUND] = "sourcecolor_background";
+    roles[MergedJournaldViewModel::SOURCE_COLOR_FOREGROUND] = "sourcecolor_foreground";
+    return roles;
+}
+
+QModelIndex MergedJournaldViewModel::index(int row, int column, const QModelIndex &parent) const
+{
+    return createIndex(row, column);
+}
+
+QModelIndex MergedJournaldViewModel::parent(const QModelIndex &index) const
+{
+    // no tree model, thus no parent
+    return QModelIndex();
+}
+
+int MergedJournaldViewModel::rowCount(const QModelIndex &parent) const
+{
+    // model represents a list and has has no children
+    if (parent.isValid()) {
+        return 0;
+    }
+    return d->mLog.size();
+}
+
+int MergedJournaldViewModel::columnCount(const QModelIndex &parent) const
+{
+    return 1;
+}
+
+QVariant MergedJournaldViewModel::data(const QModelIndex &index, int role) const
+{
+    if (index.row() < 0 || d->mLog.count() <= index.row()) {
+        return QVariant();
+    }
+    switch (role) {
+    case MergedJournaldViewModel::Roles::SOURCE:
+        return d->mLogSources.at(index.row());
+    case MergedJournaldViewModel::Roles::SOURCE_COLOR_BACKGROUND:
+        return Colorizer::color(QString::number(d->mLogSources.at(index.row())), Colorizer::COLOR_TYPE::BACKGROUND);
+    case MergedJournaldViewModel::Roles::SOURCE_COLOR_FOREGROUND:
+        return Colorizer::color(QString::number(d->mLogSources.at(index.row())), Colorizer::COLOR_TYPE::FOREGROUND);
+    }
+    return JournaldViewModelPrivate::entryData(d->mLog.at(index.row()), index.row() > 0 ? &d->mLog.at(index.row() - 1) : nullptr, role);
+}
+
+bool MergedJournaldViewModel::canFetchMore(const QModelIndex &parent) const
+{
+    return std::any_of(d->mSources.cbegin(), d->mSources.cend(), [](const MergedJournaldViewModelPrivate::Source &source) {
+        return !source.mTailReached || !source.mBuffer.empty();
+    });
+}
+
+void MergedJournaldViewModel::fetchMore(const QModelIndex &parent)
+{
+    d->mMergeRequested = true;
+    mergeBufferedEntries();
+}
@@ -0,0 +1,166 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef MERGEDJOURNALDVIEWMODEL_H
+#define MERGEDJOURNALDVIEWMODEL_H
+
+#include "journaldviewmodel.h"
+#include "kjournald_export.h"
+#include <QAbstractItemModel>
+#include <QVector>
+#include <ijournal.h>
+#include <memory>
+#include <vector>
+
+class MergedJournaldViewModelPrivate;
+struct LogEntry;
+
+/**
+ * @brief Item model that merges the entries of several journals into a single timeline
+ *
+ * Every journal (local system journal, directory, file or remote journal) is read by its own worker
+ * thread in chunks, such that reading of the next chunk is pipelined with merging of the current one
+ * and a slow source does not block reading of the other sources. The entries are merged by their
+ * realtime timestamp, ties are resolved by the monotonic timestamp and the boot ID.
+ *
+ * The model reads from the head of all journals towards their tails. Data roles are the same as for
+ * JournaldViewModel, additionally the index of the source journal is provided for each entry.
+ */
+class KJOURNALD_EXPORT MergedJournaldViewModel : public QAbstractItemModel
+{
+    Q_OBJECT
+    /**
+     * Paths to journald databases (directories or files) that shall be merged
+     **/
+    Q_PROPERTY(QStringList journalPaths WRITE setJournalPaths READ journalPaths NOTIFY journalPathsChanged)
+    /**
+     * number of merged journals
+     **/
+    Q_PROPERTY(int sourceCount READ sourceCount NOTIFY journalPathsChanged)
+
+public:
+    enum Roles {
+        SOURCE = JournaldViewModel::CURSOR + 1, //!< index of journal from which the entry is read
+        SOURCE_COLOR_BACKGROUND, //!< convenience rainbow color that is hashed for the source, lighter variant
+        SOURCE_COLOR_FOREGROUND, //!< convenience rainbow color that is hashed for the source, darker variant
+    };
+    Q_ENUM(Roles);
+
+    /**
+     * @brief Construct empty model without any journal
+     *
+     * @param parent the QObject parent
+     */
+    explicit MergedJournaldViewModel(QObject *parent = nullptr);
+
+    /**
+     * @brief Construct model that merges @p journals
+     *
+     * @param journals the journals that shall be merged, index in this list is the entry's source index
+     * @param parent the QObject parent
+     */
+    MergedJournaldViewModel(std::vector<std::unique_ptr<IJournal>> journals, QObject *parent = nullptr);
+
+    /**
+     * Destroys MergedJournaldViewModel and stops all reader threads
+     */
+    ~MergedJournaldViewModel() override;
+
+    /**
+     * @brief Reset model by merging the given journals
+     *
+     * @note the journals are moved to worker threads and must not be accessed afterwards
+     * @param journals the journals that shall be merged
+     */
+    void setJournals(std::vector<std::unique_ptr<IJournal>> journals);
+
+    /**
+     * @brief Reset model by merging local journals at @p paths
+     *
+     * @param paths paths to directories or files that contain journald databases
+     */
+    void setJournalPaths(const QStringList &paths);
+
+    /**
+     * @return paths of local journals set with @a setJournalPaths()
+     */
+    QStringList journalPaths() const;
+
+    /**
+     * @return number of merged journals
+     */
+    int sourceCount() const;
+
+    /**
+     * @brief Set how many log entries shall be read from each journal per chunk
+     * @note the initial value is 500 and changing this value only affects future resets of the model
+     */
+    void setFetchMoreChunkSize(quint32 size);
+
+    /**
+     * @copydoc QAbstractItemModel::rolesNames()
+     */
+    QHash<int, QByteArray> roleNames() const override;
+
+    /**
+     * @copydoc QAbstractItemModel::index()
+     */
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+
+    /**
+     * @copydoc QAbstractItemModel::parent()
+     */
+    QModelIndex parent(const QModelIndex &index) const override;
+
+    /**
+     * @copydoc QAbstractItemModel::rowCount()
+     */
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    /**
+     * @copydoc QAbstractItemModel::columnCount()
+     */
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    /**
+     * @copydoc QAbstractItemModel::data()
+     */
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    /**
+     * @copydoc QAbstractItemModel::canFetchMore()
+     *
+     * @note returns true as long as any journal might provide further entries
+     */
+    bool canFetchMore(const QModelIndex &parent) const override;
+
+    /**
+     * @copydoc QAbstractItemModel::fetchMore()
+     *
+     * @note rows are inserted asynchronously once the reader threads provided the required chunks
+     */
+    void fetchMore(const QModelIndex &parent) override;
+
+Q_SIGNALS:
+    /**
+     * Signal is emitted when the set of merged journal paths is changed
+     */
+    void journalPathsChanged();
+
+private:
+    /**
+     * Handle chunk that was read by reader of source @p source
+     */
+    void handleChunkRead(int source, const QVector<LogEntry> &chunk, bool tailReached);
+
+    /**
+     * Merge buffered entries into model until a chunk is complete or a source requires more data
+     */
+    void mergeBufferedEntries();
+
+    std::unique_ptr<MergedJournaldViewModelPrivate> d;
+};
+
+#endif // MERGEDJOURNALDVIEWMODEL_H
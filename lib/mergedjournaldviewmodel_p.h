@@ -0,0 +1,89 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef MERGEDJOURNALDVIEWMODEL_P_H
+#define MERGEDJOURNALDVIEWMODEL_P_H
+
+#include "ijournal.h"
+#include "journaldviewmodel_p.h"
+#include <QObject>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+#include <deque>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Worker that reads chunks of one journal from head towards tail in its own thread
+ */
+class JournalSourceReader : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @note the reader takes ownership of @p journal as QObject child, such that both are moved to the reader's thread
+     */
+    JournalSourceReader(std::unique_ptr<IJournal> journal, quint32 chunkSize);
+
+    /**
+     * read next chunk of entries and provide it via chunkRead
+     */
+    void readChunk();
+
+Q_SIGNALS:
+    /**
+     * @param chunk the entries in journal order
+     * @param tailReached true if no further entries are currently available
+     */
+    void chunkRead(const QVector<LogEntry> &chunk, bool tailReached);
+
+    /**
+     * signal is emitted when the journal reported new entries after the tail was reached
+     */
+    void journalGrown();
+
+private:
+    IJournal *mJournal{nullptr};
+    quint32 mChunkSize{500};
+    bool mHeadSeeked{false};
+};
+
+class MergedJournaldViewModelPrivate
+{
+public:
+    struct Source {
+        std::unique_ptr<QThread> mThread;
+        JournalSourceReader *mReader{nullptr}; //!< owned by its thread, deleted when thread finished
+        std::deque<LogEntry> mBuffer; //!< entries read but not yet merged
+        bool mRequestPending{false};
+        bool mTailReached{false};
+    };
+
+    /**
+     * stop all reader threads and drop all sources
+     */
+    void clearSources();
+
+    /**
+     * request next chunk for @p source unless a request is already pending or its tail is reached
+     */
+    void requestChunk(Source &source);
+
+    /**
+     * @return true if @p lhs shall be placed before @p rhs in merged timeline
+     */
+    static bool isBefore(const LogEntry &lhs, const LogEntry &rhs);
+
+    std::vector<Source> mSources;
+    QVector<LogEntry> mLog;
+    QVector<int> mLogSources; //!< source index for each entry in mLog
+    QStringList mJournalPaths;
+    quint32 mChunkSize{500};
+    bool mMergeRequested{false}; //!< fetchMore was called and rows shall be inserted when data arrives
+    int mGeneration{0}; //!< incremented on every reset, such that chunks of previous sources are ignored
+};
+
+#endif // MERGEDJOURNALDVIEWMODEL_P_H
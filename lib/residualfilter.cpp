@@ -0,0 +1,152 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "residualfilter.h"
+#include "ijournal.h"
+#include "kjournaldlib_log_general.h"
+#include <QByteArrayMatcher>
+#include <QRegularExpression>
+#include <algorithm>
+#include <cstring>
+#include <systemd/sd-journal.h>
+#include <vector>
+
+struct ResidualFilterNode {
+    FilterExpression::Type mType{FilterExpression::Type::EMPTY};
+    QByteArray mField;
+    QByteArray mValue;
+    QByteArrayMatcher mMatcher;
+    QRegularExpression mRegularExpression;
+    qint64 mMinimum{0};
+    qint64 mMaximum{0};
+    std::vector<ResidualFilterNode> mOperands;
+};
+
+namespace
+{
+const QByteArray sRealtimeTimestampField{"__REALTIME_TIMESTAMP"};
+
+ResidualFilterNode compile(const FilterExpression &expression)
+{
+    ResidualFilterNode node;
+    node.mType = expression.type();
+    node.mField = expression.field().toUtf8();
+    node.mValue = expression.value().toUtf8();
+    node.mMinimum = expression.minimum();
+    node.mMaximum = expression.maximum();
+    if (node.mType == FilterExpression::Type::CONTAINS) {
+        node.mMatcher.setPattern(node.mValue);
+    } else if (node.mType == FilterExpression::Type::REGULAR_EXPRESSION) {
+        node.mRegularExpression.setPattern(expression.value());
+        if (!node.mRegularExpression.isValid()) {
+            qCWarning(KJOURNALDLIB_GENERAL) << "Invalid regular expression in filter:" << expression.value() << node.mRegularExpression.errorString();
+        }
+        node.mRegularExpression.optimize();
+    }
+    for (const auto &operand : expression.operands()) {
+        node.mOperands.push_back(compile(operand));
+    }
+    return node;
+}
+
+bool evaluate(const ResidualFilterNode &node, const ResidualFilter::FieldAccessor &fieldValue)
+{
+    const auto evaluateOperand = [&fieldValue](const ResidualFilterNode &operand) {
+        return evaluate(operand, fieldValue);
+    };
+
+    switch (node.mType) {
+    case FilterExpression::Type::EMPTY:
+        return true;
+    case FilterExpression::Type::ALL_OF:
+        return std::all_of(node.mOperands.cbegin(), node.mOperands.cend(), evaluateOperand);
+    case FilterExpression::Type::ANY_OF:
+        return std::any_of(node.mOperands.cbegin(), node.mOperands.cend(), evaluateOperand);
+    case FilterExpression::Type::NONE_OF:
+        return std::none_of(node.mOperands.cbegin(), node.mOperands.cend(), evaluateOperand);
+    case FilterExpression::Type::MATCH: {
+        const std::optional<QByteArrayView> value = fieldValue(node.mField);
+        return value.has_value() && value->size() == node.mValue.size() && std::memcmp(value->data(), node.mValue.constData(), node.mValue.size()) == 0;
+    }
+    case FilterExpression::Type::CONTAINS: {
+        const std::optional<QByteArrayView> value = fieldValue(node.mField);
+        return value.has_value() && node.mMatcher.indexIn(value->data(), value->size()) >= 0;
+    }
+    case FilterExpression::Type::RANGE: {
+        const std::optional<QByteArrayView> value = fieldValue(node.mField);
+        if (!value.has_value()) {
+            return false;
+        }
+        bool ok{false};
+        const qint64 number = value->trimmed().toLongLong(&ok);
+        return ok && number >= node.mMinimum && number <= node.mMaximum;
+    }
+    case FilterExpression::Type::REGULAR_EXPRESSION: {
+        const std::optional<QByteArrayView> value = fieldValue(node.mField);
+        return value.has_value() && node.mRegularExpression.match(QString::fromUtf8(*value)).hasMatch();
+    }
+    }
+    return false;
+}
+}
+
+ResidualFilter::ResidualFilter(const FilterExpression &expression)
+{
+    if (!expression.isEmpty()) {
+        mRoot = std::make_shared<const ResidualFilterNode>(compile(expression));
+    }
+}
+
+bool ResidualFilter::isEmpty() const
+{
+    return mRoot == nullptr;
+}
+
+bool ResidualFilter::matches(const FieldAccessor &fieldValue) const
+{
+    if (!mRoot) {
+        return true;
+    }
+    return evaluate(*mRoot, fieldValue);
+}
+
+bool ResidualFilter::matches(sd_journal *journal) const
+{
+    if (!mRoot) {
+        return true;
+    }
+    return evaluate(*mRoot, [journal, buffer = QByteArray()](const QByteArray &field) mutable -> std::optional<QByteArrayView> {
+        // the realtime timestamp is no data field, but addressed like in the journal export format
+        if (field == sRealtimeTimestampField) {
+            uint64_t usec{0};
+            if (sd_journal_get_realtime_usec(journal, &usec) < 0) {
+                return std::nullopt;
+            }
+            buffer = QByteArray::number(static_cast<qulonglong>(usec));
+            return QByteArrayView(buffer);
+        }
+        const char *data{nullptr};
+        size_t length{0};
+        if (sd_journal_get_data(journal, field.constData(), (const void **)&data, &length) < 0) {
+            return std::nullopt;
+        }
+        // skip "FIELD=" prefix
+        return QByteArrayView(data, length).sliced(field.size() + 1);
+    });
+}
+
+bool ResidualFilter::matches(const IJournal &journal) const
+{
+    if (!mRoot) {
+        return true;
+    }
+    return evaluate(*mRoot, [&journal, buffer = QByteArray()](const QByteArray &field) mutable -> std::optional<QByteArrayView> {
+        if (field == sRealtimeTimestampField) {
+            buffer = QByteArray::number(journal.realtimeUsec());
+            return QByteArrayView(buffer);
+        }
+        return journal.fieldValue(field);
+    });
+}
@@ -0,0 +1,73 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef RESIDUALFILTER_H
+#define RESIDUALFILTER_H
+
+#include "filterexpression.h"
+#include "kjournald_export.h"
+#include <QByteArray>
+#include <QByteArrayView>
+#include <functional>
+#include <memory>
+#include <optional>
+
+class IJournal;
+class sd_journal;
+struct ResidualFilterNode;
+
+/**
+ * @brief Compiled evaluator for the parts of a filter expression that journald cannot evaluate
+ *
+ * The expression is compiled once into a predicate tree that works on the raw field bytes of an entry,
+ * i.e. without any string conversion for exact and substring matches. Field values are requested lazily
+ * only for those predicates that are evaluated, such that short-circuiting avoids reading unneeded fields.
+ */
+class KJOURNALD_EXPORT ResidualFilter
+{
+public:
+    /**
+     * @brief Accessor for the raw value of a field of the current entry, i.e. without "FIELD=" prefix
+     *
+     * The accessor returns std::nullopt if the entry does not contain the field. The returned view
+     * only has to stay valid until the accessor is called again.
+     */
+    using FieldAccessor = std::function<std::optional<QByteArrayView>(const QByteArray &field)>;
+
+    /**
+     * @brief Create empty filter that matches every entry
+     */
+    ResidualFilter() = default;
+
+    /**
+     * @brief Compile filter for @p expression
+     */
+    explicit ResidualFilter(const FilterExpression &expression);
+
+    /**
+     * @return true if the filter matches every entry
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief Evaluate filter for entry with fields provided by @p fieldValue
+     */
+    bool matches(const FieldAccessor &fieldValue) const;
+
+    /**
+     * @brief Evaluate filter for the current entry of @p journal
+     */
+    bool matches(sd_journal *journal) const;
+
+    /**
+     * @brief Evaluate filter for the current entry of @p journal
+     */
+    bool matches(const IJournal &journal) const;
+
+private:
+    std::shared_ptr<const ResidualFilterNode> mRoot;
+};
+
+#endif // RESIDUALFILTER_H
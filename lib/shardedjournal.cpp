@@ -0,0 +1,241 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#include "shardedjournal.h"
+#include "journalfileheader.h"
+#include "kjournaldlib_log_general.h"
+#include "shardedjournal_p.h"
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMap>
+#include <QSet>
+#include <algorithm>
+#include <iterator>
+#include <systemd/sd-journal.h>
+#include <vector>
+
+ShardedJournalPrivate::ShardedJournalPrivate(ShardedJournal *q)
+    : q(q)
+{
+}
+
+void ShardedJournalPrivate::discoverShards(const QString &path)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QStringList files;
+    if (QFileInfo(path).isFile()) {
+        files.append(path);
+    } else {
+        // archived files that were not closed cleanly are renamed to "*.journal~" by journald
+        QDirIterator it(path, {QLatin1String("*.journal"), QLatin1String("*.journal~")}, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            files.append(it.next());
+        }
+    }
+
+    mHeaders = JournalFileHeader::readAll(files);
+
+    QMap<QString, ShardedJournal::Shard> shards;
+    for (const auto &header : std::as_const(mHeaders)) {
+        ShardedJournal::Shard &shard = shards[header.mMachineId];
+        shard.mMachineId = header.mMachineId;
+        shard.mFiles.append(header.mPath);
+        shard.mEntryCount += header.mEntryCount;
+        // files without entries have zero timestamps and must not extend the shard's time range
+        if (header.mEntryCount > 0) {
+            shard.mHeadRealtime = shard.mHeadRealtime == 0 ? header.mHeadEntryRealtime : std::min(shard.mHeadRealtime, header.mHeadEntryRealtime);
+            shard.mTailRealtime = std::max(shard.mTailRealtime, header.mTailEntryRealtime);
+        }
+    }
+    mShards = QVector<ShardedJournal::Shard>(shards.cbegin(), shards.cend());
+    qCDebug(KJOURNALDLIB_GENERAL) << "Discovered" << mShards.size() << "shards with" << mHeaders.size() << "valid and" << files.size() - mHeaders.size()
+                                  << "invalid journal files in" << timer.elapsed() << "ms";
+}
+
+QStringList ShardedJournalPrivate::selectedFiles() const
+{
+    const std::optional<QStringList> machineIds = mQuery.requiredValues(QLatin1String("_MACHINE_ID"));
+    QVector<JournalFileHeader> headers;
+    for (const auto &header : std::as_const(mHeaders)) {
+        if (!machineIds || machineIds->contains(header.mMachineId)) {
+            headers.append(header);
+        }
+    }
+    // within the touched shards, further skip files that cannot contain entries of the requested boots or time range
+    QStringList files;
+    for (const auto &header : JournalFileHeader::select(headers, mQuery)) {
+        files.append(header.mPath);
+    }
+    return files;
+}
+
+void ShardedJournalPrivate::openSelectedFiles()
+{
+    mOpened = true;
+    QStringList selection = selectedFiles();
+    if (selection.isEmpty()) {
+        if (mJournal) {
+            // the query cannot match any entry of the known files, thus keep current journal instead of opening files
+            return;
+        }
+        if (mHeaders.isEmpty()) {
+            return;
+        }
+        selection.append(mHeaders.constFirst().mPath);
+    }
+
+    const QSet<QString> selectedPaths(selection.cbegin(), selection.cend());
+    QVector<QByteArray> paths;
+    QStringList machineIds;
+    for (const auto &header : std::as_const(mHeaders)) {
+        if (selectedPaths.contains(header.mPath)) {
+            paths.append(header.mPath.toLocal8Bit());
+            if (!machineIds.contains(header.mMachineId)) {
+                machineIds.append(header.mMachineId);
+            }
+        }
+    }
+    std::sort(machineIds.begin(), machineIds.end());
+    std::vector<const char *> files;
+    files.reserve(paths.size() + 1);
+    for (const QByteArray &path : std::as_const(paths)) {
+        files.push_back(path.constData());
+    }
+    files.push_back(nullptr);
+
+    mJournalSocketNotifier.reset();
+    mJournal.reset();
+    mOpenedMachineIds.clear();
+    mOpenedFiles.clear();
+    QElapsedTimer timer;
+    timer.start();
+    auto expectedJournal = owning_ptr_call<sd_journal>(sd_journal_open_files, files.data(), 0 /* no flags */);
+    if (expectedJournal.ret < 0) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Could not open journal files of shards" << machineIds << ":" << strerror(-expectedJournal.ret);
+        return;
+    }
+    mJournal = std::move(expectedJournal.value);
+    mOpenedMachineIds = machineIds;
+    mOpenedFiles = selection;
+    qCDebug(KJOURNALDLIB_GENERAL) << "Opened" << paths.size() << "files of shards" << machineIds << "in" << timer.elapsed() << "ms";
+
+    if (!mWatching) {
+        return;
+    }
+    const int fd = sd_journal_get_fd(mJournal.get());
+    if (fd > 0) {
+        // notifier is child such that it follows the journal when moved to another thread
+        mJournalSocketNotifier = std::make_unique<QSocketNotifier>(fd, QSocketNotifier::Read, q);
+        QObject::connect(mJournalSocketNotifier.get(), &QSocketNotifier::activated, q, &ShardedJournal::handleJournalDescriptorUpdate);
+    } else {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Could not create FD" << strerror(-fd);
+    }
+}
+
+ShardedJournal::ShardedJournal(const QString &path)
+    : d(new ShardedJournalPrivate(this))
+{
+    if (!QFileInfo::exists(path)) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Journal directory does not exist, abort opening" << path;
+        return;
+    }
+    d->mPath = path;
+    d->discoverShards(path);
+}
+
+ShardedJournal::ShardedJournal()
+    : d(new ShardedJournalPrivate(this))
+{
+}
+
+ShardedJournal::~ShardedJournal() = default;
+
+sd_journal *ShardedJournal::sdJournal() const
+{
+    if (!d->mOpened) {
+        d->openSelectedFiles();
+    }
+    return d->mJournal.get();
+}
+
+bool ShardedJournal::isValid() const
+{
+    return !d->mHeaders.isEmpty();
+}
+
+QString ShardedJournal::currentBootId() const
+{
+    return QString();
+}
+
+void ShardedJournal::prepareQuery(const FilterExpression &expression)
+{
+    d->mQuery = expression;
+    // keep opened journal if it already covers exactly the selected files
+    if (d->mOpened && d->selectedFiles() != d->mOpenedFiles) {
+        d->mOpened = false;
+    }
+}
+
+QVector<JournalFileHeader> ShardedJournal::queryFiles() const
+{
+    const QStringList files = d->mOpened ? d->mOpenedFiles : d->selectedFiles();
+    const QSet<QString> paths(files.cbegin(), files.cend());
+    QVector<JournalFileHeader> headers;
+    std::copy_if(d->mHeaders.cbegin(), d->mHeaders.cend(), std::back_inserter(headers), [&paths](const JournalFileHeader &header) {
+        return paths.contains(header.mPath);
+    });
+    return headers;
+}
+
+std::unique_ptr<IJournal> ShardedJournal::clone() const
+{
+    // the constructor is private, thus std::make_unique() cannot be used
+    std::unique_ptr<ShardedJournal> journal(new ShardedJournal);
+    journal->d->mPath = d->mPath;
+    journal->d->mHeaders = d->mHeaders;
+    journal->d->mShards = d->mShards;
+    return journal;
+}
+
+void ShardedJournal::stopWatching()
+{
+    d->mWatching = false;
+    d->mJournalSocketNotifier.reset();
+}
+
+QVector<ShardedJournal::Shard> ShardedJournal::shards() const
+{
+    return d->mShards;
+}
+
+QStringList ShardedJournal::openedMachineIds() const
+{
+    return d->mOpenedMachineIds;
+}
+
+void ShardedJournal::handleJournalDescriptorUpdate()
+{
+    const int result = sd_journal_process(d->mJournal.get());
+    switch (result) {
+    case SD_JOURNAL_NOP:
+        break;
+    case SD_JOURNAL_APPEND:
+        qCDebug(KJOURNALDLIB_GENERAL) << "Sharded journal FD updated, entries appended";
+        Q_EMIT journalUpdated(QString(), IJournal::ChangeType::APPEND);
+        break;
+    case SD_JOURNAL_INVALIDATE:
+        qCDebug(KJOURNALDLIB_GENERAL) << "Sharded journal FD updated, journal files changed";
+        Q_EMIT journalUpdated(QString(), IJournal::ChangeType::INVALIDATE);
+        break;
+    default:
+        if (result < 0) {
+            qCWarning(KJOURNALDLIB_GENERAL) << "Could not process journal changes:" << strerror(-result);
+        }
+    }
+}
@@ -0,0 +1,125 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef SHARDEDJOURNAL_H
+#define SHARDEDJOURNAL_H
+
+#include "ijournal.h"
+#include "kjournald_export.h"
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+
+class ShardedJournalPrivate;
+class sd_journal;
+
+/**
+ * @brief Journal over a large directory tree, e.g. as written by systemd-journal-remote, that opens its files lazily
+ *
+ * Opening a directory with sd_journal_open_directory maps every journal file up front, which for collector hosts
+ * with thousands of files takes a long time. Instead, this journal only reads the headers of all files (in parallel)
+ * and groups the files into shards by their machine ID. The files of a shard are opened the first time a query
+ * touches the shard, i.e. when @a sdJournal() is requested after the query was announced via @a prepareQuery().
+ * Queries that require specific "_MACHINE_ID" values only open the shards of these machines, all other queries
+ * open all shards. Within these shards, only files that may contain entries of the required boots or time range
+ * are opened, see JournalFileHeader::select().
+ *
+ * @note files that are added to the directory tree after construction are not considered
+ */
+class KJOURNALD_EXPORT ShardedJournal : public IJournal
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Journal files that were written by the same machine
+     */
+    struct Shard {
+        QString mMachineId;
+        QStringList mFiles;
+        quint64 mEntryCount{0}; //!< number of entries as recorded in file headers
+        quint64 mHeadRealtime{0}; //!< realtime timestamp of oldest entry in microseconds
+        quint64 mTailRealtime{0}; //!< realtime timestamp of newest entry in microseconds
+    };
+
+    /**
+     * @brief Construct journal for all journal files in directory tree at @p path
+     *
+     * Only file headers are read, the files are not opened.
+     */
+    explicit ShardedJournal(const QString &path);
+
+    /**
+     * @brief Destroys the journal wrapper
+     */
+    ~ShardedJournal() override;
+
+    /**
+     * @brief Getter for raw sd_journal pointer
+     *
+     * The selected shards are opened on first call after construction or after the selection changed
+     * by @a prepareQuery(). This pointer can be nullptr if an error during opening occured.
+     */
+    sd_journal *sdJournal() const override;
+
+    /**
+     * @brief returns true if the directory tree contains at least one valid journal file
+     */
+    bool isValid() const override;
+
+    /**
+     * @copydoc IJournal::currentBootId()
+     *
+     * @note the journal does not belong to the running system, thus the ID is always empty
+     */
+    QString currentBootId() const override;
+
+    /**
+     * @brief Select the shards that may contain entries matching @p expression
+     */
+    void prepareQuery(const FilterExpression &expression) override;
+
+    /**
+     * @copydoc IJournal::queryFiles()
+     */
+    QVector<JournalFileHeader> queryFiles() const override;
+
+    /**
+     * @copydoc IJournal::clone()
+     *
+     * The clone uses the file headers that were read by this journal, such that cloning does not read the
+     * headers of all files again.
+     */
+    std::unique_ptr<IJournal> clone() const override;
+
+    /**
+     * @copydoc IJournal::stopWatching()
+     */
+    void stopWatching() override;
+
+    /**
+     * @return all shards, ordered by machine ID
+     */
+    QVector<Shard> shards() const;
+
+    /**
+     * @return machine IDs of the shards whose files are currently opened
+     */
+    QStringList openedMachineIds() const;
+
+private Q_SLOTS:
+    void handleJournalDescriptorUpdate();
+
+private:
+    /**
+     * @brief Construct journal without files, used by clone()
+     */
+    ShardedJournal();
+
+    std::unique_ptr<ShardedJournalPrivate> d;
+    friend class ShardedJournalPrivate;
+};
+
+#endif // SHARDEDJOURNAL_H
@@ -0,0 +1,51 @@
+/*
+    SPDX-License-Identifier: LGPL-2.1-or-later OR MIT
+    SPDX-FileCopyrightText: 2021 Andreas Cord-Landwehr <cordlandwehr@kde.org>
+*/
+
+#ifndef SHARDEDJOURNAL_P_H
+#define SHARDEDJOURNAL_P_H
+
+#include "filterexpression.h"
+#include "journalfileheader.h"
+#include "memory.h"
+#include "shardedjournal.h"
+#include <QSocketNotifier>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+
+class ShardedJournalPrivate
+{
+public:
+    explicit ShardedJournalPrivate(ShardedJournal *q);
+
+    /**
+     * find all journal files below @p path and group them into shards by the machine IDs of their headers
+     */
+    void discoverShards(const QString &path);
+
+    /**
+     * open selected files, replacing any previously opened journal
+     */
+    void openSelectedFiles();
+
+    /**
+     * @return files of the shards touched by mQuery that may contain matching entries
+     */
+    QStringList selectedFiles() const;
+
+    ShardedJournal *q{nullptr};
+    QString mPath;
+    QVector<JournalFileHeader> mHeaders;
+    QVector<ShardedJournal::Shard> mShards;
+    FilterExpression mQuery;
+    QStringList mOpenedMachineIds;
+    QStringList mOpenedFiles;
+    bool mOpened{false};
+    std::unique_ptr<sd_journal> mJournal;
+    std::unique_ptr<QSocketNotifier> mJournalSocketNotifier;
+    bool mWatching{true}; //!< false after stopWatching(), then no notifier is created
+};
+
+#endif // SHARDEDJOURNAL_P_H
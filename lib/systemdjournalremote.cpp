@@ -4,15 +4,22 @@
 */
 
 #include "systemdjournalremote.h"
+#include "journalfileheader.h"
 #include "kjournaldlib_log_general.h"
+#include "localjournal.h"
 #include "systemdjournalremote_p.h"
 #include <QDir>
 #include <QFileInfo>
 #include <QFileSystemWatcher>
 #include <QProcess>
-#include <QThread>
+#include <algorithm>
 
-SystemdJournalRemotePrivate::SystemdJournalRemotePrivate() = default;
+SystemdJournalRemotePrivate::SystemdJournalRemotePrivate(SystemdJournalRemote *q)
+    : q(q)
+{
+    mRefreshTimer.setSingleShot(true);
+    mRefreshTimer.setInterval(sRefreshInterval);
+}
 
 bool SystemdJournalRemotePrivate::sanityCheckForSystemdJournalRemoveExec() const
 {
@@ -33,41 +40,253 @@ bool SystemdJournalRemotePrivate::sanityCheckForSystemdJournalRemoveExec() const
 
 QString SystemdJournalRemotePrivate::journalFile() const
 {
-    return mTemporyJournalDir.path() + QLatin1String("/remote.journal");
+    return mJournalFile;
+}
+
+void SystemdJournalRemotePrivate::createJournalDirectory(const QString &templatePath)
+{
+    mTemporyJournalDir = templatePath.isEmpty() ? std::make_unique<QTemporaryDir>() : std::make_unique<QTemporaryDir>(templatePath);
+    if (!mTemporyJournalDir->isValid()) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Could not create directory for journal file:" << mTemporyJournalDir->errorString();
+    }
+    mJournalFile = mTemporyJournalDir->path() + QLatin1String("/remote.journal");
+}
+
+void SystemdJournalRemotePrivate::startProcess(const QStringList &arguments)
+{
+    mTemporaryJournalDirWatcher.addPath(mTemporyJournalDir->path());
+    mJournalRemoteProcess.setProcessChannelMode(QProcess::ForwardedChannels);
+    sanityCheckForSystemdJournalRemoveExec();
+
+    QObject::connect(&mJournalRemoteProcess, &QProcess::started, q, [this]() {
+        feedProcess();
+    });
+    QObject::connect(&mJournalRemoteProcess, &QProcess::bytesWritten, q, [this](qint64 bytes) {
+        mBytesImported += bytes;
+        Q_EMIT q->importProgress(mBytesImported, mBytesTotal, mEntryCount);
+        feedProcess();
+    });
+    QObject::connect(&mJournalRemoteProcess, &QProcess::errorOccurred, q, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            qCCritical(KJOURNALDLIB_GENERAL) << "Could not start systemd-journal-remote:" << mJournalRemoteProcess.errorString();
+            // QProcess might report the error from start(), i.e. during construction
+            failImport();
+        }
+    });
+    QObject::connect(&mJournalRemoteProcess, &QProcess::finished, q, [this](int exitCode, QProcess::ExitStatus exitStatus) {
+        // entries that were written since the last file change notification are announced right away
+        refresh();
+        finishImport(exitStatus == QProcess::NormalExit && exitCode == 0);
+    });
+    QObject::connect(&mTemporaryJournalDirWatcher,
+                     &QFileSystemWatcher::directoryChanged,
+                     q,
+                     &SystemdJournalRemote::handleJournalFileCreated,
+                     Qt::QueuedConnection);
+    QObject::connect(&mTemporaryJournalDirWatcher, &QFileSystemWatcher::fileChanged, q, [this]() {
+        // a running import changes the file continuously, thus the timer is not restarted
+        if (!mRefreshTimer.isActive()) {
+            mRefreshTimer.start();
+        }
+    });
+    QObject::connect(&mRefreshTimer, &QTimer::timeout, q, [this]() {
+        refresh();
+    });
+
+    mJournalRemoteProcess.start(mSystemdJournalRemoteExec, arguments);
+}
+
+void SystemdJournalRemotePrivate::feedProcess()
+{
+    if (mWriteChannelClosed || mSource == nullptr || mJournalRemoteProcess.state() != QProcess::Running) {
+        return;
+    }
+    // only data that is available without blocking is passed, such that the GUI thread never waits for the input
+    while (mJournalRemoteProcess.bytesToWrite() < sMaxPendingBytes && mSource->bytesAvailable() > 0) {
+        mJournalRemoteProcess.write(mSource->read(std::min(mSource->bytesAvailable(), sMaxPendingBytes)));
+    }
+    if (mSource->atEnd()) {
+        if (mDecompressionDevice && mDecompressionDevice->hasError()) {
+            qCCritical(KJOURNALDLIB_GENERAL) << "Compressed export file could not be decompressed completely";
+        }
+        // pending data is still written before the channel is closed
+        mJournalRemoteProcess.closeWriteChannel();
+        mWriteChannelClosed = true;
+    }
+}
+
+void SystemdJournalRemotePrivate::openJournal()
+{
+    const QString path = journalFile();
+    const std::optional<JournalFileHeader> header = JournalFileHeader::read(path);
+    if (!header) {
+        // systemd-journal-remote creates the file before it writes the header
+        return;
+    }
+    if (mJournal != nullptr && header->mFileId == mJournalFileId) {
+        return;
+    }
+
+    sd_journal_close(mJournal);
+    mJournal = nullptr;
+    const QByteArray journalPath = path.toLocal8Bit();
+    const char *files[] = {journalPath.constData(), nullptr};
+    int result = sd_journal_open_files(&mJournal, files, 0 /* no flags, directory defines type */);
+    if (result < 0) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Could not open journal:" << strerror(-result);
+        mJournal = nullptr;
+        return;
+    }
+    mJournalFileId = header->mFileId;
+    mEntryCount = static_cast<qint64>(header->mEntryCount);
+    if (mSource == nullptr) {
+        mBytesImported = QFileInfo(path).size();
+    }
+    if (!mTemporaryJournalDirWatcher.files().contains(path)) {
+        mTemporaryJournalDirWatcher.addPath(path);
+    }
+
+    Q_EMIT q->journalFileChanged();
+    // models that were created before the file existed query the journal again
+    Q_EMIT q->journalUpdated(QString(), IJournal::ChangeType::INVALIDATE);
+    Q_EMIT q->importProgress(mBytesImported, mBytesTotal, mEntryCount);
+}
+
+void SystemdJournalRemotePrivate::refresh()
+{
+    if (mJournal == nullptr) {
+        openJournal();
+        return;
+    }
+    const std::optional<JournalFileHeader> header = JournalFileHeader::read(journalFile());
+    if (!header) {
+        return;
+    }
+    if (header->mFileId != mJournalFileId) {
+        openJournal();
+        return;
+    }
+    if (mSource == nullptr) {
+        mBytesImported = QFileInfo(journalFile()).size();
+    }
+    if (static_cast<qint64>(header->mEntryCount) == mEntryCount) {
+        return;
+    }
+    mEntryCount = static_cast<qint64>(header->mEntryCount);
+    // the header count is cheap to read, appended entries are read by the opened journal without processing events
+    Q_EMIT q->journalUpdated(QString(), IJournal::ChangeType::APPEND);
+    Q_EMIT q->importProgress(mBytesImported, mBytesTotal, mEntryCount);
+}
+
+void SystemdJournalRemotePrivate::finishImport(bool success)
+{
+    if (!mImporting) {
+        return;
+    }
+    mImporting = false;
+    mRefreshTimer.stop();
+    if (!success) {
+        qCWarning(KJOURNALDLIB_GENERAL) << "Import by systemd-journal-remote failed:" << mJournalRemoteProcess.exitCode();
+    } else if (mCache && !mCacheKey.isEmpty() && mJournal != nullptr) {
+        // the opened journal stays readable, because the file is only renamed or, between file systems, unlinked
+        const QString importedFile = mJournalFile;
+        if (mCache->insert(mCacheKey, importedFile)) {
+            mTemporaryJournalDirWatcher.removePath(importedFile);
+            mJournalFile = mCache->journalFile(mCacheKey);
+            Q_EMIT q->journalFileChanged();
+        }
+    }
+    Q_EMIT q->importFinished(success);
+}
+
+void SystemdJournalRemotePrivate::failImport()
+{
+    mSource = nullptr;
+    mWriteChannelClosed = true;
+    QMetaObject::invokeMethod(
+        q,
+        [this]() {
+            finishImport(false);
+        },
+        Qt::QueuedConnection);
 }
 
 // TODO additional access can easily be implemented by using systemd-journal-remote CLI:
-//   --listen-raw=ADDR      Listen for connections at ADDR
-//   --listen-http=ADDR     Listen for HTTP connections at ADDR
 //   --listen-https=ADDR    Listen for HTTPS connections at ADDR
+// --listen-raw and --listen-http are provided in process by IngestServer
 
 // TODO add option to persistently safe journal in DB format
 
 // TODO introduce special handling when reaching max system file size due to: https://github.com/systemd/systemd/issues/5242
 
-SystemdJournalRemote::SystemdJournalRemote(const QString &filePath)
-    : d(new SystemdJournalRemotePrivate)
+void SystemdJournalRemotePrivate::importFile(const QString &filePath)
 {
     if (!QFile::exists(filePath)) {
         qCCritical(KJOURNALDLIB_GENERAL) << "Provided export journal file format does not exists, no journal created" << filePath;
+        failImport();
+        return;
     }
-    if (!filePath.endsWith(QLatin1String("export"))) {
+    const bool compressed = DecompressionDevice::isCompressed(filePath);
+    if (!compressed && !filePath.endsWith(QLatin1String("export"))) {
         qCWarning(KJOURNALDLIB_GENERAL) << "Provided export file has uncommon file ending that is not \".export\":" << filePath;
     }
 
-    // start import
-    d->mTemporaryJournalDirWatcher.addPath(d->mTemporyJournalDir.path());
-    d->mJournalRemoteProcess.setProcessChannelMode(QProcess::ForwardedChannels);
-    d->sanityCheckForSystemdJournalRemoveExec();
-    // command structure: systemd-journal-remote --output=foo.journal foo.export
-    d->mJournalRemoteProcess.start(d->mSystemdJournalRemoteExec, QStringList() << QLatin1String("--output=") + d->journalFile() << filePath);
-    d->mJournalRemoteProcess.waitForStarted();
+    // the export is streamed to the standard input, which allows to count the imported bytes and avoids a
+    // temporary uncompressed copy of compressed files
+    // command structure: systemd-journal-remote --output=foo.journal -
+    if (compressed) {
+        mDecompressionDevice = std::make_unique<DecompressionDevice>(filePath);
+        mSource = mDecompressionDevice.get();
+        auto feed = [this]() {
+            feedProcess();
+        };
+        QObject::connect(mDecompressionDevice.get(), &QIODevice::readyRead, q, feed, Qt::QueuedConnection);
+        QObject::connect(mDecompressionDevice.get(), &QIODevice::readChannelFinished, q, feed, Qt::QueuedConnection);
+    } else {
+        mFile = std::make_unique<QFile>(filePath);
+        mSource = mFile.get();
+        mBytesTotal = mFile->size();
+    }
+    if (!mSource->open(QIODevice::ReadOnly)) {
+        qCCritical(KJOURNALDLIB_GENERAL) << "Could not read export file" << filePath << mSource->errorString();
+        failImport();
+        return;
+    }
+    startProcess(QStringList() << QLatin1String("--output=") + journalFile() << QLatin1String("-"));
+}
 
-    connect(&d->mTemporaryJournalDirWatcher,
-            &QFileSystemWatcher::directoryChanged,
+SystemdJournalRemote::SystemdJournalRemote(const QString &filePath)
+    : d(new SystemdJournalRemotePrivate(this))
+{
+    d->createJournalDirectory();
+    d->importFile(filePath);
+}
+
+SystemdJournalRemote::SystemdJournalRemote(const QString &filePath, const JournalImportCache &cache)
+    : d(new SystemdJournalRemotePrivate(this))
+{
+    d->mCache = cache;
+    d->mCacheKey = JournalImportCache::key(filePath);
+    const QString cachedFile = cache.lookup(d->mCacheKey);
+    if (!cachedFile.isEmpty()) {
+        qCDebug(KJOURNALDLIB_GENERAL) << "Opening cached import of export file" << filePath << cachedFile;
+        d->mJournalFile = cachedFile;
+        d->mImporting = false;
+        d->mBytesTotal = QFileInfo(filePath).size();
+        d->mBytesImported = d->mBytesTotal;
+        d->openJournal();
+        // announced asynchronously like for imports, such that receivers can connect after construction
+        QMetaObject::invokeMethod(
             this,
-            &SystemdJournalRemote::handleJournalFileCreated,
+            [this]() {
+                Q_EMIT importFinished(isValid());
+            },
             Qt::QueuedConnection);
+        return;
+    }
+    // the journal file is written next to the cache entries, such that it can be renamed into the cache
+    d->createJournalDirectory(cache.directory() + QLatin1String("/import-XXXXXX"));
+    d->importFile(filePath);
 }
 
 void SystemdJournalRemote::handleJournalFileCreated(const QString &path)
@@ -75,47 +294,29 @@ void SystemdJournalRemote::handleJournalFileCreated(const QString &path)
     qCDebug(KJOURNALDLIB_GENERAL) << "handleJournaldFileCreated in path:" << path;
 
     if (path.isEmpty() || !QDir().exists(d->journalFile())) {
-        qCCritical(KJOURNALDLIB_GENERAL) << "Journal directory does not exist, abort opening" << d->journalFile();
+        qCDebug(KJOURNALDLIB_GENERAL) << "Journal file not yet created" << d->journalFile();
         return;
     }
-
-    const char **files = new const char *[1];
-    QByteArray journalPath = d->journalFile().toLocal8Bit();
-    files[0] = journalPath.data();
-
-    int result = sd_journal_open_files(&d->mJournal, files, 0 /* no flags, directory defines type */);
-    if (result < 0) {
-        qCCritical(KJOURNALDLIB_GENERAL) << "Could not open journal:" << strerror(-result);
-    }
-    delete[] files;
-
-    Q_EMIT journalFileChanged();
+    // also reopens the journal if the file was replaced
+    d->refresh();
 }
 
 SystemdJournalRemote::SystemdJournalRemote(const QString &url, const QString &port)
-    : d(new SystemdJournalRemotePrivate)
+    : d(new SystemdJournalRemotePrivate(this))
 {
     if (!(url.startsWith(QLatin1String("https://")) || url.startsWith(QLatin1String("http://")))) {
         qCWarning(KJOURNALDLIB_GENERAL) << "URL seems not begin a valid URL, no http/https prefix:" << url;
     }
-    d->mTemporaryJournalDirWatcher.addPath(d->mTemporyJournalDir.path());
-    d->mJournalRemoteProcess.setProcessChannelMode(QProcess::ForwardedChannels);
-    d->sanityCheckForSystemdJournalRemoveExec();
+    d->createJournalDirectory();
     // command structure /lib/systemd/systemd-journal-remote --url http://127.0.0.1 -o /tmp/asdf.journal --split-mode=none
-    d->mJournalRemoteProcess.start(d->mSystemdJournalRemoteExec,
-                                   QStringList() << QLatin1String("--output=") + d->journalFile() << QLatin1String("--url=") + url + QLatin1Char(':') + port
-                                                 << QLatin1String("--split-mode=none"));
-    d->mJournalRemoteProcess.waitForStarted();
-
-    connect(&d->mTemporaryJournalDirWatcher,
-            &QFileSystemWatcher::directoryChanged,
-            this,
-            &SystemdJournalRemote::handleJournalFileCreated,
-            Qt::QueuedConnection);
+    d->startProcess(QStringList() << QLatin1String("--output=") + d->journalFile() << QLatin1String("--url=") + url + QLatin1Char(':') + port
+                                  << QLatin1String("--split-mode=none"));
 }
 
 SystemdJournalRemote::~SystemdJournalRemote()
 {
+    // no progress is reported while the object is destroyed
+    QObject::disconnect(&d->mJournalRemoteProcess, nullptr, this, nullptr);
     d->mJournalRemoteProcess.terminate();
     d->mJournalRemoteProcess.waitForFinished(1000);
     if (d->mJournalRemoteProcess.state() == QProcess::Running) {
@@ -148,6 +349,15 @@ QString SystemdJournalRemote::currentBootId() const
     return QString();
 }
 
+std::unique_ptr<IJournal> SystemdJournalRemote::clone() const
+{
+    const QString file = d->journalFile();
+    if (file.isEmpty() || !QFile::exists(file)) {
+        return nullptr;
+    }
+    return std::make_unique<LocalJournal>(file);
+}
+
 uint64_t SystemdJournalRemote::usage() const
 {
     uint64_t size{0};
@@ -157,3 +367,18 @@ uint64_t SystemdJournalRemote::usage() const
     }
     return size;
 }
+
+bool SystemdJournalRemote::isImporting() const
+{
+    return d->mImporting;
+}
+
+qint64 SystemdJournalRemote::bytesImported() const
+{
+    return d->mBytesImported;
+}
+
+qint64 SystemdJournalRemote::entryCount() const
+{
+    return d->mEntryCount;
+}
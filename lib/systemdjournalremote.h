@@ -11,6 +11,7 @@
 #include <QString>
 #include <memory>
 
+class JournalImportCache;
 class SystemdJournalRemotePrivate;
 class sd_journal;
 class QIODevice;
@@ -18,17 +19,36 @@ class QIODevice;
 /**
  * @brief The SystemdJournalRemote provides access to a remote journal via the systemd-journal-remote tool
  *
+ * The import runs asynchronously: construction returns immediately and the journal becomes valid as soon
+ * as systemd-journal-remote created the journal file. While the file grows, the journal announces the new
+ * entries by journalUpdated() and reports its progress by importProgress(), such that models show the
+ * first entries of large exports early and may follow the import like a local journal. The announcements do
+ * not name a boot ID, because the appended entries may belong to any boot of the export.
  */
 class KJOURNALD_EXPORT SystemdJournalRemote : public IJournal
 {
     Q_OBJECT
     Q_PROPERTY(QString journalFile READ journalFile NOTIFY journalFileChanged)
+    Q_PROPERTY(bool importing READ isImporting NOTIFY importFinished)
 public:
     /**
      * @brief Construct journal object form file containing logs in systemd's journal export format
+     *
+     * Export files that are compressed with gzip, bzip2, xz or zstd are decompressed while importing,
+     * see DecompressionDevice.
      */
     SystemdJournalRemote(const QString &filePath);
 
+    /**
+     * @brief Construct journal object for export file at @p filePath that is imported only once into @p cache
+     *
+     * If the cache contains the journal file of a previous import of the same export, the journal file is
+     * opened directly and the journal is valid right after construction. Otherwise the export is imported
+     * like for SystemdJournalRemote(const QString &) and the journal file is moved into the cache once the
+     * import succeeded, see journalFile().
+     */
+    SystemdJournalRemote(const QString &filePath, const JournalImportCache &cache);
+
     /**
      * @brief Construct journal object form file containing logs in systemd's journal export format
      */
@@ -43,7 +63,7 @@ public:
      * @brief Path to journal file that temporarily stores data from remote journal
      *
      * @note the lifetime of this file is bound to the lifetime of the SystemJournalRemote object that
-     * relays the remote data to the file.
+     * relays the remote data to the file, unless the file was moved into a JournalImportCache.
      * @return path to the journald ".journal" file
      */
     QString journalFile() const;
@@ -66,15 +86,55 @@ public:
      */
     QString currentBootId() const override;
 
+    /**
+     * @copydoc IJournal::clone()
+     *
+     * @note the returned journal is a local journal for the file written by systemd-journal-remote
+     */
+    std::unique_ptr<IJournal> clone() const override;
+
     /**
      * @brief Get file system usage of journal
      * @return size of journal in bytes
      */
     uint64_t usage() const;
 
+    /**
+     * @return true while systemd-journal-remote is running, i.e. while entries may still be appended
+     */
+    bool isImporting() const;
+
+    /**
+     * @brief Number of bytes imported so far
+     *
+     * For export files, these are the bytes of the (decompressed) export passed to systemd-journal-remote,
+     * for remote journals the size of the journal file. For exports that were found in the import cache,
+     * it is the size of the export file.
+     */
+    qint64 bytesImported() const;
+
+    /**
+     * @return number of entries that are available in the journal file
+     */
+    qint64 entryCount() const;
+
 Q_SIGNALS:
     void journalFileChanged();
 
+    /**
+     * @brief Progress of the running import
+     * @param bytesImported see bytesImported()
+     * @param bytesTotal size of uncompressed export files, otherwise -1 because the size is not known upfront
+     * @param entryCount see entryCount()
+     */
+    void importProgress(qint64 bytesImported, qint64 bytesTotal, qint64 entryCount);
+
+    /**
+     * @brief Emitted once systemd-journal-remote finished
+     * @param success is false if the tool could not be started or failed
+     */
+    void importFinished(bool success);
+
 private Q_SLOTS:
     void handleJournalFileCreated(const QString &path);
 
@@ -6,24 +6,87 @@
 #ifndef SYSTEMDJOURNALREMOTE_PRIVATE_H
 #define SYSTEMDJOURNALREMOTE_PRIVATE_H
 
+#include "decompressiondevice.h"
+#include "journalimportcache.h"
+#include <QFile>
 #include <QFileSystemWatcher>
 #include <QProcess>
 #include <QString>
 #include <QTemporaryDir>
+#include <QTimer>
 #include <memory>
+#include <optional>
 #include <systemd/sd-journal.h>
 
+class SystemdJournalRemote;
+
 class SystemdJournalRemotePrivate
 {
 public:
-    SystemdJournalRemotePrivate();
+    explicit SystemdJournalRemotePrivate(SystemdJournalRemote *q);
     bool sanityCheckForSystemdJournalRemoveExec() const;
     QString journalFile() const;
 
+    /**
+     * create the directory for the journal file written by systemd-journal-remote
+     * @param templatePath see QTemporaryDir, the system's temporary directory is used if empty
+     */
+    void createJournalDirectory(const QString &templatePath = QString());
+
+    /**
+     * stream the export file at @p filePath to systemd-journal-remote
+     */
+    void importFile(const QString &filePath);
+
+    /**
+     * start systemd-journal-remote with @p arguments without waiting for it
+     */
+    void startProcess(const QStringList &arguments);
+
+    /**
+     * pass available data of mSource to the standard input of systemd-journal-remote
+     */
+    void feedProcess();
+
+    /**
+     * open the journal file, or reopen it if systemd-journal-remote replaced the file
+     */
+    void openJournal();
+
+    /**
+     * announce entries that were appended to the journal file since the last refresh
+     */
+    void refresh();
+
+    void finishImport(bool success);
+
+    /**
+     * finish the import as failed from the event loop, such that failures that are detected during construction
+     * are announced to receivers that connect afterwards, like for imports that are read from the cache
+     */
+    void failImport();
+
+    static constexpr qint64 sMaxPendingBytes{4 * 1024 * 1024}; //!< bytes written to the process but not yet consumed
+    static constexpr int sRefreshInterval{100}; //!< ms, coalesces the file change notifications of a running import
+
+    SystemdJournalRemote *q{nullptr};
     mutable sd_journal *mJournal{nullptr};
-    QTemporaryDir mTemporyJournalDir;
+    std::unique_ptr<QTemporaryDir> mTemporyJournalDir; //!< output directory of systemd-journal-remote, not set for cached imports
+    QString mJournalFile;
     QFileSystemWatcher mTemporaryJournalDirWatcher;
     QProcess mJournalRemoteProcess;
+    QTimer mRefreshTimer;
+    std::unique_ptr<QFile> mFile; //!< only set when importing an uncompressed export file
+    std::unique_ptr<DecompressionDevice> mDecompressionDevice; //!< only set when importing a compressed export file
+    QIODevice *mSource{nullptr}; //!< export data for the standard input, nullptr when receiving from a URL
+    bool mWriteChannelClosed{false};
+    bool mImporting{true};
+    QString mJournalFileId; //!< file ID of the opened journal file
+    std::optional<JournalImportCache> mCache;
+    QString mCacheKey; //!< key of the imported export file, empty if not cached
+    qint64 mBytesImported{0};
+    qint64 mBytesTotal{-1};
+    qint64 mEntryCount{0};
     const QString mSystemdJournalRemoteExec = QLatin1String("/lib/systemd/systemd-journal-remote");
 };
 